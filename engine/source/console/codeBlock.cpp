@@ -399,11 +399,6 @@ bool CodeBlock::read(StringTableEntry fileName, Stream& st)
 
 bool CodeBlock::compile(const char* codeFileName, StringTableEntry fileName, const char* inScript)
 {
-#if defined(TORQUE_NO_DSO_GENERATION)
-    // There is probably a better way to do this.  
-    return false;
-#endif
-
     // This will return true, but return value is ignored
     char* script;
     chompUTF8BOM(inScript, &script);
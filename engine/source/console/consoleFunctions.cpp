@@ -9,6 +9,7 @@
 #include "console/ast.h"
 #include "core/resManager.h"
 #include "core/fileStream.h"
+#include "core/crc.h"
 #include "console/compiler.h"
 #include "platform/event.h"
 #include "platform/gameInterface.h"
@@ -718,6 +719,64 @@ ConsoleFunction(call, const char*, 2, 0, "call(funcName [,args ...])")
 static U32 execDepth = 0;
 static U32 journalDepth = 1;
 
+//----------------------------------------------------------------
+// Compiled script cache
+//
+// exec() compiles scripts into a cache under the prefs path instead of
+// next to the source.  Entries are named after a hash of the script
+// contents, so an unchanged script is never recompiled no matter where
+// it lives, identical scripts in different mods share one entry, and
+// file times don't matter.  Entries from an older DSO version are
+// recompiled in place.
+
+static U32 gDSOCacheCompiled = 0;
+static U32 gDSOCacheCompileTime = 0;
+static U32 gDSOCacheLoaded = 0;
+static U32 gDSOCacheLoadTime = 0;
+static bool gDSOCacheReported = false;
+
+#ifdef TORQUE_SCRIPT_CACHE
+static void getDSOCacheFileName(const char* script, U32 scriptSize, char* buffer, U32 bufferSize)
+{
+    // A CRC and an FNV-1a hash of the contents, plus the size, make an
+    // accidental collision vanishingly unlikely.
+    U32 crc = calculateCRC(script, scriptSize);
+    U32 fnv = 2166136261u;
+    for (U32 i = 0; i < scriptSize; i++)
+        fnv = (fnv ^ U8(script[i])) * 16777619u;
+
+    char fileName[64];
+    dSprintf(fileName, sizeof(fileName), "dsoCache/%08x%08x%x.dso", crc, fnv, scriptSize);
+
+    const char* path = Platform::getPrefsPath(fileName);
+    dStrcpy(buffer, path ? path : fileName);
+}
+#endif
+
+static bool openDSOCacheFile(const char* fileName, FileStream& stream)
+{
+    if (!Platform::isFile(fileName) || !stream.open(fileName, FileStream::Read))
+        return false;
+
+    U32 version;
+    if (!stream.read(&version) || version != Con::DSOVersion)
+    {
+        stream.close();
+        return false;
+    }
+    return true;
+}
+
+static void reportDSOCache()
+{
+    if (gDSOCacheReported || (!gDSOCacheCompiled && !gDSOCacheLoaded))
+        return;
+    gDSOCacheReported = true;
+
+    Con::printf("Script cache: compiled %d script(s) in %d ms, loaded %d cached script(s) in %d ms.",
+        gDSOCacheCompiled, gDSOCacheCompileTime, gDSOCacheLoaded, gDSOCacheLoadTime);
+}
+
 ConsoleFunction(compile, bool, 2, 2, "compile(fileName)")
 {
     argc;
@@ -762,12 +821,14 @@ ConsoleFunction(compile, bool, 2, 2, "compile(fileName)")
         Con::errorf(ConsoleLogEntry::Script, "compile: invalid script file %s.", scriptFilenameBuffer);
         return false;
     }
+#ifndef TORQUE_NO_DSO_GENERATION
     // compile this baddie.
     Con::printf("Compiling %s...", scriptFilenameBuffer);
     CodeBlock* code = new CodeBlock();
     code->compile(nameBuffer, scriptFilenameBuffer, script);
     delete code;
     code = NULL;
+#endif
 
     delete[] script;
     return true;
@@ -863,6 +924,12 @@ ConsoleFunction(exec, bool, 2, 4, "exec(fileName [, nocalls [,journalScript]])")
     Stream* compiledStream = NULL;
     FileTime comModifyTime, scrModifyTime;
 
+    // Compiled scripts with source go through the cache.
+    bool cached = false;
+    bool cacheMiss = false;
+    FileStream cacheStream;
+    U32 startTime = 0;
+
     // Check here for .edso
     bool edso = false;
     if (dStricmp(ext, ".edso") == 0)
@@ -875,6 +942,30 @@ ConsoleFunction(exec, bool, 2, 4, "exec(fileName [, nocalls [,journalScript]])")
         dStrcpy(nameBuffer, scriptFileName);
     }
 
+#ifdef TORQUE_SCRIPT_CACHE
+    if (compiled && !edso && rScr)
+    {
+        // Read the source now so it can be hashed; we need it to compile
+        // on a miss anyway.  Journalling is off for compiled scripts.
+        Stream* s = ResourceManager->openStream(scriptFileName);
+        if (s)
+        {
+            scriptSize = ResourceManager->getSize(scriptFileName);
+            script = new char[scriptSize + 1];
+            s->read(scriptSize, script);
+            ResourceManager->closeStream(s);
+            script[scriptSize] = 0;
+
+            getDSOCacheFileName(script, scriptSize, nameBuffer, sizeof(nameBuffer));
+            cached = true;
+
+            startTime = Platform::getRealMilliseconds();
+            if (openDSOCacheFile(nameBuffer, cacheStream))
+                compiledStream = &cacheStream;
+        }
+    }
+    else
+#endif
     // If we're supposed to be compiling this file, check to see if there's a DSO
     if (compiled && !edso)
     {
@@ -906,7 +997,7 @@ ConsoleFunction(exec, bool, 2, 4, "exec(fileName [, nocalls [,journalScript]])")
     //}
 
     // If we had a DSO, let's check to see if we should be reading from it.
-    if (compiled && rCom && (!rScr || Platform::compareFileTimes(comModifyTime, scrModifyTime) >= 0))
+    if (compiled && !cached && rCom && (!rScr || Platform::compareFileTimes(comModifyTime, scrModifyTime) >= 0))
     {
         compiledStream = ResourceManager->openStream(nameBuffer);
 
@@ -929,7 +1020,7 @@ ConsoleFunction(exec, bool, 2, 4, "exec(fileName [, nocalls [,journalScript]])")
         // If we have source but no compiled version, then we need to compile
         // (and journal as we do so, if that's required).
 
-        Stream* s = ResourceManager->openStream(scriptFileName);
+        Stream* s = script ? NULL : ResourceManager->openStream(scriptFileName);
         if (journal && Game->isJournalWriting())
             Game->getJournalStream()->write(bool(s != NULL));
 
@@ -956,20 +1047,41 @@ ConsoleFunction(exec, bool, 2, 4, "exec(fileName [, nocalls [,journalScript]])")
             return false;
         }
 
-#ifndef TORQUE_NO_DSO_GENERATION
-        if (compiled)
+#ifdef TORQUE_NO_DSO_GENERATION
+        // Only the cache is written to, anything else runs from source.
+        bool generate = cached;
+#else
+        bool generate = true;
+#endif
+        if (compiled && generate)
         {
             // compile this baddie.
             Con::printf("Compiling %s...", scriptFileName);
+            startTime = Platform::getRealMilliseconds();
             CodeBlock* code = new CodeBlock();
-            code->compile(nameBuffer, scriptFileName, script);
+            if (cached)
+            {
+                // The cache lives outside the game directory.
+                cacheMiss = true;
+                gAllowExternalWrite = true;
+                code->compile(nameBuffer, scriptFileName, script);
+                gAllowExternalWrite = false;
+
+                if (openDSOCacheFile(nameBuffer, cacheStream))
+                    compiledStream = &cacheStream;
+            }
+            else
+            {
+                code->compile(nameBuffer, scriptFileName, script);
+                compiledStream = ResourceManager->openStream(nameBuffer);
+            }
             delete code;
             code = NULL;
 
-            compiledStream = ResourceManager->openStream(nameBuffer);
             if (compiledStream)
             {
-                compiledStream->read(&version);
+                if (!cached)
+                    compiledStream->read(&version);
             }
             else
             {
@@ -979,7 +1091,6 @@ ConsoleFunction(exec, bool, 2, 4, "exec(fileName [, nocalls [,journalScript]])")
                 return false;
             }
         }
-#endif
     }
     else
     {
@@ -998,7 +1109,25 @@ ConsoleFunction(exec, bool, 2, 4, "exec(fileName [, nocalls [,journalScript]])")
         Con::printf("Loading compiled script %s.", scriptFileName);
         CodeBlock* code = new CodeBlock;
         code->read(scriptFileName, *compiledStream);
-        ResourceManager->closeStream(compiledStream);
+        if (cached)
+        {
+            cacheStream.close();
+
+            // Compile time includes reading the result back.
+            U32 elapsed = Platform::getRealMilliseconds() - startTime;
+            if (cacheMiss)
+            {
+                gDSOCacheCompiled++;
+                gDSOCacheCompileTime += elapsed;
+            }
+            else
+            {
+                gDSOCacheLoaded++;
+                gDSOCacheLoadTime += elapsed;
+            }
+        }
+        else
+            ResourceManager->closeStream(compiledStream);
         code->exec(0, scriptFileName, NULL, 0, NULL, noCalls, NULL, 0);
         ret = true;
     }
@@ -1024,6 +1153,10 @@ ConsoleFunction(exec, bool, 2, 4, "exec(fileName [, nocalls [,journalScript]])")
 
     delete[] script;
     execDepth--;
+
+    // Report once the outermost exec, normally main.cs, is done.
+    if (execDepth == 0)
+        reportDSOCache();
     return ret;
 }
 
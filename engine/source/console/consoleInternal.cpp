@@ -14,13 +14,17 @@
 #include "console/consoleInternal.h"
 #include "core/fileStream.h"
 #include "console/compiler.h"
+#include "platform/memoryTag.h"
 
 #define ST_INIT_SIZE 15
 
+static MemoryTag sDictionaryMemoryTag("ConsoleDictionaries");
+static MemoryTag sNamespaceMemoryTag("ConsoleNamespaces");
+
 static char scratchBuffer[1024];
 U32 Namespace::mCacheSequence = 0;
-DataChunker Namespace::mCacheAllocator;
-DataChunker Namespace::mAllocator;
+DataChunker Namespace::mCacheAllocator(DataChunker::ChunkSize, &sNamespaceMemoryTag);
+DataChunker Namespace::mAllocator(DataChunker::ChunkSize, &sNamespaceMemoryTag);
 Namespace* Namespace::mNamespaceList = NULL;
 Namespace* Namespace::mGlobalNamespace = NULL;
 
@@ -275,6 +279,8 @@ Dictionary::Entry* Dictionary::add(StringTableEntry name)
         else
             walk = walk->nextEntry;
     }
+    MemoryTagScope tagScope(sDictionaryMemoryTag);
+
     Entry* ret;
     hashTable->count++;
 
@@ -491,6 +497,7 @@ void Dictionary::Entry::setStringValue(const char* value)
         // may as well pad to the next cache line
         U32 newLen = ((stringLen + 1) + 15) & ~15;
 
+        MemoryTagScope tagScope(sDictionaryMemoryTag);
         if (sval == typeValueEmpty)
             sval = (char*)dMalloc(newLen);
         else if (newLen > bufferLen)
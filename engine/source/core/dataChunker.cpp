@@ -5,14 +5,16 @@
 
 #include "platform/platform.h"
 #include "core/dataChunker.h"
+#include "platform/memoryTag.h"
 
 
 //----------------------------------------------------------------------------
 
-DataChunker::DataChunker(S32 size)
+DataChunker::DataChunker(S32 size, const MemoryTag* tag)
 {
     chunkSize = size;
-    curBlock = new DataBlock(size);
+    memoryTag = tag;
+    curBlock = allocBlock();
     curBlock->next = NULL;
     curBlock->curIndex = 0;
 }
@@ -27,7 +29,7 @@ void* DataChunker::alloc(S32 size)
     AssertFatal(size <= chunkSize, "Data chunk too large.");
     if (!curBlock || size + curBlock->curIndex > chunkSize)
     {
-        DataBlock* temp = new DataBlock(chunkSize);
+        DataBlock* temp = allocBlock();
         temp->next = curBlock;
         temp->curIndex = 0;
         curBlock = temp;
@@ -37,6 +39,15 @@ void* DataChunker::alloc(S32 size)
     return ret;
 }
 
+DataChunker::DataBlock* DataChunker::allocBlock()
+{
+    if (!memoryTag)
+        return new DataBlock(chunkSize);
+
+    MemoryTagScope tagScope(*memoryTag);
+    return new DataBlock(chunkSize);
+}
+
 DataChunker::DataBlock::DataBlock(S32 size)
 {
     data = new U8[size];
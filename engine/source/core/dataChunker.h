@@ -6,6 +6,7 @@
 #ifndef _DATACHUNKER_H_
 #define _DATACHUNKER_H_
 
+class MemoryTag;
 
 //----------------------------------------------------------------------------
 /// Implements a chunked data allocater.
@@ -23,6 +24,10 @@
 /// Note that new/free/realloc WILL NOT WORK on memory gotten from the
 /// DataChunker. This also only grows (you can call freeBlocks to deallocate
 /// and reset things).
+///
+/// Blocks can be charged to a MemoryTag, so pools show up on their own in
+/// dumpMemoryTags(). A tag that is a static must be defined before the
+/// chunker in the same file.
 class DataChunker
 {
 public:
@@ -44,6 +49,9 @@ private:
     };
     DataBlock* curBlock;
     S32 chunkSize;
+    const MemoryTag* memoryTag;
+
+    DataBlock* allocBlock();
 
 public:
 
@@ -66,7 +74,8 @@ public:
     /// One new block is allocated at constructor-time.
     ///
     /// @param   size    Size in bytes of the space to allocate for each block.
-    DataChunker(S32 size = ChunkSize);
+    /// @param   tag     Memory tag to charge the blocks to, if any.
+    DataChunker(S32 size = ChunkSize, const MemoryTag* tag = NULL);
     ~DataChunker();
 };
 
@@ -89,7 +98,7 @@ class FreeListChunker : private DataChunker
     S32 elementSize;
     T* freeListHead;
 public:
-    FreeListChunker(S32 size = DataChunker::ChunkSize) : DataChunker(size)
+    FreeListChunker(S32 size = DataChunker::ChunkSize, const MemoryTag* tag = NULL) : DataChunker(size, tag)
     {
         numAllocated = 0;
         elementSize = getMax(U32(sizeof(T)), U32(sizeof(T*)));
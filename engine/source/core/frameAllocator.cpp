@@ -4,18 +4,171 @@
 //-----------------------------------------------------------------------------
 
 #include "core/frameAllocator.h"
+#include "platform/platformMutex.h"
+#include "platform/platformThread.h"
 #include "console/console.h"
 
-U8* FrameAllocator::smBuffer = NULL;
-U32   FrameAllocator::smWaterMark = 0;
-U32   FrameAllocator::smHighWaterMark = 0;
+thread_local FrameAllocator::Arena* FrameAllocator::smArena = NULL;
+FrameAllocator::Arena* FrameAllocator::smArenaList = NULL;
+void* FrameAllocator::smArenaListMutex = NULL;
 
-#if defined(TORQUE_DEBUG)
+//------------------------------------------------------------------------------
+
+FrameAllocator::Arena* FrameAllocator::createArena(U32 size)
+{
+    Arena* arena = new Arena;
+    arena->buffer = new U8[size];
+    arena->size = size;
+    arena->waterMark = 0;
+    arena->framePeak = 0;
+    arena->lastFramePeak = 0;
+    arena->maxPeak = 0;
+    arena->overflow = NULL;
+    arena->overflowCount = 0;
+    arena->overflowBytes = 0;
+    arena->threadId = Thread::getCurrentThreadId();
+
+    Mutex::lockMutex(smArenaListMutex);
+    arena->next = smArenaList;
+    smArenaList = arena;
+    Mutex::unlockMutex(smArenaListMutex);
+
+    smArena = arena;
+    return arena;
+}
+
+void FrameAllocator::destroyArena(Arena* arena)
+{
+    AssertFatal(arena->waterMark == 0, "FrameAllocator::destroyArena - someone didn't reset the water mark!");
+    freeOverflow(arena, 0);
+
+    Mutex::lockMutex(smArenaListMutex);
+    for (Arena** walk = &smArenaList; *walk; walk = &(*walk)->next)
+        if (*walk == arena)
+        {
+            *walk = arena->next;
+            break;
+        }
+    Mutex::unlockMutex(smArenaListMutex);
+
+    if (smArena == arena)
+        smArena = NULL;
+
+    delete[] arena->buffer;
+    delete arena;
+}
+
+FrameAllocator::Arena* FrameAllocator::createThreadArena()
+{
+    AssertFatal(smArenaListMutex != NULL, "FrameAllocator::createThreadArena - not initialized!");
+    return createArena(TORQUE_FRAME_THREAD_SIZE);
+}
+
+void FrameAllocator::init(const U32 frameSize)
+{
+    AssertFatal(smArenaListMutex == NULL, "Error, already initialized");
+    smArenaListMutex = Mutex::createMutex();
+    createArena(frameSize);
+}
+
+void FrameAllocator::destroy()
+{
+    AssertFatal(smArenaListMutex != NULL, "Error, not initialized");
+
+    destroyArena(smArena);
+
+    AssertWarn(smArenaList == NULL, "FrameAllocator::destroy - threads still hold frame arenas.");
+    Mutex::destroyMutex(smArenaListMutex);
+    smArenaListMutex = NULL;
+}
+
+void FrameAllocator::releaseThreadArena()
+{
+    if (smArena)
+        destroyArena(smArena);
+}
+
+//------------------------------------------------------------------------------
+
+void* FrameAllocator::allocOverflow(Arena* arena, U32 allocSize)
+{
+    OverflowBlock* block = (OverflowBlock*)dMalloc(sizeof(OverflowBlock) + allocSize);
+    block->waterMark = arena->waterMark;
+    block->size = allocSize;
+    block->next = arena->overflow;
+    arena->overflow = block;
+
+    // Move the water mark past the end of the arena so everything after this
+    // overflows too, and so markers taken from here on don't free the block.
+    arena->waterMark += allocSize;
+    if (arena->waterMark > arena->framePeak)
+        arena->framePeak = arena->waterMark;
+
+    arena->overflowCount++;
+    arena->overflowBytes += allocSize;
+
+    // Don't flood the log when a big frame overflows every allocation.
+    if (isPow2(arena->overflowCount))
+        Con::warnf("FrameAllocator: %d KB arena of thread %d is full, allocated %d bytes from the heap (%d overflows so far).",
+            arena->size / 1024, arena->threadId, allocSize, arena->overflowCount);
+
+    return block + 1;
+}
+
+void FrameAllocator::freeOverflow(Arena* arena, U32 waterMark)
+{
+    while (arena->overflow && arena->overflow->waterMark >= waterMark)
+    {
+        OverflowBlock* block = arena->overflow;
+        arena->overflow = block->next;
+        dFree(block);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void FrameAllocator::endFrame()
+{
+    Mutex::lockMutex(smArenaListMutex);
+    for (Arena* walk = smArenaList; walk; walk = walk->next)
+    {
+        walk->lastFramePeak = walk->framePeak;
+        walk->maxPeak = getMax(walk->maxPeak, walk->framePeak);
+        walk->framePeak = walk->waterMark;
+    }
+    Mutex::unlockMutex(smArenaListMutex);
+}
+
+U32 FrameAllocator::getMaxFrameAllocation()
+{
+    Arena* arena = getArena();
+    return getMax(arena->maxPeak, arena->framePeak);
+}
+
+void FrameAllocator::dumpStats()
+{
+    Con::printf("%-10s %10s %10s %12s %10s %10s %10s", "Thread", "Size KB", "Used KB",
+        "Last Peak KB", "Peak KB", "Overflows", "Ovfl KB");
+
+    Mutex::lockMutex(smArenaListMutex);
+    for (Arena* walk = smArenaList; walk; walk = walk->next)
+    {
+        Con::printf("%-10d %10d %10d %12d %10d %10d %10d", walk->threadId, walk->size / 1024,
+            walk->waterMark / 1024, walk->lastFramePeak / 1024,
+            getMax(walk->maxPeak, walk->framePeak) / 1024, walk->overflowCount, walk->overflowBytes / 1024);
+    }
+    Mutex::unlockMutex(smArenaListMutex);
+}
+
+//------------------------------------------------------------------------------
 
 ConsoleFunction(getMaxFrameAllocation, S32, 1, 1, "getMaxFrameAllocation();")
 {
     argc, argv;
-    return sgMaxFrameAllocation;
+    return FrameAllocator::getMaxFrameAllocation();
 }
 
-#endif
+ConsoleFunction(dumpFrameAllocators, void, 1, 1, "Print usage, per-frame peaks and overflows of every thread's frame arena.")
+{
+    FrameAllocator::dumpStats();
+}
@@ -26,65 +26,104 @@
 ///   // Free frameAllocator memory
 ///   FrameAllocator::setWaterMark(waterMark);
 /// @endcode
+///
+/// Every thread has an arena of its own, so the FrameAllocator (and with it
+/// FrameTemp and FrameAllocatorMarker) may be used from worker threads too.
+/// The main thread's arena is TORQUE_FRAME_SIZE bytes and is set up by init();
+/// other threads get a TORQUE_FRAME_THREAD_SIZE arena on first use, which is
+/// released when their Thread finishes. Water marks are per thread, so they
+/// must be restored on the thread they were taken on.
+///
+/// Allocations that don't fit the arena come from the heap instead, and are
+/// freed when the water mark is set back below them. Each one is counted;
+/// see dumpFrameAllocators() for the counts and the per-frame peak usage of
+/// every arena.
 class FrameAllocator
 {
-    static U8* smBuffer;
-    static U32   smHighWaterMark;
-    static U32   smWaterMark;
+    /// Heap allocation made because the arena was full.
+    struct OverflowBlock
+    {
+        OverflowBlock* next;
+        U32 waterMark;         ///< Water mark at the time of the allocation.
+        U32 size;
+    };
+
+    struct Arena
+    {
+        U8* buffer;
+        U32 size;
+        U32 waterMark;         ///< May run past size once the arena overflows.
+
+        U32 framePeak;         ///< Highest water mark since the last endFrame().
+        U32 lastFramePeak;     ///< framePeak of the previous frame.
+        U32 maxPeak;           ///< Highest framePeak so far.
+
+        OverflowBlock* overflow;   ///< Newest first.
+        U32 overflowCount;
+        U32 overflowBytes;
+
+        U32 threadId;
+        Arena* next;
+    };
+
+    static thread_local Arena* smArena;   ///< The calling thread's arena.
+    static Arena* smArenaList;
+    static void*  smArenaListMutex;
+
+    static Arena* createArena(U32 size);
+    static void   destroyArena(Arena* arena);
+
+    inline static Arena* getArena();
+    static Arena* createThreadArena();
+
+    static void* allocOverflow(Arena* arena, U32 allocSize);
+    static void  freeOverflow(Arena* arena, U32 waterMark);
 
 public:
-    inline static void init(const U32 frameSize);
-    inline static void destroy();
+    /// Create the main thread's arena.
+    static void init(const U32 frameSize);
+    static void destroy();
 
     inline static void* alloc(const U32 allocSize);
 
     inline static void setWaterMark(const U32);
     inline static U32  getWaterMark();
     inline static U32  getHighWaterMark();
-};
 
-#if defined(TORQUE_DEBUG)
-static S32 sgMaxFrameAllocation = 0;
-#endif
+    /// Free the calling thread's arena. Called when a Thread finishes.
+    static void releaseThreadArena();
 
-void FrameAllocator::init(const U32 frameSize)
-{
-    AssertFatal(smBuffer == NULL, "Error, already initialized");
-    smBuffer = new U8[frameSize];
-    smWaterMark = 0;
-    smHighWaterMark = frameSize;
-}
+    /// Roll the per-frame peak of every arena over. Called once per main loop.
+    static void endFrame();
 
-void FrameAllocator::destroy()
-{
-    AssertFatal(smBuffer != NULL, "Error, not initialized");
+    /// Highest per-frame usage of the main thread's arena.
+    static U32 getMaxFrameAllocation();
 
-    delete[] smBuffer;
-    smBuffer = NULL;
-    smWaterMark = 0;
-    smHighWaterMark = 0;
-}
+    static void dumpStats();
+};
 
+FrameAllocator::Arena* FrameAllocator::getArena()
+{
+    Arena* arena = smArena;
+    return arena ? arena : createThreadArena();
+}
 
 void* FrameAllocator::alloc(const U32 allocSize)
 {
-    AssertFatal(smBuffer != NULL, "Error, no buffer!");
-    AssertFatal(smWaterMark + allocSize <= smHighWaterMark, "Error alloc too large, increase frame size!");
+    Arena* arena = getArena();
 
     // Keep all frame allocator allocations aligned to DWORD boundries on the 360
     // Add 3, mask out the lower 3 bits.
-    smWaterMark = ( smWaterMark + ( TORQUE_BYTE_ALIGNMENT - 1 ) ) & (~( TORQUE_BYTE_ALIGNMENT - 1 ));
+    U32 waterMark = ( arena->waterMark + ( TORQUE_BYTE_ALIGNMENT - 1 ) ) & (~( TORQUE_BYTE_ALIGNMENT - 1 ));
 
-    // Sanity check.
-    AssertFatal( !( smWaterMark & ( TORQUE_BYTE_ALIGNMENT - 1 ) ), "Frame allocation is not on a 4-byte boundry." );
+    if (waterMark + allocSize > arena->size)
+        return allocOverflow(arena, allocSize);
 
-    U8* p = &smBuffer[smWaterMark];
-    smWaterMark += allocSize;
+    U8* p = &arena->buffer[waterMark];
+    arena->waterMark = waterMark + allocSize;
 
-#if defined(TORQUE_DEBUG)
-    if (smWaterMark > sgMaxFrameAllocation)
-        sgMaxFrameAllocation = smWaterMark;
-#endif
+    if (arena->waterMark > arena->framePeak)
+        arena->framePeak = arena->waterMark;
 
     return p;
 }
@@ -92,19 +131,22 @@ void* FrameAllocator::alloc(const U32 allocSize)
 
 void FrameAllocator::setWaterMark(const U32 waterMark)
 {
-    AssertFatal(waterMark < smHighWaterMark, "Error, invalid waterMark");
+    Arena* arena = getArena();
+    AssertFatal(waterMark <= arena->waterMark || waterMark <= arena->size, "Error, invalid waterMark");
 
-    smWaterMark = waterMark;
+    if (arena->overflow)
+        freeOverflow(arena, waterMark);
+    arena->waterMark = waterMark;
 }
 
 U32 FrameAllocator::getWaterMark()
 {
-    return smWaterMark;
+    return getArena()->waterMark;
 }
 
 U32 FrameAllocator::getHighWaterMark()
 {
-    return smHighWaterMark;
+    return getArena()->size;
 }
 
 /// Helper class to deal with FrameAllocator usage.
@@ -10,8 +10,11 @@
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 
+U32 ResDictionary::smGeneration = 0;
+
 ResDictionary::ResDictionary()
 {
+    smGeneration++;
     entryCount = 0;
     hashTableSize = 1023; //DefaultTableSize;
     hashTable = new ResourceObject * [hashTableSize];
@@ -26,6 +29,7 @@ ResDictionary::~ResDictionary()
     // the dictionary
 
     delete[] hashTable;
+    smGeneration++;
 }
 
 dsize_t ResDictionary::hash(StringTableEntry path, StringTableEntry file)
@@ -37,6 +41,7 @@ void ResDictionary::insert(ResourceObject* obj, StringTableEntry path, StringTab
 {
     obj->name = file;
     obj->path = path;
+    smGeneration++;
 
     S32 idx = hash(path, file);
     obj->nextEntry = hashTable[idx];
@@ -120,6 +125,7 @@ void ResDictionary::remove(ResourceObject* resObj)
     {
         if (*walk == resObj)
         {
+            smGeneration++;
             entryCount--;
             *walk = resObj->nextEntry;
             return;
@@ -13,6 +13,8 @@
 #include "core/zipHeaders.h"
 #include "core/resizeStream.h"
 #include "core/frameAllocator.h"
+#include "core/memstream.h"
+#include "core/zipCache.h"
 
 #include "core/resManager.h"
 #include "core/findMatch.h"
@@ -21,6 +23,9 @@
 #include "console/consoleTypes.h"
 
 #include "util/safeDelete.h"
+#include "platform/threadPool.h"
+#include "platform/profiler.h"
+#include "platform/memoryTag.h"
 
 ResManager* ResourceManager = NULL;
 
@@ -29,12 +34,34 @@ bool gAllowExternalWrite = false;
 char* ResManager::smExcludedDirectories = ".svn;CVS";
 
 //------------------------------------------------------------------------------
+static MemoryTag sResourceMemoryTag("Resources");
+
+/// Run a create function, measuring what the new instance holds on to.
+/// Subsystems may charge their own tags inside; the rest goes to Resources.
+static ResourceInstance* createResourceInstance(RESOURCE_CREATE_FN createFunction, Stream& stream)
+{
+    MemoryTagScope tagScope(sResourceMemoryTag);
+
+    S64 startBytes = MemoryTag::getThreadNetBytes();
+    ResourceInstance* instance = createFunction(stream);
+    if (instance)
+    {
+        S64 size = MemoryTag::getThreadNetBytes() - startBytes;
+        instance->mMemorySize = size > 0 ? U32(size) : 0;
+    }
+
+    return instance;
+}
+
+//------------------------------------------------------------------------------
+
 ResourceObject::ResourceObject()
 {
     next = NULL;
     prev = NULL;
     lockCount = 0;
     mInstance = NULL;
+    mLoadRequest = NULL;
 }
 
 void ResourceObject::destruct()
@@ -136,6 +163,13 @@ const char* ResourceObject::getFullPath()
 
 ResManager::~ResManager()
 {
+    // Requests still holding locks at this point are simply dropped.
+    while (mLoadRequests.size())
+    {
+        mLoadRequests.last()->mObject->mLoadRequest = NULL;
+        mLoadRequests.erase(mLoadRequests.size() - 1);
+    }
+
     purge();
     // volume list should be gone.
 
@@ -160,16 +194,22 @@ ResManager::~ResManager()
 #ifdef TORQUE_DEBUG
 void ResManager::dumpLoadedResources()
 {
+    U32 totalSize = 0;
+
     ResourceObject* walk = resourceList.nextResource;
     while (walk != NULL)
     {
         if (walk->mInstance != NULL)
         {
-            Con::errorf("LoadedRes: %s/%s (%d)", walk->path, walk->name,
-                walk->lockCount);
+            Con::errorf("LoadedRes: %s/%s (%d) %d KB", walk->path, walk->name,
+                walk->lockCount, walk->mInstance->mMemorySize / 1024);
+            totalSize += walk->mInstance->mMemorySize;
         }
         walk = walk->nextResource;
     }
+    Con::printf("Loaded resources hold %d KB", totalSize / 1024);
+
+    ZipInflateCache::dumpStats();
 }
 
 ConsoleFunction(dumpResourceStats, void, 1, 1, "Dump information about resources. Debug only!")
@@ -188,6 +228,8 @@ void ResManager::create()
     ResourceManager = new ResManager;
 
     Con::addVariable("Pref::ResourceManager::excludedDirectories", TypeString, &smExcludedDirectories);
+
+    ZipInflateCache::init();
 }
 
 
@@ -199,6 +241,8 @@ void ResManager::destroy()
         "ResourceManager::destroy: manager does not exist.");
     delete ResourceManager;
     ResourceManager = NULL;
+
+    ZipInflateCache::destroy();
 }
 
 //------------------------------------------------------------------------------
@@ -258,16 +302,21 @@ void ResManager::setWriteablePath(const char* path)
 
 //------------------------------------------------------------------------------
 
-static const char* buildPath(StringTableEntry path, StringTableEntry file)
+static const char* buildPath(StringTableEntry path, StringTableEntry file, char* buf, U32 bufSize)
 {
-    static char buf[1024];
     if (path)
-        dSprintf(buf, sizeof(buf), "%s/%s", path, file);
+        dSprintf(buf, bufSize, "%s/%s", path, file);
     else
-        dStrcpy(buf, file);
+        dStrncpy(buf, file, bufSize);
     return buf;
 }
 
+static const char* buildPath(StringTableEntry path, StringTableEntry file)
+{
+    static char buf[1024];
+    return buildPath(path, file, buf, sizeof(buf));
+}
+
 //------------------------------------------------------------------------------
 
 void ResManager::getPaths(const char* fullPath, StringTableEntry& path,
@@ -448,6 +497,12 @@ void ResManager::initExcludedDirectories()
 
 void ResManager::setModPaths(U32 numPaths, const char** paths)
 {
+    // Zip prefetches hold on to resource objects that may go away below,
+    // and the archives themselves may change.
+    if (ThreadPool::hasGlobal())
+        ThreadPool::getGlobal().waitForAllItems();
+    ZipInflateCache::flush();
+
     // detach all the files.
     for (ResourceObject* pwalk = resourceList.nextResource; pwalk;
         pwalk = pwalk->nextResource)
@@ -631,7 +686,7 @@ const char* ResManager::getBasePath()
 
 //------------------------------------------------------------------------------
 
-void ResManager::registerExtension(const char* name, RESOURCE_CREATE_FN create_fn)
+void ResManager::registerExtension(const char* name, RESOURCE_CREATE_FN create_fn, bool threadSafe)
 {
     AssertFatal(!getCreateFunction(name),
         "ResourceManager::registerExtension: file extension already registered.");
@@ -643,6 +698,7 @@ void ResManager::registerExtension(const char* name, RESOURCE_CREATE_FN create_f
     RegisteredExtension* add = new RegisteredExtension;
     add->mExtension = StringTable->insert(extension);
     add->mCreateFn = create_fn;
+    add->mThreadSafe = threadSafe;
     add->next = registeredList;
     registeredList = add;
 }
@@ -665,6 +721,18 @@ RESOURCE_CREATE_FN ResManager::getCreateFunction(const char* name)
     return (NULL);
 }
 
+bool ResManager::isThreadSafeExtension(const char* name)
+{
+    const char* s = dStrrchr(name, '.');
+    if (!s)
+        return false;
+
+    for (RegisteredExtension* itr = registeredList; itr; itr = itr->next)
+        if (dStricmp(s, itr->mExtension) == 0)
+            return itr->mThreadSafe;
+    return false;
+}
+
 
 //------------------------------------------------------------------------------
 
@@ -744,9 +812,18 @@ ResourceObject* ResManager::load(const char* fileName, bool computeCRC)
     if (!obj)
         return NULL;
 
+    // if it's being loaded in the background, let that finish first
+    bool crcIsFresh = false;
+    if (obj->mLoadRequest)
+    {
+        ResourceLoadRequestRef request = obj->mLoadRequest;
+        waitForLoad(request);
+        crcIsFresh = request->isLoaded() && request->mComputeCRC;
+    }
+
     // if no one has a lock on this, but it's loaded and it needs to
     // be CRC'd, delete it and reload it.
-    if (!obj->lockCount && computeCRC && obj->mInstance)
+    if (!obj->lockCount && computeCRC && obj->mInstance && !crcIsFresh)
         obj->destruct();
 
     obj->lockCount++;
@@ -807,13 +884,312 @@ ResourceInstance* ResManager::loadInstance(ResourceObject* obj, bool computeCRC)
         return NULL;
     }
 
-    ResourceInstance* ret = createFunction(*stream);
+    ResourceInstance* ret = createResourceInstance(createFunction, *stream);
     if (ret)
         ret->mSourceResource = obj;
     closeStream(stream);
     return ret;
 }
 
+//------------------------------------------------------------------------------
+// Background loading
+//------------------------------------------------------------------------------
+
+ResourceLoadRequest::ResourceLoadRequest(ResourceObject* obj, bool computeCRC)
+{
+    mObject = obj;
+    mStatus = Pending;
+    mComputeCRC = computeCRC;
+    mWorkItem = NULL;
+    mRead = false;
+    mInstance = NULL;
+    mBuffer = NULL;
+    mBufferSize = 0;
+    mCRC = InvalidCRC;
+}
+
+ResourceLoadRequest::~ResourceLoadRequest()
+{
+    // Only left over if the request was dropped before it was finished.
+    delete mInstance;
+    delete[] mBuffer;
+}
+
+ResourceObject* ResourceLoadRequest::acquire()
+{
+    if (mStatus != Loaded)
+        return NULL;
+
+    mObject->lockCount++;
+    return mObject;
+}
+
+/// Reads (and if possible decodes) a resource on a worker thread.
+class ResourceLoadWorkItem : public ThreadPool::WorkItem
+{
+    ResourceLoadRequestRef mRequest;
+    bool mDecode;
+
+public:
+    ResourceLoadWorkItem(ResourceLoadRequest* request, bool decode)
+    {
+        mRequest = request;
+        mDecode = decode;
+    }
+
+    void execute()
+    {
+        read();
+        mRequest->mRead = true;
+    }
+
+    void read()
+    {
+        ResourceObject* obj = mRequest->mObject;
+
+        Stream* stream = ResourceManager->openStream(obj);
+        if (!stream)
+            return;
+
+        bool computeCRC = mRequest->mComputeCRC;
+        if (!computeCRC)
+        {
+            const char* x = dStrrchr(obj->name, '.');
+            if (x && dStrstr(alwaysCRCList, x))
+                computeCRC = true;
+        }
+
+        if (mDecode)
+        {
+            if (computeCRC)
+                mRequest->mCRC = calculateCRCStream(stream, InvalidCRC);
+
+            RESOURCE_CREATE_FN createFunction = ResourceManager->getCreateFunction(obj->name);
+            if (createFunction)
+                mRequest->mInstance = createResourceInstance(createFunction, *stream);
+        }
+        else
+        {
+            // Pull the whole file into memory, the main thread decodes it from there.
+            U32 size = stream->getStreamSize();
+            if (size)
+            {
+                mRequest->mBuffer = new U8[size];
+                mRequest->mBufferSize = size;
+                stream->read(size, mRequest->mBuffer);
+
+                if (computeCRC)
+                    mRequest->mCRC = calculateCRC(mRequest->mBuffer, size, InvalidCRC);
+            }
+        }
+
+        ResourceManager->closeStream(stream);
+    }
+
+    void onCompleted()
+    {
+        // waitForLoad may have finished it already
+        if (!mRequest->isDone())
+            ResourceManager->finishLoadRequest(mRequest);
+    }
+};
+
+ResourceLoadRequestRef ResManager::loadAsync(const char* fileName, bool computeCRC)
+{
+    ResourceObject* obj = find(fileName);
+    if (!obj)
+        return NULL;
+
+    // Already on its way, share the request.
+    if (obj->mLoadRequest)
+        return obj->mLoadRequest;
+
+    // Same as load(), force a reload if the CRC is wanted.
+    if (!obj->lockCount && computeCRC && obj->mInstance)
+        obj->destruct();
+
+    // The request keeps the resource off the purge list until it's delivered.
+    ResourceLoadRequest* request = new ResourceLoadRequest(obj, computeCRC);
+    obj->lockCount++;
+    obj->unlink();
+
+    mLoadRequests.push_back(request);
+
+    if (obj->mInstance)
+    {
+        request->mStatus = ResourceLoadRequest::Loaded;
+        return request;
+    }
+
+    if (!getCreateFunction(obj->name))
+    {
+        Con::errorf("ResManager::loadAsync: NULL resource create function for '%s'.", obj->name);
+        request->mStatus = ResourceLoadRequest::Failed;
+        return request;
+    }
+
+    obj->mLoadRequest = request;
+    request->mWorkItem = new ResourceLoadWorkItem(request, isThreadSafeExtension(obj->name));
+    ThreadPool::getGlobal().queueWorkItem(request->mWorkItem);
+
+    return request;
+}
+
+void ResManager::finishLoadRequest(ResourceLoadRequest* request)
+{
+    PROFILE_START(ResManager_finishLoadRequest);
+
+    ResourceObject* obj = request->mObject;
+    obj->mLoadRequest = NULL;
+
+    ResourceInstance* instance = request->mInstance;
+    request->mInstance = NULL;
+
+    // Types that can't be decoded off-thread are decoded here from memory.
+    if (!instance && request->mBuffer)
+    {
+        RESOURCE_CREATE_FN createFunction = getCreateFunction(obj->name);
+
+        MemStream stream(request->mBufferSize, request->mBuffer, true, false);
+        instance = createResourceInstance(createFunction, stream);
+
+        delete[] request->mBuffer;
+        request->mBuffer = NULL;
+    }
+
+    if (instance)
+    {
+        instance->mSourceResource = obj;
+        obj->mInstance = instance;
+        obj->crc = request->mCRC;
+        request->mStatus = ResourceLoadRequest::Loaded;
+    }
+    else
+    {
+        Con::errorf("ResManager::loadAsync: failed to load '%s/%s'.", obj->path, obj->name);
+        request->mStatus = ResourceLoadRequest::Failed;
+    }
+
+    PROFILE_END();
+}
+
+void ResManager::processLoadRequests()
+{
+    if (!mLoadRequests.size())
+        return;
+
+    PROFILE_START(ResManager_processLoadRequests);
+
+    for (S32 i = 0; i < mLoadRequests.size(); i++)
+    {
+        if (mLoadRequests[i]->isDone())
+            deliverLoadRequest(i--);
+    }
+
+    PROFILE_END();
+}
+
+void ResManager::deliverLoadRequest(S32 index)
+{
+    // Hold on to it while it's delivered, listeners may start new loads.
+    ResourceLoadRequestRef request = mLoadRequests[index];
+    mLoadRequests.erase(index);
+
+    request->onLoaded.trigger(request);
+
+    // Drop the lock the request was holding.
+    if (request->isLoaded())
+        unlock(request->mObject);
+    else
+        request->mObject->lockCount--;
+}
+
+void ResManager::waitForLoad(ResourceLoadRequest* request)
+{
+    if (!request->isDone())
+    {
+        PROFILE_START(ResManager_waitForLoad);
+
+        // Read it here if no worker has started on it, otherwise wait for
+        // the one that has.  The rest of the pool's work is left alone.
+        if (!request->mRead && !ThreadPool::getGlobal().runIfQueued(request->mWorkItem))
+        {
+            while (!request->mRead)
+                Platform::sleep(0);
+        }
+
+        // Finishing creates the instance, which only the main thread may do.
+        // Anywhere else wait for the main thread to get to it.
+        if (Con::isMainThread())
+            finishLoadRequest(request);
+        else
+        {
+            while (!request->isDone())
+                Platform::sleep(0);
+        }
+
+        PROFILE_END();
+    }
+
+    if (!Con::isMainThread())
+        return;
+
+    for (S32 i = 0; i < mLoadRequests.size(); i++)
+    {
+        if (mLoadRequests[i] == request)
+        {
+            deliverLoadRequest(i);
+            break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+/// Forwards a finished background load to a script function.
+struct ResourceAsyncCallback
+{
+    StringTableEntry mFileName;
+    StringTableEntry mCallback;
+
+    ResourceAsyncCallback(const char* fileName, const char* callback)
+    {
+        mFileName = StringTable->insert(fileName);
+        mCallback = StringTable->insert(callback);
+    }
+
+    void onLoaded(ResourceLoadRequest* request)
+    {
+        Con::executef(3, mCallback, mFileName, request->isLoaded() ? "1" : "0");
+        delete this;
+    }
+};
+
+ConsoleFunction(loadResourceAsync, void, 2, 3, "(string fileName, string callback=\"\")"
+    "Start loading a resource in the background. The optional callback is "
+    "called with the file name and whether it loaded once it's done.")
+{
+    ResourceLoadRequestRef request = ResourceManager->loadAsync(argv[1]);
+    if (request.isNull())
+    {
+        if (argc > 2 && argv[2][0])
+            Con::executef(3, argv[2], argv[1], "0");
+        return;
+    }
+
+    if (argc > 2 && argv[2][0])
+    {
+        // The callback name has to outlive this call.
+        ResourceAsyncCallback* cb = new ResourceAsyncCallback(argv[1], argv[2]);
+        request->onLoaded.notify(cb, &ResourceAsyncCallback::onLoaded);
+    }
+}
+
+ConsoleFunction(getPendingResourceLoads, S32, 1, 1, "Returns the number of background resource loads in flight.")
+{
+    return ResourceManager->getNumPendingLoads();
+}
+
 //------------------------------------------------------------------------------
 
 Stream* ResManager::openStream(const char* fileName)
@@ -838,13 +1214,16 @@ Stream* ResManager::openStream(ResourceObject* obj)
     // used for openStream stream access
     FileStream* diskStream = NULL;
 
+    // local buffer, this may be called from a loader thread
+    char pathBuf[1024];
+
     // if disk file
     if (obj->flags & (ResourceObject::File))
     {
         diskStream = new FileStream;
-        if (!diskStream->open(buildPath(obj->path, obj->name), FileStream::Read))
+        if (!diskStream->open(buildPath(obj->path, obj->name, pathBuf, sizeof(pathBuf)), FileStream::Read))
         {
-            AssertISV(false, avar("ResManager::openStream - failed to open stream for resource '%s'!", buildPath(obj->path, obj->name)));
+            AssertISV(false, avar("ResManager::openStream - failed to open stream for resource '%s'!", pathBuf));
             delete diskStream;
             return NULL;
         }
@@ -856,8 +1235,13 @@ Stream* ResManager::openStream(ResourceObject* obj)
 
     if (obj->flags & ResourceObject::VolumeBlock)
     {
+        // Already inflated?
+        Stream* cached = ZipInflateCache::openStream(obj);
+        if (cached)
+            return cached;
+
         diskStream = new FileStream;
-        diskStream->open(buildPath(obj->zipPath, obj->zipName),
+        diskStream->open(buildPath(obj->zipPath, obj->zipName, pathBuf, sizeof(pathBuf)),
             FileStream::Read);
 
         diskStream->setPosition(obj->fileOffset);
@@ -885,6 +1269,18 @@ Stream* ResManager::openStream(ResourceObject* obj)
             if (zlfHeader.m_header.compressionMethod ==
                 ZipLocalFileHeader::Deflated)
             {
+                if (ZipInflateCache::canCache(obj->fileSize))
+                {
+                    cached = ZipInflateCache::inflateEntry(obj, diskStream);
+                    if (cached)
+                    {
+                        delete diskStream;
+                        return cached;
+                    }
+                    diskStream->setPosition(obj->fileOffset);
+                    zlfHeader.readFromStream(*diskStream);
+                }
+
                 ZipSubRStream* zipStream = new ZipSubRStream;
                 zipStream->attachStream(diskStream);
                 zipStream->setUncompressedSize(obj->fileSize);
@@ -1248,6 +1644,9 @@ ResourceObject* ResManager::reload(const char* fileName, bool computeCRC)
     // Check the crc to see if it needs reloading
     if (obj)
     {
+        if (obj->mLoadRequest)
+            waitForLoad(obj->mLoadRequest);
+
         bool reload = true;
 
         // If we have a valid crc check against the new crc
@@ -31,12 +31,24 @@
 #ifndef _CRC_H_
 #include "core/crc.h"
 #endif
+#ifndef _REFBASE_H_
+#include "core/refBase.h"
+#endif
+#ifndef _UTIL_SIGNAL_H_
+#include "util/tSignal.h"
+#endif
+#ifndef _THREADPOOL_H_
+#include "platform/threadPool.h"
+#endif
+
+#include <atomic>
 
 class Stream;
 class FileStream;
 class ZipSubRStream;
 class ResManager;
 class FindMatch;
+class ResourceLoadRequest;
 
 extern ResManager* ResourceManager;
 
@@ -94,7 +106,11 @@ public:
     /// Pointer to the ResourceObject that stores all our book-keeping data.
     ResourceObject* mSourceResource;
 
-    ResourceInstance() { mSourceResource = NULL; }
+    /// Heap memory still held from creating this instance. Only measured
+    /// in TORQUE_MEMORY_TAGGING builds.
+    U32 mMemorySize;
+
+    ResourceInstance() { mSourceResource = NULL; mMemorySize = 0; }
     virtual ~ResourceInstance() {}
 };
 
@@ -102,6 +118,86 @@ public:
 typedef ResourceInstance* (*RESOURCE_CREATE_FN)(Stream& stream);
 
 
+//------------------------------------------------------------------------------
+/// Handle for a resource that is being loaded in the background.
+///
+/// Returned by ResManager::loadAsync(). The file is read (and, for types
+/// registered as thread-safe, decoded) on the global ThreadPool; everything
+/// else happens on the main thread, so listeners of onLoaded are free to
+/// create textures or touch the scene.
+///
+/// @code
+///    ResourceLoadRequestRef req = ResourceManager->loadAsync(fileName);
+///    req->onLoaded.notify(this, &MyObject::onShapeLoaded);
+///
+///    void MyObject::onShapeLoaded(ResourceLoadRequest* req)
+///    {
+///       if (req->isLoaded())
+///          mShape = req->acquire();
+///    }
+/// @endcode
+///
+/// onLoaded is always triggered from ResManager::processLoadRequests(),
+/// never from inside loadAsync(), so it is safe to attach listeners after
+/// the request was made. The request holds a lock on the resource until
+/// the listeners have run.
+class ResourceLoadRequest : public RefBase
+{
+    friend class ResManager;
+    friend class ResourceLoadWorkItem;
+
+public:
+    enum Status
+    {
+        Pending,    ///< Queued or being read.
+        Loaded,     ///< Resource is loaded and mInstance is valid.
+        Failed,     ///< The file could not be read or decoded.
+    };
+
+private:
+    ResourceObject* mObject;
+    std::atomic<Status> mStatus;  ///< Set on the main thread, waitForLoad polls it from others.
+    bool            mComputeCRC;
+
+    /// The queued work item, for ResManager::waitForLoad to pull forward.
+    /// Only looked up in the pool's queue, never dereferenced.
+    ThreadPool::WorkItem* mWorkItem;
+    std::atomic<bool> mRead;      ///< Set by the worker once it is done with the file.
+
+    /// @name Worker Results
+    /// Filled in on the worker thread, consumed by the main thread.
+    /// @{
+
+    ///
+    ResourceInstance* mInstance;  ///< Decoded instance, if the type decodes off-thread.
+    U8*  mBuffer;                 ///< Raw file contents, if the type decodes on the main thread.
+    U32  mBufferSize;
+    U32  mCRC;
+    /// @}
+
+    ResourceLoadRequest(ResourceObject* obj, bool computeCRC);
+
+public:
+    ~ResourceLoadRequest();
+
+    /// Triggered on the main thread once the request is done.
+    Signal<ResourceLoadRequest*> onLoaded;
+
+    Status getStatus() const { return mStatus; }
+    bool isDone() const { return mStatus != Pending; }
+    bool isLoaded() const { return mStatus == Loaded; }
+
+    /// The resource's book-keeping object.
+    ResourceObject* getObject() const { return mObject; }
+
+    /// Returns the loaded resource with an extra lock, in the same way as
+    /// ResManager::load(). Assign it to a Resource<T> to keep it around.
+    ResourceObject* acquire();
+};
+
+typedef RefPtr<ResourceLoadRequest> ResourceLoadRequestRef;
+
+
 //------------------------------------------------------------------------------
 #define InvalidCRC 0xFFFFFFFF
 
@@ -157,6 +253,8 @@ public:
     S32 lockCount;                ///< Lock count; used to control load/unload of resource from memory.
     U32 crc;                      ///< CRC of resource.
 
+    ResourceLoadRequest* mLoadRequest; ///< Background load in flight for this resource, if any.
+
     ResourceObject();
     ~ResourceObject() { unlink(); }
 
@@ -281,6 +379,9 @@ class ResDictionary
     S32 hashTableSize;
     DataChunker memPool;
     dsize_t hash(StringTableEntry path, StringTableEntry name);
+
+    /// Bumped whenever any dictionary gains or loses an entry.
+    static U32 smGeneration;
     dsize_t hash(ResourceObject* obj) { return hash(obj->path, obj->name); }
     /// @}
 
@@ -309,6 +410,8 @@ public:
     void remove(ResourceObject* obj);
 
     void getHash(ResourceObject*** hash, U32* hashSize) { *hash = hashTable; *hashSize = hashTableSize; }
+
+    static U32 getGeneration() { return smGeneration; }
 };
 
 
@@ -330,6 +433,8 @@ public:
 /// @nosubgrouping
 class ResManager
 {
+    friend class ResourceLoadWorkItem;
+
 private:
     /// Path to which we will write data.
     ///
@@ -368,6 +473,7 @@ private:
     {
         StringTableEntry     mExtension;
         RESOURCE_CREATE_FN   mCreateFn;
+        bool                 mThreadSafe;  ///< mCreateFn may run on a worker thread.
         RegisteredExtension* next;
     };
 
@@ -377,10 +483,20 @@ private:
 
     RegisteredExtension* registeredList;
 
+    /// Background loads that have been queued but not delivered yet.
+    Vector<ResourceLoadRequestRef> mLoadRequests;
+
+    /// Finish a request whose worker has returned. Main thread only.
+    void finishLoadRequest(ResourceLoadRequest* request);
+
+    /// Run the listeners of a finished request and drop its lock. Main thread only.
+    void deliverLoadRequest(S32 index);
+
     static char* smExcludedDirectories;
     ResManager();
 public:
     RESOURCE_CREATE_FN getCreateFunction(const char* name);
+    bool isThreadSafeExtension(const char* name);
 
     ~ResManager();
     /// @name Global Control
@@ -406,7 +522,11 @@ public:
     void clearMissingFileList();                       ///< Clears the missing file list
 
     /// Tells the resource manager what to do with a resource that it loads
-    void registerExtension(const char* extension, RESOURCE_CREATE_FN create_fn);
+    ///
+    /// @param  threadSafe  Pass true if create_fn does not touch shared state, so
+    ///                     loadAsync() may run it on a worker thread. Otherwise only
+    ///                     the file read happens in the background.
+    void registerExtension(const char* extension, RESOURCE_CREATE_FN create_fn, bool threadSafe = false);
 
     S32 getSize(const char* filename);                 ///< Gets the size of the file
     const char* getFullPath(const char* filename, char* path, U32 pathLen);  ///< Gets the full path of the file
@@ -415,6 +535,31 @@ public:
     const char* getBasePath();                         ///< Gets the base path
 
     ResourceObject* load(const char* fileName, bool computeCRC = false);   ///< loads an instance of an object
+
+    /// @name Background Loading
+    /// @{
+
+    /// Start loading a resource on the global ThreadPool.
+    ///
+    /// Returns NULL if the file is unknown. If the resource is already loaded, or
+    /// a load for it is already in flight, the returned request simply completes
+    /// on the next call to processLoadRequests().
+    ResourceLoadRequestRef loadAsync(const char* fileName, bool computeCRC = false);
+
+    /// Deliver finished background loads. Called once per main loop iteration.
+    void processLoadRequests();
+
+    /// Block until the given request is done, and deliver it.
+    ///
+    /// Only this request is waited on; if no worker has picked it up yet it
+    /// is read on the calling thread.  On the main thread only this request
+    /// is delivered, other finished loads and their listeners are left for
+    /// processLoadRequests(); elsewhere delivery is left to the main loop.
+    void waitForLoad(ResourceLoadRequest* request);
+
+    /// Number of background loads that have not been delivered yet.
+    U32 getNumPendingLoads() const { return mLoadRequests.size(); }
+    /// @}
     Stream* openStream(const char* fileName);        ///< Opens a stream for an object
     Stream* openStream(ResourceObject* object);       ///< Opens a stream for an object
     void     closeStream(Stream* stream);              ///< Closes the stream
@@ -436,6 +581,12 @@ public:
     /// Searches the hash list for the filename and returns it's object if found, otherwise NULL
     ResourceObject* find(const char* fileName, U32 flags);
 
+    /// Changes whenever a resource is added to or removed from the dictionary,
+    /// by setModPaths(), a file found on disk, a purge and so on.  Anything
+    /// that caches find() results, misses included, should drop them when
+    /// this moves.
+    U32 getDictionaryGeneration() const { return ResDictionary::getGeneration(); }
+
     /// Finds a resource object with given expression
     ResourceObject* findMatch(const char* expression, const char** fn, ResourceObject* start = NULL);
 
@@ -5,6 +5,7 @@
 
 #include "platform/platform.h"
 #include "core/stringTable.h"
+#include "platform/platformMutex.h"
 
 _StringTable* StringTable = NULL;
 const U32 _StringTable::csm_stInitSize = 29;
@@ -71,11 +72,18 @@ _StringTable::_StringTable()
 
     numBuckets = csm_stInitSize;
     itemCount = 0;
+
+    // Build the hash table now, before any worker thread can race on it.
+    if (sgInitTable)
+        initTolowerTable();
+
+    mMutex = Mutex::createMutex();
 }
 
 //--------------------------------------
 _StringTable::~_StringTable()
 {
+    Mutex::destroyMutex(mMutex);
     dFree(buckets);
 }
 
@@ -100,6 +108,9 @@ void _StringTable::destroy()
 //--------------------------------------
 StringTableEntry _StringTable::insert(const char* val, const bool  caseSens)
 {
+    MutexHandle handle;
+    handle.lock(mMutex);
+
     Node** walk, * temp;
     U32 key = hashString(val);
     walk = &buckets[key % numBuckets];
@@ -138,6 +149,9 @@ StringTableEntry _StringTable::insertn(const char* src, S32 len, const bool  cas
 //--------------------------------------
 StringTableEntry _StringTable::lookup(const char* val, const bool  caseSens)
 {
+    MutexHandle handle;
+    handle.lock(mMutex);
+
     Node** walk, * temp;
     U32 key = hashString(val);
     walk = &buckets[key % numBuckets];
@@ -154,6 +168,9 @@ StringTableEntry _StringTable::lookup(const char* val, const bool  caseSens)
 //--------------------------------------
 StringTableEntry _StringTable::lookupn(const char* val, S32 len, const bool  caseSens)
 {
+    MutexHandle handle;
+    handle.lock(mMutex);
+
     Node** walk, * temp;
     U32 key = hashStringn(val, len);
     walk = &buckets[key % numBuckets];
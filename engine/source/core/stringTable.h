@@ -53,6 +53,9 @@
 ///  The scripting engine and the resource manager are the primary users of the
 ///  StringTable.
 ///
+/// insert() and lookup() take an internal lock, so resources decoded on worker
+/// threads (see ResManager::loadAsync) may add strings too.
+///
 /// @note Be aware that the StringTable NEVER DEALLOCATES memory, so be careful when you
 ///       add strings to it. If you carelessly add many strings, you will end up wasting
 ///       space.
@@ -73,6 +76,7 @@ private:
     U32         numBuckets;
     U32         itemCount;
     DataChunker mempool;
+    void*       mMutex;
 
 protected:
     static const U32 csm_stInitSize;
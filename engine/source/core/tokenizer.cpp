@@ -21,6 +21,7 @@ Tokenizer::Tokenizer()
 
     dMemset(mCurrTokenBuffer, 0, sizeof(mCurrTokenBuffer));
     mTokenIsCurrent = false;
+    mStrictQuotes = false;
 }
 
 Tokenizer::~Tokenizer()
@@ -175,9 +176,10 @@ bool Tokenizer::advanceToken(const bool crossLine, const bool assertAvail)
             if (c == '\"')
             {
                 // Quoted token
-                //AssertISV(currPosition == 0,
-                //          avar("Error, quotes MUST be at start of token.  Error: (%s: %d)",
-                //               getFileName(), getCurrentLine()));
+                if (mStrictQuotes)
+                    AssertISV(currPosition == 0,
+                        avar("Error, quotes MUST be at start of token.  Error: (%s: %d)",
+                            getFileName(), getCurrentLine()));
 
                 U32 startLine = getCurrentLine();
                 mCurrPos++;
@@ -230,8 +232,9 @@ bool Tokenizer::advanceToken(const bool crossLine, const bool assertAvail)
     if (assertAvail == true)
         AssertISV(currPosition != 0, avar("Error parsing: %s at or around line: %d", getFileName(), getCurrentLine()));
 
+    // the last token of a buffer without a trailing newline still counts
     if (mCurrPos == mBufferSize)
-        return false;
+        return mCurrTokenBuffer[0] != '\0';
 
     return currPosition != 0;
 }
@@ -34,6 +34,7 @@ private:
 
     char   mCurrTokenBuffer[MaxTokenSize + 1];
     bool   mTokenIsCurrent;
+    bool   mStrictQuotes;
 
 public:
     Tokenizer();
@@ -60,6 +61,10 @@ public:
     bool     reset();
 
     bool     endOfFile();
+
+    /// Treat a quote anywhere but at the start of a token as a fatal parse
+    /// error, as map2dif always has.  Off by default.
+    void     setStrictQuotes(const bool strict) { mStrictQuotes = strict; }
 };
 
 
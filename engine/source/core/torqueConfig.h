@@ -189,6 +189,23 @@
 /// available.
 #define TORQUE_DISABLE_MEMORY_MANAGER
 
+/// Define me to serve small allocations (up to 2k) from a size-class
+/// allocator instead. Each thread keeps its own cache of free blocks per size
+/// class, so allocating and freeing small objects neither searches the free
+/// tree nor contends on the memory manager's lock. Larger blocks still go to
+/// the memory manager, or to the system if it is disabled.
+///
+/// Ignored when TORQUE_DEBUG_GUARD is defined, so that guards and leak
+/// tracking keep working. Use memoryStressTest() to compare the backends;
+/// it and sizeClassMemoryDump() are only built with this defined.
+//#define TORQUE_SIZECLASS_ALLOCATOR
+
+/// Define me to charge every heap allocation to the MemoryTag that is active
+/// when it is made, so dumpMemoryTags() can break memory use down by
+/// subsystem (interiors, shapes, tick cache, console, ...). Costs 16 bytes
+/// per allocation and works with any of the allocators above.
+//#define TORQUE_MEMORY_TAGGING
+
 /// Define me if you want to enable debug guards in the memory manager.
 ///
 /// Debug guards are known values placed before and after every block of
@@ -239,6 +256,10 @@
 #define TORQUE_FRAME_SIZE     16 << 20
 #endif
 
+/// Size of the FrameAllocator arena of each thread other than the main one.
+/// Allocations beyond it fall back to the heap.
+#define TORQUE_FRAME_THREAD_SIZE  1 << 20
+
 /// Define if you want nVIDIA's NVPerfHUD to work with TSE
 #define TORQUE_NVPERFHUD
 
@@ -247,6 +268,12 @@
 // to be compiled each time.
 #define TORQUE_NO_DSO_GENERATION
 
+/// Define to have exec() compile scripts into a cache under the prefs path,
+/// named by a hash of their contents.  This is separate from
+/// TORQUE_NO_DSO_GENERATION, which only stops DSOs being written next to
+/// the scripts.
+#define TORQUE_SCRIPT_CACHE
+
 // Used to check internal GFX state, D3D/OGL states, etc.  
 //#define TORQUE_DEBUG_RENDER
 
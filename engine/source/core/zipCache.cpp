@@ -0,0 +1,370 @@
+//-----------------------------------------------------------------------------
+// Torque Game Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#include "zlib.h"
+#include "platform/platform.h"
+#include "platform/platformMutex.h"
+#include "platform/threadPool.h"
+#include "platform/profiler.h"
+#include "core/zipCache.h"
+#include "core/memstream.h"
+#include "core/resManager.h"
+#include "console/console.h"
+#include "console/consoleTypes.h"
+
+S32 ZipInflateCache::smMaxSizeKB = 32 * 1024;
+
+ZipInflateCache::Entry* ZipInflateCache::smHashTable[HashTableSize];
+ZipInflateCache::Entry* ZipInflateCache::smLRUHead = NULL;
+ZipInflateCache::Entry* ZipInflateCache::smLRUTail = NULL;
+U32 ZipInflateCache::smCachedBytes = 0;
+U32 ZipInflateCache::smOpenStreams = 0;
+bool ZipInflateCache::smDestroyed = false;
+void* ZipInflateCache::smMutex = NULL;
+ZipInflateCache::Stats ZipInflateCache::smStats;
+
+//------------------------------------------------------------------------------
+
+/// Memory stream over a cache entry; keeps the entry alive while open.
+class ZipInflateCache::CacheStream : public MemStream
+{
+    Entry* mEntry;
+
+public:
+    CacheStream(Entry* entry)
+        : MemStream(entry->size, entry->data, true, false)
+    {
+        mEntry = entry;
+    }
+
+    ~CacheStream()
+    {
+        ZipInflateCache::releaseEntry(mEntry);
+    }
+};
+
+//------------------------------------------------------------------------------
+
+void ZipInflateCache::init()
+{
+    smMutex = Mutex::createMutex();
+    smDestroyed = false;
+    dMemset(smHashTable, 0, sizeof(smHashTable));
+    dMemset(&smStats, 0, sizeof(smStats));
+
+    Con::addVariable("Pref::ResourceManager::zipCacheSize", TypeS32, &smMaxSizeKB);
+}
+
+void ZipInflateCache::destroy()
+{
+    if (!smMutex)
+        return;
+
+    flush();
+
+    // Streams still open release their entries through the lock, so it has
+    // to outlive them.  Stop caching and let the last one free it.
+    Mutex::lockMutex(smMutex);
+    bool streamsOpen = smOpenStreams != 0;
+    smDestroyed = true;
+    Mutex::unlockMutex(smMutex);
+
+    AssertWarn(!streamsOpen, "ZipInflateCache::destroy - streams still open on cached entries.");
+    if (!streamsOpen)
+    {
+        Mutex::destroyMutex(smMutex);
+        smMutex = NULL;
+    }
+}
+
+U32 ZipInflateCache::hashKey(StringTableEntry zipName, S32 fileOffset)
+{
+    return (U32(dsize_t(zipName) >> 2) ^ (U32(fileOffset) * 2654435761U)) % HashTableSize;
+}
+
+ZipInflateCache::Entry* ZipInflateCache::findEntry(ResourceObject* obj)
+{
+    for (Entry* walk = smHashTable[hashKey(obj->zipName, obj->fileOffset)]; walk; walk = walk->nextHash)
+        if (walk->zipName == obj->zipName && walk->zipPath == obj->zipPath && walk->fileOffset == obj->fileOffset)
+            return walk;
+    return NULL;
+}
+
+bool ZipInflateCache::canCache(U32 size)
+{
+    return smMutex && !smDestroyed && size && size <= U32(smMaxSizeKB) * 1024 / 4;
+}
+
+//------------------------------------------------------------------------------
+
+void ZipInflateCache::lruLink(Entry* entry)
+{
+    entry->lruPrev = NULL;
+    entry->lruNext = smLRUHead;
+    if (smLRUHead)
+        smLRUHead->lruPrev = entry;
+    else
+        smLRUTail = entry;
+    smLRUHead = entry;
+}
+
+void ZipInflateCache::lruUnlink(Entry* entry)
+{
+    if (entry->lruPrev)
+        entry->lruPrev->lruNext = entry->lruNext;
+    else
+        smLRUHead = entry->lruNext;
+    if (entry->lruNext)
+        entry->lruNext->lruPrev = entry->lruPrev;
+    else
+        smLRUTail = entry->lruPrev;
+    entry->lruPrev = entry->lruNext = NULL;
+}
+
+void ZipInflateCache::removeEntry(Entry* entry)
+{
+    Entry** walk = &smHashTable[hashKey(entry->zipName, entry->fileOffset)];
+    while (*walk != entry)
+        walk = &(*walk)->nextHash;
+    *walk = entry->nextHash;
+
+    lruUnlink(entry);
+    smCachedBytes -= entry->size;
+    entry->evicted = true;
+
+    // Drop the cache's own reference; open streams keep the data around.
+    if (--entry->refCount == 0)
+    {
+        delete[] entry->data;
+        delete entry;
+    }
+}
+
+void ZipInflateCache::releaseEntry(Entry* entry)
+{
+    Mutex::lockMutex(smMutex);
+    smOpenStreams--;
+    if (--entry->refCount == 0)
+    {
+        AssertFatal(entry->evicted, "ZipInflateCache::releaseEntry - releasing an entry still in the cache!");
+        delete[] entry->data;
+        delete entry;
+    }
+    bool lastAfterDestroy = smDestroyed && !smOpenStreams;
+    Mutex::unlockMutex(smMutex);
+
+    if (lastAfterDestroy)
+    {
+        Mutex::destroyMutex(smMutex);
+        smMutex = NULL;
+    }
+}
+
+void ZipInflateCache::makeRoom(U32 incoming)
+{
+    const U32 budget = U32(getMax(smMaxSizeKB, 0)) * 1024;
+    while (smLRUTail && smCachedBytes + incoming > budget)
+    {
+        removeEntry(smLRUTail);
+        smStats.evictions++;
+    }
+}
+
+Stream* ZipInflateCache::createStream(Entry* entry)
+{
+    // Called with the lock held.
+    entry->refCount++;
+    smOpenStreams++;
+    lruUnlink(entry);
+    lruLink(entry);
+    return new CacheStream(entry);
+}
+
+//------------------------------------------------------------------------------
+
+Stream* ZipInflateCache::openStream(ResourceObject* obj)
+{
+    if (!smMutex || smDestroyed)
+        return NULL;
+
+    Stream* ret = NULL;
+
+    Mutex::lockMutex(smMutex);
+    Entry* entry = findEntry(obj);
+    if (entry)
+    {
+        smStats.hits++;
+        ret = createStream(entry);
+    }
+    Mutex::unlockMutex(smMutex);
+
+    return ret;
+}
+
+Stream* ZipInflateCache::inflateEntry(ResourceObject* obj, Stream* compressed)
+{
+    PROFILE_START(ZipInflateCache_inflateEntry);
+    U32 startTime = Platform::getRealMilliseconds();
+
+    // Inflate the whole entry in one pass, outside the lock.
+    U8* input = new U8[obj->compressedFileSize];
+    U8* output = new U8[obj->fileSize];
+    bool ok = compressed->read(obj->compressedFileSize, input);
+
+    if (ok)
+    {
+        z_stream zs;
+        zs.zalloc = Z_NULL;
+        zs.zfree = Z_NULL;
+        zs.opaque = Z_NULL;
+        zs.next_in = input;
+        zs.avail_in = obj->compressedFileSize;
+        zs.next_out = output;
+        zs.avail_out = obj->fileSize;
+
+        inflateInit2(&zs, -MAX_WBITS);
+        ok = inflate(&zs, Z_FINISH) == Z_STREAM_END && zs.total_out == U32(obj->fileSize);
+        inflateEnd(&zs);
+    }
+    delete[] input;
+
+    if (!ok)
+    {
+        Con::errorf("ZipInflateCache::inflateEntry - failed to inflate '%s' from '%s/%s'.",
+            obj->name, obj->zipPath, obj->zipName);
+        delete[] output;
+        PROFILE_END();
+        return NULL;
+    }
+
+    Stream* ret;
+
+    Mutex::lockMutex(smMutex);
+
+    smStats.misses++;
+    smStats.inflatedMB += F64(obj->fileSize) / (1024.0 * 1024.0);
+    smStats.inflateMS += Platform::getRealMilliseconds() - startTime;
+
+    // Another thread may have beaten us to it.
+    Entry* entry = findEntry(obj);
+    if (entry)
+        delete[] output;
+    else
+    {
+        makeRoom(obj->fileSize);
+
+        entry = new Entry;
+        entry->zipPath = obj->zipPath;
+        entry->zipName = obj->zipName;
+        entry->fileOffset = obj->fileOffset;
+        entry->data = output;
+        entry->size = obj->fileSize;
+        entry->refCount = 1;
+        entry->evicted = false;
+        entry->lruPrev = entry->lruNext = NULL;
+
+        U32 index = hashKey(entry->zipName, entry->fileOffset);
+        entry->nextHash = smHashTable[index];
+        smHashTable[index] = entry;
+        lruLink(entry);
+
+        smCachedBytes += entry->size;
+        smStats.peakBytes = getMax(smStats.peakBytes, smCachedBytes);
+    }
+    ret = createStream(entry);
+
+    Mutex::unlockMutex(smMutex);
+
+    PROFILE_END();
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+
+/// Opens (and so inflates) a zip entry on a worker thread.
+class ZipPrefetchWorkItem : public ThreadPool::WorkItem
+{
+    ResourceObject* mObject;
+
+public:
+    ZipPrefetchWorkItem(ResourceObject* obj) { mObject = obj; }
+
+    void execute()
+    {
+        Stream* stream = ResourceManager->openStream(mObject);
+        if (stream)
+            ResourceManager->closeStream(stream);
+    }
+};
+
+void ZipInflateCache::prefetch(ResourceObject* obj)
+{
+    if (!(obj->flags & ResourceObject::VolumeBlock) || !canCache(obj->fileSize))
+        return;
+
+    Mutex::lockMutex(smMutex);
+    bool cached = findEntry(obj) != NULL;
+    if (!cached)
+        smStats.prefetches++;
+    Mutex::unlockMutex(smMutex);
+
+    if (!cached)
+        ThreadPool::getGlobal().queueWorkItem(new ZipPrefetchWorkItem(obj));
+}
+
+void ZipInflateCache::flush()
+{
+    if (!smMutex)
+        return;
+
+    Mutex::lockMutex(smMutex);
+    while (smLRUTail)
+        removeEntry(smLRUTail);
+    Mutex::unlockMutex(smMutex);
+}
+
+void ZipInflateCache::dumpStats()
+{
+    if (!smMutex)
+        return;
+
+    Mutex::lockMutex(smMutex);
+
+    U32 numEntries = 0;
+    for (Entry* walk = smLRUHead; walk; walk = walk->lruNext)
+        numEntries++;
+
+    U32 lookups = smStats.hits + smStats.misses;
+    Con::printf("Zip inflate cache: %d entries, %.2f of %.2f MB (peak %.2f MB)",
+        numEntries, F32(smCachedBytes) / (1024.0f * 1024.0f), F32(smMaxSizeKB) / 1024.0f,
+        F32(smStats.peakBytes) / (1024.0f * 1024.0f));
+    Con::printf("   %d hits, %d misses (%.1f%% hit rate), %d evictions, %d prefetches",
+        smStats.hits, smStats.misses, lookups ? 100.0f * smStats.hits / lookups : 0.0f,
+        smStats.evictions, smStats.prefetches);
+    Con::printf("   %.2f MB inflated in %d ms", F32(smStats.inflatedMB), smStats.inflateMS);
+
+    Mutex::unlockMutex(smMutex);
+}
+
+//------------------------------------------------------------------------------
+
+ConsoleFunction(flushZipCache, void, 1, 1, "Drop all inflated zip entries that aren't in use.")
+{
+    ZipInflateCache::flush();
+}
+
+ConsoleFunction(dumpZipCacheStats, void, 1, 1, "Print hit/miss statistics of the zip inflate cache.")
+{
+    ZipInflateCache::dumpStats();
+}
+
+ConsoleFunction(prefetchZipEntries, void, 2, 2, "(string pattern)"
+    "Inflate all zipped resources matching the pattern into the zip cache in the background.")
+{
+    const char* fileName;
+    for (ResourceObject* obj = ResourceManager->findMatch(argv[1], &fileName); obj;
+        obj = ResourceManager->findMatch(argv[1], &fileName, obj))
+        ZipInflateCache::prefetch(obj);
+}
@@ -0,0 +1,115 @@
+//-----------------------------------------------------------------------------
+// Torque Game Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#ifndef _ZIPCACHE_H_
+#define _ZIPCACHE_H_
+
+#ifndef _PLATFORM_H_
+#include "platform/platform.h"
+#endif
+
+class Stream;
+class ResourceObject;
+
+/// Cache of fully inflated zip entries.
+///
+/// ZipSubRStream inflates on demand and has to start over from the beginning
+/// of the entry whenever it seeks backwards, which resource loaders do a lot
+/// (CRC pass, header probing). Deflated entries that fit the budget are instead
+/// inflated in one go into a buffer held by this cache, and handed out as
+/// memory streams. Buffers are shared between open streams and evicted least
+/// recently used first once the budget is exceeded.
+///
+/// The budget is set with $pref::ResourceManager::zipCacheSize (in KB, zero
+/// disables the cache). Entries bigger than a quarter of the budget stream
+/// through ZipSubRStream as before.
+///
+/// All methods are safe to call from loader threads.
+class ZipInflateCache
+{
+    struct Entry
+    {
+        StringTableEntry zipPath;  ///< Key: the archive...
+        StringTableEntry zipName;
+        S32 fileOffset;            ///< ...and the entry's offset in it.
+
+        U8* data;
+        U32 size;
+
+        U32 refCount;              ///< Open streams plus one while cached.
+        bool evicted;
+
+        Entry* nextHash;
+        Entry* lruPrev;            ///< Towards most recently used.
+        Entry* lruNext;            ///< Towards least recently used.
+    };
+
+    class CacheStream;
+    friend class CacheStream;
+
+    enum { HashTableSize = 256 };
+
+    static Entry* smHashTable[HashTableSize];
+    static Entry* smLRUHead;
+    static Entry* smLRUTail;
+    static U32    smCachedBytes;
+    static U32    smOpenStreams;
+    static bool   smDestroyed;     ///< destroy() ran with streams open, the last one frees smMutex.
+    static void*  smMutex;
+
+    struct Stats
+    {
+        U32 hits;
+        U32 misses;
+        U32 evictions;
+        U32 prefetches;
+        U32 peakBytes;
+        F64 inflatedMB;
+        U32 inflateMS;
+    };
+    static Stats smStats;
+
+    static U32 hashKey(StringTableEntry zipName, S32 fileOffset);
+    static Entry* findEntry(ResourceObject* obj);
+
+    static void lruLink(Entry* entry);
+    static void lruUnlink(Entry* entry);
+    static void removeEntry(Entry* entry);
+    static void releaseEntry(Entry* entry);
+
+    /// Evict until 'incoming' more bytes fit the budget. Called with the lock held.
+    static void makeRoom(U32 incoming);
+
+    static Stream* createStream(Entry* entry);
+
+public:
+    static S32 smMaxSizeKB;
+
+    static void init();
+    static void destroy();
+
+    /// Is an entry of this (uncompressed) size worth caching?
+    static bool canCache(U32 size);
+
+    /// Return a stream over the cached contents of a deflated zip entry,
+    /// or NULL if it isn't cached.
+    static Stream* openStream(ResourceObject* obj);
+
+    /// Inflate a whole entry from 'compressed', which must be positioned at the
+    /// start of the entry's deflated data, and return a stream over the result.
+    ///
+    /// The stream is not taken over. Returns NULL if inflation fails.
+    static Stream* inflateEntry(ResourceObject* obj, Stream* compressed);
+
+    /// Inflate an entry into the cache on the global ThreadPool.
+    static void prefetch(ResourceObject* obj);
+
+    /// Drop everything that isn't in use.
+    static void flush();
+
+    static void dumpStats();
+};
+
+#endif // _ZIPCACHE_H_
@@ -0,0 +1,220 @@
+//-----------------------------------------------------------------------------
+// Torque Game Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "platform/platformThread.h"
+#include "console/console.h"
+#include "core/resManager.h"
+#include "core/memstream.h"
+#include "core/crc.h"
+#include "gfx/gBitmap.h"
+#include "ts/tsShape.h"
+#include "interior/interiorRes.h"
+
+//-----------------------------------------------------------------------------
+// Parallel decode stress test
+//
+// Decodes every resource under a path whose type is registered thread-safe
+// (see ResManager::registerExtension) on several threads at once, and checks
+// each result against a decode of the same file on the main thread.  Each
+// thread starts at a different file so different decoders overlap.
+
+namespace
+{
+    /// Write only stream that keeps a CRC of what is written to it.
+    class CRCStream : public Stream
+    {
+        U32 mCRC;
+        U32 mPosition;
+
+    protected:
+        bool _read(const U32, void*) { return false; }
+        bool _write(const U32 numBytes, const void* buffer)
+        {
+            mCRC = calculateCRC(buffer, numBytes, mCRC);
+            mPosition += numBytes;
+            return true;
+        }
+
+    public:
+        CRCStream() { mCRC = INITIAL_CRC_VALUE; mPosition = 0; setStatus(Ok); }
+
+        bool hasCapability(const Capability cap) const { return cap == StreamWrite; }
+        U32 getPosition() const { return mPosition; }
+        bool setPosition(const U32) { return false; }
+        U32 getStreamSize() { return mPosition; }
+
+        U32 getCRC() const { return mCRC; }
+    };
+
+    /// Sums up a decoded resource, by writing it back out where the type can.
+    U32 fingerprintInstance(ResourceInstance* inst)
+    {
+        CRCStream stream;
+        if (GBitmap* bmp = dynamic_cast<GBitmap*>(inst))
+        {
+            stream.write(bmp->getWidth());
+            stream.write(bmp->getHeight());
+            stream.write(U32(bmp->getFormat()));
+            stream.write(bmp->byteSize, bmp->getBits());
+        }
+        else if (TSShape* shape = dynamic_cast<TSShape*>(inst))
+            shape->write(&stream);
+        else if (InteriorResource* interior = dynamic_cast<InteriorResource*>(inst))
+            interior->write(stream);
+
+        return stream.getCRC();
+    }
+
+    struct DecodeFile
+    {
+        ResourceObject* obj;
+        RESOURCE_CREATE_FN create;
+        U8* data;
+        U32 size;
+        U32 crc;
+    };
+
+    struct DecodeThreadData
+    {
+        const Vector<DecodeFile>* files;
+        U32 start;
+        U32 passes;
+        U32 decoded;
+        U32 mismatches;
+        U32 failures;
+    };
+
+    void decodeThread(void* arg)
+    {
+        DecodeThreadData* data = (DecodeThreadData*)arg;
+        const Vector<DecodeFile>& files = *data->files;
+
+        for (U32 pass = 0; pass < data->passes; pass++)
+        {
+            for (S32 i = 0; i < files.size(); i++)
+            {
+                const DecodeFile& file = files[(data->start + i) % files.size()];
+
+                MemStream stream(file.size, file.data, true, false);
+                ResourceInstance* inst = file.create(stream);
+                if (!inst)
+                {
+                    data->failures++;
+                    continue;
+                }
+
+                if (fingerprintInstance(inst) != file.crc)
+                    data->mismatches++;
+                data->decoded++;
+                delete inst;
+            }
+        }
+    }
+}
+
+ConsoleFunction(decodeStressTest, void, 1, 4, "([string path, int numThreads, int passes]) "
+    "Decode the thread-safe resources under path (marble/data by default) on several "
+    "threads at once and compare the results with a single threaded decode.")
+{
+    const char* path = argc > 1 ? argv[1] : "marble/data";
+    U32 numThreads = argc > 2 ? getMax(dAtoi(argv[2]), 1) : getMax(Platform::SystemInfo.processor.numCores, U32(2));
+    U32 passes = argc > 3 ? getMax(dAtoi(argv[3]), 1) : 2;
+    U32 pathLen = dStrlen(path);
+
+    // Find the files first, reading them could disturb the traversal.
+    Vector<ResourceObject*> objects;
+    ResourceManager->startResourceTraverse();
+    while (ResourceObject* obj = ResourceManager->getNextResource())
+    {
+        if (!obj->path || dStrnicmp(obj->path, path, pathLen) || (obj->path[pathLen] && obj->path[pathLen] != '/'))
+            continue;
+        if (ResourceManager->isThreadSafeExtension(obj->name))
+            objects.push_back(obj);
+    }
+
+    // Pull each file into memory and decode it once here for reference.
+    Vector<DecodeFile> files;
+    U32 totalBytes = 0;
+    U32 startTime = Platform::getRealMilliseconds();
+    for (S32 i = 0; i < objects.size(); i++)
+    {
+        Stream* stream = ResourceManager->openStream(objects[i]);
+        if (!stream)
+            continue;
+
+        DecodeFile file;
+        file.obj = objects[i];
+        file.create = ResourceManager->getCreateFunction(file.obj->name);
+        file.size = stream->getStreamSize();
+        file.data = new U8[file.size];
+        stream->read(file.size, file.data);
+        ResourceManager->closeStream(stream);
+
+        MemStream memStream(file.size, file.data, true, false);
+        ResourceInstance* inst = file.create ? file.create(memStream) : NULL;
+        if (!inst)
+        {
+            Con::warnf("decodeStressTest: couldn't decode '%s/%s', skipping it.", file.obj->path, file.obj->name);
+            delete[] file.data;
+            continue;
+        }
+
+        file.crc = fingerprintInstance(inst);
+        delete inst;
+
+        files.push_back(file);
+        totalBytes += file.size;
+    }
+    U32 serialTime = Platform::getRealMilliseconds() - startTime;
+
+    if (!files.size())
+    {
+        Con::errorf("decodeStressTest: no thread-safe resources under '%s'.", path);
+        return;
+    }
+
+    Con::printf("Decode stress test: %d files, %.1f MB, %d thread(s), %d passes",
+        files.size(), totalBytes / 1048576.0f, numThreads, passes);
+    Con::printf("   serial    %6d ms for one pass", serialTime);
+
+    DecodeThreadData* data = new DecodeThreadData[numThreads];
+    Thread** threads = new Thread * [numThreads];
+
+    startTime = Platform::getRealMilliseconds();
+    for (U32 i = 0; i < numThreads; i++)
+    {
+        data[i].files = &files;
+        data[i].start = i * files.size() / numThreads;
+        data[i].passes = passes;
+        data[i].decoded = 0;
+        data[i].mismatches = 0;
+        data[i].failures = 0;
+        threads[i] = new Thread(decodeThread, &data[i], true);
+    }
+    for (U32 i = 0; i < numThreads; i++)
+        delete threads[i];
+    U32 parallelTime = getMax(Platform::getRealMilliseconds() - startTime, U32(1));
+
+    U32 decoded = 0, mismatches = 0, failures = 0;
+    for (U32 i = 0; i < numThreads; i++)
+    {
+        decoded += data[i].decoded;
+        mismatches += data[i].mismatches;
+        failures += data[i].failures;
+    }
+
+    Con::printf("   parallel  %6d ms for %d decodes, %.1f ms per pass",
+        parallelTime, decoded, F32(parallelTime) / passes);
+    if (mismatches || failures)
+        Con::errorf("   FAILED: %d decodes differed from the serial result, %d failed", mismatches, failures);
+    else
+        Con::printf("   every decode matched the serial result");
+
+    delete[] threads;
+    delete[] data;
+    for (S32 i = 0; i < files.size(); i++)
+        delete[] files[i].data;
+}
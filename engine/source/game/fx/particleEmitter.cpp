@@ -4,6 +4,7 @@
 //-----------------------------------------------------------------------------
 
 #include "particleEmitter.h"
+#include "particleManager.h"
 #include "sceneGraph/sceneGraph.h"
 #include "sceneGraph/sceneState.h"
 #include "console/consoleTypes.h"
@@ -13,8 +14,10 @@
 #include "gfx/primBuilder.h"
 #include "renderInstance/renderInstMgr.h"
 #include "game/gameProcess.h"
+#include "platform/memoryTag.h"
 
 static ParticleEmitterData gDefaultEmitterData;
+static MemoryTag sParticleBufferMemoryTag("ParticleVertexBuffers");
 Point3F ParticleEmitter::mWindVelocity(0.0, 0.0, 0.0);
 
 IMPLEMENT_CO_DATABLOCK_V1(ParticleEmitterData);
@@ -84,6 +87,14 @@ void ParticleEmitterData::initPersistFields()
     addField("useEmitterColors", TypeBool, Offset(useEmitterColors, ParticleEmitterData));
 }
 
+//-----------------------------------------------------------------------------
+// consoleInit
+//-----------------------------------------------------------------------------
+void ParticleEmitterData::consoleInit()
+{
+    Con::addVariable("$pref::Particles::batch", TypeBool, &ParticleManager::smBatchParticles);
+}
+
 //-----------------------------------------------------------------------------
 // packData
 //-----------------------------------------------------------------------------
@@ -338,7 +349,6 @@ ParticleEmitter::ParticleEmitter()
     mLifetimeMS = 0;
     mElapsedTimeMS = 0;
 
-    mLastPartIndex = 0;
     mCurBuffSize = 0;
 
     mDead = false;
@@ -350,6 +360,8 @@ ParticleEmitter::ParticleEmitter()
 ParticleEmitter::~ParticleEmitter()
 {
     //   AssertFatal(mParticleListHead == NULL, "Error, particles remain in emitter after remove?");
+
+    sParticleBufferMemoryTag.removeExternal(mCurBuffSize * 4 * sizeof(GFXVertexPCT));
 }
 
 //-----------------------------------------------------------------------------
@@ -368,7 +380,7 @@ bool ParticleEmitter::onAdd()
         mLifetimeMS += S32(gRandGen.randI() % (2 * mDataBlock->lifetimeVarianceMS + 1)) - S32(mDataBlock->lifetimeVarianceMS);
     }
 
-    mPartList.setSize(mDataBlock->partListInitSize);
+    mParticles.setCapacity(mDataBlock->partListInitSize);
 
     F32 radius = 5.0;
     mObjBox.min = Point3F(-radius, -radius, -radius);
@@ -408,14 +420,18 @@ ColorF ParticleEmitter::getCollectiveColor()
     U32 count = 0;
     ColorF color = ColorF(0.0f, 0.0f, 0.0f);
 
-    U32 numpart = getMin(mLastPartIndex, (mPartList.size() - 1));
+    U32 numpart = getMin(mParticles.size(), (mParticles.getCapacity() - 1));
 
     //if(numpart <= 0)
     //	Con::printf("NumParts: %f", numpart);
 
+    const F32* red = mParticles.field(ParticleList::Red);
+    const F32* green = mParticles.field(ParticleList::Green);
+    const F32* blue = mParticles.field(ParticleList::Blue);
+    const F32* alpha = mParticles.field(ParticleList::Alpha);
     for (U32 i = 0; i < numpart; i++)
     {
-        color += mPartList[i].color;
+        color += ColorF(red[i], green[i], blue[i], alpha[i]);
         count++;
     }
 
@@ -443,7 +459,10 @@ bool ParticleEmitter::prepRenderImage(SceneState* state, const U32 stateKey,
     //  don't need to return a specialized RenderImage...
     if (state->isObjectRendered(this))
     {
-        prepBatchRender(state->getCameraPosition());
+        if (ParticleManager::smBatchParticles)
+            gParticleManager.addEmitter(this, state->getCameraPosition());
+        else
+            prepBatchRender(state->getCameraPosition());
     }
 
     return false;
@@ -454,7 +473,7 @@ bool ParticleEmitter::prepRenderImage(SceneState* state, const U32 stateKey,
 //-----------------------------------------------------------------------------
 void ParticleEmitter::prepBatchRender(const Point3F& camPos)
 {
-    if (mLastPartIndex == 0) return;
+    if (mParticles.size() == 0) return;
     if (mDead) return;
 
     copyToVB(camPos);
@@ -472,10 +491,10 @@ void ParticleEmitter::prepBatchRender(const Point3F& camPos)
     ri->worldXform = gRenderInstManager.allocXform();
     MatrixF world = GFX->getWorldMatrix();
     *ri->worldXform = world;
-    ri->primBuffIndex = mLastPartIndex;
-    ri->transFlags = mPartList[0].dataBlock->useInvAlpha;
+    ri->primBuffIndex = mParticles.size();
+    ri->transFlags = mDataBlock->particleDataBlock->useInvAlpha;
 
-    ri->miscTex = &*(mPartList[0].dataBlock->textureList[0]);
+    ri->miscTex = &*(mDataBlock->particleDataBlock->textureList[0]);
 
     gRenderInstManager.addInst(ri);
 
@@ -646,7 +665,7 @@ void ParticleEmitter::emitParticles(const Point3F& start,
         updateBBox();
 
 
-    if (mLastPartIndex && mSceneManager == NULL)
+    if (mParticles.size() && mSceneManager == NULL)
     {
         getCurrentClientSceneGraph()->addObjectToScene(this);
         getCurrentClientContainer()->addObject(this);
@@ -717,7 +736,7 @@ void ParticleEmitter::emitParticles(const Point3F& rCenter,
     resetWorldBox();
 
     // Make sure we're part of the world
-    if (mLastPartIndex && mSceneManager == NULL)
+    if (mParticles.size() && mSceneManager == NULL)
     {
         getCurrentClientSceneGraph()->addObjectToScene(this);
         getCurrentClientContainer()->addObject(this);
@@ -732,15 +751,8 @@ void ParticleEmitter::emitParticles(const Point3F& rCenter,
 //-----------------------------------------------------------------------------
 void ParticleEmitter::updateBBox()
 {
-    Point3F min(1e10, 1e10, 1e10);
-    Point3F max(-1e10, -1e10, -1e10);
-
-    for (U32 i = 0; i < mLastPartIndex; i++)
-    {
-        Particle* part = &mPartList[i];
-        min.setMin(part->pos);
-        max.setMax(part->pos);
-    }
+    Point3F min, max;
+    mParticles.getBounds(&min, &max);
 
     mObjBox = Box3F(min, max);
     MatrixF temp = getTransform();
@@ -755,18 +767,19 @@ void ParticleEmitter::addParticle(const Point3F& pos,
     const Point3F& vel,
     const Point3F& axisx)
 {
-    mLastPartIndex++;
+    S32 newCount = mParticles.size() + 1;
 
     // ARGGH, need to fix this - can get large numbers of particle to draw when dt is high?
 
-    if (mLastPartIndex > mPartList.size() || mLastPartIndex > mDataBlock->partListInitSize)
+    if (newCount > mParticles.getCapacity() || newCount > mDataBlock->partListInitSize)
     {
-        mPartList.setSize(mPartList.size() + 16);
+        mParticles.setCapacity(mParticles.getCapacity() + 16);
 
-        mDataBlock->allocPrimBuffer(mLastPartIndex + 16); // allocate larger primitive buffer or will crash
+        mDataBlock->allocPrimBuffer(newCount + 16); // allocate larger primitive buffer or will crash
     }
 
-    Particle* pNew = &mPartList[mLastPartIndex - 1];
+    Particle part;
+    Particle* pNew = &part;
 
     Point3F ejectionAxis = axis;
     F32 theta = (mDataBlock->thetaMax - mDataBlock->thetaMin) * gRandGen.randF() +
@@ -794,10 +807,15 @@ void ParticleEmitter::addParticle(const Point3F& pos,
     pNew->orientDir = ejectionAxis;
     pNew->acc.set(0, 0, 0);
     pNew->currentAge = 0;
+    pNew->color.set(0, 0, 0, 0);
+    pNew->size = 0;
 
     mDataBlock->particleDataBlock->initializeParticle(pNew, vel);
-    updateKeyData(pNew);
+    mParticles.push(part);
 
+    ParticleKeys keys;
+    getKeys(&keys);
+    mParticles.updateKeys(keys, mParticles.size() - 1);
 }
 
 
@@ -832,73 +850,32 @@ void ParticleEmitter::advanceTime(F32 dt)
     U32 numMSToUpdate = (U32)(dt * 1000.0f);
     if (numMSToUpdate == 0) return;
 
-    // remove dead particles
-    for (U32 i = 0; i < mLastPartIndex; i++)
-    {
-        Particle* part = &mPartList[i];
-        part->currentAge += numMSToUpdate;
-        if (part->currentAge > part->totalLifetime)
-        {
-            *part = mPartList[mLastPartIndex - 1];
-            mLastPartIndex--;
-        }
-    }
-
+    // age and remove dead particles
+    mParticles.advanceAges(numMSToUpdate);
 
-    if (mLastPartIndex <= 0 && mDeleteWhenEmpty)
+    if (mParticles.size() <= 0 && mDeleteWhenEmpty)
     {
         mDeleteOnTick = true;
         return;
     }
 
-    if (numMSToUpdate != 0 && mLastPartIndex > 0)
+    if (numMSToUpdate != 0 && mParticles.size() > 0)
     {
         update(numMSToUpdate);
     }
 }
 
 //-----------------------------------------------------------------------------
-// Update key related particle data
+// Gather color and size keys
 //-----------------------------------------------------------------------------
-void ParticleEmitter::updateKeyData(Particle* part)
+void ParticleEmitter::getKeys(ParticleKeys* keys) const
 {
-    F32 t = F32(part->currentAge) / F32(part->totalLifetime);
-    AssertFatal(t <= 1.0f, "Out out bounds filter function for particle.");
-
-    for (U32 i = 1; i < ParticleData::PDC_NUM_KEYS; i++)
+    const ParticleData* data = mDataBlock->particleDataBlock;
+    for (U32 i = 0; i < ParticleData::PDC_NUM_KEYS; i++)
     {
-        if (part->dataBlock->times[i] >= t)
-        {
-            F32 firstPart = t - part->dataBlock->times[i - 1];
-            F32 total = part->dataBlock->times[i] -
-                part->dataBlock->times[i - 1];
-
-            firstPart /= total;
-
-            if (mDataBlock->useEmitterColors)
-            {
-                part->color.interpolate(colors[i - 1], colors[i], firstPart);
-            }
-            else
-            {
-                part->color.interpolate(part->dataBlock->colors[i - 1],
-                    part->dataBlock->colors[i],
-                    firstPart);
-            }
-
-            if (mDataBlock->useEmitterSizes)
-            {
-                part->size = (sizes[i - 1] * (1.0 - firstPart)) +
-                    (sizes[i] * firstPart);
-            }
-            else
-            {
-                part->size = (part->dataBlock->sizes[i - 1] * (1.0 - firstPart)) +
-                    (part->dataBlock->sizes[i] * firstPart);
-            }
-            break;
-
-        }
+        keys->times[i] = data->times[i];
+        keys->colors[i] = mDataBlock->useEmitterColors ? colors[i] : data->colors[i];
+        keys->sizes[i] = mDataBlock->useEmitterSizes ? sizes[i] : data->sizes[i];
     }
 }
 
@@ -907,24 +884,17 @@ void ParticleEmitter::updateKeyData(Particle* part)
 //-----------------------------------------------------------------------------
 void ParticleEmitter::update(U32 ms)
 {
+    const ParticleData* data = mDataBlock->particleDataBlock;
+    F32 t = F32(ms) / 1000.0;
 
-    for (U32 i = 0; i < mLastPartIndex; i++)
-    {
-        Particle* part = &mPartList[i];
-
-        F32 t = F32(ms) / 1000.0;
-
-        Point3F a = part->acc;
-        a -= part->vel * part->dataBlock->dragCoefficient;
-        a -= mWindVelocity * part->dataBlock->windCoefficient;
-        a += Point3F(0, 0, -9.81) * part->dataBlock->gravityCoefficient;
-
-        part->vel += a * t;
-        part->pos += part->vel * t;
-
-        updateKeyData(part);
-    }
+    mParticles.integrate(t,
+        mWindVelocity * data->windCoefficient,
+        Point3F(0, 0, -9.81) * data->gravityCoefficient,
+        data->dragCoefficient);
 
+    ParticleKeys keys;
+    getKeys(&keys);
+    mParticles.updateKeys(keys);
 }
 
 //-----------------------------------------------------------------------------
@@ -932,152 +902,261 @@ void ParticleEmitter::update(U32 ms)
 //-----------------------------------------------------------------------------
 void ParticleEmitter::copyToVB(const Point3F& camPos)
 {
-    Particle* partPtr = mPartList.address();
+    S32 count = mParticles.size();
 
     static Vector<GFXVertexPCT> tempBuff(2048);
-    tempBuff.reserve(mLastPartIndex * 4 + 64); // make sure tempBuff is big enough
-    GFXVertexPCT* buffPtr = tempBuff.address(); // use direct pointer (faster)
+    tempBuff.reserve(count * 4 + 64); // make sure tempBuff is big enough
 
     if (mDataBlock->orientParticles)
     {
-        for (U32 i = 0; i < mLastPartIndex; i++, partPtr++, buffPtr += 4)
-        {
-            setupOriented(partPtr, camPos, buffPtr);
-        }
+        mParticles.fillOriented(camPos, mDataBlock->orientOnVelocity, tempBuff.address());
     }
     else
     {
-        // somewhat odd ordering so that texture coordinates match the oriented
-        // particles
-        Point3F basePoints[4];
-        basePoints[0] = Point3F(-1.0, 0.0, 1.0);
-        basePoints[1] = Point3F(-1.0, 0.0, -1.0);
-        basePoints[2] = Point3F(1.0, 0.0, -1.0);
-        basePoints[3] = Point3F(1.0, 0.0, 1.0);
-
         MatrixF camView = GFX->getWorldMatrix();
         camView.transpose();  // inverse - this gets the particles facing camera
 
-        for (U32 i = 0; i < mLastPartIndex; i++, partPtr++, buffPtr += 4)
-        {
-            setupBillboard(partPtr, basePoints, camView, buffPtr);
-        }
+        mParticles.fillBillboards(camView, tempBuff.address());
     }
 
     // create new VB if emitter size grows
-    if (!mVertBuff || mLastPartIndex > mCurBuffSize)
+    if (!mVertBuff || count > mCurBuffSize)
     {
-        mCurBuffSize = mLastPartIndex;
-        mVertBuff.set(GFX, mLastPartIndex * 4, GFXBufferTypeDynamic);
+        sParticleBufferMemoryTag.removeExternal(mCurBuffSize * 4 * sizeof(GFXVertexPCT));
+        mCurBuffSize = count;
+        mVertBuff.set(GFX, count * 4, GFXBufferTypeDynamic);
+        sParticleBufferMemoryTag.addExternal(mCurBuffSize * 4 * sizeof(GFXVertexPCT));
     }
     // lock and copy tempBuff to video RAM
     GFXVertexPCT* verts = mVertBuff.lock();
-    dMemcpy(verts, tempBuff.address(), mLastPartIndex * 4 * sizeof(GFXVertexPCT));
+    dMemcpy(verts, tempBuff.address(), count * 4 * sizeof(GFXVertexPCT));
     mVertBuff.unlock();
-
 }
 
 //-----------------------------------------------------------------------------
-// Set up particle for billboard style render
+// Particle benchmark
+//
+// Runs particles for every loaded ParticleEmitterData through ParticleList and
+// through the one particle at a time code the emitter used before it, and
+// reports the time for each and how far apart the results end up.
 //-----------------------------------------------------------------------------
-void ParticleEmitter::setupBillboard(Particle* part,
-    Point3F* basePts,
-    MatrixF camView,
-    GFXVertexPCT* lVerts)
+namespace
 {
-    const F32 spinFactor = (1.0 / 1000.0) * (1.0 / 360.0) * M_PI * 2.0;
-
-    F32 width = part->size * 0.5;
-    F32 spinAngle = part->spinSpeed * part->currentAge * spinFactor;
-
-    F32 sy, cy;
-    mSinCos(spinAngle, sy, cy);
-
-    // fill four verts, use macro and unroll loop
-#define fillVert(){ \
-      lVerts->point.x = cy * basePts->x - sy * basePts->z;  \
-      lVerts->point.y = 0.0;                                \
-      lVerts->point.z = sy * basePts->x + cy * basePts->z;  \
-      camView.mulV( lVerts->point );                        \
-      lVerts->point *= width;                               \
-      lVerts->point += part->pos;                           \
-      lVerts->color = part->color; }                        \
-
-
-    fillVert();
-    lVerts->texCoord.set(0.0, 0.0);
-    ++lVerts;
-    ++basePts;
-
-    fillVert();
-    lVerts->texCoord.set(0.0, 1.0);
-    ++lVerts;
-    ++basePts;
-
-    fillVert();
-    lVerts->texCoord.set(1.0, 1.0);
-    ++lVerts;
-    ++basePts;
-
-    fillVert();
-    lVerts->texCoord.set(1.0, 0.0);
-    ++lVerts;
-    ++basePts;
-}
+    void referenceUpdate(Particle* part, U32 ms, const ParticleKeys& keys, const Point3F& wind)
+    {
+        part->currentAge += ms;
 
-//-----------------------------------------------------------------------------
-// Set up oriented particle
-//-----------------------------------------------------------------------------
-void ParticleEmitter::setupOriented(Particle* part,
-    const Point3F& camPos,
-    GFXVertexPCT* lVerts)
-{
-    Point3F dir;
+        F32 t = F32(ms) / 1000.0;
+        Point3F a = part->acc;
+        a -= part->vel * part->dataBlock->dragCoefficient;
+        a -= wind * part->dataBlock->windCoefficient;
+        a += Point3F(0, 0, -9.81) * part->dataBlock->gravityCoefficient;
+        part->vel += a * t;
+        part->pos += part->vel * t;
 
-    if (mDataBlock->orientOnVelocity)
+        F32 k = F32(part->currentAge) / F32(part->totalLifetime);
+        for (U32 i = 1; i < ParticleData::PDC_NUM_KEYS; i++)
+        {
+            if (keys.times[i] >= k)
+            {
+                F32 firstPart = (k - keys.times[i - 1]) / (keys.times[i] - keys.times[i - 1]);
+                part->color.interpolate(keys.colors[i - 1], keys.colors[i], firstPart);
+                part->size = (keys.sizes[i - 1] * (1.0 - firstPart)) + (keys.sizes[i] * firstPart);
+                break;
+            }
+        }
+    }
+
+    void referenceBillboard(const Particle* part, const Point3F* basePts, MatrixF camView, GFXVertexPCT* lVerts)
     {
-        // don't render oriented particle if it has no velocity
-        if (part->vel.magnitudeSafe() == 0.0) return;
-        dir = part->vel;
+        const F32 spinFactor = (1.0 / 1000.0) * (1.0 / 360.0) * M_PI * 2.0;
+        static const Point2F texCoords[4] = { Point2F(0, 0), Point2F(0, 1), Point2F(1, 1), Point2F(1, 0) };
+
+        F32 width = part->size * 0.5;
+        F32 spinAngle = part->spinSpeed * part->currentAge * spinFactor;
+        F32 sy, cy;
+        mSinCos(spinAngle, sy, cy);
+
+        for (S32 i = 0; i < 4; i++, lVerts++, basePts++)
+        {
+            lVerts->point.x = cy * basePts->x - sy * basePts->z;
+            lVerts->point.y = 0.0;
+            lVerts->point.z = sy * basePts->x + cy * basePts->z;
+            camView.mulV(lVerts->point);
+            lVerts->point *= width;
+            lVerts->point += part->pos;
+            lVerts->color = part->color;
+            lVerts->texCoord = texCoords[i];
+        }
     }
-    else
+
+    void referenceOriented(const Particle* part, const Point3F& camPos, bool orientOnVelocity, GFXVertexPCT* lVerts)
     {
-        dir = part->orientDir;
+        Point3F dir = orientOnVelocity ? part->vel : part->orientDir;
+
+        // the old code left whatever was in the buffer, ParticleList collapses the quad
+        if (orientOnVelocity && dir.isZero())
+        {
+            for (S32 i = 0; i < 4; i++)
+                lVerts[i].point = part->pos;
+            return;
+        }
+
+        Point3F dirFromCam = part->pos - camPos;
+        Point3F crossDir;
+        mCross(dirFromCam, dir, &crossDir);
+        crossDir.normalize();
+        dir.normalize();
+
+        F32 width = part->size * 0.5;
+        dir *= width;
+        crossDir *= width;
+        Point3F start = part->pos - dir;
+        Point3F end = part->pos + dir;
+
+        lVerts[0].point = start + crossDir;
+        lVerts[1].point = start - crossDir;
+        lVerts[2].point = end - crossDir;
+        lVerts[3].point = end + crossDir;
     }
+}
 
-    Point3F dirFromCam = part->pos - camPos;
-    Point3F crossDir;
-    mCross(dirFromCam, dir, &crossDir);
-    crossDir.normalize();
-    dir.normalize();
+ConsoleFunction(benchmarkParticles, void, 1, 3, "([int count, int frames]) "
+    "Time count particles of each loaded ParticleEmitterData through the ParticleList passes "
+    "and the old per particle code, and check they agree.")
+{
+    S32 count = argc > 1 ? getMax(dAtoi(argv[1]), 1) : 1000;
+    S32 frames = argc > 2 ? getMax(dAtoi(argv[2]), 1) : 100;
+    const U32 ms = 16;
+    const F32 dt = F32(ms) / 1000.0;
+
+    MatrixF camView(EulerF(0.3f, 0.2f, 0.9f));
+    Point3F camPos(0.0f, -10.0f, 2.0f);
+    Point3F wind(1.0f, 0.5f, 0.0f);
+
+    Point3F basePoints[4];
+    basePoints[0] = Point3F(-1.0, 0.0, 1.0);
+    basePoints[1] = Point3F(-1.0, 0.0, -1.0);
+    basePoints[2] = Point3F(1.0, 0.0, -1.0);
+    basePoints[3] = Point3F(1.0, 0.0, 1.0);
+
+    Vector<Particle> reference;
+    Vector<GFXVertexPCT> refVerts, listVerts;
+    reference.setSize(count);
+    refVerts.setSize(count * 4);
+    listVerts.setSize(count * 4);
+
+    S32 numEmitters = 0;
+    U32 totalRefTime = 0, totalListTime = 0;
+    F32 worstPos = 0.0f, worstColor = 0.0f, worstVert = 0.0f;
+
+    Con::printf("Particle benchmark: %d particles, %d frames of %d ms", count, frames, ms);
+
+    SimDataBlockGroup* group = Sim::getDataBlockGroup();
+    for (SimSet::iterator itr = group->begin(); itr != group->end(); itr++)
+    {
+        ParticleEmitterData* data = dynamic_cast<ParticleEmitterData*>(*itr);
+        if (!data || !data->particleDataBlock)
+            continue;
+        ParticleData* pd = data->particleDataBlock;
 
+        ParticleKeys keys;
+        for (U32 k = 0; k < ParticleData::PDC_NUM_KEYS; k++)
+        {
+            keys.times[k] = pd->times[k];
+            keys.colors[k] = pd->colors[k];
+            keys.sizes[k] = pd->sizes[k];
+        }
 
-    F32 width = part->size * 0.5;
-    dir *= width;
-    crossDir *= width;
-    Point3F start = part->pos - dir;
-    Point3F end = part->pos + dir;
+        // same particles for both, long lived enough that none die during the run
+        ParticleList list;
+        list.setCapacity(count);
+        for (S32 i = 0; i < count; i++)
+        {
+            Particle& p = reference[i];
+            Point3F dir(gRandGen.randF(-1.0f, 1.0f), gRandGen.randF(-1.0f, 1.0f), gRandGen.randF(0.1f, 1.0f));
+            dir.normalize();
+
+            p.pos.set(gRandGen.randF(-1.0f, 1.0f), gRandGen.randF(-1.0f, 1.0f), gRandGen.randF(-1.0f, 1.0f));
+            p.vel = dir * data->ejectionVelocity;
+            p.orientDir = dir;
+            p.acc.set(0, 0, 0);
+            p.color.set(0, 0, 0, 0);
+            p.size = 0;
+            pd->initializeParticle(&p, Point3F(0, 0, 0));
+
+            U32 runMS = frames * ms;
+            p.totalLifetime = getMax(p.totalLifetime, runMS * 2);
+            p.currentAge = gRandGen.randI() % (p.totalLifetime - runMS + 1);
+            list.push(p);
+        }
+        list.updateKeys(keys);
 
+        U32 startTime = Platform::getRealMilliseconds();
+        for (S32 f = 0; f < frames; f++)
+        {
+            for (S32 i = 0; i < count; i++)
+                referenceUpdate(&reference[i], ms, keys, wind);
 
-    lVerts->point = start + crossDir;
-    lVerts->color = part->color;
-    lVerts->texCoord.set(0.0, 0.0);
-    ++lVerts;
+            MatrixF view = camView;
+            view.transpose();
+            for (S32 i = 0; i < count; i++)
+            {
+                if (data->orientParticles)
+                    referenceOriented(&reference[i], camPos, data->orientOnVelocity, &refVerts[i * 4]);
+                else
+                    referenceBillboard(&reference[i], basePoints, view, &refVerts[i * 4]);
+            }
+        }
+        U32 refTime = Platform::getRealMilliseconds() - startTime;
+
+        startTime = Platform::getRealMilliseconds();
+        for (S32 f = 0; f < frames; f++)
+        {
+            list.advanceAges(ms);
+            list.integrate(dt, wind * pd->windCoefficient, Point3F(0, 0, -9.81) * pd->gravityCoefficient, pd->dragCoefficient);
+            list.updateKeys(keys);
+
+            MatrixF view = camView;
+            view.transpose();
+            if (data->orientParticles)
+                list.fillOriented(camPos, data->orientOnVelocity, listVerts.address());
+            else
+                list.fillBillboards(view, listVerts.address());
+        }
+        U32 listTime = Platform::getRealMilliseconds() - startTime;
 
-    lVerts->point = start - crossDir;
-    lVerts->color = part->color;
-    lVerts->texCoord.set(0.0, 1.0);
-    ++lVerts;
+        F32 posError = 0.0f, colorError = 0.0f, vertError = 0.0f;
+        for (S32 i = 0; i < count; i++)
+        {
+            Particle p;
+            list.get(i, &p);
+            posError = getMax(posError, (p.pos - reference[i].pos).len());
+            colorError = getMax(colorError, mFabs(p.color.red - reference[i].color.red));
+            colorError = getMax(colorError, mFabs(p.color.alpha - reference[i].color.alpha));
+            colorError = getMax(colorError, mFabs(p.size - reference[i].size));
+            for (S32 v = 0; v < 4; v++)
+                vertError = getMax(vertError, (listVerts[i * 4 + v].point - refVerts[i * 4 + v].point).len());
+        }
 
-    lVerts->point = end - crossDir;
-    lVerts->color = part->color;
-    lVerts->texCoord.set(1.0, 1.0);
-    ++lVerts;
+        Con::printf("   %-32s %s  old %5d ms  list %5d ms  error pos %g, keys %g, verts %g",
+            data->getName() ? data->getName() : "(unnamed)", data->orientParticles ? "oriented " : "billboard",
+            refTime, listTime, posError, colorError, vertError);
 
-    lVerts->point = end + crossDir;
-    lVerts->color = part->color;
-    lVerts->texCoord.set(1.0, 0.0);
-    ++lVerts;
+        numEmitters++;
+        totalRefTime += refTime;
+        totalListTime += listTime;
+        worstPos = getMax(worstPos, posError);
+        worstColor = getMax(worstColor, colorError);
+        worstVert = getMax(worstVert, vertError);
+    }
 
+    if (!numEmitters)
+    {
+        Con::errorf("benchmarkParticles: no ParticleEmitterData datablocks are loaded.");
+        return;
+    }
 
+    Con::printf("   %d emitters: old %d ms, list %d ms; largest error pos %g, keys %g, verts %g",
+        numEmitters, totalRefTime, totalListTime, worstPos, worstColor, worstVert);
 }
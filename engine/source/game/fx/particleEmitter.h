@@ -14,6 +14,7 @@
 #endif
 
 #include "particle.h"
+#include "particleList.h"
 #include "gfx/gfxDevice.h"
 
 class  ParticleData;
@@ -29,6 +30,7 @@ public:
     ParticleEmitterData();
     DECLARE_CONOBJECT(ParticleEmitterData);
     static void initPersistFields();
+    static void consoleInit();
     void packData(BitStream* stream);
     void unpackData(BitStream* stream);
     bool preload(bool server, char errorBuffer[256]);
@@ -75,6 +77,7 @@ DECLARE_CONSOLETYPE(ParticleEmitterData)
 class ParticleEmitter : public GameBase
 {
     typedef GameBase Parent;
+    friend class ParticleManager;
 
 public:
     ParticleEmitter();
@@ -141,15 +144,8 @@ protected:
     /// @param   axisx
     void addParticle(const Point3F& pos, const Point3F& axis, const Point3F& vel, const Point3F& axisx);
 
-
-    inline void setupBillboard(Particle* part,
-        Point3F* basePts,
-        MatrixF camView,
-        GFXVertexPCT* lVerts);
-
-    inline void setupOriented(Particle* part,
-        const Point3F& camPos,
-        GFXVertexPCT* lVerts);
+    /// Gathers the color and size keys, from this emitter or the particle datablock
+    void getKeys(ParticleKeys* keys) const;
 
     /// Updates the bounding box for the particle system
     void updateBBox();
@@ -172,7 +168,6 @@ protected:
 private:
 
     void update(U32 ms);
-    inline void updateKeyData(Particle* part);
 
 
 private:
@@ -195,8 +190,7 @@ private:
     ColorF    colors[ParticleData::PDC_NUM_KEYS];
 
     GFXVertexBufferHandle<GFXVertexPCT> mVertBuff;
-    Vector <Particle> mPartList;
-    S32       mLastPartIndex;
+    ParticleList mParticles;
     S32       mCurBuffSize;
 
 };
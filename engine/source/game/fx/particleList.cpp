@@ -0,0 +1,549 @@
+//-----------------------------------------------------------------------------
+// Torque Shader Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#include "particleList.h"
+
+#if defined(TORQUE_CPU_X86) || defined(TORQUE_CPU_X64)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLE_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
+namespace
+{
+    const F32 sSpinFactor = (1.0 / 1000.0) * (1.0 / 360.0) * M_PI * 2.0;
+
+    /// Point3F::normalize on one component set, zero length gives +z.
+    inline void normalizeInPlace(F32& x, F32& y, F32& z)
+    {
+        F32 squared = x * x + y * y + z * z;
+        if (squared != 0.0f)
+        {
+            F32 factor = 1.0f / mSqrt(squared);
+            x *= factor;
+            y *= factor;
+            z *= factor;
+        }
+        else
+        {
+            x = 0.0f;
+            y = 0.0f;
+            z = 1.0f;
+        }
+    }
+
+    inline void writeQuad(GFXVertexPCT* verts, const F32 corners[4][3], const GFXVertexColor& color)
+    {
+        for (S32 c = 0; c < 4; c++)
+        {
+            verts[c].point.set(corners[c][0], corners[c][1], corners[c][2]);
+            verts[c].color = color;
+        }
+        verts[0].texCoord.set(0.0f, 0.0f);
+        verts[1].texCoord.set(0.0f, 1.0f);
+        verts[2].texCoord.set(1.0f, 1.0f);
+        verts[3].texCoord.set(1.0f, 0.0f);
+    }
+
+#if defined(PARTICLE_SSE2)
+    inline __m128 select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    inline __m128 loadU32AsF32(const U32* p)
+    {
+        return _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)p));
+    }
+
+    /// normalizeInPlace on four lanes
+    inline void normalize4(__m128& x, __m128& y, __m128& z)
+    {
+        __m128 squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 nonZero = _mm_cmpneq_ps(squared, _mm_setzero_ps());
+        __m128 factor = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(squared));
+        x = _mm_and_ps(nonZero, _mm_mul_ps(x, factor));
+        y = _mm_and_ps(nonZero, _mm_mul_ps(y, factor));
+        z = select(nonZero, _mm_mul_ps(z, factor), _mm_set1_ps(1.0f));
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Storage
+//-----------------------------------------------------------------------------
+ParticleList::ParticleList()
+{
+    mCount = 0;
+    mCapacity = 0;
+}
+
+void ParticleList::setCapacity(S32 capacity)
+{
+    capacity = (getMax(capacity, mCount) + 3) & ~3;
+    if (capacity == mCapacity)
+        return;
+
+    // zeroed so the padding never feeds the SIMD loops anything odd
+    Vector<F32> data;
+    data.setSize(NumFields * capacity);
+    dMemset(data.address(), 0, data.size() * sizeof(F32));
+    for (S32 f = 0; f < NumFields; f++)
+        dMemcpy(data.address() + f * capacity, field(Field(f)), mCount * sizeof(F32));
+    mData = data;
+
+    S32 oldCapacity = mCapacity;
+    mAges.setSize(capacity);
+    mLifetimes.setSize(capacity);
+    for (S32 i = oldCapacity; i < capacity; i++)
+    {
+        mAges[i] = 0;
+        mLifetimes[i] = 1;
+    }
+    mCapacity = capacity;
+}
+
+void ParticleList::push(const Particle& part)
+{
+    AssertFatal(mCount < mCapacity, "ParticleList::push: out of room");
+    S32 i = mCount++;
+
+    field(PosX)[i] = part.pos.x;
+    field(PosY)[i] = part.pos.y;
+    field(PosZ)[i] = part.pos.z;
+    field(VelX)[i] = part.vel.x;
+    field(VelY)[i] = part.vel.y;
+    field(VelZ)[i] = part.vel.z;
+    field(AccX)[i] = part.acc.x;
+    field(AccY)[i] = part.acc.y;
+    field(AccZ)[i] = part.acc.z;
+    field(OrientX)[i] = part.orientDir.x;
+    field(OrientY)[i] = part.orientDir.y;
+    field(OrientZ)[i] = part.orientDir.z;
+    field(Red)[i] = part.color.red;
+    field(Green)[i] = part.color.green;
+    field(Blue)[i] = part.color.blue;
+    field(Alpha)[i] = part.color.alpha;
+    field(Size)[i] = part.size;
+    field(SpinSpeed)[i] = part.spinSpeed;
+    mAges[i] = part.currentAge;
+    mLifetimes[i] = part.totalLifetime;
+}
+
+void ParticleList::get(S32 i, Particle* part) const
+{
+    AssertFatal(i >= 0 && i < mCount, "ParticleList::get: out of range");
+
+    part->pos.set(field(PosX)[i], field(PosY)[i], field(PosZ)[i]);
+    part->vel.set(field(VelX)[i], field(VelY)[i], field(VelZ)[i]);
+    part->acc.set(field(AccX)[i], field(AccY)[i], field(AccZ)[i]);
+    part->orientDir.set(field(OrientX)[i], field(OrientY)[i], field(OrientZ)[i]);
+    part->color.set(field(Red)[i], field(Green)[i], field(Blue)[i], field(Alpha)[i]);
+    part->size = field(Size)[i];
+    part->spinSpeed = field(SpinSpeed)[i];
+    part->currentAge = mAges[i];
+    part->totalLifetime = mLifetimes[i];
+    part->dataBlock = NULL;
+}
+
+void ParticleList::remove(S32 i)
+{
+    AssertFatal(i >= 0 && i < mCount, "ParticleList::remove: out of range");
+    S32 last = --mCount;
+    if (i == last)
+        return;
+
+    for (S32 f = 0; f < NumFields; f++)
+    {
+        F32* row = field(Field(f));
+        row[i] = row[last];
+    }
+    mAges[i] = mAges[last];
+    mLifetimes[i] = mLifetimes[last];
+}
+
+//-----------------------------------------------------------------------------
+// Simulation
+//-----------------------------------------------------------------------------
+void ParticleList::advanceAges(U32 ms)
+{
+    S32 i;
+#if defined(PARTICLE_SSE2)
+    __m128i step = _mm_set1_epi32(ms);
+    for (i = 0; i < mCount; i += 4)
+    {
+        __m128i* age = (__m128i*)(mAges.address() + i);
+        _mm_storeu_si128(age, _mm_add_epi32(_mm_loadu_si128(age), step));
+    }
+#else
+    for (i = 0; i < mCount; i++)
+        mAges[i] += ms;
+#endif
+
+    // whatever moves into a freed slot is already aged, so check it too
+    for (i = 0; i < mCount; )
+    {
+        if (mAges[i] > mLifetimes[i])
+            remove(i);
+        else
+            i++;
+    }
+}
+
+void ParticleList::integrate(F32 dt, const Point3F& wind, const Point3F& gravity, F32 drag)
+{
+    // same order of operations as the old per particle Point3F code:
+    //    a = acc - vel * drag - wind + gravity, vel += a * dt, pos += vel * dt
+    for (S32 c = 0; c < 3; c++)
+    {
+        F32* pos = field(Field(PosX + c));
+        F32* vel = field(Field(VelX + c));
+        const F32* acc = field(Field(AccX + c));
+
+#if defined(PARTICLE_SSE2)
+        __m128 t = _mm_set1_ps(dt);
+        __m128 d = _mm_set1_ps(drag);
+        __m128 w = _mm_set1_ps(wind[c]);
+        __m128 g = _mm_set1_ps(gravity[c]);
+        for (S32 i = 0; i < mCount; i += 4)
+        {
+            __m128 v = _mm_loadu_ps(vel + i);
+            __m128 a = _mm_sub_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(v, d));
+            a = _mm_add_ps(_mm_sub_ps(a, w), g);
+            v = _mm_add_ps(v, _mm_mul_ps(a, t));
+            _mm_storeu_ps(vel + i, v);
+            _mm_storeu_ps(pos + i, _mm_add_ps(_mm_loadu_ps(pos + i), _mm_mul_ps(v, t)));
+        }
+#else
+        for (S32 i = 0; i < mCount; i++)
+        {
+            F32 a = acc[i] - vel[i] * drag;
+            a = (a - wind[c]) + gravity[c];
+            vel[i] += a * dt;
+            pos[i] += vel[i] * dt;
+        }
+#endif
+    }
+}
+
+void ParticleList::updateKeys(const ParticleKeys& keys, S32 start)
+{
+    const U32* ages = mAges.address();
+    const U32* lifetimes = mLifetimes.address();
+    F32* color[4] = { field(Red), field(Green), field(Blue), field(Alpha) };
+    F32* size = field(Size);
+
+#if defined(PARTICLE_SSE2)
+    for (S32 i = start & ~3; i < mCount; i += 4)
+    {
+        __m128 t = _mm_div_ps(loadU32AsF32(ages + i), loadU32AsF32(lifetimes + i));
+
+        // pick the first key at or past t for each lane
+        __m128 found = _mm_setzero_ps();
+        __m128 t0 = _mm_setzero_ps(), t1 = _mm_set1_ps(1.0f);
+        __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+        __m128 c0[4], c1[4];
+        S32 c;
+        for (c = 0; c < 4; c++)
+            c0[c] = c1[c] = _mm_setzero_ps();
+
+        for (S32 k = 1; k < ParticleData::PDC_NUM_KEYS; k++)
+        {
+            __m128 hit = _mm_andnot_ps(found, _mm_cmple_ps(t, _mm_set1_ps(keys.times[k])));
+            found = _mm_or_ps(found, hit);
+
+            t0 = select(hit, _mm_set1_ps(keys.times[k - 1]), t0);
+            t1 = select(hit, _mm_set1_ps(keys.times[k]), t1);
+            s0 = select(hit, _mm_set1_ps(keys.sizes[k - 1]), s0);
+            s1 = select(hit, _mm_set1_ps(keys.sizes[k]), s1);
+            for (c = 0; c < 4; c++)
+            {
+                c0[c] = select(hit, _mm_set1_ps((&keys.colors[k - 1].red)[c]), c0[c]);
+                c1[c] = select(hit, _mm_set1_ps((&keys.colors[k].red)[c]), c1[c]);
+            }
+        }
+
+        __m128 f = _mm_div_ps(_mm_sub_ps(t, t0), _mm_sub_ps(t1, t0));
+        __m128 f2 = _mm_sub_ps(_mm_set1_ps(1.0f), f);
+
+        // lanes past the last key keep what they had, like the scalar loop
+        for (c = 0; c < 4; c++)
+        {
+            __m128 value = _mm_add_ps(_mm_mul_ps(c0[c], f2), _mm_mul_ps(c1[c], f));
+            _mm_storeu_ps(color[c] + i, select(found, value, _mm_loadu_ps(color[c] + i)));
+        }
+        __m128 value = _mm_add_ps(_mm_mul_ps(s0, f2), _mm_mul_ps(s1, f));
+        _mm_storeu_ps(size + i, select(found, value, _mm_loadu_ps(size + i)));
+    }
+#else
+    for (S32 i = start; i < mCount; i++)
+    {
+        F32 t = F32(ages[i]) / F32(lifetimes[i]);
+        for (S32 k = 1; k < ParticleData::PDC_NUM_KEYS; k++)
+        {
+            if (keys.times[k] >= t)
+            {
+                F32 f = (t - keys.times[k - 1]) / (keys.times[k] - keys.times[k - 1]);
+                F32 f2 = 1.0f - f;
+                for (S32 c = 0; c < 4; c++)
+                    color[c][i] = ((&keys.colors[k - 1].red)[c] * f2) + ((&keys.colors[k].red)[c] * f);
+                size[i] = (keys.sizes[k - 1] * f2) + (keys.sizes[k] * f);
+                break;
+            }
+        }
+    }
+#endif
+}
+
+void ParticleList::getBounds(Point3F* min, Point3F* max) const
+{
+    min->set(1e10, 1e10, 1e10);
+    max->set(-1e10, -1e10, -1e10);
+
+    for (S32 c = 0; c < 3; c++)
+    {
+        const F32* pos = field(Field(PosX + c));
+        F32 lo = (*min)[c], hi = (*max)[c];
+        S32 i = 0;
+
+#if defined(PARTICLE_SSE2)
+        // whole groups only, the padding past mCount isn't live
+        __m128 lo4 = _mm_set1_ps(lo), hi4 = _mm_set1_ps(hi);
+        for (; i + 4 <= mCount; i += 4)
+        {
+            __m128 p = _mm_loadu_ps(pos + i);
+            lo4 = _mm_min_ps(lo4, p);
+            hi4 = _mm_max_ps(hi4, p);
+        }
+        F32 los[4], his[4];
+        _mm_storeu_ps(los, lo4);
+        _mm_storeu_ps(his, hi4);
+        for (S32 lane = 0; lane < 4; lane++)
+        {
+            lo = getMin(lo, los[lane]);
+            hi = getMax(hi, his[lane]);
+        }
+#endif
+        for (; i < mCount; i++)
+        {
+            lo = getMin(lo, pos[i]);
+            hi = getMax(hi, pos[i]);
+        }
+        (*min)[c] = lo;
+        (*max)[c] = hi;
+    }
+}
+
+void ParticleList::getDepthKeys(const Point3F& camPos, U32* keys) const
+{
+    // Squared distances are never negative, so their bits order like the
+    // floats do.  Flipping them puts the farthest particle first.
+    const F32* posX = field(PosX);
+    const F32* posY = field(PosY);
+    const F32* posZ = field(PosZ);
+    S32 i = 0;
+
+#if defined(PARTICLE_SSE2)
+    __m128 camX = _mm_set1_ps(camPos.x);
+    __m128 camY = _mm_set1_ps(camPos.y);
+    __m128 camZ = _mm_set1_ps(camPos.z);
+    __m128i flip = _mm_set1_epi32(-1);
+    for (; i + 4 <= mCount; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(posX + i), camX);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(posY + i), camY);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(posZ + i), camZ);
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        _mm_storeu_si128((__m128i*)(keys + i), _mm_xor_si128(_mm_castps_si128(d2), flip));
+    }
+#endif
+    for (; i < mCount; i++)
+    {
+        F32 dx = posX[i] - camPos.x;
+        F32 dy = posY[i] - camPos.y;
+        F32 dz = posZ[i] - camPos.z;
+        F32 d2 = dx * dx + dy * dy + dz * dz;
+        U32 bits;
+        dMemcpy(&bits, &d2, sizeof(bits));
+        keys[i] = ~bits;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Vertex output
+//-----------------------------------------------------------------------------
+void ParticleList::fillBillboards(const MatrixF& camView, GFXVertexPCT* verts) const
+{
+    // The old code spun each corner in the quad's plane and took it through
+    // camView.  Both steps are linear, so the spun quad is just two scaled
+    // camera axes: X along the right and Y along the up, turned by the spin.
+    const F32* m = camView;
+    const F32 right[3] = { m[0], m[4], m[8] };
+    const F32 up[3] = { m[2], m[6], m[10] };
+
+    const F32* pos[3] = { field(PosX), field(PosY), field(PosZ) };
+    const F32* color[4] = { field(Red), field(Green), field(Blue), field(Alpha) };
+    const F32* size = field(Size);
+    const F32* spin = field(SpinSpeed);
+
+    F32 corners[4][4][3];   // lane, corner, component
+    for (S32 i = 0; i < mCount; i += 4)
+    {
+        S32 lanes = getMin(mCount - i, 4);
+
+        // no SIMD sin/cos that matches the libm one, so these stay scalar
+        F32 sn[4], cs[4], width[4];
+        for (S32 lane = 0; lane < 4; lane++)
+        {
+            mSinCos(spin[i + lane] * mAges[i + lane] * sSpinFactor, sn[lane], cs[lane]);
+            width[lane] = size[i + lane] * 0.5f;
+        }
+
+#if defined(PARTICLE_SSE2)
+        __m128 s = _mm_loadu_ps(sn), c = _mm_loadu_ps(cs), w = _mm_loadu_ps(width);
+        for (S32 k = 0; k < 3; k++)
+        {
+            __m128 r = _mm_set1_ps(right[k]), u = _mm_set1_ps(up[k]);
+            __m128 x = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(c, r), _mm_mul_ps(s, u)), w);
+            __m128 y = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(c, u), _mm_mul_ps(s, r)), w);
+            __m128 p = _mm_loadu_ps(pos[k] + i);
+
+            F32 out[4][4];
+            _mm_storeu_ps(out[0], _mm_add_ps(_mm_sub_ps(p, x), y));
+            _mm_storeu_ps(out[1], _mm_sub_ps(_mm_sub_ps(p, x), y));
+            _mm_storeu_ps(out[2], _mm_sub_ps(_mm_add_ps(p, x), y));
+            _mm_storeu_ps(out[3], _mm_add_ps(_mm_add_ps(p, x), y));
+            for (S32 lane = 0; lane < 4; lane++)
+                for (S32 corner = 0; corner < 4; corner++)
+                    corners[lane][corner][k] = out[corner][lane];
+        }
+#else
+        for (S32 lane = 0; lane < lanes; lane++)
+        {
+            for (S32 k = 0; k < 3; k++)
+            {
+                F32 x = (cs[lane] * right[k] + sn[lane] * up[k]) * width[lane];
+                F32 y = (cs[lane] * up[k] - sn[lane] * right[k]) * width[lane];
+                F32 p = pos[k][i + lane];
+                corners[lane][0][k] = (p - x) + y;
+                corners[lane][1][k] = (p - x) - y;
+                corners[lane][2][k] = (p + x) - y;
+                corners[lane][3][k] = (p + x) + y;
+            }
+        }
+#endif
+
+        for (S32 lane = 0; lane < lanes; lane++)
+        {
+            GFXVertexColor vertColor;
+            vertColor = ColorF(color[0][i + lane], color[1][i + lane], color[2][i + lane], color[3][i + lane]);
+            writeQuad(verts + (i + lane) * 4, corners[lane], vertColor);
+        }
+    }
+}
+
+void ParticleList::fillOriented(const Point3F& camPos, bool orientOnVelocity, GFXVertexPCT* verts) const
+{
+    const F32* pos[3] = { field(PosX), field(PosY), field(PosZ) };
+    const F32* dir[3];
+    for (S32 k = 0; k < 3; k++)
+        dir[k] = orientOnVelocity ? field(Field(VelX + k)) : field(Field(OrientX + k));
+    const F32* color[4] = { field(Red), field(Green), field(Blue), field(Alpha) };
+    const F32* size = field(Size);
+
+    F32 corners[4][4][3];   // lane, corner, component
+    for (S32 i = 0; i < mCount; i += 4)
+    {
+        S32 lanes = getMin(mCount - i, 4);
+        bool still[4];      // no velocity to stretch along
+
+#if defined(PARTICLE_SSE2)
+        __m128 px = _mm_loadu_ps(pos[0] + i), py = _mm_loadu_ps(pos[1] + i), pz = _mm_loadu_ps(pos[2] + i);
+        __m128 dx = _mm_loadu_ps(dir[0] + i), dy = _mm_loadu_ps(dir[1] + i), dz = _mm_loadu_ps(dir[2] + i);
+
+        // same test as Point3F::isZero
+        __m128 eps = _mm_set1_ps(F32(POINT_EPSILON));
+        __m128 zero = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(_mm_mul_ps(dx, dx), eps),
+            _mm_cmple_ps(_mm_mul_ps(dy, dy), eps)), _mm_cmple_ps(_mm_mul_ps(dz, dz), eps));
+        S32 zeroMask = orientOnVelocity ? _mm_movemask_ps(zero) : 0;
+        for (S32 lane = 0; lane < 4; lane++)
+            still[lane] = (zeroMask >> lane) & 1;
+
+        // mCross(pos - camPos, dir)
+        __m128 fx = _mm_sub_ps(px, _mm_set1_ps(camPos.x));
+        __m128 fy = _mm_sub_ps(py, _mm_set1_ps(camPos.y));
+        __m128 fz = _mm_sub_ps(pz, _mm_set1_ps(camPos.z));
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(fy, dz), _mm_mul_ps(fz, dy));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(fz, dx), _mm_mul_ps(fx, dz));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(fx, dy), _mm_mul_ps(fy, dx));
+        normalize4(cx, cy, cz);
+        normalize4(dx, dy, dz);
+
+        __m128 w = _mm_mul_ps(_mm_loadu_ps(size + i), _mm_set1_ps(0.5f));
+        __m128 c[3] = { _mm_mul_ps(cx, w), _mm_mul_ps(cy, w), _mm_mul_ps(cz, w) };
+        __m128 d[3] = { _mm_mul_ps(dx, w), _mm_mul_ps(dy, w), _mm_mul_ps(dz, w) };
+        __m128 p[3] = { px, py, pz };
+
+        for (S32 k = 0; k < 3; k++)
+        {
+            __m128 start = _mm_sub_ps(p[k], d[k]);
+            __m128 end = _mm_add_ps(p[k], d[k]);
+
+            F32 out[4][4];
+            _mm_storeu_ps(out[0], _mm_add_ps(start, c[k]));
+            _mm_storeu_ps(out[1], _mm_sub_ps(start, c[k]));
+            _mm_storeu_ps(out[2], _mm_sub_ps(end, c[k]));
+            _mm_storeu_ps(out[3], _mm_add_ps(end, c[k]));
+            for (S32 lane = 0; lane < 4; lane++)
+                for (S32 corner = 0; corner < 4; corner++)
+                    corners[lane][corner][k] = out[corner][lane];
+        }
+#else
+        for (S32 lane = 0; lane < lanes; lane++)
+        {
+            S32 j = i + lane;
+            Point3F p(pos[0][j], pos[1][j], pos[2][j]);
+            Point3F d(dir[0][j], dir[1][j], dir[2][j]);
+            still[lane] = orientOnVelocity && d.isZero();
+
+            Point3F c;
+            mCross(p - camPos, d, &c);
+            normalizeInPlace(c.x, c.y, c.z);
+            normalizeInPlace(d.x, d.y, d.z);
+
+            F32 width = size[j] * 0.5f;
+            c *= width;
+            d *= width;
+            Point3F start = p - d;
+            Point3F end = p + d;
+            for (S32 k = 0; k < 3; k++)
+            {
+                corners[lane][0][k] = start[k] + c[k];
+                corners[lane][1][k] = start[k] - c[k];
+                corners[lane][2][k] = end[k] - c[k];
+                corners[lane][3][k] = end[k] + c[k];
+            }
+        }
+#endif
+
+        for (S32 lane = 0; lane < lanes; lane++)
+        {
+            S32 j = i + lane;
+
+            // nothing to point along, collapse the quad rather than draw it
+            if (still[lane])
+            {
+                for (S32 corner = 0; corner < 4; corner++)
+                    for (S32 k = 0; k < 3; k++)
+                        corners[lane][corner][k] = pos[k][j];
+            }
+
+            GFXVertexColor vertColor;
+            vertColor = ColorF(color[0][j], color[1][j], color[2][j], color[3][j]);
+            writeQuad(verts + j * 4, corners[lane], vertColor);
+        }
+    }
+}
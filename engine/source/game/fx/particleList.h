@@ -0,0 +1,121 @@
+//-----------------------------------------------------------------------------
+// Torque Shader Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#ifndef _PARTICLELIST_H_
+#define _PARTICLELIST_H_
+
+#ifndef _TVECTOR_H_
+#include "core/tVector.h"
+#endif
+#ifndef _MMATH_H_
+#include "math/mMath.h"
+#endif
+#ifndef _COLOR_H_
+#include "core/color.h"
+#endif
+#ifndef _GFXSTRUCTS_H_
+#include "gfx/gfxStructs.h"
+#endif
+
+#include "particle.h"
+
+//*****************************************************************************
+// Particle Keys
+//*****************************************************************************
+/// Color and size keys for ParticleList::updateKeys, gathered from the emitter
+/// and particle datablocks once per update.
+struct ParticleKeys
+{
+    F32    times[ParticleData::PDC_NUM_KEYS];
+    ColorF colors[ParticleData::PDC_NUM_KEYS];
+    F32    sizes[ParticleData::PDC_NUM_KEYS];
+};
+
+//*****************************************************************************
+// Particle List
+//*****************************************************************************
+/// The live particles of an emitter, stored a field at a time.
+///
+/// Each pass over the particles (aging, integration, keys, vertex output)
+/// streams only the fields it uses, four particles at a time where SSE2 is
+/// available.  Capacity is kept to a multiple of four so those loops never need
+/// a scalar tail; the slots past size() hold leftovers and are never read back.
+class ParticleList
+{
+public:
+    enum Field
+    {
+        PosX, PosY, PosZ,
+        VelX, VelY, VelZ,
+        AccX, AccY, AccZ,
+        OrientX, OrientY, OrientZ,
+        Red, Green, Blue, Alpha,
+        Size,
+        SpinSpeed,
+        NumFields
+    };
+
+    ParticleList();
+
+    S32  size() const { return mCount; }
+    S32  getCapacity() const { return mCapacity; }
+    void setCapacity(S32 capacity);     ///< Rounded up to a multiple of 4, keeps the live particles
+
+    F32* field(Field f) { return mData.address() + f * mCapacity; }
+    const F32* field(Field f) const { return mData.address() + f * mCapacity; }
+    U32* ages() { return mAges.address(); }
+    const U32* ages() const { return mAges.address(); }
+    const U32* lifetimes() const { return mLifetimes.address(); }
+
+    /// @name Particle Access
+    /// Unpacked copies, for emission and debugging.
+    /// @{
+    void push(const Particle& part);
+    void get(S32 index, Particle* part) const;
+    void remove(S32 index);             ///< Moves the last particle into index
+    /// @}
+
+    /// @name Simulation
+    /// @{
+
+    /// Ages every particle by ms and removes the ones past their lifetime.
+    void advanceAges(U32 ms);
+
+    /// One Euler step.  Each particle accelerates by its constant acceleration,
+    /// less drag times its velocity, less wind, plus gravity.
+    void integrate(F32 dt, const Point3F& wind, const Point3F& gravity, F32 drag);
+
+    /// Interpolates color and size from the keys by each particle's age, for
+    /// the particles from start on (new ones only, when emitting).
+    void updateKeys(const ParticleKeys& keys, S32 start = 0);
+
+    void getBounds(Point3F* min, Point3F* max) const;
+
+    /// One key per particle that sorts ascending from the farthest from camPos
+    /// to the nearest, for back to front drawing.
+    void getDepthKeys(const Point3F& camPos, U32* keys) const;
+    /// @}
+
+    /// @name Vertex Output
+    /// Four verts per particle, in the order the emitter's index buffer expects.
+    /// @{
+
+    /// Camera facing quads spun by spinSpeed; camView is the inverse of the view.
+    void fillBillboards(const MatrixF& camView, GFXVertexPCT* verts) const;
+
+    /// Quads stretched along the velocity (or the ejection direction) and
+    /// turned to face camPos.
+    void fillOriented(const Point3F& camPos, bool orientOnVelocity, GFXVertexPCT* verts) const;
+    /// @}
+
+private:
+    Vector<F32> mData;                  ///< NumFields rows of mCapacity
+    Vector<U32> mAges;
+    Vector<U32> mLifetimes;
+    S32 mCount;
+    S32 mCapacity;
+};
+
+#endif // _PARTICLELIST_H_
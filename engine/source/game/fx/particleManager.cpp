@@ -0,0 +1,443 @@
+//-----------------------------------------------------------------------------
+// Torque Shader Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#include "particleManager.h"
+#include "particleEmitter.h"
+#include "console/console.h"
+#include "console/simBase.h"
+#include "math/mRandom.h"
+#include "platform/profiler.h"
+#include "renderInstance/renderInstMgr.h"
+
+ParticleManager gParticleManager;
+bool ParticleManager::smBatchParticles = true;
+
+//-----------------------------------------------------------------------------
+// ParticleManager
+//-----------------------------------------------------------------------------
+ParticleManager::ParticleManager()
+{
+    mWorld.identity();
+    mCamPos.set(0, 0, 0);
+    mNumParticles = 0;
+    mVertBuffSize = 0;
+    GFXDevice::getDeviceEventSignal().notify(this, &ParticleManager::handleGFXEvent);
+}
+
+void ParticleManager::handleGFXEvent(GFXDevice::GFXDeviceEventType event)
+{
+    if (event == GFXDevice::deDestroy)
+    {
+        mVertBuff = NULL;
+        mPrimBuff = NULL;
+        mVertBuffSize = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Queueing
+//-----------------------------------------------------------------------------
+void ParticleManager::addEmitter(ParticleEmitter* emitter, const Point3F& camPos)
+{
+    if (emitter->mParticles.size() == 0 || emitter->mDead)
+        return;
+
+    if (mEntries.empty())
+        begin(GFX->getWorldMatrix(), camPos);
+
+    ParticleData* data = emitter->mDataBlock->particleDataBlock;
+    addParticles(&emitter->mParticles, &*data->textureList[0], data->useInvAlpha,
+        emitter->mDataBlock->orientParticles, emitter->mDataBlock->orientOnVelocity,
+        emitter->getWorldBox().getClosestPoint(camPos));
+    mEntries.last().emitter = emitter;
+}
+
+void ParticleManager::begin(const MatrixF& world, const Point3F& camPos)
+{
+    clear();
+    mWorld = world;
+    mCamPos = camPos;
+}
+
+void ParticleManager::addParticles(const ParticleList* particles, GFXTextureObject* texture, bool invAlpha,
+    bool oriented, bool orientOnVelocity, const Point3F& sortPoint)
+{
+    mEntries.increment();
+    Entry& entry = mEntries.last();
+    entry.emitter = NULL;
+    entry.particles = particles;
+    entry.texture = texture;
+    entry.invAlpha = invAlpha;
+    entry.oriented = oriented;
+    entry.orientOnVelocity = orientOnVelocity;
+    entry.sortPoint = sortPoint;
+    entry.batch = -1;
+}
+
+void ParticleManager::clear()
+{
+    mEntries.clear();
+    mBatches.clear();
+    mNumParticles = 0;
+}
+
+//-----------------------------------------------------------------------------
+// submit
+//-----------------------------------------------------------------------------
+void ParticleManager::submit()
+{
+    if (mEntries.empty())
+        return;
+
+    PROFILE_START(ParticleManagerSubmit);
+
+    fillBatches();
+
+    for (S32 i = 0; i < mBatches.size(); i++)
+    {
+        const Batch& batch = mBatches[i];
+
+        // out of room, these emitters draw themselves
+        if (batch.start < 0)
+        {
+            for (S32 j = 0; j < mEntries.size(); j++)
+                if (mEntries[j].batch == i && mEntries[j].emitter)
+                    mEntries[j].emitter->prepBatchRender(mCamPos);
+            continue;
+        }
+
+        RenderInst* ri = gRenderInstManager.allocInst();
+        ri->vertBuff = &mVertBuff;
+        ri->primBuff = &mPrimBuff;
+        ri->matInst = NULL;
+        ri->translucent = true;
+        ri->type = RenderInstManager::RIT_Translucent;
+        ri->sortPoint = batch.sortPoint;
+        ri->particles = true;
+
+        ri->worldXform = gRenderInstManager.allocXform();
+        *ri->worldXform = mWorld;
+        ri->primStartIndex = batch.start * 6;
+        ri->primBuffIndex = batch.count;
+        ri->transFlags = batch.invAlpha;
+        ri->miscTex = batch.texture;
+
+        gRenderInstManager.addInst(ri);
+    }
+
+    clear();
+
+    PROFILE_END();
+}
+
+//-----------------------------------------------------------------------------
+// fillBatches
+//-----------------------------------------------------------------------------
+void ParticleManager::fillBatches()
+{
+    mBatches.clear();
+    mNumParticles = 0;
+
+    // group by texture and blend mode, a scene only has a handful of each
+    for (S32 i = 0; i < mEntries.size(); i++)
+    {
+        Entry& entry = mEntries[i];
+
+        S32 b;
+        for (b = 0; b < mBatches.size(); b++)
+            if (mBatches[b].texture == entry.texture && mBatches[b].invAlpha == entry.invAlpha)
+                break;
+        if (b == mBatches.size())
+        {
+            mBatches.increment();
+            Batch& batch = mBatches.last();
+            batch.texture = entry.texture;
+            batch.invAlpha = entry.invAlpha;
+            batch.count = 0;
+            batch.start = -1;
+            batch.sortPoint = entry.sortPoint;
+            batch.sortDist = -1.0f;
+        }
+
+        Batch& batch = mBatches[b];
+        entry.batch = b;
+        batch.count += entry.particles->size();
+
+        F32 dist = (entry.sortPoint - mCamPos).lenSquared();
+        if (dist > batch.sortDist)
+        {
+            batch.sortDist = dist;
+            batch.sortPoint = entry.sortPoint;
+        }
+    }
+
+    // lay the batches out in the vertex buffer
+    for (S32 b = 0; b < mBatches.size(); b++)
+    {
+        Batch& batch = mBatches[b];
+        if (mNumParticles + batch.count > MaxParticles)
+            continue;
+        batch.start = mNumParticles;
+        mNumParticles += batch.count;
+    }
+
+    if (!mNumParticles)
+        return;
+
+    if (!mPrimBuff)
+    {
+        // same quad ordering as ParticleEmitterData::allocPrimBuffer
+        U16* indices;
+        mPrimBuff.set(GFX, MaxParticles * 6, 0, GFXBufferTypeStatic);
+        mPrimBuff.lock(&indices);
+        for (U32 i = 0; i < MaxParticles; i++)
+        {
+            U16* idx = &indices[i * 6];
+            U16 offset = i * 4;
+            idx[0] = 0 + offset;
+            idx[1] = 1 + offset;
+            idx[2] = 3 + offset;
+            idx[3] = 1 + offset;
+            idx[4] = 3 + offset;
+            idx[5] = 2 + offset;
+        }
+        mPrimBuff.unlock();
+    }
+
+    if (!mVertBuff || mNumParticles > mVertBuffSize)
+    {
+        // grow in steps so a few more particles don't mean a new buffer every frame
+        mVertBuffSize = getMin((mNumParticles + 1023) & ~1023, S32(MaxParticles));
+        mVertBuff.set(GFX, mVertBuffSize * 4, GFXBufferTypeDynamic);
+    }
+
+    PROFILE_START(ParticleManagerFill);
+    GFXVertexPCT* verts = mVertBuff.lock(0, mNumParticles * 4);
+    for (S32 b = 0; b < mBatches.size(); b++)
+    {
+        if (mBatches[b].start >= 0)
+            fillBatch(mBatches[b], b, verts + mBatches[b].start * 4);
+    }
+    mVertBuff.unlock();
+    PROFILE_END();
+}
+
+void ParticleManager::fillEntry(const Entry& entry, GFXVertexPCT* verts)
+{
+    if (entry.oriented)
+    {
+        entry.particles->fillOriented(mCamPos, entry.orientOnVelocity, verts);
+    }
+    else
+    {
+        MatrixF camView = mWorld;
+        camView.transpose();  // inverse - this gets the particles facing camera
+        entry.particles->fillBillboards(camView, verts);
+    }
+}
+
+void ParticleManager::fillBatch(const Batch& batch, S32 batchIndex, GFXVertexPCT* verts)
+{
+    // additive blending doesn't care about order, write straight out
+    if (!batch.invAlpha)
+    {
+        for (S32 i = 0; i < mEntries.size(); i++)
+        {
+            if (mEntries[i].batch != batchIndex)
+                continue;
+            fillEntry(mEntries[i], verts);
+            verts += mEntries[i].particles->size() * 4;
+        }
+        return;
+    }
+
+    // alpha blended quads go back to front across every emitter in the batch
+    mScratchVerts.setSize(batch.count * 4);
+    mKeys.setSize(batch.count);
+
+    S32 count = 0;
+    for (S32 i = 0; i < mEntries.size(); i++)
+    {
+        if (mEntries[i].batch != batchIndex)
+            continue;
+        fillEntry(mEntries[i], &mScratchVerts[count * 4]);
+        mEntries[i].particles->getDepthKeys(mCamPos, &mKeys[count]);
+        count += mEntries[i].particles->size();
+    }
+
+    PROFILE_START(ParticleManagerSort);
+    sortQuads(count);
+    PROFILE_END();
+
+    const GFXVertexPCT* src = mScratchVerts.address();
+    for (S32 i = 0; i < count; i++)
+        dMemcpy(verts + i * 4, src + mOrder[i] * 4, 4 * sizeof(GFXVertexPCT));
+}
+
+//-----------------------------------------------------------------------------
+// sortQuads
+//
+// Radix sort of mKeys into mOrder, 11 bits a pass.  It's stable, so particles
+// at the same depth keep their emitter's order.
+//-----------------------------------------------------------------------------
+void ParticleManager::sortQuads(S32 count)
+{
+    const U32 RadixBits = 11;
+    const U32 RadixSize = 1 << RadixBits;
+    const U32 RadixMask = RadixSize - 1;
+
+    mOrder.setSize(count);
+    mOrderTemp.setSize(count);
+    mKeysTemp.setSize(count);
+    for (S32 i = 0; i < count; i++)
+        mOrder[i] = i;
+
+    U32* keys = mKeys.address();
+    U32* keysOut = mKeysTemp.address();
+    U32* order = mOrder.address();
+    U32* orderOut = mOrderTemp.address();
+
+    U32 offsets[RadixSize];
+    for (U32 shift = 0; shift < 32; shift += RadixBits)
+    {
+        dMemset(offsets, 0, sizeof(offsets));
+        for (S32 i = 0; i < count; i++)
+            offsets[(keys[i] >> shift) & RadixMask]++;
+
+        // every key has the same digit, nothing moves
+        if (offsets[(keys[0] >> shift) & RadixMask] == U32(count))
+            continue;
+
+        U32 sum = 0;
+        for (U32 d = 0; d < RadixSize; d++)
+        {
+            U32 n = offsets[d];
+            offsets[d] = sum;
+            sum += n;
+        }
+
+        for (S32 i = 0; i < count; i++)
+        {
+            U32 dest = offsets[(keys[i] >> shift) & RadixMask]++;
+            keysOut[dest] = keys[i];
+            orderOut[dest] = order[i];
+        }
+
+        U32* swap = keys; keys = keysOut; keysOut = swap;
+        swap = order; order = orderOut; orderOut = swap;
+    }
+
+    if (order != mOrder.address())
+        dMemcpy(mOrder.address(), order, count * sizeof(U32));
+}
+
+//-----------------------------------------------------------------------------
+// Batching benchmark
+//
+// Builds a scene's worth of emitters that share a few textures and times the
+// CPU side of drawing them: each emitter filling and locking its own buffer
+// the way ParticleEmitter::copyToVB does, against one pass of the manager.
+// Nothing is drawn, so it runs the same on the Null device.
+//-----------------------------------------------------------------------------
+ConsoleFunction(benchmarkParticleBatch, void, 1, 5, "([int emitters, int particles, int frames, int textures]) "
+    "Time filling particle vertex buffers per emitter against filling them in batches.")
+{
+    S32 numEmitters = argc > 1 ? getMax(dAtoi(argv[1]), 1) : 64;
+    S32 numParticles = argc > 2 ? getMax(dAtoi(argv[2]), 1) : 100;
+    S32 frames = argc > 3 ? getMax(dAtoi(argv[3]), 1) : 100;
+    S32 numTextures = argc > 4 ? getMax(dAtoi(argv[4]), 1) : 4;
+
+    if (!GFXDevice::devicePresent())
+    {
+        Con::errorf("benchmarkParticleBatch: no GFX device.");
+        return;
+    }
+
+    MatrixF world(EulerF(0.3f, 0.2f, 0.9f));
+    MatrixF camView = world;
+    camView.transpose();
+    Point3F camPos(0.0f, -10.0f, 2.0f);
+
+    // The textures are fake pointers, only compared and never bound.  Every
+    // other one is alpha blended so both kinds of batch get timed.
+    ParticleList* lists = new ParticleList[numEmitters];
+    Vector<Point3F> centers;
+    centers.setSize(numEmitters);
+    for (S32 e = 0; e < numEmitters; e++)
+    {
+        Point3F& center = centers[e];
+        center.set(gRandGen.randF(-50.0f, 50.0f), gRandGen.randF(0.0f, 100.0f), gRandGen.randF(-5.0f, 5.0f));
+
+        lists[e].setCapacity(numParticles);
+        for (S32 i = 0; i < numParticles; i++)
+        {
+            Particle p;
+            p.pos = center + Point3F(gRandGen.randF(-2.0f, 2.0f), gRandGen.randF(-2.0f, 2.0f), gRandGen.randF(-2.0f, 2.0f));
+            p.vel.set(gRandGen.randF(-1.0f, 1.0f), gRandGen.randF(-1.0f, 1.0f), gRandGen.randF(0.0f, 2.0f));
+            p.orientDir = p.vel;
+            p.acc.set(0, 0, 0);
+            p.color.set(1.0f, 1.0f, 1.0f, gRandGen.randF());
+            p.size = gRandGen.randF(0.5f, 2.0f);
+            p.spinSpeed = gRandGen.randF(-90.0f, 90.0f);
+            p.currentAge = gRandGen.randI(0, 1000);
+            p.totalLifetime = 2000;
+            p.dataBlock = NULL;
+            lists[e].push(p);
+        }
+    }
+
+    // per emitter, the way copyToVB did it
+    Vector<GFXVertexBufferHandle<GFXVertexPCT> > buffers;
+    buffers.setSize(numEmitters);
+    Vector<GFXVertexPCT> tempBuff;
+    tempBuff.setSize(numParticles * 4);
+
+    U32 startTime = Platform::getRealMilliseconds();
+    for (S32 f = 0; f < frames; f++)
+    {
+        for (S32 e = 0; e < numEmitters; e++)
+        {
+            if (e & 2)
+                lists[e].fillOriented(camPos, true, tempBuff.address());
+            else
+                lists[e].fillBillboards(camView, tempBuff.address());
+
+            if (!buffers[e])
+                buffers[e].set(GFX, numParticles * 4, GFXBufferTypeDynamic);
+            GFXVertexPCT* verts = buffers[e].lock();
+            dMemcpy(verts, tempBuff.address(), numParticles * 4 * sizeof(GFXVertexPCT));
+            buffers[e].unlock();
+        }
+    }
+    U32 emitterTime = Platform::getRealMilliseconds() - startTime;
+
+    // the scene isn't rendering while a console function runs, so the global
+    // manager is free to use
+    ParticleManager& manager = gParticleManager;
+    startTime = Platform::getRealMilliseconds();
+    for (S32 f = 0; f < frames; f++)
+    {
+        manager.begin(world, camPos);
+        for (S32 e = 0; e < numEmitters; e++)
+        {
+            GFXTextureObject* texture = (GFXTextureObject*)(size_t)(16 + (e % numTextures) * 16);
+            manager.addParticles(&lists[e], texture, (e % numTextures) & 1, (e & 2) != 0, true, centers[e]);
+        }
+        manager.fillBatches();
+    }
+    U32 batchTime = Platform::getRealMilliseconds() - startTime;
+    S32 numBatches = manager.getNumBatches();
+    S32 numBatched = manager.getNumParticles();
+    manager.clear();
+
+    Con::printf("Particle batch benchmark: %d emitters of %d particles, %d textures, %d frames",
+        numEmitters, numParticles, numTextures, frames);
+    Con::printf("   per emitter  %6d ms, %d buffers", emitterTime, numEmitters);
+    Con::printf("   batched      %6d ms, %d batches, %d particles", batchTime, numBatches, numBatched);
+    if (numBatched < numEmitters * numParticles)
+        Con::warnf("   %d particles didn't fit in the batch buffer", numEmitters * numParticles - numBatched);
+
+    delete[] lists;
+}
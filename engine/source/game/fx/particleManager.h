@@ -0,0 +1,116 @@
+//-----------------------------------------------------------------------------
+// Torque Shader Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#ifndef _PARTICLEMANAGER_H_
+#define _PARTICLEMANAGER_H_
+
+#ifndef _TVECTOR_H_
+#include "core/tVector.h"
+#endif
+#ifndef _MMATH_H_
+#include "math/mMath.h"
+#endif
+#ifndef _GFXDEVICE_H_
+#include "gfx/gfxDevice.h"
+#endif
+
+class ParticleEmitter;
+class ParticleList;
+
+//*****************************************************************************
+// Particle Manager
+//*****************************************************************************
+/// Draws the visible particle emitters of a scene pass in batches.
+///
+/// Emitters hand themselves over from prepRenderImage instead of filling their
+/// own vertex buffer.  When the pass renders, the emitters are grouped by
+/// texture and blend mode, every batch is written into one shared dynamic
+/// vertex buffer, and each batch goes to the translucent bin as a single
+/// RenderInst.  Alpha blended batches are sorted back to front across all of
+/// their emitters; additive ones don't need it.
+///
+/// A batch is sorted against the other translucent instances at its farthest
+/// emitter.  Batches that no longer fit in the buffer (16 bit indices) fall back
+/// to the emitter drawing itself.
+class ParticleManager
+{
+public:
+    enum Constants
+    {
+        MaxParticles = GFXPrimitiveBufferHandle::MaxIndexCount / 6,    ///< Quads one index buffer can address
+    };
+
+    static bool smBatchParticles;       ///< $pref::Particles::batch
+
+    ParticleManager();
+
+    /// Queues an emitter for the current scene pass.  The first one of a pass
+    /// records the camera and the world matrix the batches are drawn with.
+    void addEmitter(ParticleEmitter* emitter, const Point3F& camPos);
+
+    /// Batches, fills and submits everything queued, then clears the queue.
+    /// Called by SceneState before the render bins are sorted.
+    void submit();
+
+    /// @name Batch Building
+    /// The CPU side of submit, exposed for benchmarkParticleBatch.
+    /// @{
+    void begin(const MatrixF& world, const Point3F& camPos);
+    void addParticles(const ParticleList* particles, GFXTextureObject* texture, bool invAlpha,
+        bool oriented, bool orientOnVelocity, const Point3F& sortPoint);
+    void fillBatches();                 ///< Groups, sorts and writes the vertex buffer
+    void clear();
+
+    S32 getNumBatches() const { return mBatches.size(); }
+    S32 getNumParticles() const { return mNumParticles; }
+    /// @}
+
+private:
+    struct Entry
+    {
+        ParticleEmitter* emitter;       ///< NULL for benchmark lists
+        const ParticleList* particles;
+        GFXTextureObject* texture;
+        bool invAlpha;
+        bool oriented;
+        bool orientOnVelocity;
+        Point3F sortPoint;
+        S32 batch;
+    };
+
+    struct Batch
+    {
+        GFXTextureObject* texture;
+        bool invAlpha;
+        S32 count;
+        S32 start;                      ///< First quad in the vertex buffer, -1 if it didn't fit
+        Point3F sortPoint;
+        F32 sortDist;
+    };
+
+    void handleGFXEvent(GFXDevice::GFXDeviceEventType event);
+    void fillEntry(const Entry& entry, GFXVertexPCT* verts);
+    void fillBatch(const Batch& batch, S32 batchIndex, GFXVertexPCT* verts);
+    void sortQuads(S32 count);
+
+    Vector<Entry> mEntries;
+    Vector<Batch> mBatches;
+    MatrixF mWorld;
+    Point3F mCamPos;
+    S32 mNumParticles;
+
+    // sort scratch
+    Vector<GFXVertexPCT> mScratchVerts;
+    Vector<U32> mKeys, mKeysTemp;
+    Vector<U32> mOrder, mOrderTemp;
+
+    GFXVertexBufferHandle<GFXVertexPCT> mVertBuff;
+    GFXPrimitiveBufferHandle mPrimBuff;
+    S32 mVertBuffSize;                  ///< In quads
+};
+
+extern ParticleManager gParticleManager;
+
+#endif // _PARTICLEMANAGER_H_
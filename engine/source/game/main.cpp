@@ -54,6 +54,7 @@
 #include "sceneGraph/detailManager.h"
 #include "game/version.h"
 #include "platform/profiler.h"
+#include "platform/threadPool.h"
 #include "game/shapeBase.h"
 #include "game/objectTypes.h"
 #include "game/net/serverQuery.h"
@@ -161,11 +162,13 @@ static bool initLibraries()
     ResManager::create();
 
     // Register known file types here
-    ResourceManager->registerExtension(".jpg", constructBitmapJPEG);
-    ResourceManager->registerExtension(".png", constructBitmapPNG);
+    // Types passed true here decode on the ThreadPool when loaded through
+    // ResManager::loadAsync; keep their readers free of shared state.
+    ResourceManager->registerExtension(".jpg", constructBitmapJPEG, true);
+    ResourceManager->registerExtension(".png", constructBitmapPNG, true);
     ResourceManager->registerExtension(".gif", constructBitmapGIF);
     ResourceManager->registerExtension(".dbm", constructBitmapDBM);
-    ResourceManager->registerExtension(".bmp", constructBitmapBMP);
+    ResourceManager->registerExtension(".bmp", constructBitmapBMP, true);
     ResourceManager->registerExtension(".jng", constructBitmapMNG);
     //   ResourceManager->registerExtension(".gft", constructFont);
 #ifdef TORQUE_TERRAIN
@@ -173,11 +176,11 @@ static bool initLibraries()
 #endif
     //ResourceManager->registerExtension(".gf2", constructFont);
     ResourceManager->registerExtension(".uft", constructNewFont);
-    ResourceManager->registerExtension(".dif", constructInteriorDIF);
+    ResourceManager->registerExtension(".dif", constructInteriorDIF, true);
 #ifdef TORQUE_TERRAIN
     ResourceManager->registerExtension(".ter", constructTerrainFile);
 #endif
-    ResourceManager->registerExtension(".dts", constructTSShape);
+    ResourceManager->registerExtension(".dts", constructTSShape, true);
     //   ResourceManager->registerExtension(".dml", constructMaterialList);
     ResourceManager->registerExtension(".map", constructInteriorMAP);
 #ifdef TORQUE_TERRAIN
@@ -193,6 +196,7 @@ static bool initLibraries()
     Processor::init();
     Math::init();
     Platform::init();    // platform specific initialization
+    ThreadPool::createGlobal();  // after Processor::init, needs the core count
     InteriorInstance::init();
     TSShapeInstance::init();
     RedBook::init();
@@ -208,6 +212,12 @@ static bool initLibraries()
 /// Destroys all the things initalized in initLibraries
 static void shutdownLibraries()
 {
+    // Finish any background work while everything it uses is still around.
+    if (ThreadPool::hasGlobal())
+    {
+        ThreadPool::destroyGlobal();
+        ResourceManager->processLoadRequests();
+    }
 
     // Purge any resources on the timeout list...
     if (ResourceManager)
@@ -586,10 +596,16 @@ int DemoGame::main(int argc, const char** argv)
         PROFILE_START(TelDebuggerProcessMain);
         TelDebugger->process();
         PROFILE_END();
+        PROFILE_START(ThreadPoolProcessMain);
+        ThreadPool::getGlobal().processCompletedItems();
+        ResourceManager->processLoadRequests();
+        PROFILE_END();
         PROFILE_START(TimeManagerProcessMain);
         TimeManager::process(); // guaranteed to produce an event
         PROFILE_END();
+        FrameAllocator::endFrame();
         PROFILE_END();
+        PROFILE_FRAME_MARK();
     }
     shutdownGame();
     shutdownLibraries();
@@ -605,6 +605,12 @@ void ShapeBaseData::unpackData(BitStream* stream)
 
 
     shapeName = stream->readSTString();
+
+    // All datablocks of a packet are unpacked before the first is preloaded,
+    // so start reading the shape now; preload() then waits only for this one.
+    if (shapeName && shapeName[0])
+        ResourceManager->loadAsync(shapeName, computeCRC);
+
     cloakTexName = stream->readSTString();
     if (stream->readFlag())
         stream->read(&mass);
@@ -2340,8 +2346,15 @@ void ShapeBase::advanceThreads(F32 dt)
         }
     }
 
+    // Ghosts are only read back at render time, so they can be animated in
+    // one batch once the whole process list has advanced.
     if (anim)
-        mShapeInstance->animate();
+    {
+        if (isGhost())
+            mShapeInstance->deferAnimate();
+        else
+            mShapeInstance->animate();
+    }
 }
 
 
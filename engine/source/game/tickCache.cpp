@@ -6,7 +6,10 @@
 #include "tickCache.h"
 
 #include "game/moveManager.h"
+#include "platform/memoryTag.h"
 
-FreeListChunker<TickCacheEntry> TickCacheEntry::smTickCacheEntryStore;
-FreeListChunker<Move> TickCacheEntry::smMoveStore;
-FreeListChunker<TickCacheHead> TickCacheHead::smTickCacheHeadStore;
+static MemoryTag sTickCacheMemoryTag("TickCache");
+
+FreeListChunker<TickCacheEntry> TickCacheEntry::smTickCacheEntryStore(DataChunker::ChunkSize, &sTickCacheMemoryTag);
+FreeListChunker<Move> TickCacheEntry::smMoveStore(DataChunker::ChunkSize, &sTickCacheMemoryTag);
+FreeListChunker<TickCacheHead> TickCacheHead::smTickCacheHeadStore(DataChunker::ChunkSize, &sTickCacheMemoryTag);
@@ -59,11 +59,24 @@ static int jpegErrorFn(void* client_data)
 
 
 //--------------------------------------
-bool GBitmap::readJPEG(Stream& stream)
+// The library only has one set of I/O hooks, so bind them once up front
+// rather than per call; the stream itself travels in client_data, which lets
+// several threads read or write jpegs at the same time.
+static struct JpegHookInit
 {
-    JFREAD = jpegReadDataFn;
-    JFERROR = jpegErrorFn;
+    JpegHookInit()
+    {
+        JFREAD = jpegReadDataFn;
+        JFWRITE = jpegWriteDataFn;
+        JFFLUSH = jpegFlushDataFn;
+        JFERROR = jpegErrorFn;
+    }
+} sJpegHookInit;
+
 
+//--------------------------------------
+bool GBitmap::readJPEG(Stream& stream)
+{
     jpeg_decompress_struct cinfo;
     jpeg_error_mgr jerr;
 
@@ -145,12 +158,6 @@ bool GBitmap::writeJPEG(Stream& stream) const
     if (height > MAX_HEIGHT)
         return false;
 
-    // Bind our own stream writing, error, and memory flush functions
-    // to the jpeg library interface
-    JFWRITE = jpegWriteDataFn;
-    JFFLUSH = jpegFlushDataFn;
-    JFERROR = jpegErrorFn;
-
     // Allocate and initialize our jpeg compression structure and error manager
     jpeg_compress_struct cinfo;
     jpeg_error_mgr jerr;
@@ -23,13 +23,6 @@
 static png_byte DGL_CHUNK_dcCf[5] = { 100, 99, 67, 102, '\0' };
 static png_byte DGL_CHUNK_dcCs[5] = { 100, 99, 67, 115, '\0' };
 
-#ifdef TORQUE_32K_TEXTURES
-static const U32 csgMaxRowPointers = 32768;
-#else
-static const U32 csgMaxRowPointers = 1024;
-#endif
-static png_bytep sRowPointers[csgMaxRowPointers];
-
 //-------------------------------------- Replacement I/O for standard LIBPng
 //                                        functions.  we don't wanna use
 //                                        FILE*'s...
@@ -250,9 +243,9 @@ bool GBitmap::readPNG(Stream& io_rStream, bool useMemoryManager /* = false */)
         false,            // don't extrude miplevels...
         format);          // use determined format...
 
-     // Set up the row pointers...
-    AssertISV(height <= csgMaxRowPointers, "Error, cannot load pngs taller than 1024 pixels!");
-    png_bytep* rowPointers = sRowPointers;
+    // Set up the row pointers, on this thread's frame allocator so several
+    //  pngs can be read at once; released with the watermark below.
+    png_bytep* rowPointers = (png_bytep*)FrameAllocator::alloc(height * sizeof(png_bytep));
     U8* pBase = (U8*)getBits();
     for (U32 i = 0; i < height; i++)
         rowPointers[i] = pBase + (i * rowBytes);
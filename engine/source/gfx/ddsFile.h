@@ -11,6 +11,8 @@
 #include "core/stream.h"
 #include "core/tVector.h"
 
+#include <atomic>
+
 struct DDSFile
 {
     enum DDSFlags
@@ -27,6 +29,8 @@ struct DDSFile
                               RGBData = BIT(6), ///< Indicates that this is straight out RGBA data.
                               CompressedData = BIT(7), ///< Indicates that this is compressed or otherwise
                                                        ///  exotic data.
+
+                              BakedFlag = BIT(8), ///< Written by bakeTextures(), mSourceCRC is valid.
     };
 
     BitSet32    mFlags;
@@ -39,6 +43,8 @@ struct DDSFile
     GFXFormat   mFormat;
     U32         mBytesPerPixel; ///< Ignored if we're a compressed texture.
     U32         mFourCC;
+    U32         mRGBAMasks[4];  ///< Red, green, blue and alpha bit masks of RGB data.
+    U32         mSourceCRC;     ///< CRC of the image a baked texture was made from.
 
     struct SurfaceData
     {
@@ -79,6 +85,9 @@ struct DDSFile
     bool read(Stream& s);
     bool read(const char* filename);
 
+    /// Write a plain, uncompressed RGB texture and its mips.
+    bool write(Stream& s);
+
     const U32 getWidth(const U32 mipLevel = 0)  const
     {
         return getMax(U32(1), mWidth >> mipLevel);
@@ -126,8 +135,8 @@ struct DDSFile
         }
     }
 
-    // For debugging fun!
-    static S32 smExtantCopies;
+    // For debugging fun!  Atomic since dds files are also loaded on workers.
+    static std::atomic<S32> smExtantCopies;
 
     DDSFile()
     {
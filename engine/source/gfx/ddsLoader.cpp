@@ -7,7 +7,7 @@
 #include "util/fourcc.h"
 #include "gfx/gfxDevice.h"
 
-S32 DDSFile::smExtantCopies = 0;
+std::atomic<S32> DDSFile::smExtantCopies(0);
 
 // These were brutally ripped from their home in the DX9 docs, yayz for me.
 // The names are slightly changed from the "real" defines since not all
@@ -54,11 +54,17 @@ enum DDSCapFlags
 #define FOURCC_DXT4  (MAKEFOURCC('D','X','T','4'))
 #define FOURCC_DXT5  (MAKEFOURCC('D','X','T','5'))
 
+// Marks the reserved header words of a baked texture, the next word is
+// the source CRC.
+#define FOURCC_TBAK  (MAKEFOURCC('T','B','A','K'))
+
 void DDSFile::clear()
 {
     mFlags = 0;
     mHeight = mWidth = mDepth = mPitchOrLinearSize = mMipMapCount = 0;
     mFormat = GFXFormatR8G8B8;
+    mRGBAMasks[0] = mRGBAMasks[1] = mRGBAMasks[2] = mRGBAMasks[3] = 0;
+    mSourceCRC = 0;
 }
 
 U32 DDSFile::getSurfaceSize(U32 height, U32 width, U32 mipLevel)
@@ -189,9 +195,17 @@ bool DDSFile::readHeader(Stream& s)
     }
 
     // Deal with 11 DWORDS of reserved space (this reserved space brought to
-    // you by DirectDraw and the letters F and U).
+    // you by DirectDraw and the letters F and U).  Baked textures keep
+    // their source CRC here.
+    U32 reserved[11];
     for (U32 i = 0; i < 11; i++)
-        s.read(&tmp);
+        s.read(&reserved[i]);
+
+    if (reserved[0] == FOURCC_TBAK)
+    {
+        mFlags.set(BakedFlag);
+        mSourceCRC = reserved[1];
+    }
 
     // Now we're onto the pixel format!
     s.read(&tmp);
@@ -228,24 +242,14 @@ bool DDSFile::readHeader(Stream& s)
     {
         mFlags.set(RGBData);
 
-        Con::printf("RGB Pixel format of DDS:");
-        Con::printf("   bitcount = %d (16, 24, 32)", pfBitCount);
         mBytesPerPixel = pfBitCount / 8;
-        Con::printf("   red   mask = %x", pfRMask);
-        Con::printf("   green mask = %x", pfGMask);
-        Con::printf("   blue  mask = %x", pfBMask);
 
-        bool hasAlpha = false;
+        bool hasAlpha = (ddpfFlags & DDPFAlphaPixels) != 0;
 
-        if (ddpfFlags & DDPFAlphaPixels)
-        {
-            hasAlpha = true;
-            Con::printf("   alpha mask = %x", pfAlphaMask);
-        }
-        else
-        {
-            Con::printf("   no alpha.");
-        }
+        mRGBAMasks[0] = pfRMask;
+        mRGBAMasks[1] = pfGMask;
+        mRGBAMasks[2] = pfBMask;
+        mRGBAMasks[3] = hasAlpha ? pfAlphaMask : 0;
 
         // Try to match a format.
         if (hasAlpha)
@@ -405,6 +409,59 @@ bool DDSFile::read(Stream& s)
 
     return true;
 }
+
+bool DDSFile::write(Stream& s)
+{
+    AssertFatal(mFlags.test(RGBData) && mSurfaces.size() == 1,
+        "DDSFile::write - only plain uncompressed textures can be written.");
+
+    bool hasMips = mMipMapCount > 1;
+
+    s.write(U32(MAKEFOURCC('D', 'D', 'S', ' ')));
+    s.write(U32(124));
+
+    U32 ddsdFlags = DDSDCaps | DDSDPixelFormat | DDSDWidth | DDSDHeight | DDSDPitch;
+    if (hasMips)
+        ddsdFlags |= DDSDMipMapCount;
+    s.write(ddsdFlags);
+
+    s.write(mHeight);
+    s.write(mWidth);
+    s.write(U32(getPitch()));
+    s.write(U32(0));     // Depth
+    s.write(mMipMapCount);
+
+    U32 reserved[11];
+    dMemset(reserved, 0, sizeof(reserved));
+    if (mFlags.test(BakedFlag))
+    {
+        reserved[0] = FOURCC_TBAK;
+        reserved[1] = mSourceCRC;
+    }
+    for (U32 i = 0; i < 11; i++)
+        s.write(reserved[i]);
+
+    // Pixel format.
+    s.write(U32(32));
+    s.write(U32(DDPFRGB | (mRGBAMasks[3] ? DDPFAlphaPixels : 0)));
+    s.write(U32(0));     // FourCC
+    s.write(U32(mBytesPerPixel * 8));
+    for (U32 i = 0; i < 4; i++)
+        s.write(mRGBAMasks[i]);
+
+    // Caps and the reserved words after them.
+    s.write(U32(DDSCAPSTexture | (hasMips ? DDSCAPSComplex | DDSCAPSMipMap : 0)));
+    s.write(U32(0));
+    s.write(U32(0));
+    s.write(U32(0));
+    s.write(U32(0));
+
+    for (U32 i = 0; i < mMipMapCount; i++)
+        s.write(getSurfaceSize(mHeight, mWidth, i), mSurfaces[0]->mMips[i]);
+
+    return s.getStatus() == Stream::Ok;
+}
+
 ConsoleFunction(readDDS, void, 2, 2, "(file ddsFile)")
 {
     DDSFile dds;
@@ -444,5 +501,5 @@ void DDSFile::SurfaceData::addNextMip(DDSFile* dds, Stream& s, U32 height, U32 w
 
 ConsoleFunction(getExtantDDSFiles, S32, 1, 1, "() - Returns active DDSes in memory!")
 {
-    return DDSFile::smExtantCopies;
+    return DDSFile::smExtantCopies.load();
 }
\ No newline at end of file
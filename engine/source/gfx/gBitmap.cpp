@@ -8,14 +8,27 @@
 #include "gBitmap.h"
 #include "gPalette.h"
 #include "core/resManager.h"
+#include "core/tDictionary.h"
 #include "platform/platform.h"
 #include "math/mRect.h"
 #include "platform/profiler.h"
+#include "platform/threadPool.h"
+#include "math/mMathFn.h"
 
 #include "console/console.h"
 
+#include <atomic>
+
+#if defined(TORQUE_CPU_X86) || defined(TORQUE_CPU_X64)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GBITMAP_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
 const U32 GBitmap::csFileVersion = 3;
 U32       GBitmap::sBitmapIdSource = 0;
+bool      GBitmap::sGammaCorrectMips = false;
 
 
 GBitmap::GBitmap()
@@ -447,11 +460,302 @@ void bitmapExtrudeRGBA_c(const void* srcMip, void* mip, U32 srcHeight, U32 srcWi
     }
 }
 
-void (*bitmapExtrude5551)(const void* srcMip, void* mip, U32 height, U32 width) = bitmapExtrude5551_c;
+#if defined(GBITMAP_SSE2)
+//--------------------------------------------------------------------------
+// SSE2 box filters.  These round exactly like the C versions above, so the
+// output is bit for bit the same.  Rows that aren't a multiple of eight
+// pixels, and the 1xN levels, go to the C versions.
+
+void bitmapExtrudeRGB_sse2(const void* srcMip, void* mip, U32 srcHeight, U32 srcWidth)
+{
+    if (srcHeight < 2 || srcWidth < 8 || (srcWidth & 7))
+    {
+        bitmapExtrudeRGB_c(srcMip, mip, srcHeight, srcWidth);
+        return;
+    }
+
+    const U8* src = (const U8*)srcMip;
+    U8* dst = (U8*)mip;
+    const U32 stride = srcWidth * 3;
+    const U32 height = srcHeight >> 1;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+
+    for (U32 y = 0; y < height; y++)
+    {
+        const U8* row0 = src + y * 2 * stride;
+        const U8* row1 = row0 + stride;
+
+        // Eight source pixels (24 bytes) per row make four destination pixels.
+        for (U32 x = 0; x < stride; x += 24)
+        {
+            __m128i top = _mm_loadu_si128((const __m128i*)(row0 + x));
+            __m128i bottom = _mm_loadu_si128((const __m128i*)(row1 + x));
+            __m128i topTail = _mm_loadl_epi64((const __m128i*)(row0 + x + 16));
+            __m128i bottomTail = _mm_loadl_epi64((const __m128i*)(row1 + x + 16));
+
+            // Vertical sums of bytes 0-7, 8-15 and 16-23.
+            __m128i a = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+            __m128i b = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+            __m128i c = _mm_add_epi16(_mm_unpacklo_epi8(topTail, zero), _mm_unpacklo_epi8(bottomTail, zero));
+
+            // Add each byte to the one three further on, i.e. the same
+            // channel of the next pixel.
+            a = _mm_add_epi16(a, _mm_or_si128(_mm_srli_si128(a, 6), _mm_slli_si128(b, 10)));
+            b = _mm_add_epi16(b, _mm_or_si128(_mm_srli_si128(b, 6), _mm_slli_si128(c, 10)));
+            c = _mm_add_epi16(c, _mm_srli_si128(c, 6));
+
+            a = _mm_srli_epi16(_mm_add_epi16(a, two), 2);
+            b = _mm_srli_epi16(_mm_add_epi16(b, two), 2);
+            c = _mm_srli_epi16(_mm_add_epi16(c, two), 2);
+
+            // Every other pixel of the sums is a result.
+            U8 sums[32];
+            _mm_storeu_si128((__m128i*)sums, _mm_packus_epi16(a, b));
+            _mm_storeu_si128((__m128i*)(sums + 16), _mm_packus_epi16(c, c));
+            for (U32 i = 0; i < 4; i++)
+            {
+                *dst++ = sums[i * 6 + 0];
+                *dst++ = sums[i * 6 + 1];
+                *dst++ = sums[i * 6 + 2];
+            }
+        }
+    }
+}
+
+void bitmapExtrudeRGBA_sse2(const void* srcMip, void* mip, U32 srcHeight, U32 srcWidth)
+{
+    if (srcHeight < 2 || srcWidth < 8 || (srcWidth & 7))
+    {
+        bitmapExtrudeRGBA_c(srcMip, mip, srcHeight, srcWidth);
+        return;
+    }
+
+    const U8* src = (const U8*)srcMip;
+    U8* dst = (U8*)mip;
+    const U32 stride = srcWidth * 4;
+    const U32 height = srcHeight >> 1;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+
+    for (U32 y = 0; y < height; y++)
+    {
+        const U8* row0 = src + y * 2 * stride;
+        const U8* row1 = row0 + stride;
+
+        // Eight source pixels (32 bytes) per row make four destination pixels.
+        for (U32 x = 0; x < stride; x += 32)
+        {
+            __m128i top0 = _mm_loadu_si128((const __m128i*)(row0 + x));
+            __m128i top1 = _mm_loadu_si128((const __m128i*)(row0 + x + 16));
+            __m128i bottom0 = _mm_loadu_si128((const __m128i*)(row1 + x));
+            __m128i bottom1 = _mm_loadu_si128((const __m128i*)(row1 + x + 16));
+
+            // Vertical sums, two pixels per register.
+            __m128i p01 = _mm_add_epi16(_mm_unpacklo_epi8(top0, zero), _mm_unpacklo_epi8(bottom0, zero));
+            __m128i p23 = _mm_add_epi16(_mm_unpackhi_epi8(top0, zero), _mm_unpackhi_epi8(bottom0, zero));
+            __m128i p45 = _mm_add_epi16(_mm_unpacklo_epi8(top1, zero), _mm_unpacklo_epi8(bottom1, zero));
+            __m128i p67 = _mm_add_epi16(_mm_unpackhi_epi8(top1, zero), _mm_unpackhi_epi8(bottom1, zero));
+
+            // Horizontal sums.
+            __m128i q01 = _mm_add_epi16(_mm_unpacklo_epi64(p01, p23), _mm_unpackhi_epi64(p01, p23));
+            __m128i q23 = _mm_add_epi16(_mm_unpacklo_epi64(p45, p67), _mm_unpackhi_epi64(p45, p67));
+
+            q01 = _mm_srli_epi16(_mm_add_epi16(q01, two), 2);
+            q23 = _mm_srli_epi16(_mm_add_epi16(q23, two), 2);
+
+            _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(q01, q23));
+            dst += 16;
+        }
+    }
+}
+#endif
+
+//--------------------------------------------------------------------------
+// Gamma correct box filters.  The color channels are averaged in linear
+// space rather than on the sRGB values, which keeps bright detail from
+// going dark in the smaller mips.  Alpha is averaged as is.
+
+static U16 sSRGBToLinear[256];     // 12 bit linear
+static U8  sLinearToSRGB[4096];
+
+static void buildGammaTables()
+{
+    for (U32 i = 0; i < 256; i++)
+    {
+        F32 c = i / 255.0f;
+        F32 linear = c <= 0.04045f ? c / 12.92f : mPow((c + 0.055f) / 1.055f, 2.4f);
+        sSRGBToLinear[i] = U16(linear * 4095.0f + 0.5f);
+    }
+    for (U32 i = 0; i < 4096; i++)
+    {
+        F32 linear = i / 4095.0f;
+        F32 c = linear <= 0.0031308f ? linear * 12.92f : 1.055f * mPow(linear, 1.0f / 2.4f) - 0.055f;
+        sLinearToSRGB[i] = U8(mClampF(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+}
+
+// Built at startup so decoder threads never race to build them.
+static struct GammaTableInit
+{
+    GammaTableInit() { buildGammaTables(); }
+} sGammaTableInit;
+
+static void bitmapExtrudeGamma(const U8* src, U8* dst, U32 srcHeight, U32 srcWidth, U32 bytesPerPixel)
+{
+    U32 width = srcWidth >> 1;
+    U32 height = srcHeight >> 1;
+    if (width == 0) width = 1;
+    if (height == 0) height = 1;
+
+    const U32 stride = srcWidth * bytesPerPixel;
+
+    for (U32 y = 0; y < height; y++)
+    {
+        const U8* row0 = src + getMin(y * 2, srcHeight - 1) * stride;
+        const U8* row1 = src + getMin(y * 2 + 1, srcHeight - 1) * stride;
+
+        for (U32 x = 0; x < width; x++)
+        {
+            U32 x0 = getMin(x * 2, srcWidth - 1) * bytesPerPixel;
+            U32 x1 = getMin(x * 2 + 1, srcWidth - 1) * bytesPerPixel;
+
+            for (U32 i = 0; i < 3; i++)
+            {
+                U32 sum = sSRGBToLinear[row0[x0 + i]] + sSRGBToLinear[row0[x1 + i]] +
+                    sSRGBToLinear[row1[x0 + i]] + sSRGBToLinear[row1[x1 + i]];
+                *dst++ = sLinearToSRGB[(sum + 2) >> 2];
+            }
+            if (bytesPerPixel == 4)
+                *dst++ = (U32(row0[x0 + 3]) + U32(row0[x1 + 3]) + U32(row1[x0 + 3]) + U32(row1[x1 + 3]) + 2) >> 2;
+        }
+    }
+}
+
+static void bitmapExtrudeRGBGamma(const void* srcMip, void* mip, U32 srcHeight, U32 srcWidth)
+{
+    bitmapExtrudeGamma((const U8*)srcMip, (U8*)mip, srcHeight, srcWidth, 3);
+}
+
+static void bitmapExtrudeRGBAGamma(const void* srcMip, void* mip, U32 srcHeight, U32 srcWidth)
+{
+    bitmapExtrudeGamma((const U8*)srcMip, (U8*)mip, srcHeight, srcWidth, 4);
+}
+
+#if defined(GBITMAP_SSE2)
+void (*bitmapExtrudeRGB)(const void* srcMip, void* mip, U32 srcHeight, U32 srcWidth) = bitmapExtrudeRGB_sse2;
+void (*bitmapExtrudeRGBA)(const void* srcMip, void* mip, U32 srcHeight, U32 srcWidth) = bitmapExtrudeRGBA_sse2;
+#else
 void (*bitmapExtrudeRGB)(const void* srcMip, void* mip, U32 srcHeight, U32 srcWidth) = bitmapExtrudeRGB_c;
 void (*bitmapExtrudeRGBA)(const void* srcMip, void* mip, U32 srcHeight, U32 srcWidth) = bitmapExtrudeRGBA_c;
+#endif
+void (*bitmapExtrude5551)(const void* srcMip, void* mip, U32 height, U32 width) = bitmapExtrude5551_c;
 void (*bitmapExtrudePaletted)(const void* srcMip, void* mip, U32 srcHeight, U32 srcWidth) = bitmapExtrudePaletted_c;
 
+//--------------------------------------------------------------------------
+// Large mip levels are split into bands of rows which are filtered on the
+// thread pool.  Each band only reads its own source rows, so any of the
+// kernels above can be used.
+
+typedef void (*BitmapExtrudeFn)(const void* srcMip, void* mip, U32 srcHeight, U32 srcWidth);
+
+static bool sThreadedMips = true;
+
+// The bands of one mip level.  The pool's items and the calling thread take
+// bands off it until none are left; the caller only waits on its own bands.
+struct MipBandBatch
+{
+    enum { BandRows = 32 };
+
+    BitmapExtrudeFn extrude;
+    const U8* src;
+    U8* dst;
+    U32 srcWidth;
+    U32 height;
+    U32 bytesPerPixel;
+    S32 numBands;
+    std::atomic<S32> next;
+    std::atomic<S32> done;
+    std::atomic<S32> refs;
+
+    void run()
+    {
+        const U32 width = srcWidth >> 1;
+
+        S32 i;
+        while ((i = next++) < numBands)
+        {
+            U32 y = i * BandRows;
+            U32 rows = getMin(U32(BandRows), height - y);
+            extrude(src + y * 2 * srcWidth * bytesPerPixel, dst + y * width * bytesPerPixel, rows * 2, srcWidth);
+            done++;
+        }
+    }
+
+    void release()
+    {
+        if (--refs == 0)
+            delete this;
+    }
+};
+
+class MipBandWorkItem : public ThreadPool::WorkItem
+{
+    MipBandBatch* mBatch;
+
+public:
+    MipBandWorkItem(MipBandBatch* batch) { mBatch = batch; }
+    ~MipBandWorkItem() { mBatch->release(); }
+
+    void execute() { mBatch->run(); }
+};
+
+static void extrudeMipLevel(BitmapExtrudeFn extrude, const U8* src, U8* dst, U32 srcHeight, U32 srcWidth, U32 bytesPerPixel)
+{
+    enum
+    {
+        MinThreadedPixels = 256 * 256
+    };
+
+    const U32 width = srcWidth >> 1;
+    const U32 height = srcHeight >> 1;
+
+    if (!sThreadedMips || !ThreadPool::hasGlobal() || !Con::isMainThread() ||
+        width * height < MinThreadedPixels)
+    {
+        extrude(src, dst, srcHeight, srcWidth);
+        return;
+    }
+
+    ThreadPool& pool = ThreadPool::getGlobal();
+    S32 numBands = (height + MipBandBatch::BandRows - 1) / MipBandBatch::BandRows;
+    U32 numItems = getMin(pool.getNumThreads(), U32(numBands - 1));
+
+    MipBandBatch* batch = new MipBandBatch;
+    batch->extrude = extrude;
+    batch->src = src;
+    batch->dst = dst;
+    batch->srcWidth = srcWidth;
+    batch->height = height;
+    batch->bytesPerPixel = bytesPerPixel;
+    batch->numBands = numBands;
+    batch->next = 0;
+    batch->done = 0;
+    batch->refs = numItems + 1;
+
+    for (U32 i = 0; i < numItems; i++)
+        pool.queueWorkItem(new MipBandWorkItem(batch));
+
+    // work alongside the pool, then wait for the bands it's still finishing
+    batch->run();
+    while (batch->done < numBands)
+        Platform::sleep(0);
+
+    batch->release();
+}
+
 
 //--------------------------------------------------------------------------
 void GBitmap::extrudeMipLevels(bool clearBorders)
@@ -474,15 +778,17 @@ void GBitmap::extrudeMipLevels(bool clearBorders)
 
     case GFXFormatR8G8B8:
     {
+        BitmapExtrudeFn extrude = sGammaCorrectMips ? bitmapExtrudeRGBGamma : bitmapExtrudeRGB;
         for (U32 i = 1; i < numMipLevels; i++)
-            bitmapExtrudeRGB(getBits(i - 1), getWritableBits(i), getHeight(i - 1), getWidth(i - 1));
+            extrudeMipLevel(extrude, getBits(i - 1), getWritableBits(i), getHeight(i - 1), getWidth(i - 1), 3);
         break;
     }
 
     case GFXFormatR8G8B8A8:
     {
+        BitmapExtrudeFn extrude = sGammaCorrectMips ? bitmapExtrudeRGBAGamma : bitmapExtrudeRGBA;
         for (U32 i = 1; i < numMipLevels; i++)
-            bitmapExtrudeRGBA(getBits(i - 1), getWritableBits(i), getHeight(i - 1), getWidth(i - 1));
+            extrudeMipLevel(extrude, getBits(i - 1), getWritableBits(i), getHeight(i - 1), getWidth(i - 1), 4);
         break;
     }
 
@@ -863,8 +1169,29 @@ GBitmap* GBitmap::createPaddedBitmap()
 #define EXT_ARRAY_SIZE 6
 static const char* extArray[EXT_ARRAY_SIZE] = { "", ".jpg", ".png", ".gif", ".bmp", ".jng" };
 
+// What each name given to findBmpResource() resolved to, NULL when none of
+// the extensions exist.  Most texture names only exist in one format, or not
+// at all, so without this every lookup costs several failed finds (and in
+// non-shipping builds a disk check each).  Dropped whenever the resource
+// dictionary changes, which also covers purged ResourceObjects.
+static HashTable<StringTableEntry, ResourceObject*> sBmpResourceCache;
+static U32 sBmpResourceCacheGeneration = 0;
+
 ResourceObject* GBitmap::findBmpResource(const char* path, char** hackFileName)
 {
+    PROFILE_SCOPE(GBitmap_findBmpResource);
+
+    U32 generation = ResourceManager->getDictionaryGeneration();
+    if (generation != sBmpResourceCacheGeneration)
+    {
+        sBmpResourceCache.clear();
+        sBmpResourceCacheGeneration = generation;
+    }
+
+    HashTable<StringTableEntry, ResourceObject*>::Iterator itr = sBmpResourceCache.find(path);
+    if (itr != sBmpResourceCache.end())
+        return itr->value;
+
     const U32 BufSize = 4096;
     char fileNameBuffer[BufSize];
     AssertFatal(dStrlen(path) < sizeof(fileNameBuffer), "doh!");
@@ -872,44 +1199,43 @@ ResourceObject* GBitmap::findBmpResource(const char* path, char** hackFileName)
     fileNameBuffer[BufSize - 1] = 0; // null terminate just in case
 
     // Try some different possible filenames.
+    ResourceObject* ret = NULL;
     U32 len = dStrlen(fileNameBuffer);
-    for (U32 i = 0; i < EXT_ARRAY_SIZE; i++)
+    for (U32 i = 0; i < EXT_ARRAY_SIZE && !ret; i++)
     {
         dStrncpy(fileNameBuffer + len, extArray[i], BufSize - len - 1);
-        ResourceObject* ret = ResourceManager->find(fileNameBuffer);
-        if (ret)
-        {
-            return ret;
-        }
+        ret = ResourceManager->find(fileNameBuffer);
+    }
+
+    // A file found on disk goes into the dictionary, so only cache against
+    // the generation it is in now.
+    if (ResourceManager->getDictionaryGeneration() != sBmpResourceCacheGeneration)
+    {
+        sBmpResourceCache.clear();
+        sBmpResourceCacheGeneration = ResourceManager->getDictionaryGeneration();
     }
-    return NULL;
+    sBmpResourceCache.insertUnique(StringTable->insert(path, true), ret);
+
+    return ret;
 }
 
 GBitmap* GBitmap::load(const char* path)
 {
-    const U32 BufSize = 4096;
-    char fileNameBuffer[BufSize];
-    AssertFatal(dStrlen(path) < sizeof(fileNameBuffer), "doh!");
-    dStrncpy(fileNameBuffer, path, sizeof(fileNameBuffer));
-    fileNameBuffer[BufSize - 1] = 0; // null terminate just in case
     GBitmap* bmp = NULL;
 
-    // Try some different possible filenames.
-    U32 len = dStrlen(fileNameBuffer);
-    for (U32 i = 0; i < EXT_ARRAY_SIZE; i++)
-    {
-        dStrncpy(fileNameBuffer + len, extArray[i], BufSize - len - 1);
-        bmp = (GBitmap*)ResourceManager->loadInstance(fileNameBuffer);
-
-        if (bmp != NULL)
-            break;
-    }
+    ResourceObject* ro = findBmpResource(path);
+    if (ro)
+        bmp = (GBitmap*)ResourceManager->loadInstance(ro);
 
     // If unable to load texture in current directory
     // look in the parent directory.  But never look in the root.
-    fileNameBuffer[len] = 0;
     if (!bmp)
     {
+        const U32 BufSize = 4096;
+        char fileNameBuffer[BufSize];
+        dStrncpy(fileNameBuffer, path, sizeof(fileNameBuffer));
+        fileNameBuffer[BufSize - 1] = 0; // null terminate just in case
+
         char* name = dStrrchr(fileNameBuffer, '/');
 
         if (name)
@@ -1080,3 +1406,138 @@ ResourceInstance* constructBitmapDBM(Stream& stream)
     }
 }
 
+
+//------------------------------------------------------------------------------
+//-------------------------------------- Mip generation benchmark
+//
+// Builds the mip chains of every RGB/RGBA bitmap under a directory with each
+// set of kernels and reports the throughput, in megabytes of top level image
+// per second.  The SIMD results are checked against the C ones.
+
+struct MipBenchmarkMode
+{
+    const char* name;
+    BitmapExtrudeFn rgb;
+    BitmapExtrudeFn rgba;
+    bool threaded;
+    bool gamma;
+};
+
+ConsoleFunction(benchmarkMipGeneration, void, 1, 3, "([string path, int passes]) "
+    "Time mip chain generation for the bitmaps under path (marble/data/textures by default).")
+{
+    const char* path = argc > 1 ? argv[1] : "marble/data/textures";
+    U32 passes = argc > 2 ? getMax(dAtoi(argv[2]), 1) : 4;
+    U32 pathLen = dStrlen(path);
+
+    // Find the bitmaps first, loading them could disturb the traversal.
+    Vector<ResourceObject*> files;
+    ResourceManager->startResourceTraverse();
+    while (ResourceObject* obj = ResourceManager->getNextResource())
+    {
+        if (!obj->path || dStrnicmp(obj->path, path, pathLen) || (obj->path[pathLen] && obj->path[pathLen] != '/'))
+            continue;
+
+        const char* ext = dStrrchr(obj->name, '.');
+        if (ext && (!dStricmp(ext, ".png") || !dStricmp(ext, ".jpg") || !dStricmp(ext, ".jng") ||
+            !dStricmp(ext, ".bmp") || !dStricmp(ext, ".gif")))
+            files.push_back(obj);
+    }
+
+    Vector<GBitmap*> bitmaps;
+    U32 totalBytes = 0;
+    for (S32 i = 0; i < files.size(); i++)
+    {
+        GBitmap* bmp = (GBitmap*)ResourceManager->loadInstance(files[i]);
+        if (!bmp)
+            continue;
+
+        // The kernels only matter for power of two RGB and RGBA images.
+        if ((bmp->getFormat() != GFXFormatR8G8B8 && bmp->getFormat() != GFXFormatR8G8B8A8) ||
+            !isPow2(bmp->getWidth()) || !isPow2(bmp->getHeight()))
+        {
+            delete bmp;
+            continue;
+        }
+
+        bitmaps.push_back(bmp);
+        totalBytes += bmp->getWidth() * bmp->getHeight() * bmp->bytesPerPixel;
+    }
+
+    if (!bitmaps.size())
+    {
+        Con::errorf("benchmarkMipGeneration: no RGB or RGBA bitmaps under '%s'.", path);
+        return;
+    }
+
+    Con::printf("Mip generation, %d bitmaps, %.1f MB, %d passes:", bitmaps.size(), totalBytes / 1048576.0f, passes);
+
+    const MipBenchmarkMode modes[] = {
+        { "C", bitmapExtrudeRGB_c, bitmapExtrudeRGBA_c, false, false },
+#if defined(GBITMAP_SSE2)
+        { "SSE2", bitmapExtrudeRGB_sse2, bitmapExtrudeRGBA_sse2, false, false },
+        { "SSE2, threaded", bitmapExtrudeRGB_sse2, bitmapExtrudeRGBA_sse2, true, false },
+#endif
+        { "gamma correct, threaded", bitmapExtrudeRGB, bitmapExtrudeRGBA, true, true },
+    };
+
+    BitmapExtrudeFn oldRGB = bitmapExtrudeRGB;
+    BitmapExtrudeFn oldRGBA = bitmapExtrudeRGBA;
+    bool oldThreaded = sThreadedMips;
+    bool oldGamma = GBitmap::sGammaCorrectMips;
+
+    // The C output of each bitmap, to check the others against.
+    Vector<GBitmap*> reference;
+
+    for (U32 m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+    {
+        const MipBenchmarkMode& mode = modes[m];
+        bitmapExtrudeRGB = mode.rgb;
+        bitmapExtrudeRGBA = mode.rgba;
+        sThreadedMips = mode.threaded;
+        GBitmap::sGammaCorrectMips = mode.gamma;
+
+        U32 time = 0;
+        U32 mismatches = 0;
+        for (U32 pass = 0; pass < passes; pass++)
+        {
+            for (S32 i = 0; i < bitmaps.size(); i++)
+            {
+                const GBitmap* src = bitmaps[i];
+                GBitmap* bmp = new GBitmap(src->getWidth(), src->getHeight(), true, src->getFormat());
+                dMemcpy(bmp->getWritableBits(), src->getBits(),
+                    src->getWidth() * src->getHeight() * src->bytesPerPixel);
+
+                U32 start = Platform::getRealMilliseconds();
+                bmp->extrudeMipLevels();
+                time += Platform::getRealMilliseconds() - start;
+
+                if (pass != 0)
+                    delete bmp;
+                else if (m == 0)
+                    reference.push_back(bmp);
+                else
+                {
+                    if (!mode.gamma && dMemcmp(bmp->pBits, reference[i]->pBits, bmp->byteSize))
+                        mismatches++;
+                    delete bmp;
+                }
+            }
+        }
+
+        F32 seconds = getMax(time, U32(1)) / 1000.0f;
+        Con::printf("   %s: %d ms, %.1f MB/s", mode.name, time, totalBytes * F32(passes) / 1048576.0f / seconds);
+        if (mismatches)
+            Con::errorf("   %s: %d bitmaps differ from the C output!", mode.name, mismatches);
+    }
+
+    bitmapExtrudeRGB = oldRGB;
+    bitmapExtrudeRGBA = oldRGBA;
+    sThreadedMips = oldThreaded;
+    GBitmap::sGammaCorrectMips = oldGamma;
+
+    for (S32 i = 0; i < reference.size(); i++)
+        delete reference[i];
+    for (S32 i = 0; i < bitmaps.size(); i++)
+        delete bitmaps[i];
+}
@@ -100,6 +100,10 @@ public:
     //-------------------------------------- Internal data/operators
     static U32 sBitmapIdSource;
 
+    /// Average RGB and RGBA mips in linear space rather than on the sRGB
+    /// values ($pref::TextureManager::gammaCorrectMips).
+    static bool sGammaCorrectMips;
+
     void deleteImage();
 
     GFXFormat internalFormat;
@@ -235,11 +239,13 @@ inline const U8* GBitmap::getAddress(const S32 in_x, const S32 in_y, const U32 m
 
 extern void (*bitmapExtrude5551)(const void* srcMip, void* mip, U32 height, U32 width);
 extern void (*bitmapExtrudeRGB)(const void* srcMip, void* mip, U32 height, U32 width);
+extern void (*bitmapExtrudeRGBA)(const void* srcMip, void* mip, U32 height, U32 width);
 extern void (*bitmapConvertRGB_to_5551)(U8* src, U32 pixels);
 extern void (*bitmapConvertRGB_to_1555)(U8* src, U32 pixels);
 extern void (*bitmapConvertRGB_to_RGBX)(U8** src, U32 pixels);
 extern void (*bitmapExtrudePaletted)(const void* srcMip, void* mip, U32 height, U32 width);
 
 void bitmapExtrudeRGB_c(const void* srcMip, void* mip, U32 height, U32 width);
+void bitmapExtrudeRGBA_c(const void* srcMip, void* mip, U32 height, U32 width);
 
 #endif //_GBITMAP_H_
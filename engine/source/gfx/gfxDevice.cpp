@@ -71,6 +71,8 @@ GFXDevice::GFXDevice()
     mViewMatrix.identity();
     mProjectionMatrix.identity();
 
+    mSceneCount = 0;
+
     for (int i = 0; i < WORLD_STACK_MAX; i++)
         mWorldMatrix[i].identity();
 
@@ -2088,6 +2090,7 @@ inline void GFXDevice::beginScene()
 inline void GFXDevice::endScene()
 {
     endSceneInternal();
+    mSceneCount++;
 }
 
 //------------------------------------------------------------------------------
@@ -233,6 +233,9 @@ protected:
     /// Set once the device is active.
     bool mCanCurrentlyRender;
 
+    /// Bumped by every endScene.
+    U32 mSceneCount;
+
     /// Set if we're in a mode where we want rendering to occur.
     bool mAllowRender;
 
@@ -693,6 +696,10 @@ public:
     virtual void clear(U32 flags, ColorI color, F32 z, U32 stencil) = 0;
     virtual void beginScene();
     virtual void endScene();
+
+    /// Number of scenes ended so far.  It changes at least once a frame, so
+    /// anything keyed on it can't outlive a device reset.
+    U32 getSceneCount() const { return mSceneCount; }
     //virtual void swapBuffers() = 0;
 
     void setPrimitiveBuffer(GFXPrimitiveBuffer* buffer);
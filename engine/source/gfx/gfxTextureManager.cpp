@@ -10,6 +10,7 @@
 #include "console/consoleTypes.h"
 #include "gui/core/guiCanvas.h"
 #include "math/mathUtils.h"
+#include "core/crc.h"
 
 /// Threshold of total VRAM under which we start scaling textures down...
 ///
@@ -27,6 +28,8 @@ S32 gTextureQualityMode = 0;
 // 0 == none, 1 == 1/(4^1), 2 == 1/(4^2), 3 = 1/(4^3)
 S32 gTextureReductionLevel = 1;
 
+bool gUseBakedTextures = true;
+
 //-----------------------------------------------------------------------------
 
 void GFXTextureManager::init()
@@ -34,6 +37,8 @@ void GFXTextureManager::init()
     Con::addVariable("pref::TextureManager::scaleThreshold", TypeS32, &gTextureScaleThreshold);
     Con::addVariable("pref::TextureManager::qualityMode", TypeS32, &gTextureQualityMode);
     Con::addVariable("pref::TextureManager::reductionLevel", TypeS32, &gTextureReductionLevel);
+    Con::addVariable("pref::TextureManager::gammaCorrectMips", TypeBool, &GBitmap::sGammaCorrectMips);
+    Con::addVariable("pref::TextureManager::useBakedTextures", TypeBool, &gUseBakedTextures);
 }
 
 GFXTextureManager::GFXTextureManager()
@@ -326,7 +331,7 @@ GFXTextureObject* GFXTextureManager::createTexture(GBitmap* bmp, GFXTextureProfi
 }
 
 
-GFXTextureObject* GFXTextureManager::createTexture(DDSFile* dds, GFXTextureProfile* profile, bool deleteDDS)
+GFXTextureObject* GFXTextureManager::createTexture(DDSFile* dds, GFXTextureProfile* profile, bool deleteDDS, StringTableEntry fileName)
 {
     AssertWarn(dds, "GFXTextureManager::createTexture - NULL DDS passed to GFXTextureManager::createTexture.");
 
@@ -342,11 +347,13 @@ GFXTextureObject* GFXTextureManager::createTexture(DDSFile* dds, GFXTextureProfi
 
     // Ignore padding from the profile.
 
-    char* fileName = NULL;
-
     U32 numMips = dds->mMipMapCount;
     validateTexParams(dds->getHeight(), dds->getWidth(), profile, numMips);
 
+    // Only upload the mips the texture has room for.
+    if (numMips == 1)
+        dds->mMipMapCount = 1;
+
     // Call the internal create... (use the real* variables now, as they
     // reflect the reality of the texture we are creating.)
     GFXTextureObject* ret =
@@ -369,7 +376,7 @@ GFXTextureObject* GFXTextureManager::createTexture(DDSFile* dds, GFXTextureProfi
     // Do statistics and book-keeping...
 
     //    - info for the texture...
-    ret->mTextureFileName = NULL;
+    ret->mTextureFileName = fileName;
     ret->mBitmapSize.set(dds->mHeight, dds->mWidth, 0);
 
     if (profile->doStoreBitmap())
@@ -425,6 +432,46 @@ GFXTextureObject* GFXTextureManager::createTexture(const char* filename, GFXText
         }
     }
 
+    // A current bake skips decoding and mip generation.  Textures that keep
+    // their bitmap around still need the GBitmap.
+    if (gUseBakedTextures && !profile->doStoreBitmap())
+    {
+        char bakedName[1024];
+        getBakedFileName(filename, ro, bakedName, sizeof(bakedName));
+        StringTableEntry fileName = ro ? StringTable->insert(ro->getFullPath()) : StringTable->insert(bakedName);
+
+        GFXTextureObject* cacheHit = ro ? NULL : hashFind(fileName);
+        if (cacheHit)
+        {
+            PROFILE_END();
+            return cacheHit;
+        }
+
+        DDSFile* dds = loadBakedTexture(filename, ro);
+        if (dds)
+        {
+            // Drop the top mips in low quality mode, as the bitmap path does.
+            U32 scalePower = getBitmapScalePower(profile);
+            if (scalePower && dds->mMipMapCount > scalePower)
+            {
+                Vector<void*>& mips = dds->mSurfaces[0]->mMips;
+                for (U32 i = 0; i < scalePower; i++)
+                {
+                    delete[] (U8*)mips[0];
+                    mips.erase(U32(0));
+                }
+
+                dds->mWidth = dds->getWidth(scalePower);
+                dds->mHeight = dds->getHeight(scalePower);
+                dds->mMipMapCount -= scalePower;
+            }
+
+            GFXTextureObject* ret = createTexture(dds, profile, true, fileName);
+            PROFILE_END();
+            return ret;
+        }
+    }
+
     // Find and load the texture.
     GBitmap* bmp = GBitmap::load(filename);
 
@@ -686,6 +733,100 @@ void GFXTextureManager::validateTexParams(U32 width, U32 height,
 
 }
 
+//-----------------------------------------------------------------------------
+
+void GFXTextureManager::getBakedChannelMasks(U32 masks[4])
+{
+    // Push a pixel with a different bit in each channel through the swizzle.
+    U8 pixel[4] = { 1, 2, 4, 8 };
+    if (GFXDevice::devicePresent() && GFX->getDeviceSwizzle32())
+        GFX->getDeviceSwizzle32()->InPlace(pixel, sizeof(pixel));
+
+    for (U32 channel = 0; channel < 4; channel++)
+    {
+        masks[channel] = 0;
+        for (U32 i = 0; i < 4; i++)
+            if (pixel[i] == (1 << channel))
+                masks[channel] = 0xFF << (i * 8);
+    }
+}
+
+U32 GFXTextureManager::getSourceCRC(ResourceObject* source)
+{
+    // The same CRC the resource manager computes on load.
+    if (source->crc == InvalidCRC)
+    {
+        Stream* stream = ResourceManager->openStream(source);
+        if (stream)
+        {
+            source->crc = calculateCRCStream(stream, InvalidCRC);
+            ResourceManager->closeStream(stream);
+        }
+    }
+    return source->crc;
+}
+
+void GFXTextureManager::getBakedFileName(const char* filename, ResourceObject* source, char* buffer, U32 bufferSize)
+{
+    if (source)
+    {
+        // foo.png -> foo.dds
+        dSprintf(buffer, bufferSize, "%s/%s", source->path, source->name);
+        char* ext = dStrrchr(buffer, '.');
+        if (ext && !dStrchr(ext, '/'))
+            *ext = 0;
+        dStrcat(buffer, ".dds");
+    }
+    else
+        dSprintf(buffer, bufferSize, "%s.dds", filename);
+}
+
+DDSFile* GFXTextureManager::loadBakedTexture(const char* filename, ResourceObject* source)
+{
+    char bakedName[1024];
+    getBakedFileName(filename, source, bakedName, sizeof(bakedName));
+
+    ResourceObject* baked = ResourceManager->find(bakedName);
+    if (!baked)
+        return NULL;
+
+    PROFILE_START(GFXTextureManager_loadBakedTexture);
+
+    Stream* stream = ResourceManager->openStream(baked);
+    if (!stream)
+    {
+        PROFILE_END();
+        return NULL;
+    }
+
+    DDSFile* dds = new DDSFile;
+    dds->clear();
+    bool ok = dds->read(*stream);
+    ResourceManager->closeStream(stream);
+
+    // It has to be ours, in this device's channel order, and made from the
+    // source as it is now.
+    U32 masks[4];
+    getBakedChannelMasks(masks);
+
+    ok = ok && dds->mFlags.test(DDSFile::BakedFlag) && dds->mFlags.test(DDSFile::RGBData) &&
+        dds->mSurfaces.size() == 1 && dds->mRGBAMasks[0] == masks[0] &&
+        dds->mRGBAMasks[1] == masks[1] && dds->mRGBAMasks[2] == masks[2] &&
+        (!dds->mRGBAMasks[3] || dds->mRGBAMasks[3] == masks[3]);
+
+    if (ok && source && dds->mSourceCRC != getSourceCRC(source))
+        ok = false;
+
+    PROFILE_END();
+
+    if (!ok)
+    {
+        delete dds;
+        return NULL;
+    }
+    return dds;
+}
+
 //-----------------------------------------------------------------------------
 // Reloads texture resource from disk
 //-----------------------------------------------------------------------------
@@ -161,7 +161,8 @@ public:
 
     virtual GFXTextureObject* createTexture(DDSFile* dds,
         GFXTextureProfile* profile,
-        bool deleteDDS);
+        bool deleteDDS,
+        StringTableEntry fileName = NULL);
 
     virtual GFXTextureObject* createTexture(const char* filename,
         GFXTextureProfile* profile);
@@ -208,6 +209,31 @@ public:
     void unregisterTexCallback(S32 handle);
 
     /// @}
+
+    /// @name Baked Textures
+    ///
+    /// bakeTextures() writes a .dds next to each source image, with the mips
+    /// already built and the pixels in the device's channel order.  When
+    /// createTexture() is given a file name it loads the bake instead of the
+    /// image, as long as the CRC of the source it was made from still
+    /// matches ($pref::TextureManager::useBakedTextures).
+    ///
+    /// @{
+
+    /// Channel masks of 32 bit pixels in the device's order.
+    static void getBakedChannelMasks(U32 masks[4]);
+
+    /// CRC of a source image, cached on the resource.
+    static U32 getSourceCRC(ResourceObject* source);
+
+    /// Name of the bake for a texture, next to the source if there is one.
+    static void getBakedFileName(const char* filename, ResourceObject* source, char* buffer, U32 bufferSize);
+
+    /// Load the bake of a texture if it's current, NULL if not.  Without a
+    /// source any bake is taken.
+    static DDSFile* loadBakedTexture(const char* filename, ResourceObject* source);
+
+    /// @}
 };
 
 //-----------------------------------------------------------------------------
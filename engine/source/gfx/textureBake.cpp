@@ -0,0 +1,311 @@
+//-----------------------------------------------------------------------------
+// Torque Shader Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "console/console.h"
+#include "core/resManager.h"
+#include "core/fileStream.h"
+#include "core/crc.h"
+#include "gfx/gBitmap.h"
+#include "gfx/ddsFile.h"
+#include "gfx/gfxDevice.h"
+#include "gfx/gfxTextureManager.h"
+
+//-----------------------------------------------------------------------------
+// Offline texture bake
+//
+// Converts the images under a directory into .dds files that the texture
+// manager can hand to the device as they are: 32 bits per pixel in the
+// device's channel order, with the full mip chain.  Each bake records the
+// CRC of its source, so a stale bake is ignored at load time and rebaked
+// by the next run.
+
+static bool isBakeableImage(const char* name)
+{
+    const char* ext = dStrrchr(name, '.');
+    return ext && (!dStricmp(ext, ".png") || !dStricmp(ext, ".jpg") || !dStricmp(ext, ".jng") ||
+        !dStricmp(ext, ".bmp") || !dStricmp(ext, ".gif"));
+}
+
+/// Build the bake of an image.  Returns NULL for formats the fast path
+/// doesn't handle.
+static DDSFile* bakeBitmap(GBitmap* bmp, U32 sourceCRC)
+{
+    GFXFormat format = bmp->getFormat();
+    if (format != GFXFormatR8G8B8 && format != GFXFormatR8G8B8A8)
+        return NULL;
+
+    bool hasAlpha = format == GFXFormatR8G8B8A8;
+    const U32 width = bmp->getWidth();
+    const U32 height = bmp->getHeight();
+
+    // Everything goes to 32 bits, devices rarely take 24 bit textures.
+    // Without alpha it's padded with opaque alpha and flagged RGBX.
+    GBitmap rgba(width, height, false, GFXFormatR8G8B8A8);
+    if (hasAlpha)
+        dMemcpy(rgba.getWritableBits(), bmp->getBits(), width * height * 4);
+    else
+    {
+        const U8* src = bmp->getBits();
+        U8* dst = rgba.getWritableBits();
+        for (U32 i = 0; i < width * height; i++)
+        {
+            *dst++ = *src++;
+            *dst++ = *src++;
+            *dst++ = *src++;
+            *dst++ = 0xFF;
+        }
+    }
+
+    if (isPow2(width) && isPow2(height))
+        rgba.extrudeMipLevels();
+
+    DDSFile* dds = new DDSFile;
+    dds->clear();
+    dds->mFlags.set(DDSFile::RGBData | DDSFile::BakedFlag);
+    if (rgba.getNumMipLevels() > 1)
+        dds->mFlags.set(DDSFile::MipMapsFlag | DDSFile::ComplexFlag);
+    dds->mWidth = width;
+    dds->mHeight = height;
+    dds->mMipMapCount = rgba.getNumMipLevels();
+    dds->mFormat = hasAlpha ? GFXFormatR8G8B8A8 : GFXFormatR8G8B8X8;
+    dds->mBytesPerPixel = 4;
+    dds->mSourceCRC = sourceCRC;
+
+    GFXTextureManager::getBakedChannelMasks(dds->mRGBAMasks);
+    if (!hasAlpha)
+        dds->mRGBAMasks[3] = 0;
+
+    const Swizzle<U8, 4>* swizzle = GFXDevice::devicePresent() ? GFX->getDeviceSwizzle32() : NULL;
+
+    dds->mSurfaces.push_back(new DDSFile::SurfaceData());
+    for (U32 i = 0; i < dds->mMipMapCount; i++)
+    {
+        U32 size = rgba.getWidth(i) * rgba.getHeight(i) * 4;
+        U8* mip = new U8[size];
+        if (swizzle)
+            swizzle->ToBuffer(mip, rgba.getBits(i), size);
+        else
+            dMemcpy(mip, rgba.getBits(i), size);
+        dds->mSurfaces[0]->mMips.push_back(mip);
+    }
+
+    return dds;
+}
+
+/// True if there is a .dds at bakedName that bakeTextures didn't write, such
+/// as one exported by hand.  Those are never overwritten.
+static bool isForeignDDS(const char* bakedName)
+{
+    ResourceObject* obj = ResourceManager->find(bakedName);
+    if (!obj)
+        return false;
+
+    Stream* stream = ResourceManager->openStream(obj);
+    if (!stream)
+        return true;
+
+    DDSFile header;
+    header.clear();
+    bool baked = header.readHeader(*stream) && header.mFlags.test(DDSFile::BakedFlag);
+    ResourceManager->closeStream(stream);
+
+    return !baked;
+}
+
+ConsoleFunction(bakeTextures, S32, 2, 3, "(string path, bool force=false) "
+    "Bake every image under path to a .dds next to it, with mips, for fast loading. "
+    "Bakes that are still current are skipped unless force is set. Returns the number of textures baked.")
+{
+    const char* path = argv[1];
+    bool force = argc > 2 && dAtob(argv[2]);
+    U32 pathLen = dStrlen(path);
+
+    // Find the images first, writing the bakes adds resources.
+    Vector<ResourceObject*> sources;
+    ResourceManager->startResourceTraverse();
+    while (ResourceObject* obj = ResourceManager->getNextResource())
+    {
+        if (!obj->path || dStrnicmp(obj->path, path, pathLen) || (obj->path[pathLen] && obj->path[pathLen] != '/'))
+            continue;
+        if (isBakeableImage(obj->name))
+            sources.push_back(obj);
+    }
+
+    U32 baked = 0, current = 0, skipped = 0, foreign = 0, failed = 0;
+    U32 start = Platform::getRealMilliseconds();
+
+    for (S32 i = 0; i < sources.size(); i++)
+    {
+        ResourceObject* source = sources[i];
+
+        char bakedName[1024];
+        GFXTextureManager::getBakedFileName(NULL, source, bakedName, sizeof(bakedName));
+
+        if (isForeignDDS(bakedName))
+        {
+            Con::warnf("bakeTextures: %s was not written by bakeTextures, leaving it alone.", bakedName);
+            foreign++;
+            continue;
+        }
+
+        if (!force)
+        {
+            DDSFile* existing = GFXTextureManager::loadBakedTexture(NULL, source);
+            if (existing)
+            {
+                delete existing;
+                current++;
+                continue;
+            }
+        }
+
+        GBitmap* bmp = (GBitmap*)ResourceManager->loadInstance(source);
+        if (!bmp)
+        {
+            Con::errorf("bakeTextures: unable to load %s/%s.", source->path, source->name);
+            failed++;
+            continue;
+        }
+
+        DDSFile* dds = bakeBitmap(bmp, GFXTextureManager::getSourceCRC(source));
+        delete bmp;
+
+        if (!dds)
+        {
+            skipped++;
+            continue;
+        }
+
+        FileStream stream;
+        if (ResourceManager->openFileForWrite(stream, bakedName) && dds->write(stream))
+        {
+            Con::printf("   baked %s", bakedName);
+            baked++;
+        }
+        else
+        {
+            Con::errorf("bakeTextures: unable to write %s.", bakedName);
+            failed++;
+        }
+        delete dds;
+    }
+
+    Con::printf("bakeTextures: %d baked, %d already current, %d skipped (format), %d skipped (not a bake), %d failed in %d ms.",
+        baked, current, skipped, foreign, failed, Platform::getRealMilliseconds() - start);
+
+    return baked;
+}
+
+//-----------------------------------------------------------------------------
+// Round trip test
+//
+// Writes two test images into a directory and bakes it.  The first image's
+// bake has to load back through the texture manager exactly as bakeBitmap
+// made it.  The second one already has a .dds the baker didn't write, which
+// has to survive a forced bake untouched.
+
+static GBitmap* makeTestImage(U32 seed)
+{
+    GBitmap* bmp = new GBitmap(64, 64, false, GFXFormatR8G8B8A8);
+    U8* bits = bmp->getWritableBits();
+    for (U32 i = 0; i < 64 * 64 * 4; i++)
+        bits[i] = U8(i * 7 + seed);
+    return bmp;
+}
+
+static U32 getFileCRC(const char* fileName)
+{
+    ResourceObject* obj = ResourceManager->find(fileName);
+    Stream* stream = obj ? ResourceManager->openStream(obj) : NULL;
+    if (!stream)
+        return 0;
+
+    U32 crc = calculateCRCStream(stream);
+    ResourceManager->closeStream(stream);
+    return crc;
+}
+
+static bool sameBake(const DDSFile* a, const DDSFile* b)
+{
+    if (a->mWidth != b->mWidth || a->mHeight != b->mHeight || a->mMipMapCount != b->mMipMapCount ||
+        a->mFormat != b->mFormat || a->mSourceCRC != b->mSourceCRC || a->mSurfaces.size() != 1)
+        return false;
+
+    for (U32 i = 0; i < a->mMipMapCount; i++)
+    {
+        U32 size = a->getWidth(i) * a->getHeight(i) * a->mBytesPerPixel;
+        if (dMemcmp(a->mSurfaces[0]->mMips[i], b->mSurfaces[0]->mMips[i], size))
+            return false;
+    }
+    return true;
+}
+
+ConsoleFunction(testTextureBake, bool, 2, 2, "(string path) "
+    "Bake two test images written to path, a scratch directory, and check the bake "
+    "loads back as it was made and that a .dds the baker didn't write is left alone.")
+{
+    const char* path = argv[1];
+
+    char imageName[1024], foreignImageName[1024], foreignName[1024];
+    dSprintf(imageName, sizeof(imageName), "%s/bakeTest.png", path);
+    dSprintf(foreignImageName, sizeof(foreignImageName), "%s/bakeTestForeign.png", path);
+    dSprintf(foreignName, sizeof(foreignName), "%s/bakeTestForeign.dds", path);
+
+    GBitmap* image = makeTestImage(0);
+    GBitmap* foreignImage = makeTestImage(1);
+
+    // the hand made .dds is a bake without the baker's mark
+    DDSFile* foreignDDS = bakeBitmap(foreignImage, 0);
+    foreignDDS->mFlags.clear(DDSFile::BakedFlag);
+
+    FileStream stream;
+    bool written = ResourceManager->openFileForWrite(stream, imageName) && image->writePNG(stream);
+    stream.close();
+    written = written && ResourceManager->openFileForWrite(stream, foreignImageName) && foreignImage->writePNG(stream);
+    stream.close();
+    written = written && ResourceManager->openFileForWrite(stream, foreignName) && foreignDDS->write(stream);
+    stream.close();
+
+    delete image;
+    delete foreignImage;
+    delete foreignDDS;
+
+    if (!written)
+    {
+        Con::errorf("testTextureBake: unable to write the test files to %s.", path);
+        return false;
+    }
+
+    U32 foreignCRC = getFileCRC(foreignName);
+    Con::executef(3, "bakeTextures", path, "1");
+
+    // what the bake should be, from the image as it decodes
+    ResourceObject* source = ResourceManager->find(imageName);
+    GBitmap* decoded = source ? (GBitmap*)ResourceManager->loadInstance(source) : NULL;
+    DDSFile* expected = decoded ? bakeBitmap(decoded, GFXTextureManager::getSourceCRC(source)) : NULL;
+    DDSFile* loaded = source ? GFXTextureManager::loadBakedTexture(NULL, source) : NULL;
+
+    bool ok = true;
+    if (!expected || !loaded || !sameBake(loaded, expected))
+    {
+        Con::errorf("testTextureBake: %s did not load back as it was baked.", imageName);
+        ok = false;
+    }
+
+    if (getFileCRC(foreignName) != foreignCRC)
+    {
+        Con::errorf("testTextureBake: bakeTextures overwrote %s.", foreignName);
+        ok = false;
+    }
+
+    delete decoded;
+    delete expected;
+    delete loaded;
+
+    if (ok)
+        Con::printf("testTextureBake: passed.");
+    return ok;
+}
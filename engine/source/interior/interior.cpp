@@ -25,6 +25,7 @@ bool Interior::smRenderEnvironmentMaps = true;
 bool Interior::smUseVertexLighting = false;
 bool Interior::smUseTexturedFog = false;
 bool Interior::smLockArrays = true;
+MemoryTag Interior::smLightmapMemoryTag("InteriorLightmaps");
 
 
 // These are setup by setupActivePolyList
@@ -2734,6 +2735,7 @@ void Interior::generateLightmaps()
     mLightDirMaps.setSize(mMaterialList->size());
     mLightmapKeep.setSize(mMaterialList->size());
 
+    MemoryTagScope tagScope(smLightmapMemoryTag);
     for (U32 i = 0; i < mLightmaps.size(); i++)
     {
         GFXTextureObject* texture = mMaterialList->getMaterial(i);
@@ -46,6 +46,9 @@
 #ifndef _REFLECTPLANE_H_
 #include "gfx/reflectPlane.h"
 #endif
+#ifndef _MEMORYTAG_H_
+#include "platform/memoryTag.h"
+#endif
 
 #include "gfx/gfxDevice.h"
 #include "materials/sceneData.h"
@@ -309,6 +312,9 @@ public:
     static bool smUseTexturedFog;
     static bool smLockArrays;
 
+    /// Charged with the memory of all interior lightmap bitmaps.
+    static MemoryTag smLightmapMemoryTag;
+
     //-------------------------------------- Persistence interface
 public:
     bool read(Stream& stream);
@@ -427,6 +427,8 @@ bool Interior::read(Stream& stream)
         mLightmaps.setSize(vectorSize);
         mLightDirMaps.setSize(vectorSize);
         mLightmapKeep.setSize(vectorSize);
+
+        MemoryTagScope tagScope(smLightmapMemoryTag);
         for (i = 0; i < mLightmaps.size(); i++)
         {
             mLightmaps[i] = new GBitmap;
@@ -459,7 +461,9 @@ bool Interior::read(Stream& stream)
             stream.read(&mLightmapKeep[i]);
         }
 
-        if (GFXDevice::devicePresent())
+        // Textures can only be made on the main thread; interiors decoded by
+        // ResManager::loadAsync skip them (the renderer doesn't sample them).
+        if (GFXDevice::devicePresent() && Con::isMainThread())
         {
             for (i = 0; i < mLightDirMaps.size(); i++)
             {
@@ -554,6 +554,7 @@ GFXTexHandle& InteriorLMManager::duplicateBaseLightmap(LM_HANDLE interiorHandle,
 
     // copy it
     GBitmap* src = mInteriors[interiorHandle]->mInstances[0]->mLightmapHandles[index]->getBitmap();
+    MemoryTagScope tagScope(Interior::smLightmapMemoryTag);
     GBitmap* dest = new GBitmap(*src);
 
     // don't want this texture to be downloaded yet (SceneLighting will take care of that)
@@ -599,6 +600,7 @@ GFXTexHandle& InteriorLMManager::duplicateBaseNormalmap(LM_HANDLE interiorHandle
 
     // copy it
     GBitmap* src = mInteriors[interiorHandle]->mInstances[0]->mNormalVectorHandles[index]->getBitmap();
+    MemoryTagScope tagScope(Interior::smLightmapMemoryTag);
     GBitmap* dest = new GBitmap(*src);
 
     // don't want this texture to be downloaded yet (SceneLighting will take care of that)
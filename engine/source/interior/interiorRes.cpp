@@ -11,6 +11,9 @@
 #include "interior/forceField.h"
 
 #include "interior/interiorRes.h"
+#include "platform/memoryTag.h"
+
+static MemoryTag sInteriorMemoryTag("Interiors");
 
 const U32 InteriorResource::smFileVersion = 44;
 
@@ -310,6 +313,8 @@ GBitmap* InteriorResource::extractPreview(Stream& stream)
 //-------------------------------------- Interior Resource constructor
 ResourceInstance* constructInteriorDIF(Stream& stream)
 {
+    MemoryTagScope tagScope(sInteriorMemoryTag);
+
     InteriorResource* pResource = new InteriorResource;
 
     if (pResource->read(stream) == true)
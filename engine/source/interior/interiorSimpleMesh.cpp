@@ -125,6 +125,9 @@ void InteriorSimpleMesh::render(const RenderInst &copyinst, U32 interiorlmhandle
                                    LightInfo *pridynlight, LightInfo *secdynlight,
                                    GFXTexHandle *pridyntex, GFXTexHandle *secdyntex)
 {
+   if (primBuff.isNull())
+      buildBuffers();
+
    AssertFatal((primBuff->mPrimitiveCount == packedPrimitives.size()), "Primitive mismatch");
 
 	for(S32 i=0; i<packedPrimitives.size(); i++)
@@ -247,7 +250,11 @@ bool InteriorSimpleMesh::read(Stream& stream)
    mathRead(stream, &scale);
 
    calculateBounds();
-   buildBuffers();
+
+   // GFX buffers can only be made on the main thread, render() builds them
+   // for meshes read on a worker
+   if (Con::isMainThread())
+      buildBuffers();
 
    return true;
 }
@@ -80,6 +80,7 @@ U32 sgStatistics::sgInteriorOccluderCount = 0;
 U32 sgStatistics::sgTerrainLexelCount = 0;
 F32 sgStatistics::sgTerrainLexelTime = 0;
 //U32 sgStatistics::sgTerrainOccluderCount = 0;
+U32 sgStatistics::sgStartTime = 0;
 
 
 LightInfo::LightInfo()
@@ -944,6 +945,7 @@ void sgStatistics::sgClear()
     sgTerrainLexelCount = 0;
     sgTerrainLexelTime = 0;
     //sgTerrainOccluderCount = 0;
+    sgStartTime = Platform::getRealMilliseconds();
 }
 
 void sgStatistics::sgPrint()
@@ -952,6 +954,8 @@ void sgStatistics::sgPrint()
     Con::printf("  Lighting Pack lighting system stats:");
     Con::printf("    Interior Lexel Count:                %d", sgInteriorLexelCount);
     Con::printf("    Interior Lexel Time:                 %f", sgInteriorLexelTime);
+    F32 seconds = (Platform::getRealMilliseconds() - sgStartTime) / 1000.f;
+    Con::printf("    Interior Lexels Per Second:          %.0f", (seconds > 0.0f) ? (sgInteriorLexelCount / seconds) : 0.0f);
     Con::printf("    Interior Object Count:               %d", sgInteriorObjectCount);
     Con::printf("    Interior Object Included Count:      %d", sgInteriorObjectIncludedCount);
     Con::printf("    Interior Object Illumination Count:  %d", sgInteriorObjectIlluminationCount);
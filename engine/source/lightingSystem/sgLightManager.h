@@ -320,6 +320,8 @@ public:
     static U32 sgTerrainLexelCount;
     static F32 sgTerrainLexelTime;
     //static U32 sgTerrainOccluderCount;
+    /// Real time at the last sgClear, for the lexels per second benchmark.
+    static U32 sgStartTime;
 
     static void sgClear();
     static void sgPrint();
@@ -11,16 +11,17 @@
 #include "atlas/runtime/atlasInstance2.h"
 #endif
 #include "platform/profiler.h"
+#include "platform/platformMutex.h"
+#include "core/frameAllocator.h"
 #include "interior/interior.h"
 #include "interior/interiorInstance.h"
 #include "lightingSystem/sgLightMap.h"
 #include "lightingSystem/sgLightingModel.h"
 
-/// used to calculate the start and end points
-/// for ray casting directional light.
-#define SG_STATIC_LIGHT_VECTOR_DIST	100
-
 VectorPtr<SceneObject*> sgShadowObjects::sgObjects;
+void* sgShadowObjects::sgRayCastMutex = NULL;
+sgShadowBVH sgShadowObjects::sgBVH;
+bool sgShadowObjects::sgUseBVH = true;
 
 void sgCalculateLightMapTransforms(InteriorInstance* intinst, const Interior::Surface& surf, MatrixF& objspace, MatrixF& tanspace)
 {
@@ -198,7 +199,15 @@ inline bool sgCastLightRay(SceneObject* object, Interior* interior, const Point3
 
     if (interior)
         return interior->castRay(start, end, &info);
-    return object->castRay(start, end, &info);
+
+    // interiors don't change while casting, everything else might...
+    if (object->getTypeMask() & InteriorObjectType)
+        return object->castRay(start, end, &info);
+
+    Mutex::lockMutex(sgShadowObjects::sgRayCastMutex);
+    bool hit = object->castRay(start, end, &info);
+    Mutex::unlockMutex(sgShadowObjects::sgRayCastMutex);
+    return hit;
 }
 
 
@@ -210,10 +219,30 @@ void sgObjectCallback(SceneObject* object, void* vector)
 
 void sgShadowObjects::sgGetObjects(SceneObject* obj)
 {
+    // always called from the main thread before any lighting...
+    if (!sgRayCastMutex)
+        sgRayCastMutex = Mutex::createMutex();
+
     sgObjects.clear();
     obj->getContainer()->findObjects(ShadowCasterObjectType, &sgObjectCallback, &sgObjects);
 }
 
+void sgShadowObjects::sgBuildBVH(Container* container)
+{
+    sgBVH.sgClear();
+    if (!sgUseBVH)
+        return;
+
+    U32 time = Platform::getRealMilliseconds();
+
+    VectorPtr<SceneObject*> objects;
+    container->findObjects(ShadowCasterObjectType, &sgObjectCallback, &objects);
+    sgBVH.sgBuild(objects);
+
+    Con::printf("    Built shadow BVH with %d triangles from %d objects (%3.3f seconds)",
+        sgBVH.sgGetTriangleCount(), objects.size(), (Platform::getRealMilliseconds() - time) / 1000.f);
+}
+
 void sgLightMap::sgGetIntersectingObjects(const Box3F& surfacebox, const LightInfo* light)
 {
     Box3F box = surfacebox;
@@ -232,7 +261,7 @@ void sgLightMap::sgGetIntersectingObjects(const Box3F& surfacebox, const LightIn
 void sgPlanarLightMap::sgSetupLighting()
 {
     // stats...
-    sgStatistics::sgInteriorSurfaceIncludedCount++;
+    sgStats.sgSurfaceIncludedCount++;
 
 
     // get tranformed points...
@@ -355,13 +384,29 @@ void sgPlanarLightMap::sgSetupLighting()
 }
 
 void sgPlanarLightMap::sgCalculateLighting(LightInfo* light)
+{
+    // first get lighting model...
+    sgLightingModel& model = sgLightingModelManager::sgGetLightingModel(
+        light->sgLightingModelName);
+    model.sgSetState(light);
+
+    // this is slow, so only do it if the surface can be lit...
+    if (model.sgCanIlluminate(sgSurfaceBox))
+        model.sgInitStateLM();
+
+    sgCalculateLighting(light, model);
+
+    model.sgResetState();
+}
+
+void sgPlanarLightMap::sgCalculateLighting(LightInfo* light, sgLightingModel& model)
 {
     U32 o;
     U32 i, ii;
 
 
     // stats...
-    sgStatistics::sgInteriorSurfaceIlluminationCount++;
+    sgStats.sgSurfaceIlluminationCount++;
 
 
     // setup zone info...
@@ -396,12 +441,7 @@ void sgPlanarLightMap::sgCalculateLighting(LightInfo* light)
 
     // should I bother?
     if ((!allowdiffuse) && (!allowambient))
-    {
-        //testing...
-        S32 zone = sgInteriorInstance->getSurfaceZone(sgSurfaceIndex, sgInteriorCurrentDetail);
-        Con::printf("Skipping surface in zone %d.", zone);
         return;
-    }
 
     // calculate some static info...
     Point3F run = sgLightMapSVector * sgWidth;
@@ -413,26 +453,18 @@ void sgPlanarLightMap::sgCalculateLighting(LightInfo* light)
     U32 time = Platform::getRealMilliseconds();
     SceneObject* object;
 
-    // first get lighting model...
-    sgLightingModel& model = sgLightingModelManager::sgGetLightingModel(
-        light->sgLightingModelName);
-    model.sgSetState(light);
-
     // test for early out...
     if (!model.sgCanIlluminate(sgSurfaceBox))
     {
-        model.sgResetState();
-
         // stats...
-        sgStatistics::sgInteriorLexelTime += Platform::getRealMilliseconds() - time;
+        sgStats.sgLexelTime += Platform::getRealMilliseconds() - time;
         return;
     }
 
-    // this is slow, so do it after the early out...
-    model.sgInitStateLM();
-
     // build a list of potential shadow casters...
-    if (light->sgCastsShadows && LightManager::sgAllowShadows())
+    const bool castshadows = light->sgCastsShadows && LightManager::sgAllowShadows();
+    const bool usebvh = castshadows && !sgShadowObjects::sgBVH.sgIsEmpty();
+    if (castshadows && !usebvh)
         sgGetIntersectingObjects(sgSurfaceBox, light);
 
     Vector<S32> selfshadowingsurfaces;
@@ -447,9 +479,25 @@ void sgPlanarLightMap::sgCalculateLighting(LightInfo* light)
 
 
     // stats...
-    sgStatistics::sgInteriorSurfaceIlluminatedCount++;
-    sgStatistics::sgInteriorLexelCount += sgInnerLexels.size() + sgOuterLexels.size();
+    sgStats.sgSurfaceIlluminatedCount++;
+    sgStats.sgLexelCount += sgInnerLexels.size() + sgOuterLexels.size();
+
+
+    // the shadow rays are cast in batches, so the lighting
+    // results are kept around until the rays are done...
+    const U32 lexelmax = getMax(sgInnerLexels.size(), sgOuterLexels.size());
+    FrameAllocatorMarker marker;
+    ColorF* diffuses = (ColorF*)marker.alloc(lexelmax * sizeof(ColorF));
+    ColorF* ambients = (ColorF*)marker.alloc(lexelmax * sizeof(ColorF));
+    Point3F* lightingnormals = (Point3F*)marker.alloc(lexelmax * sizeof(Point3F));
+    Point3F* lightpositions = (Point3F*)marker.alloc(lexelmax * sizeof(Point3F));
+    U8* lexelflags = (U8*)marker.alloc(lexelmax * sizeof(U8));
 
+    enum
+    {
+        sglfLit = BIT(0),
+        sglfShadowed = BIT(1)
+    };
 
     for (i = 0; i < sgPlanarLightMap::sglpCount; i++)
     {
@@ -467,6 +515,7 @@ void sgPlanarLightMap::sgCalculateLighting(LightInfo* light)
             templexels = sgOuterLexels.address();
         }
 
+        // step one: run the lighting model...
         for (ii = 0; ii < templexelscount; ii++)
         {
             // get the current lexel...
@@ -477,84 +526,138 @@ void sgPlanarLightMap::sgCalculateLighting(LightInfo* light)
             lightingnormal = VectorF(0.0f, 0.0f, 0.0f);
             model.sgLightingLM(lexel.worldPos, sgPlaneNormal, diffuse, ambient, lightingnormal);
 
-
-            const U32 x = lexel.lmPos.x;
-            const U32 y = lexel.lmPos.y;
-            const U32 lmindex = ((y * sgWidth) + x);
+            diffuses[ii] = diffuse;
+            ambients[ii] = ambient;
+            lightingnormals[ii] = lightingnormal;
+            lexelflags[ii] = 0;
 
             if (allowdiffuse && ((diffuse.red > SG_MIN_LEXEL_INTENSITY) ||
                 (diffuse.green > SG_MIN_LEXEL_INTENSITY) ||
                 (diffuse.blue > SG_MIN_LEXEL_INTENSITY)))
             {
-                // step four: check for shadows...
+                lexelflags[ii] = sglfLit;
 
-                bool shadowed = false;
-                RayInfo info;
+                // set light pos for shadows...
+                lightpositions[ii] = light->mPos;
+                if (light->mType == LightInfo::Vector)
+                {
+                    lightpositions[ii] = SG_STATIC_LIGHT_VECTOR_DIST * light->mDirection * -1;
+                    lightpositions[ii] = lexel.worldPos + lightpositions[ii];
+                }
+            }
+        }
 
-                if (light->sgCastsShadows && LightManager::sgAllowShadows())
+        // step two: cast rays against the other shadow casters...
+        if (usebvh)
+        {
+            Point3F starts[sgShadowBVH::sgPacketSize];
+            Point3F ends[sgShadowBVH::sgPacketSize];
+            U32 indexes[sgShadowBVH::sgPacketSize];
+            bool hits[sgShadowBVH::sgPacketSize];
+            U32 count = 0;
+
+            for (ii = 0; ii < templexelscount; ii++)
+            {
+                if (lexelflags[ii] & sglfLit)
                 {
-                    // set light pos for shadows...
-                    Point3F lightpos = light->mPos;
-                    if (light->mType == LightInfo::Vector)
+                    starts[count] = templexels[ii].worldPos;
+                    ends[count] = lightpositions[ii];
+                    indexes[count] = ii;
+                    count++;
+                }
+
+                if ((count == sgShadowBVH::sgPacketSize) || ((ii == (templexelscount - 1)) && count))
+                {
+                    sgShadowObjects::sgBVH.sgCastRays(starts, ends, count, sgInteriorInstance, hits);
+                    for (o = 0; o < count; o++)
                     {
-                        lightpos = SG_STATIC_LIGHT_VECTOR_DIST * light->mDirection * -1;
-                        lightpos = lexel.worldPos + lightpos;
+                        if (hits[o])
+                            lexelflags[indexes[o]] |= sglfShadowed;
                     }
 
-                    // cast rays against the potential shadow casters...
-                    for (o = 0; o < sgIntersectingObjects.size(); o++)
+                    // stats...
+                    sgStats.sgOccluderCount += count;
+                    count = 0;
+                }
+            }
+        }
+        else if (castshadows)
+        {
+            for (ii = 0; ii < templexelscount; ii++)
+            {
+                if (!(lexelflags[ii] & sglfLit))
+                    continue;
+
+                RayInfo info;
+                for (o = 0; o < sgIntersectingObjects.size(); o++)
+                {
+                    object = sgIntersectingObjects[o];
+                    // ignore self...
+                    if (object != sgInteriorInstance)
                     {
-                        object = sgIntersectingObjects[o];
-                        // ignore self...
-                        if (object != sgInteriorInstance)
+                        if (sgCastLightRay(object, NULL, templexels[ii].worldPos, lightpositions[ii], info))
                         {
-                            if (sgCastLightRay(object, NULL, lexel.worldPos, lightpos, info))
-                            {
-                                shadowed = true;
-                                break;
-                            }
+                            lexelflags[ii] |= sglfShadowed;
+                            break;
                         }
+                    }
 
 
-                        // stats...
-                        sgStatistics::sgInteriorOccluderCount++;
-                    }
+                    // stats...
+                    sgStats.sgOccluderCount++;
+                }
+            }
+        }
 
-                    // cast against self...
-                    if ((!shadowed) && (sgSelfShadowing) &&
-                        (sgCastLightRay(sgInteriorInstance, sgInteriorCurrentDetail, lexel.worldPos, lightpos, info)))
-                    {
-                        // stats...
-                        sgStatistics::sgInteriorOccluderCount++;
+        // step three: self shadowing and applying the light, in
+        // order since the outer lexels depend on the inner ones...
+        for (ii = 0; ii < templexelscount; ii++)
+        {
+            const sgLexel& lexel = templexels[ii];
 
+            const U32 x = lexel.lmPos.x;
+            const U32 y = lexel.lmPos.y;
+            const U32 lmindex = ((y * sgWidth) + x);
 
-                        // prevent self or neighbor surface shadowing...
-                        if (info.face != sgSurfaceIndex)
+            if (lexelflags[ii] & sglfLit)
+            {
+                bool shadowed = (lexelflags[ii] & sglfShadowed) != 0;
+                RayInfo info;
+
+                // cast against self...
+                if (castshadows && (!shadowed) && (sgSelfShadowing) &&
+                    (sgCastLightRay(sgInteriorInstance, sgInteriorCurrentDetail, lexel.worldPos, lightpositions[ii], info)))
+                {
+                    // stats...
+                    sgStats.sgOccluderCount++;
+
+
+                    // prevent self or neighbor surface shadowing...
+                    if (info.face != sgSurfaceIndex)
+                    {
+                        U32 adj = sgAreAdjacent(info.face, sgSurfaceIndex);
+                        if (adj == sgaTrue)
+                            shadowed = false;
+                        else if (adj == sgaFalse)
+                            shadowed = true;
+                        else
                         {
-                            U32 adj = sgAreAdjacent(info.face, sgSurfaceIndex);
-                            if (adj == sgaTrue)
-                                shadowed = false;
-                            else if (adj == sgaFalse)
+                            // maybe... :)
+                            if (i == sglpInner)
+                            {
                                 shadowed = true;
+                                selfshadowingsurfaces.push_back(info.face);
+                            }
                             else
                             {
-                                // maybe... :)
-                                if (i == sglpInner)
-                                {
-                                    shadowed = true;
-                                    selfshadowingsurfaces.push_back(info.face);
-                                }
-                                else
+                                // was it shadowing the inner lexels?
+                                shadowed = false;
+                                for (U32 s = 0; s < selfshadowingsurfaces.size(); s++)
                                 {
-                                    // was it shadowing the inner lexels?
-                                    shadowed = false;
-                                    for (U32 s = 0; s < selfshadowingsurfaces.size(); s++)
+                                    if (selfshadowingsurfaces[s] == info.face)
                                     {
-                                        if (selfshadowingsurfaces[s] == info.face)
-                                        {
-                                            shadowed = true;
-                                            break;
-                                        }
+                                        shadowed = true;
+                                        break;
                                     }
                                 }
                             }
@@ -564,13 +667,14 @@ void sgPlanarLightMap::sgCalculateLighting(LightInfo* light)
 
                 if (!shadowed)
                 {
-                    // step five: apply the lighting to the light map...
+                    // step four: apply the lighting to the light map...
                     sgDirty = true;
-                    sgTexels->sgData[lmindex] += diffuse;
-                    sgVectors->sgData[lmindex] += sgCalculateLightMapVector(lightingnormal, objspace, tanspace);
+                    sgTexels->sgData[lmindex] += diffuses[ii];
+                    sgVectors->sgData[lmindex] += sgCalculateLightMapVector(lightingnormals[ii], objspace, tanspace);
                 }
             }
 
+            ambient = ambients[ii];
             if (allowambient && ((ambient.red > 0.0f) || (ambient.green > 0.0f) || (ambient.blue > 0.0f)))
             {
                 sgDirty = true;
@@ -582,11 +686,19 @@ void sgPlanarLightMap::sgCalculateLighting(LightInfo* light)
         }
     }
 
-    model.sgResetState();
-
-
     // stats...
-    sgStatistics::sgInteriorLexelTime += Platform::getRealMilliseconds() - time;
+    sgStats.sgLexelTime += Platform::getRealMilliseconds() - time;
+}
+
+void sgPlanarLightMap::sgFlushStatistics()
+{
+    sgStatistics::sgInteriorSurfaceIncludedCount += sgStats.sgSurfaceIncludedCount;
+    sgStatistics::sgInteriorSurfaceIlluminationCount += sgStats.sgSurfaceIlluminationCount;
+    sgStatistics::sgInteriorSurfaceIlluminatedCount += sgStats.sgSurfaceIlluminatedCount;
+    sgStatistics::sgInteriorLexelCount += sgStats.sgLexelCount;
+    sgStatistics::sgInteriorOccluderCount += sgStats.sgOccluderCount;
+    sgStatistics::sgInteriorLexelTime += sgStats.sgLexelTime;
+    dMemset(&sgStats, 0, sizeof(sgStats));
 }
 
 U32 sgPlanarLightMap::sgAreAdjacent(U32 surface1, U32 surface2)
@@ -7,13 +7,42 @@
 #define _SGLIGHTMAP_H_
 
 #include "lightingSystem/sgLighting.h"
+#include "lightingSystem/sgShadowBVH.h"
 
+class sgLightingModel;
+
+/// used to calculate the start and end points
+/// for ray casting directional light.
+#define SG_STATIC_LIGHT_VECTOR_DIST	100
 
 class sgShadowObjects
 {
 public:
     static VectorPtr<SceneObject*> sgObjects;
+    /// Serializes ray casts against casters that aren't interiors, since
+    /// those may animate their shapes while casting.
+    static void* sgRayCastMutex;
+    /// All shadow casters of the current lighting pass; empty unless
+    /// sgBuildBVH was called.  sgPlanarLightMap casts its shadow rays
+    /// against this instead of the individual objects when it's built.
+    static sgShadowBVH sgBVH;
+    static bool sgUseBVH;
     static void sgGetObjects(SceneObject* obj);
+    static void sgBuildBVH(Container* container);
+    static void sgClearBVH() { sgBVH.sgClear(); }
+};
+
+/// Lighting statistics gathered by a single light map.  Light maps can be
+/// calculated on worker threads, so they count locally and the owner adds
+/// the counts to sgStatistics from the main thread.
+struct sgLightMapStatistics
+{
+    U32 sgSurfaceIncludedCount;
+    U32 sgSurfaceIlluminationCount;
+    U32 sgSurfaceIlluminatedCount;
+    U32 sgLexelCount;
+    U32 sgOccluderCount;
+    F32 sgLexelTime;
 };
 
 class sgColorMap
@@ -73,7 +102,7 @@ public:
         sgTexels = new sgColorMap(width, height);
         sgVectors = new sgColorMap(width, height);
     }
-    ~sgLightMap()
+    virtual ~sgLightMap()
     {
         delete sgTexels;
         delete sgVectors;
@@ -136,15 +165,26 @@ public:
         sgInteriorCurrentDetail = currentdetail;
         sgSurfaceIndex = surfaceindex;
         sgPlaneNormal = normal;
+        dMemset(&sgStats, 0, sizeof(sgStats));
     }
     /// Transfer the light map to a GBitmap.
     void sgMergeLighting(GBitmap* lightmap, GBitmap* normalmap, U32 xoffset, U32 yoffset);
     /// See: sgLightMap::sgCalculateLighting.
     virtual void sgSetupLighting();
     virtual void sgCalculateLighting(LightInfo* light);
+    /// Same as above, but uses a lighting model whose state has already been
+    /// set and initialized (sgSetState and sgInitStateLM) for the light.  The
+    /// model is only read, so many light maps can be lit by the same light
+    /// on different threads at once.
+    void sgCalculateLighting(LightInfo* light, sgLightingModel& model);
+    /// Add the statistics gathered so far to sgStatistics and clear them.
+    /// Call from the main thread.
+    void sgFlushStatistics();
     bool sgIsDirty() { return sgDirty; }
+    U32 sgGetLexelCount() { return sgWidth * sgHeight; }
 protected:
     bool sgDirty;
+    sgLightMapStatistics sgStats;
     /// Try to avoid false shadows by ignoring direct neighbors.
     U32 sgAreAdjacent(U32 surface1, U32 surface2);
 };
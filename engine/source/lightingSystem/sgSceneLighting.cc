@@ -19,7 +19,9 @@
 #include "game/staticShape.h"
 #include "game/tsStatic.h"
 #include "collision/concretePolyList.h"
+#include "core/crc.h"
 #include "lightingSystem/sgSceneLighting.h"
+#include "lightingSystem/sgLightingModel.h"
 
 
 namespace
@@ -33,7 +35,55 @@ namespace
     bool              gTerminateLighting = false;
     F32               gLightingProgress = 0.f;
     const char* gCompleteCallback = 0;
-    U32               gConnectionMissionCRC = 0xffffffff;
+
+    template <class T> U32 sgHashValue(const T& value, U32 crc)
+    {
+        return(calculateCRC(&value, sizeof(T), crc));
+    }
+
+    U32 sgHashString(const char* str, U32 crc)
+    {
+        if (!str)
+            return(crc);
+        return(calculateCRC(str, dStrlen(str), crc));
+    }
+
+    /// Hash of every light setting that ends up in the light maps.
+    U32 sgHashLight(const LightInfo* light, U32 crc)
+    {
+        crc = sgHashValue(U32(light->mType), crc);
+        crc = sgHashValue(light->mPos, crc);
+        crc = sgHashValue(light->mDirection, crc);
+        crc = sgHashValue(light->mColor, crc);
+        crc = sgHashValue(light->mAmbient, crc);
+        crc = sgHashValue(light->mShadowColor, crc);
+        crc = sgHashValue(light->mRadius, crc);
+        crc = sgHashValue(light->sgSpotAngle, crc);
+        crc = sgHashValue(light->sgCastsShadows, crc);
+        crc = sgHashValue(light->sgDiffuseRestrictZone, crc);
+        crc = sgHashValue(light->sgAmbientRestrictZone, crc);
+        crc = sgHashValue(light->sgZone, crc);
+        crc = sgHashValue(light->sgLocalAmbientAmount, crc);
+        crc = sgHashValue(light->sgSmoothSpotLight, crc);
+        crc = sgHashValue(light->sgDoubleSidedAmbient, crc);
+        crc = sgHashValue(light->sgUseNormals, crc);
+        crc = sgHashValue(light->sgSpotPlane, crc);
+        return(sgHashString(light->sgLightingModelName, crc));
+    }
+
+    /// Hash of a shadow caster's shape and placement.
+    U32 sgHashCaster(SceneObject* obj)
+    {
+        U32 crc = sgHashString(obj->getClassName(), INITIAL_CRC_VALUE);
+        crc = sgHashValue(obj->getTransform(), crc);
+        crc = sgHashValue(obj->getScale(), crc);
+        crc = sgHashValue(obj->getWorldBox(), crc);
+
+        InteriorInstance* interior = dynamic_cast<InteriorInstance*>(obj);
+        if (interior)
+            crc = sgHashValue(interior->getCRC(), crc);
+        return(crc);
+    }
 }
 
 SceneLighting* gLighting = 0;
@@ -43,6 +93,8 @@ F32 gPlaneDistThresh = 0.001;
 
 
 bool SceneLighting::smUseVertexLighting = false;
+bool SceneLighting::smUseLightingJobs = true;
+bool SceneLighting::smRelightInteriors = false;
 
 
 void SceneLighting::sgNewEvent(U32 light, S32 object, U32 event)
@@ -65,7 +117,8 @@ void SceneLighting::sgLightingStartEvent()
 
     sgTimeTemp2 = Platform::getRealMilliseconds();
 
-    // clear interior light maps
+    // clear interior light maps (cached objects are already loaded and
+    // aren't in the list)...
     for (ObjectProxy** proxyItr = mSceneObjects.begin(); proxyItr != mSceneObjects.end(); proxyItr++)
     {
         // is there an object?
@@ -100,10 +153,16 @@ void SceneLighting::sgLightingCompleteEvent()
     // save out the lighting?
     if (Con::getBoolVariable("$pref::sceneLighting::cacheLighting", true))
     {
-        if (!savePersistInfo(mFileName))
-            Con::errorf(ConsoleLogEntry::General, "SceneLighting::light: unable to persist lighting!");
-        else
-            Con::printf("Successfully saved mission lighting file: '%s'", mFileName);
+        U32 saved = 0;
+        for (U32 i = 0; i < mSceneObjects.size(); i++)
+        {
+            if (savePersistInfo(mSceneObjects[i]))
+                saved++;
+            else
+                Con::errorf(ConsoleLogEntry::General, "SceneLighting::light: unable to persist lighting to '%s'!", mSceneObjects[i]->mCacheFileName);
+        }
+
+        Con::printf("Saved lighting for %d objects to '%s'", saved, mCachePath);
     }
 
     Con::printf("Scene lighting complete (%3.3f seconds)", (Platform::getRealMilliseconds() - sgTimeTemp2) / 1000.f);
@@ -300,6 +359,10 @@ void SceneLighting::sgSGPassSetupEvent()
     sgStatistics::sgClear();
     sgStatistics::sgInteriorObjectCount += mLitObjects.size();
 
+    // the shadow tree only serves relit interiors, so it's built when the first one comes up...
+    sgShadowObjects::sgClearBVH();
+    sgShadowBVHBuilt = false;
+
 
     Canvas->paint();
     sgNewEvent(0, 0, sgSceneLightingProcessEvent::sgSGObjectStartEventType);
@@ -371,6 +434,26 @@ void SceneLighting::sgSGObjectProcessEvent(U32 light, S32 object)
         return;
     }
 
+    // interiors keep their stored light maps unless relighting is asked for,
+    // then they light all of their surfaces in one go on the thread pool...
+    InteriorProxy* interior = smRelightInteriors ? dynamic_cast<InteriorProxy*>(mLitObjects[object]) : NULL;
+    if (interior)
+    {
+        // all shadow rays of this pass go through one tree...
+        if (!sgShadowBVHBuilt)
+        {
+            sgShadowObjects::sgBuildBVH(getCurrentClientContainer());
+            sgShadowBVHBuilt = true;
+        }
+
+        interior->sgProcessSurfaces(object);
+        sgSGSetProgress(mLights.size(), object);
+
+        Canvas->paint();
+        sgSGObjectCompleteEvent(object);
+        return;
+    }
+
     // avoid the event overhead...
     // 80 lights == 0.6 seconds an interior without ANY lighting (events only)...
     U32 time = Platform::getRealMilliseconds();
@@ -408,6 +491,7 @@ void SceneLighting::sgSGObjectCompleteEvent(S32 object)
     {
         sgSGSetProgress(mLights.size(), mLitObjects.size());
         Con::printf("  Synapse Gaming Lighting Pack scene lighting complete (%3.3f seconds)", (Platform::getRealMilliseconds() - sgTimeTemp2) / 1000.f);
+        sgShadowObjects::sgClearBVH();
 
         // stats...
         sgStatistics::sgPrint();
@@ -491,7 +575,8 @@ void SceneLighting::processEvent(U32 light, S32 object)
 SceneLighting::SceneLighting()
 {
     mStartTime = 0;
-    mFileName[0] = 0;
+    mCachePath[0] = 0;
+    sgShadowBVHBuilt = false;
     smUseVertexLighting = Interior::smUseVertexLighting;
 
     static bool initialized = false;
@@ -499,6 +584,9 @@ SceneLighting::SceneLighting()
     {
         Con::addVariable("SceneLighting::terminateLighting", TypeBool, &gTerminateLighting);
         Con::addVariable("SceneLighting::lightingProgress", TypeF32, &gLightingProgress);
+        Con::addVariable("SceneLighting::useLightingJobs", TypeBool, &smUseLightingJobs);
+        Con::addVariable("SceneLighting::relightInteriors", TypeBool, &smRelightInteriors);
+        Con::addVariable("SceneLighting::useShadowBVH", TypeBool, &sgShadowObjects::sgUseBVH);
         initialized = true;
     }
 }
@@ -508,9 +596,14 @@ SceneLighting::~SceneLighting()
     gLighting = 0;
     gLightingProgress = 0.f;
 
+    // in case lighting was aborted...
+    sgShadowObjects::sgClearBVH();
+
     ObjectProxy** proxyItr;
     for (proxyItr = mSceneObjects.begin(); proxyItr != mSceneObjects.end(); proxyItr++)
         delete* proxyItr;
+    for (proxyItr = mCachedObjects.begin(); proxyItr != mCachedObjects.end(); proxyItr++)
+        delete* proxyItr;
 }
 
 bool SceneLighting::light(BitSet32 flags)
@@ -596,40 +689,84 @@ bool SceneLighting::light(BitSet32 flags)
     if (!mSceneObjects.size())
         return(false);
 
-    // grab the missions crc
-    U32 missionCRC = calcMissionCRC();
-
-    // remove the '.mis' extension from the mission name
-    char misName[256];
-    dSprintf(misName, sizeof(misName), "%s", Con::getVariable("$Client::MissionFile"));
-    char* dot = dStrstr((const char*)misName, ".mis");
-    if (dot)
-        *dot = '\0';
+    // the lighting files live next to the mission
+    char misPath[256];
+    dSprintf(misPath, sizeof(misPath), "%s", Con::getVariable("$Client::MissionFile"));
+    char* slash = dStrrchr(misPath, '/');
+    if (slash)
+        *slash = '\0';
+    else
+        misPath[0] = '\0';
 
-    // get the mission name
-    if (LightManager::sgAllowFullLightMaps())
-        dSprintf(mFileName, sizeof(mFileName), "%s_%x.ml", misName, missionCRC);
+    if (misPath[0])
+        dSprintf(mCachePath, sizeof(mCachePath), "%s/lighting", misPath);
     else
-        dSprintf(mFileName, sizeof(mFileName), "%s_%x-raw.ml", misName, missionCRC);
-    if (!ResourceManager->isValidWriteFileName(mFileName))
+        dStrcpy(mCachePath, "lighting");
+
+    // key every object by what goes into its lighting
+    Vector<SceneObject*> casters;
+    getCurrentClientContainer()->findObjects(ShadowCasterObjectType, findObjectsCallback, &casters);
+
+    for (U32 i = 0; i < mSceneObjects.size(); i++)
+    {
+        ObjectProxy* proxy = mSceneObjects[i];
+        proxy->mCacheKey = calcCacheKey(proxy, casters);
+
+        char fileName[1024];
+        dSprintf(fileName, sizeof(fileName), "%s/%08x.ml", mCachePath, proxy->mCacheKey);
+        proxy->mCacheFileName = StringTable->insert(fileName);
+    }
+
+    if (!ResourceManager->isValidWriteFileName(mSceneObjects[0]->mCacheFileName))
     {
-        Con::warnf("Invalid filename '%s'.  Failed to light mission.", mFileName);
+        Con::warnf("Invalid filename '%s'.  Failed to light mission.", mSceneObjects[0]->mCacheFileName);
         return(false);
     }
 
     // check for some persisted data, check if being forced..
     if (!flags.test(ForceAlways | ForceWritable))
     {
-        if (loadPersistInfo(mFileName))
+        for (U32 i = 0; i < mSceneObjects.size(); i++)
         {
-            Con::printf(" Successfully loaded mission lighting file: '%s'", mFileName);
+            if (!loadPersistInfo(mSceneObjects[i]))
+                continue;
 
             // touch this file...
-            if (!dFileTouch(mFileName))
-                Con::warnf("  Failed to touch file '%s'.  File may be read only.", mFileName);
+            if (!dFileTouch(mSceneObjects[i]->mCacheFileName))
+                Con::warnf("  Failed to touch file '%s'.  File may be read only.", mSceneObjects[i]->mCacheFileName);
 
-            return(false);
+            mCachedObjects.push_back(mSceneObjects[i]);
+            mSceneObjects.erase(i);
+            i--;
+        }
+
+#ifdef TORQUE_TERRAIN
+        // atlas chunks are cached with their light map proxy...
+        for (U32 i = 0; i < mSceneObjects.size(); i++)
+        {
+            if (!dynamic_cast<AtlasChunkProxy*>(mSceneObjects[i]))
+                continue;
+
+            for (U32 c = 0; c < mCachedObjects.size(); c++)
+            {
+                if (dynamic_cast<AtlasLightMapProxy*>(mCachedObjects[c]) &&
+                    (mCachedObjects[c]->getObject() == mSceneObjects[i]->getObject()))
+                {
+                    mCachedObjects.push_back(mSceneObjects[i]);
+                    mSceneObjects.erase(i);
+                    i--;
+                    break;
+                }
+            }
         }
+#endif
+
+        if (mCachedObjects.size())
+            Con::printf(" Loaded cached lighting for %d of %d objects from '%s'", mCachedObjects.size(),
+                (mCachedObjects.size() + mSceneObjects.size()), mCachePath);
+
+        if (!mSceneObjects.size())
+            return(false);
 
         // texture manager must have lighting complete now
         if (flags.test(LoadOnly))
@@ -643,9 +780,9 @@ bool SceneLighting::light(BitSet32 flags)
     if (!flags.test(ForceAlways))
     {
         FileStream fileStream;
-        if (!ResourceManager->openFileForWrite(fileStream, mFileName))
+        if (!ResourceManager->openFileForWrite(fileStream, mSceneObjects[0]->mCacheFileName))
         {
-            Con::errorf(ConsoleLogEntry::General, "SceneLighting::Light: Failed to light mission.  File '%s' cannot be written to.", mFileName);
+            Con::errorf(ConsoleLogEntry::General, "SceneLighting::Light: Failed to light mission.  File '%s' cannot be written to.", mSceneObjects[0]->mCacheFileName);
             return(false);
         }
     }
@@ -722,7 +859,6 @@ bool SceneLighting::lightScene(const char* callback, BitSet32 flags)
     gTerminateLighting = false;
     gLightingProgress = 0.f;
     gCompleteCallback = callback;
-    gConnectionMissionCRC = con->getMissionCRC();
 
 
     if (!lighting->light(flags))
@@ -801,35 +937,77 @@ void SceneLighting::addStatic(void* terrainproxy, ShadowVolumeBSP* shadowVolume,
 }
 
 //------------------------------------------------------------------------------
-bool SceneLighting::verifyMissionInfo(PersistInfo::PersistChunk* chunk)
+U32 SceneLighting::calcCacheKey(ObjectProxy* proxy, const Vector<SceneObject*>& casters)
 {
-    PersistInfo::MissionChunk* info = dynamic_cast<PersistInfo::MissionChunk*>(chunk);
-    if (!info)
-        return(false);
+    SceneObject* obj = proxy->getObject();
+
+    // the object itself...
+    U32 crc = sgHashValue(proxy->mChunkCRC ^ PersistInfo::smFileVersion, INITIAL_CRC_VALUE);
+    crc = sgHashValue(obj->getTransform(), crc);
+    crc = sgHashValue(obj->getScale(), crc);
+
+    // the lighting settings...
+    crc = sgHashValue(smUseVertexLighting, crc);
+    crc = sgHashValue(LightManager::sgAllowFullLightMaps(), crc);
+    crc = sgHashValue(LightManager::sgAllowShadows(), crc);
+    crc = sgHashValue(LightManager::sgGetLightMapScale(), crc);
+    for (U32 i = 0; i < LightManager::sgPropertyCount; i++)
+        crc = sgHashValue(LightManager::sgGetProperty(i), crc);
+
+    // the lights that reach it, and the space their shadow rays pass through...
+    const Box3F& box = obj->getWorldBox();
+    Box3F casterbox = box;
+    for (U32 i = 0; i < mLights.size(); i++)
+    {
+        LightInfo* light = mLights[i];
 
-    PersistInfo::MissionChunk curInfo;
-    if (!getMissionInfo(&curInfo))
-        return(false);
+        sgLightingModel& model = sgLightingModelManager::sgGetLightingModel(
+            light->sgLightingModelName);
+        model.sgSetState(light);
+        bool lit = model.sgCanIlluminate(box);
+        model.sgResetState();
 
-    return(curInfo.mChunkCRC == info->mChunkCRC);
-}
+        if (!lit)
+            continue;
 
-bool SceneLighting::getMissionInfo(PersistInfo::PersistChunk* chunk)
-{
-    PersistInfo::MissionChunk* info = dynamic_cast<PersistInfo::MissionChunk*>(chunk);
-    if (!info)
-        return(false);
+        crc = sgHashLight(light, crc);
 
-    info->mChunkCRC = gConnectionMissionCRC ^ PersistInfo::smFileVersion;
-    return(true);
+        if (light->mType == LightInfo::Vector)
+        {
+            Point3F offset = light->mDirection * -SG_STATIC_LIGHT_VECTOR_DIST;
+            casterbox.min.setMin(box.min + offset);
+            casterbox.max.setMax(box.max + offset);
+        }
+        else
+        {
+            casterbox.min.setMin(light->mPos);
+            casterbox.max.setMax(light->mPos);
+        }
+    }
+
+    // ...and whatever can shadow it, in any order
+    U32 casterscrc = 0;
+    for (U32 i = 0; i < casters.size(); i++)
+    {
+        if (casterbox.isOverlapped(casters[i]->getWorldBox()))
+            casterscrc += sgHashCaster(casters[i]);
+    }
+
+    return(sgHashValue(casterscrc, crc));
 }
 
 //------------------------------------------------------------------------------
-bool SceneLighting::loadPersistInfo(const char* fileName)
+bool SceneLighting::loadPersistInfo(ObjectProxy* proxy)
 {
+#ifdef TORQUE_TERRAIN
+    // these are loaded with their atlas light map...
+    if (dynamic_cast<AtlasChunkProxy*>(proxy))
+        return(false);
+#endif
+
     // open the file
     Stream* stream = 0;
-    stream = ResourceManager->openStream(fileName);
+    stream = ResourceManager->openStream(proxy->mCacheFileName);
     if (!stream)
         return(false);
 
@@ -839,86 +1017,45 @@ bool SceneLighting::loadPersistInfo(const char* fileName)
     if (!success)
         return(false);
 
-    // verify the mission chunk
-    if (!verifyMissionInfo(persistInfo.mChunks[0]))
+    // the mission chunk holds the key, followed by the object
+    if ((persistInfo.mChunks.size() != 2) || (persistInfo.mChunks[0]->mChunkCRC != proxy->mCacheKey))
         return(false);
 
-#ifdef TORQUE_TERRAIN
-    // remove atlas proxy info, these do not persist here...
-    for (U32 i = 0; i < mSceneObjects.size(); i++)
-    {
-        AtlasChunkProxy* atlas = dynamic_cast<AtlasChunkProxy*>(mSceneObjects[i]);
-        if (atlas)
-        {
-            mSceneObjects.erase(i);
-            i--;
-        }
-    }
-#endif
-
-    if (mSceneObjects.size() != (persistInfo.mChunks.size() - 1))
+    if (!proxy->isValidChunk(persistInfo.mChunks[1]))
         return(false);
 
-    Vector<PersistInfo::PersistChunk*> chunks;
-
-    // ensure that the scene objects are in the same order as the chunks
-    //  - different instances will depend on this
-    U32 i;
-    for (i = 0; i < mSceneObjects.size(); i++)
-    {
-        // 0th chunk is the mission chunk
-        U32 chunkIdx = i + 1;
-        if (chunkIdx >= persistInfo.mChunks.size())
-            return(false);
-
-        if (!mSceneObjects[i]->isValidChunk(persistInfo.mChunks[chunkIdx]))
-            return(false);
-        chunks.push_back(persistInfo.mChunks[chunkIdx]);
-    }
-
-    // get the objects to load in the persisted chunks
-    for (i = 0; i < mSceneObjects.size(); i++)
-        if (!mSceneObjects[i]->setPersistInfo(chunks[i]))
-            return(false);
-
-    return(true);
+    return(proxy->setPersistInfo(persistInfo.mChunks[1]));
 }
 
-bool SceneLighting::savePersistInfo(const char* fileName)
+bool SceneLighting::savePersistInfo(ObjectProxy* proxy)
 {
-    // open the file
-    FileStream file;
-    if (!ResourceManager->openFileForWrite(file, fileName))
-        return(false);
-
     PersistInfo persistInfo;
 
     // add in the mission chunk
     persistInfo.mChunks.push_back(new PersistInfo::MissionChunk);
+    persistInfo.mChunks[0]->mChunkCRC = proxy->mCacheKey;
 
-    // get the mission info, will return false when there are 0 lights
-    if (!getMissionInfo(persistInfo.mChunks[0]))
-        return(false);
-
-    // get all the persist chunks
-    for (U32 i = 0; i < mSceneObjects.size(); i++)
-    {
-        if (isInterior(mSceneObjects[i]->mObj))
-            persistInfo.mChunks.push_back(new PersistInfo::InteriorChunk);
+    // get the persist chunk
+    if (isInterior(proxy->mObj))
+        persistInfo.mChunks.push_back(new PersistInfo::InteriorChunk);
 #ifdef TORQUE_TERRAIN
-        else if (isTerrain(mSceneObjects[i]->mObj))
-            persistInfo.mChunks.push_back(new PersistInfo::TerrainChunk);
-        else if (dynamic_cast<AtlasLightMapProxy*>(mSceneObjects[i]))
-            persistInfo.mChunks.push_back(new PersistInfo::AtlasLightMapChunk);
-        else if (isAtlas(mSceneObjects[i]->mObj))
-            continue;
+    else if (isTerrain(proxy->mObj))
+        persistInfo.mChunks.push_back(new PersistInfo::TerrainChunk);
+    else if (dynamic_cast<AtlasLightMapProxy*>(proxy))
+        persistInfo.mChunks.push_back(new PersistInfo::AtlasLightMapChunk);
+    else if (isAtlas(proxy->mObj))
+        return(true);
 #endif
-        else
-            return(false);
+    else
+        return(false);
 
-        if (!mSceneObjects[i]->getPersistInfo(persistInfo.mChunks.last()))
-            return(false);
-    }
+    if (!proxy->getPersistInfo(persistInfo.mChunks.last()))
+        return(false);
+
+    // open the file
+    FileStream file;
+    if (!ResourceManager->openFileForWrite(file, proxy->mCacheFileName))
+        return(false);
 
     if (!persistInfo.write(file))
         return(false);
@@ -926,10 +1063,23 @@ bool SceneLighting::savePersistInfo(const char* fileName)
     file.close();
 
     // open/close the stream to get the fileSize calculated on the resource object
-    ResourceManager->closeStream(ResourceManager->openStream(fileName));
+    ResourceManager->closeStream(ResourceManager->openStream(proxy->mCacheFileName));
     return(true);
 }
 
+bool SceneLighting::isCacheFileInUse(const char* fileName)
+{
+    for (U32 i = 0; i < mSceneObjects.size(); i++)
+        if (mSceneObjects[i]->mCacheFileName && !dStricmp(fileName, mSceneObjects[i]->mCacheFileName))
+            return(true);
+
+    for (U32 i = 0; i < mCachedObjects.size(); i++)
+        if (mCachedObjects[i]->mCacheFileName && !dStricmp(fileName, mCachedObjects[i]->mCacheFileName))
+            return(true);
+
+    return(false);
+}
+
 struct CacheEntry {
     ResourceObject* mFileObject;
     const char* mFileName;
@@ -1021,8 +1171,8 @@ void SceneLighting::processCache()
     {
         if (match->flags & ResourceObject::File)
         {
-            // dont allow the current file to be removed...
-            if (!dStrstr(name, mFileName))
+            // dont allow the current files to be removed...
+            if (!isCacheFileInUse(name))
             {
                 CacheEntry entry;
                 entry.mFileObject = match;
@@ -1116,31 +1266,6 @@ void SceneLighting::processCache()
     }
 }
 
-static S32 QSORT_CALLBACK compareS32(const void* a, const void* b)
-{
-    return(*((S32*)a) - *((S32*)b));
-}
-
-U32 SceneLighting::calcMissionCRC()
-{
-    // all the objects + mission chunk
-    Vector<U32> crc;
-
-    // grab the object crcs
-    for (U32 i = 0; i < mSceneObjects.size(); i++)
-        crc.push_back(mSceneObjects[i]->mChunkCRC);
-
-    // grab the missions crc
-    PersistInfo::MissionChunk curInfo;
-    getMissionInfo(&curInfo);
-    crc.push_back(curInfo.mChunkCRC);
-
-    // sort them (order may not have been preserved)
-    dQsort(crc.address(), crc.size(), sizeof(U32), compareS32);
-
-    return(calculateCRC(crc.address(), sizeof(U32) * crc.size(), 0xffffffff));
-}
-
 bool SceneLighting::ObjectProxy::calcValidation()
 {
     mChunkCRC = getResourceCRC();
@@ -37,6 +37,7 @@ class SceneLighting : public SimObject
 public:
     S32 sgTimeTemp;
     S32 sgTimeTemp2;
+    bool sgShadowBVHBuilt; ///< built for this SG pass, on the first relit interior
     void sgNewEvent(U32 light, S32 object, U32 event);
 
     void sgLightingStartEvent();
@@ -64,14 +65,6 @@ public:
     // persist objects moved to 'sgScenePersist.h' for clarity...
     // everything below this line should be original code...
 
-    U32 calcMissionCRC();
-
-    bool verifyMissionInfo(PersistInfo::PersistChunk*);
-    bool getMissionInfo(PersistInfo::PersistChunk*);
-
-    bool loadPersistInfo(const char*);
-    bool savePersistInfo(const char*);
-
     class ObjectProxy;
     class TerrainProxy;
     class InteriorProxy;
@@ -90,8 +83,10 @@ public:
     public:
         SimObjectPtr<SceneObject>     mObj;
         U32                           mChunkCRC;
+        U32                           mCacheKey;        ///< Hash of everything that goes into this object's lighting.
+        StringTableEntry              mCacheFileName;   ///< Lighting cache file named after mCacheKey.
 
-        ObjectProxy(SceneObject* obj) : mObj(obj) { mChunkCRC = 0; }
+        ObjectProxy(SceneObject* obj) : mObj(obj) { mChunkCRC = 0; mCacheKey = 0; mCacheFileName = NULL; }
         virtual ~ObjectProxy() {}
         SceneObject* operator->() { return(mObj); }
         SceneObject* getObject() { return(mObj); }
@@ -111,6 +106,11 @@ public:
         ///
         /// There are flags such as ForceAlways and LoadOnly which allow you
         /// to control this behaviour.
+        ///
+        /// Every object is cached in its own file, named after a key built
+        /// from the object, the lights reaching it and the shadow casters
+        /// between them (see SceneLighting::calcCacheKey).  Changing part of
+        /// a mission only relights the objects whose key changed.
         /// @{
         bool calcValidation();
         bool isValidChunk(PersistInfo::PersistChunk*);
@@ -264,9 +264,28 @@ public:
         Vector<LightInfo*> sgLights;
         Vector<sgSurfaceInfo> sgSurfaces;
 
+        /// A surface's light map while it is being lit by sgProcessSurfaces.
+        struct sgSurfaceJob
+        {
+            sgSurfaceInfo* sgInfo;
+            sgPlanarLightMap* sgLightMap;
+            PlaneF sgProjPlane;
+            S32 sgXOffset;
+            S32 sgYOffset;
+        };
+
         void sgAddLight(LightInfo* light, InteriorInstance* interior);
         //void sgLightUniversalPoint(LightInfo *light);
         void sgProcessSurface(const Interior::Surface& surface, U32 i, Interior* detail, bool hasAlarm);
+        /// Light every surface with every light in sgLights, spreading the
+        /// surfaces over the global thread pool.  The light maps come out
+        /// the same as with sgProcessSurface.
+        void sgProcessSurfaces(S32 object);
+
+        sgPlanarLightMap* sgCreateSurfaceLightMap(const Interior::Surface& surface, U32 i, Interior* detail,
+            PlaneF& projPlane, S32& xoff, S32& yoff);
+        static bool sgSurfaceWantsLight(const Interior::Surface& surface, const PlaneF& projPlane, LightInfo* light);
+        void sgMergeSurfaceLightMap(sgPlanarLightMap* lightmap, U32 i, Interior* detail, bool hasAlarm, S32 xoff, S32 yoff);
 
 
         // lighting interface
@@ -336,8 +355,9 @@ public:
 
     typedef Vector<ObjectProxy*>  ObjectProxyList;
 
-    ObjectProxyList            mSceneObjects;
+    ObjectProxyList            mSceneObjects;       ///< Objects that need to be lit.
     ObjectProxyList            mLitObjects;
+    ObjectProxyList            mCachedObjects;      ///< Objects loaded from the lighting cache.
 
     LightInfoList              mLights;
 
@@ -353,14 +373,24 @@ public:
     static bool isLighting();
 
     S32                        mStartTime;
-    char                       mFileName[1024];
+    char                       mCachePath[1024];    ///< Directory holding the per object lighting files.
     static bool                smUseVertexLighting;
+    static bool                smUseLightingJobs;   ///< Light interior surfaces on the thread pool.
+    static bool                smRelightInteriors;  ///< Relight interior surfaces during SG lighting, off by default.
 
     bool light(BitSet32);
     void completed(bool success);
     void processEvent(U32 light, S32 object);
     void processCache();
 
+    /// @name Lighting Cache
+    /// @{
+    U32 calcCacheKey(ObjectProxy*, const Vector<SceneObject*>& casters);
+    bool loadPersistInfo(ObjectProxy*);
+    bool savePersistInfo(ObjectProxy*);
+    bool isCacheFileInUse(const char*);
+    /// @}
+
     // inlined
     bool isAtlas(SceneObject*);
 
@@ -23,6 +23,9 @@
 #include "lightingSystem/sgLightMap.h"
 #include "lightingSystem/sgSceneLightingGlobals.h"
 #include "lightingSystem/sgLightingModel.h"
+#include "platform/threadPool.h"
+
+#include <atomic>
 
 
 /// adds the ability to bake point lights into interior light maps.
@@ -497,6 +500,28 @@ void SceneLighting::InteriorProxy::light(LightInfo* light)
 
 void SceneLighting::InteriorProxy::sgProcessSurface(const Interior::Surface& surface,
     U32 i, Interior* detail, bool hasAlarm)
+{
+    PlaneF projPlane;
+    S32 xoff, yoff;
+    sgPlanarLightMap* lightmap = sgCreateSurfaceLightMap(surface, i, detail, projPlane, xoff, yoff);
+    lightmap->sgSetupLighting();
+
+    for (U32 ii = 0; ii < sgLights.size(); ii++)
+    {
+        // should we even bother?
+        LightInfo* light = sgLights[ii];
+        if (sgSurfaceWantsLight(surface, projPlane, light))
+            lightmap->sgCalculateLighting(light);
+    }
+
+    sgMergeSurfaceLightMap(lightmap, i, detail, hasAlarm, xoff, yoff);
+    lightmap->sgFlushStatistics();
+
+    delete lightmap;
+}
+
+sgPlanarLightMap* SceneLighting::InteriorProxy::sgCreateSurfaceLightMap(const Interior::Surface& surface,
+    U32 i, Interior* detail, PlaneF& projPlane, S32& xoff, S32& yoff)
 {
     // points right way?
     PlaneF plane = detail->getPlane(surface.planeIndex);
@@ -507,7 +532,6 @@ void SceneLighting::InteriorProxy::sgProcessSurface(const Interior::Surface& sur
     const Point3F& scale = sgInterior->getScale();
 
     //
-    PlaneF projPlane;
     mTransformPlane(transform, scale, plane, &projPlane);
 
     //-----------------------------
@@ -518,7 +542,7 @@ void SceneLighting::InteriorProxy::sgProcessSurface(const Interior::Surface& sur
     //
     // Support for interior light map border sizes.
     //
-    S32 xlen, ylen, xoff, yoff;
+    S32 xlen, ylen;
     S32 lmborder = detail->getLightMapBorderSize();
     xlen = surface.mapSizeX + (lmborder * 2);
     ylen = surface.mapSizeY + (lmborder * 2);
@@ -668,25 +692,25 @@ void SceneLighting::InteriorProxy::sgProcessSurface(const Interior::Surface& sur
 
     lightmap->sgLightMapSVector = sVec;
     lightmap->sgLightMapTVector = tVec;
-    lightmap->sgSetupLighting();
 
-    for (U32 ii = 0; ii < sgLights.size(); ii++)
-    {
-        // should we even bother?
-        LightInfo* light = sgLights[ii];
+    return lightmap;
+}
 
-        if ((light->mType == LightInfo::Vector) &&
-            (!(surface.surfaceFlags & Interior::SurfaceOutsideVisible)))
-            continue;
+bool SceneLighting::InteriorProxy::sgSurfaceWantsLight(const Interior::Surface& surface,
+    const PlaneF& projPlane, LightInfo* light)
+{
+    if ((light->mType == LightInfo::Vector) &&
+        (!(surface.surfaceFlags & Interior::SurfaceOutsideVisible)))
+        return false;
 
-        if (!((light->mType != LightInfo::Vector) &&
-            (projPlane.distToPlane(light->mPos) <= 0) &&
-            (light->sgLocalAmbientAmount <= 0.0f)))
-        {
-            lightmap->sgCalculateLighting(light);
-        }
-    }
+    return !((light->mType != LightInfo::Vector) &&
+        (projPlane.distToPlane(light->mPos) <= 0) &&
+        (light->sgLocalAmbientAmount <= 0.0f));
+}
 
+void SceneLighting::InteriorProxy::sgMergeSurfaceLightMap(sgPlanarLightMap* lightmap,
+    U32 i, Interior* detail, bool hasAlarm, S32 xoff, S32 yoff)
+{
     if (lightmap->sgIsDirty())
     {
         GFXTexHandle normHandle = gInteriorLMManager.duplicateBaseLightmap(detail->getLMHandle(), sgInterior->getLMHandle(), detail->getNormalLMapIndex(i));
@@ -711,8 +735,223 @@ void SceneLighting::InteriorProxy::sgProcessSurface(const Interior::Surface& sur
 
         lightmap->sgMergeLighting(normLightmap, normalmap, xoff, yoff);
     }
+}
 
-    delete lightmap;
+//------------------------------------------------------------------------------
+
+/// Counts the finished items of one sgRunSurfaceJobs call, so it waits on its
+/// own surfaces and not on everything else queued on the global pool.  The
+/// items hold a reference, since the pool deletes them after the call returns.
+struct sgSurfaceJobCounter
+{
+    std::atomic<S32> done;
+    std::atomic<S32> refs;
+
+    void release()
+    {
+        if (--refs == 0)
+            delete this;
+    }
+};
+
+/// Sets up or lights a run of surface light maps.  Every light map belongs to
+/// exactly one item, so items never touch the same lexels.
+class sgSurfaceLightingWorkItem : public ThreadPool::WorkItem
+{
+    typedef SceneLighting::InteriorProxy::sgSurfaceJob sgSurfaceJob;
+
+    sgSurfaceJob* mJobs;
+    U32 mCount;
+    LightInfo* mLight;          ///< NULL to build the lexel lists.
+    sgLightingModel* mModel;
+    sgSurfaceJobCounter* mCounter;  ///< NULL when run inline.
+
+public:
+    sgSurfaceLightingWorkItem(sgSurfaceJob* jobs, U32 count, LightInfo* light, sgLightingModel* model,
+        sgSurfaceJobCounter* counter)
+    {
+        mJobs = jobs;
+        mCount = count;
+        mLight = light;
+        mModel = model;
+        mCounter = counter;
+        if (mCounter)
+            mCounter->refs++;
+    }
+
+    ~sgSurfaceLightingWorkItem()
+    {
+        if (mCounter)
+            mCounter->release();
+    }
+
+    virtual void execute()
+    {
+        for (U32 i = 0; i < mCount; i++)
+        {
+            sgSurfaceJob& job = mJobs[i];
+            if (!mLight)
+                job.sgLightMap->sgSetupLighting();
+            else if (SceneLighting::InteriorProxy::sgSurfaceWantsLight(*job.sgInfo->sgSurface, job.sgProjPlane, mLight))
+                job.sgLightMap->sgCalculateLighting(mLight, *mModel);
+        }
+
+        if (mCounter)
+            mCounter->done++;
+    }
+};
+
+/// Split the jobs into work items of roughly equal lexel counts and run them.
+static void sgRunSurfaceJobs(Vector<SceneLighting::InteriorProxy::sgSurfaceJob>& jobs,
+    LightInfo* light, sgLightingModel* model)
+{
+    // small surfaces are batched, one item per surface has too much overhead...
+    const U32 lexelsPerItem = 4096;
+
+    bool threaded = SceneLighting::smUseLightingJobs && ThreadPool::hasGlobal();
+
+    sgSurfaceJobCounter* counter = NULL;
+    if (threaded)
+    {
+        counter = new sgSurfaceJobCounter;
+        counter->done = 0;
+        counter->refs = 1;
+    }
+
+    Vector<ThreadPool::WorkItem*> queued;
+    U32 start = 0;
+    U32 lexels = 0;
+    for (U32 i = 0; i < jobs.size(); i++)
+    {
+        lexels += jobs[i].sgLightMap->sgGetLexelCount();
+        if ((lexels < lexelsPerItem) && (i != (jobs.size() - 1)))
+            continue;
+
+        sgSurfaceLightingWorkItem* item = new sgSurfaceLightingWorkItem(&jobs[start], (i + 1 - start), light, model, counter);
+        if (threaded)
+        {
+            ThreadPool::getGlobal().queueWorkItem(item);
+            queued.push_back(item);
+        }
+        else
+        {
+            item->execute();
+            delete item;
+        }
+
+        start = i + 1;
+        lexels = 0;
+    }
+
+    if (!threaded)
+        return;
+
+    // take back whatever the workers haven't started, then wait for the rest;
+    // the pool completes the items later, outside the lighting pass...
+    for (U32 i = 0; i < queued.size(); i++)
+        ThreadPool::getGlobal().runIfQueued(queued[i]);
+    while (counter->done < S32(queued.size()))
+        Platform::sleep(0);
+
+    counter->release();
+}
+
+/// Size of a surface's light map including its border.
+static U32 sgGetSurfaceLexelCount(const SceneLighting::InteriorProxy::sgSurfaceInfo& info)
+{
+    S32 lmborder = info.sgDetail->getLightMapBorderSize();
+    return (info.sgSurface->mapSizeX + (lmborder * 2)) * (info.sgSurface->mapSizeY + (lmborder * 2));
+}
+
+void SceneLighting::InteriorProxy::sgProcessSurfaces(S32 object)
+{
+    // caps the memory used by light maps waiting to be merged...
+    const U32 maxLexelsInFlight = 1 << 20;
+
+    if (!sgLights.size() || !sgSurfaces.size())
+        return;
+
+    S32 time = Platform::getRealMilliseconds();
+
+    // count the passes for the progress bar...
+    U32 chunks = 0;
+    U32 lexels = 0;
+    U32 totallexels = 0;
+    for (U32 i = 0; i < sgSurfaces.size(); i++)
+    {
+        lexels += sgGetSurfaceLexelCount(sgSurfaces[i]);
+        totallexels += sgGetSurfaceLexelCount(sgSurfaces[i]);
+        if ((lexels >= maxLexelsInFlight) || (i == (sgSurfaces.size() - 1)))
+        {
+            chunks++;
+            lexels = 0;
+        }
+    }
+
+    const U32 steps = chunks * sgLights.size();
+    U32 step = 0;
+    U32 painttime = Platform::getRealMilliseconds();
+
+    Vector<sgSurfaceJob> jobs;
+    U32 surface = 0;
+    while (surface < sgSurfaces.size())
+    {
+        // create the next batch of light maps, this is cheap...
+        jobs.clear();
+        lexels = 0;
+        while ((surface < sgSurfaces.size()) && (lexels < maxLexelsInFlight))
+        {
+            sgSurfaceInfo& info = sgSurfaces[surface++];
+            lexels += sgGetSurfaceLexelCount(info);
+
+            jobs.increment();
+            sgSurfaceJob& job = jobs.last();
+            job.sgInfo = &info;
+            job.sgLightMap = sgCreateSurfaceLightMap(*info.sgSurface, info.sgIndex, info.sgDetail,
+                job.sgProjPlane, job.sgXOffset, job.sgYOffset);
+        }
+
+        // sort the lexels...
+        sgRunSurfaceJobs(jobs, NULL, NULL);
+
+        // the lighting models are shared, so the lights go one at a time
+        // and each one lights all of the surfaces at once...
+        for (U32 l = 0; l < sgLights.size(); l++)
+        {
+            LightInfo* light = sgLights[l];
+            sgLightingModel& model = sgLightingModelManager::sgGetLightingModel(
+                light->sgLightingModelName);
+            model.sgSetState(light);
+            model.sgInitStateLM();
+
+            sgRunSurfaceJobs(jobs, light, &model);
+
+            model.sgResetState();
+
+            step++;
+            gLighting->sgSGSetProgress((step * gLighting->mLights.size()) / steps, object);
+            if ((Platform::getRealMilliseconds() - painttime) >= 500)
+            {
+                Canvas->paint();
+                painttime = Platform::getRealMilliseconds();
+            }
+        }
+
+        // and copy them to the bitmaps in order...
+        for (U32 i = 0; i < jobs.size(); i++)
+        {
+            sgSurfaceJob& job = jobs[i];
+            sgMergeSurfaceLightMap(job.sgLightMap, job.sgInfo->sgIndex, job.sgInfo->sgDetail,
+                job.sgInfo->sgHasAlarm, job.sgXOffset, job.sgYOffset);
+            job.sgLightMap->sgFlushStatistics();
+            delete job.sgLightMap;
+        }
+    }
+
+    bool threaded = SceneLighting::smUseLightingJobs && ThreadPool::hasGlobal();
+    Con::printf("    = %d surfaces, %d lexels, %d lights lit in %3.3f seconds (%d threads)",
+        sgSurfaces.size(), totallexels, sgLights.size(), (Platform::getRealMilliseconds() - time) / 1000.f,
+        threaded ? ThreadPool::getGlobal().getNumThreads() + 1 : 1);
 }
 
 void SceneLighting::addInterior(ShadowVolumeBSP* shadowVolume, InteriorProxy& interior, LightInfo* light, S32 level)
@@ -0,0 +1,411 @@
+//-----------------------------------------------------------------------------
+// Torque Game Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#include "lightingSystem/sgShadowBVH.h"
+#include "collision/concretePolyList.h"
+#include "sim/sceneObject.h"
+
+#ifdef SG_SHADOWBVH_SSE
+#include <xmmintrin.h>
+#endif
+
+/// Rays closer than this (as a fraction of their length) to their start
+/// don't count as hits, so lexels don't shadow themselves.
+#define SG_SHADOWBVH_MIN_T      0.00001f
+#define SG_SHADOWBVH_MIN_DET    1.0e-12f
+
+//------------------------------------------------------------------------------
+
+void sgShadowBVH::sgClear()
+{
+    sgTriangles.clear();
+    sgTriangles.compact();
+    sgNodes.clear();
+    sgNodes.compact();
+}
+
+void sgShadowBVH::sgBuild(const VectorPtr<SceneObject*>& objects)
+{
+    sgClear();
+
+    // grab the world space polys...
+    ConcretePolyList polylist;
+    for (U32 i = 0; i < objects.size(); i++)
+    {
+        SceneObject* obj = objects[i];
+        obj->buildPolyList(&polylist, obj->getWorldBox(), obj->getWorldSphere());
+    }
+
+    // and turn them into triangle fans...
+    for (U32 p = 0; p < polylist.mPolyList.size(); p++)
+    {
+        const ConcretePolyList::Poly& poly = polylist.mPolyList[p];
+        if (poly.vertexCount < 3)
+            continue;
+
+        const Point3F& v0 = polylist.mVertexList[polylist.mIndexList[poly.vertexStart]];
+        for (U32 v = 1; (v + 1) < poly.vertexCount; v++)
+        {
+            const Point3F& v1 = polylist.mVertexList[polylist.mIndexList[poly.vertexStart + v]];
+            const Point3F& v2 = polylist.mVertexList[polylist.mIndexList[poly.vertexStart + v + 1]];
+
+            sgTriangles.increment();
+            sgTriangle& tri = sgTriangles.last();
+            tri.sgVert0 = v0;
+            tri.sgEdge1 = v1 - v0;
+            tri.sgEdge2 = v2 - v0;
+            tri.sgObject = poly.object;
+        }
+    }
+
+    sgBuildTree();
+}
+
+void sgShadowBVH::sgBuildTree()
+{
+    if (!sgTriangles.size())
+        return;
+
+    Vector<U32> indices;
+    Vector<Point3F> centers;
+    Vector<Box3F> boxes;
+    indices.setSize(sgTriangles.size());
+    centers.setSize(sgTriangles.size());
+    boxes.setSize(sgTriangles.size());
+
+    for (U32 i = 0; i < sgTriangles.size(); i++)
+    {
+        const sgTriangle& tri = sgTriangles[i];
+        Point3F v1 = tri.sgVert0 + tri.sgEdge1;
+        Point3F v2 = tri.sgVert0 + tri.sgEdge2;
+
+        Box3F& box = boxes[i];
+        box.min = box.max = tri.sgVert0;
+        box.min.setMin(v1);
+        box.min.setMin(v2);
+        box.max.setMax(v1);
+        box.max.setMax(v2);
+        box.getCenter(&centers[i]);
+
+        indices[i] = i;
+    }
+
+    // worst case is one leaf per triangle...
+    sgNodes.reserve(sgTriangles.size() * 2);
+    sgBuildNode(indices, centers, boxes, 0, indices.size(), 0);
+
+    // put the triangles in leaf order...
+    Vector<sgTriangle> sorted;
+    sorted.setSize(sgTriangles.size());
+    for (U32 i = 0; i < indices.size(); i++)
+        sorted[i] = sgTriangles[indices[i]];
+    sgTriangles = sorted;
+}
+
+U32 sgShadowBVH::sgBuildNode(Vector<U32>& indices, const Vector<Point3F>& centers,
+    const Vector<Box3F>& boxes, U32 start, U32 count, U32 depth)
+{
+    U32 nodeindex = sgNodes.size();
+    sgNodes.increment();
+
+    Box3F box = boxes[indices[start]];
+    Box3F centerbox(centers[indices[start]], centers[indices[start]]);
+    for (U32 i = start + 1; i < (start + count); i++)
+    {
+        box.min.setMin(boxes[indices[i]].min);
+        box.max.setMax(boxes[indices[i]].max);
+        centerbox.min.setMin(centers[indices[i]]);
+        centerbox.max.setMax(centers[indices[i]]);
+    }
+
+    sgNodes[nodeindex].sgBox = box;
+
+    if (count <= sgMaxLeafTriangles)
+    {
+        sgNodes[nodeindex].sgStart = start;
+        sgNodes[nodeindex].sgCount = count;
+        return nodeindex;
+    }
+
+    // split the longest axis of the centers in the middle...
+    U32 axis = 0;
+    Point3F extent = centerbox.max - centerbox.min;
+    if (extent.y > extent.x)
+        axis = 1;
+    if (extent.z > extent[axis])
+        axis = 2;
+    F32 split = (centerbox.min[axis] + centerbox.max[axis]) * 0.5f;
+
+    U32 mid = start;
+    if (depth < sgMaxDepth)
+    {
+        for (U32 i = start; i < (start + count); i++)
+        {
+            if (centers[indices[i]][axis] < split)
+            {
+                U32 temp = indices[i];
+                indices[i] = indices[mid];
+                indices[mid] = temp;
+                mid++;
+            }
+        }
+    }
+
+    // all on one side (or too deep), just halve it...
+    if ((mid == start) || (mid == (start + count)))
+        mid = start + (count / 2);
+
+    sgBuildNode(indices, centers, boxes, start, mid - start, depth + 1);
+    U32 right = sgBuildNode(indices, centers, boxes, mid, start + count - mid, depth + 1);
+
+    sgNodes[nodeindex].sgStart = right;
+    sgNodes[nodeindex].sgCount = 0;
+    return nodeindex;
+}
+
+//------------------------------------------------------------------------------
+
+/// Returns the reciprocal, but never infinity, so slab tests stay NaN free.
+inline F32 sgSafeInverse(F32 val)
+{
+    if (mFabs(val) < 1.0e-20f)
+        val = (val < 0.0f) ? -1.0e-20f : 1.0e-20f;
+    return 1.0f / val;
+}
+
+bool sgShadowBVH::sgIntersect(const sgTriangle& tri, const Point3F& start, const Point3F& dir)
+{
+    // Moller-Trumbore...
+    Point3F p;
+    mCross(dir, tri.sgEdge2, &p);
+    F32 det = mDot(tri.sgEdge1, p);
+    if (mFabs(det) < SG_SHADOWBVH_MIN_DET)
+        return false;
+    F32 invdet = 1.0f / det;
+
+    Point3F s = start - tri.sgVert0;
+    F32 u = mDot(s, p) * invdet;
+    if ((u < 0.0f) || (u > 1.0f))
+        return false;
+
+    Point3F q;
+    mCross(s, tri.sgEdge1, &q);
+    F32 v = mDot(dir, q) * invdet;
+    if ((v < 0.0f) || ((u + v) > 1.0f))
+        return false;
+
+    F32 t = mDot(tri.sgEdge2, q) * invdet;
+    return (t > SG_SHADOWBVH_MIN_T) && (t < 1.0f);
+}
+
+bool sgShadowBVH::sgCastRay(const Point3F& start, const Point3F& end, const SceneObject* ignore) const
+{
+    if (sgIsEmpty())
+        return false;
+
+    Point3F dir = end - start;
+    Point3F inv(sgSafeInverse(dir.x), sgSafeInverse(dir.y), sgSafeInverse(dir.z));
+
+    U32 stack[sgStackSize];
+    U32 stackcount = 0;
+    stack[stackcount++] = 0;
+
+    while (stackcount)
+    {
+        const sgNode& node = sgNodes[stack[--stackcount]];
+
+        F32 tmin = 0.0f;
+        F32 tmax = 1.0f;
+        bool miss = false;
+        for (U32 a = 0; a < 3; a++)
+        {
+            F32 t0 = (node.sgBox.min[a] - start[a]) * inv[a];
+            F32 t1 = (node.sgBox.max[a] - start[a]) * inv[a];
+            if (t0 > t1)
+            {
+                F32 temp = t0;
+                t0 = t1;
+                t1 = temp;
+            }
+            tmin = (t0 > tmin) ? t0 : tmin;
+            tmax = (t1 < tmax) ? t1 : tmax;
+            if (tmin > tmax)
+            {
+                miss = true;
+                break;
+            }
+        }
+        if (miss)
+            continue;
+
+        if (node.sgCount)
+        {
+            for (U32 i = node.sgStart; i < (node.sgStart + node.sgCount); i++)
+            {
+                const sgTriangle& tri = sgTriangles[i];
+                if ((tri.sgObject != ignore) && sgIntersect(tri, start, dir))
+                    return true;
+            }
+            continue;
+        }
+
+        AssertFatal((stackcount + 2) <= sgStackSize, "sgShadowBVH::sgCastRay: stack overflow.");
+        stack[stackcount++] = node.sgStart;
+        stack[stackcount++] = U32(&node - sgNodes.address()) + 1;
+    }
+
+    return false;
+}
+
+#ifdef SG_SHADOWBVH_SSE
+
+void sgShadowBVH::sgCastRays(const Point3F* start, const Point3F* end, U32 count,
+    const SceneObject* ignore, bool* hit) const
+{
+    AssertFatal((count <= sgPacketSize), "sgShadowBVH::sgCastRays: too many rays.");
+
+    for (U32 i = 0; i < count; i++)
+        hit[i] = false;
+    if (!count || sgIsEmpty())
+        return;
+
+    // structure of arrays, unused lanes repeat the first ray...
+    F32 o[3][sgPacketSize];
+    F32 d[3][sgPacketSize];
+    F32 inv[3][sgPacketSize];
+    for (U32 i = 0; i < sgPacketSize; i++)
+    {
+        U32 r = (i < count) ? i : 0;
+        for (U32 a = 0; a < 3; a++)
+        {
+            o[a][i] = start[r][a];
+            d[a][i] = end[r][a] - start[r][a];
+            inv[a][i] = sgSafeInverse(d[a][i]);
+        }
+    }
+
+    const __m128 ox = _mm_loadu_ps(o[0]);
+    const __m128 oy = _mm_loadu_ps(o[1]);
+    const __m128 oz = _mm_loadu_ps(o[2]);
+    const __m128 dx = _mm_loadu_ps(d[0]);
+    const __m128 dy = _mm_loadu_ps(d[1]);
+    const __m128 dz = _mm_loadu_ps(d[2]);
+    const __m128 ix = _mm_loadu_ps(inv[0]);
+    const __m128 iy = _mm_loadu_ps(inv[1]);
+    const __m128 iz = _mm_loadu_ps(inv[2]);
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 mint = _mm_set1_ps(SG_SHADOWBVH_MIN_T);
+    const __m128 mindet = _mm_set1_ps(SG_SHADOWBVH_MIN_DET);
+
+    // one bit per ray still looking for a hit...
+    S32 active = (1 << count) - 1;
+
+    U32 stack[sgStackSize];
+    U32 stackcount = 0;
+    stack[stackcount++] = 0;
+
+    while (stackcount && active)
+    {
+        const sgNode& node = sgNodes[stack[--stackcount]];
+        const Box3F& box = node.sgBox;
+
+        // slab test all four rays...
+        __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.x), ox), ix);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.x), ox), ix);
+        __m128 tmin = _mm_max_ps(zero, _mm_min_ps(t0, t1));
+        __m128 tmax = _mm_min_ps(one, _mm_max_ps(t0, t1));
+
+        t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.y), oy), iy);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.y), oy), iy);
+        tmin = _mm_max_ps(tmin, _mm_min_ps(t0, t1));
+        tmax = _mm_min_ps(tmax, _mm_max_ps(t0, t1));
+
+        t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.z), oz), iz);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.z), oz), iz);
+        tmin = _mm_max_ps(tmin, _mm_min_ps(t0, t1));
+        tmax = _mm_min_ps(tmax, _mm_max_ps(t0, t1));
+
+        if (!(_mm_movemask_ps(_mm_cmple_ps(tmin, tmax)) & active))
+            continue;
+
+        if (!node.sgCount)
+        {
+            AssertFatal((stackcount + 2) <= sgStackSize, "sgShadowBVH::sgCastRays: stack overflow.");
+            stack[stackcount++] = node.sgStart;
+            stack[stackcount++] = U32(&node - sgNodes.address()) + 1;
+            continue;
+        }
+
+        for (U32 i = node.sgStart; (i < (node.sgStart + node.sgCount)) && active; i++)
+        {
+            const sgTriangle& tri = sgTriangles[i];
+            if (tri.sgObject == ignore)
+                continue;
+
+            const __m128 e1x = _mm_set1_ps(tri.sgEdge1.x);
+            const __m128 e1y = _mm_set1_ps(tri.sgEdge1.y);
+            const __m128 e1z = _mm_set1_ps(tri.sgEdge1.z);
+            const __m128 e2x = _mm_set1_ps(tri.sgEdge2.x);
+            const __m128 e2y = _mm_set1_ps(tri.sgEdge2.y);
+            const __m128 e2z = _mm_set1_ps(tri.sgEdge2.z);
+
+            // p = dir x edge2
+            __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+            __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+            __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+            __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+            __m128 mask = _mm_cmpge_ps(_mm_max_ps(det, _mm_sub_ps(zero, det)), mindet);
+            __m128 invdet = _mm_div_ps(one, det);
+
+            // s = start - vert0
+            __m128 sx = _mm_sub_ps(ox, _mm_set1_ps(tri.sgVert0.x));
+            __m128 sy = _mm_sub_ps(oy, _mm_set1_ps(tri.sgVert0.y));
+            __m128 sz = _mm_sub_ps(oz, _mm_set1_ps(tri.sgVert0.z));
+
+            __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invdet);
+
+            // q = s x edge1
+            __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+            __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+            __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+            __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invdet);
+            __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invdet);
+
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+            mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+            mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, mint));
+            mask = _mm_and_ps(mask, _mm_cmplt_ps(t, one));
+
+            S32 hits = _mm_movemask_ps(mask) & active;
+            if (!hits)
+                continue;
+
+            for (U32 r = 0; r < count; r++)
+            {
+                if (hits & (1 << r))
+                    hit[r] = true;
+            }
+            active &= ~hits;
+        }
+    }
+}
+
+#else
+
+void sgShadowBVH::sgCastRays(const Point3F* start, const Point3F* end, U32 count,
+    const SceneObject* ignore, bool* hit) const
+{
+    AssertFatal((count <= sgPacketSize), "sgShadowBVH::sgCastRays: too many rays.");
+
+    for (U32 i = 0; i < count; i++)
+        hit[i] = sgCastRay(start[i], end[i], ignore);
+}
+
+#endif
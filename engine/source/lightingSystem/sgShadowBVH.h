@@ -0,0 +1,94 @@
+//-----------------------------------------------------------------------------
+// Torque Game Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#ifndef _SGSHADOWBVH_H_
+#define _SGSHADOWBVH_H_
+
+#ifndef _PLATFORM_H_
+#include "platform/platform.h"
+#endif
+#ifndef _TVECTOR_H_
+#include "core/tVector.h"
+#endif
+#ifndef _MPOINT_H_
+#include "math/mPoint.h"
+#endif
+#ifndef _MBOX_H_
+#include "math/mBox.h"
+#endif
+
+class SceneObject;
+
+#if defined(TORQUE_CPU_X86) || defined(TORQUE_CPU_X64)
+#define SG_SHADOWBVH_SSE
+#endif
+
+/// Bounding volume hierarchy over the polygons of every shadow caster.
+///
+/// Light map generation only needs to know whether anything blocks the path
+/// from a lexel to the light, so instead of casting each shadow ray against
+/// every overlapping object this tree is built once per lighting pass and
+/// answers any-hit queries for whole packets of rays.  Where SSE is
+/// available sgCastRays() traces four rays at a time.
+///
+/// Once built the tree is only read, so it can be queried from several
+/// threads at once.
+class sgShadowBVH
+{
+public:
+    /// Rays per packet in sgCastRays().
+    enum { sgPacketSize = 4 };
+
+private:
+    enum
+    {
+        sgMaxLeafTriangles = 4,
+        sgMaxDepth = 64,
+        sgStackSize = 128
+    };
+
+    struct sgTriangle
+    {
+        Point3F sgVert0;
+        Point3F sgEdge1;
+        Point3F sgEdge2;
+        SceneObject* sgObject;
+    };
+
+    /// Nodes are stored depth first, so the left child directly follows its
+    /// parent.  Leaves have a triangle count, interior nodes don't.
+    struct sgNode
+    {
+        Box3F sgBox;
+        U32 sgStart;        ///< First triangle, or the right child.
+        U32 sgCount;
+    };
+
+    Vector<sgTriangle> sgTriangles;
+    Vector<sgNode> sgNodes;
+
+    void sgBuildTree();
+    U32 sgBuildNode(Vector<U32>& indices, const Vector<Point3F>& centers,
+        const Vector<Box3F>& boxes, U32 start, U32 count, U32 depth);
+
+    static bool sgIntersect(const sgTriangle& tri, const Point3F& start, const Point3F& dir);
+
+public:
+    /// Collect the polygons of the objects and build the tree.
+    void sgBuild(const VectorPtr<SceneObject*>& objects);
+    void sgClear();
+    bool sgIsEmpty() const { return sgNodes.size() == 0; }
+    U32 sgGetTriangleCount() const { return sgTriangles.size(); }
+
+    /// Returns true if the segment hits any polygon not belonging to ignore.
+    bool sgCastRay(const Point3F& start, const Point3F& end, const SceneObject* ignore) const;
+
+    /// Same as sgCastRay for up to sgPacketSize segments at once; hit[i] is
+    /// set for every segment that is blocked.
+    void sgCastRays(const Point3F* start, const Point3F* end, U32 count,
+        const SceneObject* ignore, bool* hit) const;
+};
+
+#endif
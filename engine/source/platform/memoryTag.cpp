@@ -0,0 +1,148 @@
+//-----------------------------------------------------------------------------
+// Torque Game Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "platform/memoryTag.h"
+#include "console/console.h"
+
+#include <atomic>
+
+namespace
+{
+    // Updated from every thread on every allocation, so lock-free counters
+    // rather than a mutex. Zero-initialized before any constructor runs, as
+    // allocations happen during static initialization too.
+    struct TagStats
+    {
+        std::atomic<S64> bytes;
+        std::atomic<S64> peakBytes;
+        std::atomic<S32> liveAllocs;
+        std::atomic<U32> totalAllocs;
+    };
+
+    TagStats    gTagStats[MemoryTag::MaxTags];
+    const char* gTagNames[MemoryTag::MaxTags] = { "Untagged" };
+    U32         gNumTags = 1;
+
+    void chargeTag(U32 tag, S64 delta, bool countAlloc)
+    {
+        TagStats& stats = gTagStats[tag];
+
+        S64 bytes = stats.bytes.fetch_add(delta) + delta;
+        if (delta > 0)
+        {
+            S64 peak = stats.peakBytes.load();
+            while (bytes > peak && !stats.peakBytes.compare_exchange_weak(peak, bytes))
+                ;
+        }
+
+        if (countAlloc)
+        {
+            if (delta >= 0)
+            {
+                stats.liveAllocs++;
+                stats.totalAllocs++;
+            }
+            else
+                stats.liveAllocs--;
+        }
+    }
+}
+
+thread_local U32 MemoryTag::smCurrent = MemoryTag::Untagged;
+thread_local S64 MemoryTag::smThreadNetBytes = 0;
+
+//------------------------------------------------------------------------------
+
+MemoryTag::MemoryTag(const char* name)
+{
+    // Tags are statics, so this runs before any other thread exists.
+    AssertFatal(gNumTags < MaxTags, "MemoryTag::MemoryTag - too many memory tags, increase MaxTags.");
+
+    mIndex = gNumTags++;
+    gTagNames[mIndex] = name;
+}
+
+const char* MemoryTag::getName() const
+{
+    return gTagNames[mIndex];
+}
+
+void MemoryTag::addExternal(dsize_t bytes) const
+{
+    chargeTag(mIndex, S64(bytes), false);
+}
+
+void MemoryTag::removeExternal(dsize_t bytes) const
+{
+    chargeTag(mIndex, -S64(bytes), false);
+}
+
+void MemoryTag::noteAlloc(U32 tag, dsize_t bytes)
+{
+    smThreadNetBytes += bytes;
+    chargeTag(tag, S64(bytes), true);
+}
+
+void MemoryTag::noteFree(U32 tag, dsize_t bytes)
+{
+    smThreadNetBytes -= bytes;
+    chargeTag(tag, -S64(bytes), true);
+}
+
+//------------------------------------------------------------------------------
+
+void MemoryTag::dump()
+{
+#ifndef TORQUE_MEMORY_TAGGING
+    Con::warnf("Heap allocations are not tagged in this build (TORQUE_MEMORY_TAGGING); only external memory is shown.");
+#endif
+
+    // Biggest first.
+    U32 order[MaxTags];
+    for (U32 i = 0; i < gNumTags; i++)
+        order[i] = i;
+    for (U32 i = 1; i < gNumTags; i++)
+        for (U32 j = i; j > 0 && gTagStats[order[j]].bytes.load() > gTagStats[order[j - 1]].bytes.load(); j--)
+        {
+            U32 temp = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = temp;
+        }
+
+    S64 totalBytes = 0;
+
+    Con::printf("%-24s %12s %12s %10s %12s", "Tag", "Current KB", "Peak KB", "Live", "Total Allocs");
+    for (U32 i = 0; i < gNumTags; i++)
+    {
+        const TagStats& stats = gTagStats[order[i]];
+        S64 bytes = stats.bytes.load();
+        S64 peak = stats.peakBytes.load();
+        if (!peak)
+            continue;
+
+        Con::printf("%-24s %12.1f %12.1f %10d %12u", gTagNames[order[i]],
+            F64(bytes) / 1024.0, F64(peak) / 1024.0, stats.liveAllocs.load(), stats.totalAllocs.load());
+
+        totalBytes += bytes;
+    }
+    Con::printf("%-24s %12.1f", "Total", F64(totalBytes) / 1024.0);
+}
+
+void MemoryTag::resetPeaks()
+{
+    for (U32 i = 0; i < gNumTags; i++)
+        gTagStats[i].peakBytes = gTagStats[i].bytes.load();
+}
+
+ConsoleFunction(dumpMemoryTags, void, 1, 1, "Print memory use per subsystem, with high-water marks.")
+{
+    MemoryTag::dump();
+}
+
+ConsoleFunction(resetMemoryTagPeaks, void, 1, 1, "Restart memory high-water tracking from the current sizes.")
+{
+    MemoryTag::resetPeaks();
+}
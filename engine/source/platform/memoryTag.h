@@ -0,0 +1,101 @@
+//-----------------------------------------------------------------------------
+// Torque Game Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#ifndef _MEMORYTAG_H_
+#define _MEMORYTAG_H_
+
+#ifndef _PLATFORM_H_
+#include "platform/platform.h"
+#endif
+
+/// A named bucket that memory use is charged to.
+///
+/// Heap allocations made while a MemoryTagScope is active on the allocating
+/// thread are charged to its tag until they are freed; everything else ends
+/// up in "Untagged". Memory that does not come from the heap, like GFX
+/// buffers, can be charged by hand with addExternal() and removeExternal().
+///
+/// Tags are meant to be file scope statics:
+///
+/// @code
+/// static MemoryTag sTickCacheTag("TickCache");
+///
+/// void TickCache::grow()
+/// {
+///    MemoryTagScope tagScope(sTickCacheTag);
+///    ...
+/// }
+/// @endcode
+///
+/// Heap accounting is only done when TORQUE_MEMORY_TAGGING is defined, as it
+/// costs a small header per allocation. Use dumpMemoryTags() to see the
+/// current breakdown and the high-water mark of each tag.
+class MemoryTag
+{
+    friend class MemoryTagScope;
+
+public:
+    enum
+    {
+        Untagged = 0,
+        MaxTags = 64,
+    };
+
+    MemoryTag(const char* name);
+
+    U32 getIndex() const { return mIndex; }
+    const char* getName() const;
+
+    /// Charge memory that isn't allocated from the heap to this tag.
+    void addExternal(dsize_t bytes) const;
+    void removeExternal(dsize_t bytes) const;
+
+    /// @name Allocator Hooks
+    /// Called by the memory manager for every heap allocation.
+    /// @{
+
+    ///
+    static U32 getCurrent() { return smCurrent; }
+    static void noteAlloc(U32 tag, dsize_t bytes);
+    static void noteFree(U32 tag, dsize_t bytes);
+
+    /// Heap bytes allocated minus bytes freed by the calling thread, used to
+    /// attribute memory to whatever the thread was building at the time.
+    static S64 getThreadNetBytes() { return smThreadNetBytes; }
+    /// @}
+
+    /// Print the current size, peak size and allocation count of every tag.
+    static void dump();
+
+    /// Restart high-water tracking from the current sizes.
+    static void resetPeaks();
+
+private:
+    U32 mIndex;
+
+    static thread_local U32 smCurrent;
+    static thread_local S64 smThreadNetBytes;
+};
+
+/// Charges heap allocations on this thread to a tag for the lifetime of the
+/// scope. Scopes nest; the innermost one wins.
+class MemoryTagScope
+{
+    U32 mPrevious;
+
+public:
+    MemoryTagScope(const MemoryTag& tag)
+    {
+        mPrevious = MemoryTag::smCurrent;
+        MemoryTag::smCurrent = tag.getIndex();
+    }
+
+    ~MemoryTagScope()
+    {
+        MemoryTag::smCurrent = mPrevious;
+    }
+};
+
+#endif // _MEMORYTAG_H_
@@ -420,6 +420,7 @@ public:
             const char* name;
             U32         mhz;
             U32         properties;      // CPU type specific enum
+            U32         numCores;        // number of logical processors
         } processor;
     } SystemInfo;
 
@@ -597,6 +598,10 @@ namespace Memory
     dsize_t getMemoryUsed();
     dsize_t getMemoryAllocated();
     void validate();
+
+    /// Return the calling thread's cached size-class blocks to the shared
+    /// pool. Called automatically when a Thread finishes running.
+    void releaseThreadCache();
 } // namespace Memory
 
 template <class T>
@@ -8,6 +8,8 @@
 #include "console/console.h"
 #include "platform/profiler.h"
 #include "platform/platformMutex.h"
+#include "platform/platformThread.h"
+#include "platform/memoryTag.h"
 
 
 #ifdef TORQUE_MULTITHREAD
@@ -40,6 +42,12 @@ static U32 MinPageSize = 8 * 1024 * 1024;
 #define LOG_PAGE_ALLOCS
 #endif
 
+// The size-class allocator has no guards or leak tracking, so debug guard
+// builds keep everything in the memory manager.
+#if defined(TORQUE_SIZECLASS_ALLOCATOR) && !defined(TORQUE_DEBUG_GUARD)
+#define USE_SIZECLASS_ALLOCATOR
+#endif
+
 U32 gNewNewTotal = 0;
 U32 gImageAlloc = 0;
 //---------------------------------------------------------------------------
@@ -1290,6 +1298,429 @@ namespace Memory
     }
 #endif
 
+#ifdef TORQUE_SIZECLASS_ALLOCATOR
+    //---------------------------------------------------------------------------
+    // Size-class allocator
+    //
+    // Small blocks are carved from 64k slabs, one slab at a time per size class,
+    // and recycled through per-thread free lists, so the common alloc/free pair
+    // neither walks the free tree nor takes a lock. Threads trade blocks with a
+    // central free list in batches. Anything larger than the biggest class goes
+    // to the fallback allocator (the memory manager or the system).
+    //
+    // Blocks carry a small header naming their class, so they may be freed
+    // from any thread. Slabs are never returned to the system, just like the
+    // memory manager's pages.
+
+    enum SizeClassConstants : U32 {
+        SizeClassGuard = 0x5C1A55ED,
+        LargeBlock = 0xFFFFFFFF,
+        SlabSize = 64 * 1024,
+        MaxSmallSize = 2048,
+        NumSizeClasses = 28,
+        ThreadCacheBytes = 32 * 1024,  // per class, per thread
+    };
+
+    struct SmallHeader
+    {
+        U32 sizeClass;
+        U32 guard;
+        U32 size;      // only for LargeBlock
+        U32 unused;    // keep blocks 16 byte aligned
+    };
+
+    struct SmallFreeBlock
+    {
+        SmallFreeBlock* next;
+    };
+
+    static const U32 gSizeClassSizes[NumSizeClasses] = {
+          16,   32,   48,   64,   80,   96,  112,  128,
+         144,  160,  176,  192,  208,  224,  240,  256,
+         320,  384,  448,  512,  640,  768,  896, 1024,
+        1280, 1536, 1792, 2048,
+    };
+
+    struct ThreadCache
+    {
+        SmallFreeBlock* freeList[NumSizeClasses];
+        U32 count[NumSizeClasses];
+    };
+
+    struct CentralClass
+    {
+        SmallFreeBlock* freeList;
+        U32 freeCount;
+        U8* slabCursor;
+        U32 slabRemaining;   // blocks left to carve from the current slab
+        U32 numSlabs;
+    };
+
+    // Plain old data so it needs no construction or destruction on any thread;
+    // threads hand their blocks back with releaseThreadCache().
+    static thread_local ThreadCache tThreadCache;
+
+    static CentralClass gCentral[NumSizeClasses];
+    static void* gSizeClassMutex = NULL;
+    static bool  gSizeClassMutexCreating = false;
+    static U32   gSizeClassSlabBytes = 0;
+
+    static inline U32 getSizeClass(dsize_t size)
+    {
+        if (size <= 256)
+            return size ? U32(size - 1) >> 4 : 0;
+
+        // Four classes per power of two above 256.
+        U32 shift = 8;
+        while ((U32(size - 1) >> (shift + 1)) != 0)
+            shift++;
+        return 16 + (shift - 8) * 4 + (U32(size - 1) >> (shift - 2)) - 4;
+    }
+
+    static inline U32 getThreadCacheLimit(U32 sizeClass)
+    {
+        return getMax(ThreadCacheBytes / gSizeClassSizes[sizeClass], U32(16));
+    }
+
+    static bool lockSizeClasses()
+    {
+        if (!gSizeClassMutex)
+        {
+            // Creating the mutex allocates; that nested call runs unlocked,
+            // which is fine as this happens before any other thread exists.
+            if (gSizeClassMutexCreating)
+                return false;
+
+            gSizeClassMutexCreating = true;
+            gSizeClassMutex = Mutex::createMutex();
+            gSizeClassMutexCreating = false;
+        }
+
+        Mutex::lockMutex(gSizeClassMutex);
+        return true;
+    }
+
+    static void unlockSizeClasses(bool locked)
+    {
+        if (locked)
+            Mutex::unlockMutex(gSizeClassMutex);
+    }
+
+#if !defined(TORQUE_DISABLE_MEMORY_MANAGER)
+    static inline void* fallbackAlloc(dsize_t size) { return alloc(size, false, NULL, 0); }
+    static inline void  fallbackFree(void* mem)     { free(mem, false); }
+#else
+    static inline void* fallbackAlloc(dsize_t size)
+    {
+        void* mem = dRealMalloc(size);
+        if (!mem)
+            memoryError();
+        return mem;
+    }
+    static inline void  fallbackFree(void* mem)     { dRealFree(mem); }
+#endif
+
+    /// Move a batch of blocks from the central list (or a fresh slab) into
+    /// the thread cache.
+    static void refillThreadCache(ThreadCache& cache, U32 sizeClass)
+    {
+        const U32 blockSize = gSizeClassSizes[sizeClass] + sizeof(SmallHeader);
+        const U32 batch = getMax(getThreadCacheLimit(sizeClass) / 2, U32(1));
+
+        bool locked = lockSizeClasses();
+        CentralClass& central = gCentral[sizeClass];
+
+        for (U32 i = 0; i < batch; i++)
+        {
+            SmallFreeBlock* block = central.freeList;
+            if (block)
+            {
+                central.freeList = block->next;
+                central.freeCount--;
+            }
+            else
+            {
+                if (!central.slabRemaining)
+                {
+                    central.slabCursor = (U8*)dRealMalloc(SlabSize);
+                    if (!central.slabCursor)
+                        memoryError();
+                    central.slabRemaining = SlabSize / blockSize;
+                    central.numSlabs++;
+                    gSizeClassSlabBytes += SlabSize;
+                }
+
+                SmallHeader* hdr = (SmallHeader*)central.slabCursor;
+                central.slabCursor += blockSize;
+                central.slabRemaining--;
+
+                hdr->sizeClass = sizeClass;
+                hdr->guard = SizeClassGuard;
+                hdr->size = 0;
+                hdr->unused = 0;
+                block = (SmallFreeBlock*)(hdr + 1);
+            }
+
+            block->next = cache.freeList[sizeClass];
+            cache.freeList[sizeClass] = block;
+            cache.count[sizeClass]++;
+        }
+
+        unlockSizeClasses(locked);
+    }
+
+    /// Hand 'count' blocks of a class back to the central list.
+    static void flushThreadCache(ThreadCache& cache, U32 sizeClass, U32 count)
+    {
+        bool locked = lockSizeClasses();
+        CentralClass& central = gCentral[sizeClass];
+
+        for (U32 i = 0; i < count && cache.freeList[sizeClass]; i++)
+        {
+            SmallFreeBlock* block = cache.freeList[sizeClass];
+            cache.freeList[sizeClass] = block->next;
+            cache.count[sizeClass]--;
+
+            block->next = central.freeList;
+            central.freeList = block;
+            central.freeCount++;
+        }
+
+        unlockSizeClasses(locked);
+    }
+
+    static void* sizeClassAlloc(dsize_t size)
+    {
+        AssertFatal(size < MaxAllocationAmount - sizeof(SmallHeader), "Size error.");
+
+        if (size > MaxSmallSize)
+        {
+            SmallHeader* hdr = (SmallHeader*)fallbackAlloc(size + sizeof(SmallHeader));
+            hdr->sizeClass = LargeBlock;
+            hdr->guard = SizeClassGuard;
+            hdr->size = size;
+            return hdr + 1;
+        }
+
+        U32 sizeClass = getSizeClass(size);
+        ThreadCache& cache = tThreadCache;
+
+        if (!cache.freeList[sizeClass])
+            refillThreadCache(cache, sizeClass);
+
+        SmallFreeBlock* block = cache.freeList[sizeClass];
+        cache.freeList[sizeClass] = block->next;
+        cache.count[sizeClass]--;
+
+#ifdef TORQUE_DEBUG
+        dMemset(block, 0xCF, gSizeClassSizes[sizeClass]);
+#endif
+        return block;
+    }
+
+    static void sizeClassFree(void* mem)
+    {
+        if (!mem)
+            return;
+
+        SmallHeader* hdr = ((SmallHeader*)mem) - 1;
+        AssertFatal(hdr->guard == SizeClassGuard, "Memory::sizeClassFree - not a size class block!");
+
+        if (hdr->sizeClass == LargeBlock)
+        {
+            fallbackFree(hdr);
+            return;
+        }
+
+        U32 sizeClass = hdr->sizeClass;
+#ifdef TORQUE_DEBUG
+        dMemset(mem, 0xCE, gSizeClassSizes[sizeClass]);
+#endif
+
+        ThreadCache& cache = tThreadCache;
+        SmallFreeBlock* block = (SmallFreeBlock*)mem;
+        block->next = cache.freeList[sizeClass];
+        cache.freeList[sizeClass] = block;
+
+        const U32 limit = getThreadCacheLimit(sizeClass);
+        if (++cache.count[sizeClass] > limit)
+            flushThreadCache(cache, sizeClass, limit / 2);
+    }
+
+    static void* sizeClassRealloc(void* mem, dsize_t size)
+    {
+        if (!mem)
+            return sizeClassAlloc(size);
+        if (!size)
+        {
+            sizeClassFree(mem);
+            return NULL;
+        }
+
+        SmallHeader* hdr = ((SmallHeader*)mem) - 1;
+        AssertFatal(hdr->guard == SizeClassGuard, "Memory::sizeClassRealloc - not a size class block!");
+
+        dsize_t oldSize;
+        if (hdr->sizeClass == LargeBlock)
+            oldSize = hdr->size;
+        else
+        {
+            if (size <= MaxSmallSize && getSizeClass(size) == hdr->sizeClass)
+                return mem;
+            oldSize = gSizeClassSizes[hdr->sizeClass];
+        }
+
+        void* ret = sizeClassAlloc(size);
+        dMemcpy(ret, mem, getMin(U32(oldSize), U32(size)));
+        sizeClassFree(mem);
+        return ret;
+    }
+
+    void releaseThreadCache()
+    {
+        ThreadCache& cache = tThreadCache;
+        for (U32 i = 0; i < NumSizeClasses; i++)
+            if (cache.count[i])
+                flushThreadCache(cache, i, cache.count[i]);
+    }
+
+    ConsoleFunction(sizeClassMemoryDump, void, 1, 1, "Print slab usage of the size-class allocator.")
+    {
+        bool locked = lockSizeClasses();
+
+        for (U32 i = 0; i < NumSizeClasses; i++)
+        {
+            const CentralClass& central = gCentral[i];
+            if (central.numSlabs)
+                Con::printf("Size: %d - Slabs: %d  Central free blocks: %d",
+                    gSizeClassSizes[i], central.numSlabs, central.freeCount);
+        }
+        Con::printf("Total slab memory: %d KB", gSizeClassSlabBytes / 1024);
+
+        unlockSizeClasses(locked);
+    }
+
+    //---------------------------------------------------------------------------
+    // Allocation stress benchmark
+    //
+    // Runs the same random alloc/free mix on a number of threads against each
+    // available backend. Most blocks are small, as in the engine; a few are
+    // large enough to go to the fallback allocator.
+
+    struct StressBackend
+    {
+        const char* name;
+        void* (*alloc)(dsize_t);
+        void  (*free)(void*);
+    };
+
+    static void* stressSystemAlloc(dsize_t size) { return dRealMalloc(size); }
+    static void  stressSystemFree(void* mem)     { dRealFree(mem); }
+#if !defined(TORQUE_DISABLE_MEMORY_MANAGER)
+    static void* stressTreeAlloc(dsize_t size)   { return alloc(size, false, NULL, 0); }
+    static void  stressTreeFree(void* mem)       { free(mem, false); }
+#endif
+
+    static const StressBackend gStressBackends[] = {
+        { "system", stressSystemAlloc, stressSystemFree },
+#if !defined(TORQUE_DISABLE_MEMORY_MANAGER)
+        { "free tree", stressTreeAlloc, stressTreeFree },
+#endif
+        { "size class", sizeClassAlloc, sizeClassFree },
+    };
+
+    struct StressThreadData
+    {
+        const StressBackend* backend;
+        U32 iterations;
+        U32 maxSize;
+        U32 seed;
+    };
+
+    static void stressThread(void* arg)
+    {
+        StressThreadData* data = (StressThreadData*)arg;
+        const StressBackend* backend = data->backend;
+
+        enum { NumSlots = 4096 };
+        void* slots[NumSlots];
+        dMemset(slots, 0, sizeof(slots));
+
+        U32 seed = data->seed;
+        for (U32 i = 0; i < data->iterations; i++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            U32 slot = (seed >> 8) % NumSlots;
+
+            if (slots[slot])
+            {
+                backend->free(slots[slot]);
+                slots[slot] = NULL;
+                continue;
+            }
+
+            seed = seed * 1664525 + 1013904223;
+            U32 pick = (seed >> 8) % 100;
+            U32 size;
+            if (pick < 80)
+                size = 8 + (seed >> 16) % 120;
+            else if (pick < 95)
+                size = 128 + (seed >> 16) % (MaxSmallSize - 128);
+            else
+                size = MaxSmallSize + (seed >> 16) % getMax(data->maxSize - MaxSmallSize, U32(1));
+
+            U8* mem = (U8*)backend->alloc(size);
+            mem[0] = mem[size - 1] = U8(i);
+            slots[slot] = mem;
+        }
+
+        for (U32 i = 0; i < NumSlots; i++)
+            if (slots[i])
+                backend->free(slots[i]);
+    }
+
+    ConsoleFunction(memoryStressTest, void, 1, 4, "([numThreads], [iterations], [maxSize])"
+        "Time a random allocation workload against each memory backend.")
+    {
+        U32 numThreads = argc > 1 ? getMax(dAtoi(argv[1]), 1) : getMax(Platform::SystemInfo.processor.numCores, U32(1));
+        U32 iterations = argc > 2 ? getMax(dAtoi(argv[2]), 1) : 1000000;
+        U32 maxSize = argc > 3 ? getMax(dAtoi(argv[3]), S32(MaxSmallSize) + 1) : 16384;
+
+        Con::printf("Memory stress test: %d thread(s), %d iterations each, blocks up to %d bytes",
+            numThreads, iterations, maxSize);
+
+        StressThreadData* data = new StressThreadData[numThreads];
+        Thread** threads = new Thread * [numThreads];
+
+        for (U32 b = 0; b < sizeof(gStressBackends) / sizeof(gStressBackends[0]); b++)
+        {
+            U32 startTime = Platform::getRealMilliseconds();
+
+            for (U32 i = 0; i < numThreads; i++)
+            {
+                data[i].backend = &gStressBackends[b];
+                data[i].iterations = iterations;
+                data[i].maxSize = maxSize;
+                data[i].seed = 0x1234567 + i * 7919;
+                threads[i] = new Thread(stressThread, &data[i], true);
+            }
+            for (U32 i = 0; i < numThreads; i++)
+                delete threads[i];
+
+            U32 elapsed = getMax(Platform::getRealMilliseconds() - startTime, U32(1));
+            Con::printf("   %-12s %6d ms  %.2f Mops/s", gStressBackends[b].name, elapsed,
+                F32(iterations) * numThreads / (elapsed * 1000.0f));
+        }
+
+        delete[] threads;
+        delete[] data;
+    }
+#else
+    void releaseThreadCache()
+    {
+    }
+#endif // TORQUE_SIZECLASS_ALLOCATOR
+
     dsize_t getMemoryUsed()
     {
         U32 size = 0;
@@ -1356,72 +1787,205 @@ void setMinimumAllocUnit(U32 allocUnit)
 //---------------------------------------------------------------------------
 #include <stdlib.h>
 
-#if !defined(TORQUE_DISABLE_MEMORY_MANAGER)
+namespace Memory
+{
+    // The allocator that actually hands out the memory.
+
+#if defined(USE_SIZECLASS_ALLOCATOR)
+
+    // Small blocks come from the size-class allocator, large ones from the
+    // memory manager or the system.
+    static inline void* backendAlloc(dsize_t size, bool array, const char* fileName, const U32 line)
+    {
+        return sizeClassAlloc(size);
+    }
+
+    static inline void backendFree(void* mem, bool array)
+    {
+        sizeClassFree(mem);
+    }
+
+    static inline void* backendRealloc(void* mem, dsize_t size)
+    {
+        return sizeClassRealloc(mem, size);
+    }
+
+#elif !defined(TORQUE_DISABLE_MEMORY_MANAGER)
+
+    // Manage our own memory.
+    static inline void* backendAlloc(dsize_t size, bool array, const char* fileName, const U32 line)
+    {
+        return alloc(size, array, fileName, line);
+    }
+
+    static inline void backendFree(void* mem, bool array)
+    {
+        free(mem, array);
+    }
+
+    static inline void* backendRealloc(void* mem, dsize_t size)
+    {
+        return realloc(mem, size);
+    }
+
+#else
+
+    // Don't manage our own memory.
+    static inline void* backendAlloc(dsize_t size, bool array, const char* fileName, const U32 line)
+    {
+        return ::malloc(size);
+    }
+
+    static inline void backendFree(void* mem, bool array)
+    {
+        ::free(mem);
+    }
+
+    static inline void* backendRealloc(void* mem, dsize_t size)
+    {
+        return ::realloc(mem, size);
+    }
+
+#endif
 
-// Manage our own memory, add overloaded memory operators and functions
+#ifdef TORQUE_MEMORY_TAGGING
 
+    // Every block remembers the tag it was charged to and its size, so the
+    // right tag can be credited when it is freed from anywhere.
+    struct TagHeader
+    {
+        U32 tag;
+        U32 size;
+        U32 guard;
+        U32 unused;    // keep blocks 16 byte aligned
+    };
+
+    enum { TagGuard = 0x7A6B10C5 };
+
+    static void* managedAlloc(dsize_t size, bool array, const char* fileName, const U32 line)
+    {
+        TagHeader* hdr = (TagHeader*)backendAlloc(size + sizeof(TagHeader), array, fileName, line);
+        if (!hdr)
+            return NULL;
+
+        hdr->tag = MemoryTag::getCurrent();
+        hdr->size = size;
+        hdr->guard = TagGuard;
+        MemoryTag::noteAlloc(hdr->tag, size);
+        return hdr + 1;
+    }
+
+    static void managedFree(void* mem, bool array)
+    {
+        if (!mem)
+            return;
+
+        TagHeader* hdr = ((TagHeader*)mem) - 1;
+        AssertFatal(hdr->guard == TagGuard, "Memory::managedFree - block was not allocated by us!");
+        MemoryTag::noteFree(hdr->tag, hdr->size);
+        backendFree(hdr, array);
+    }
+
+    static void* managedRealloc(void* mem, dsize_t size)
+    {
+        if (!mem)
+            return managedAlloc(size, false, NULL, 0);
+        if (!size)
+        {
+            managedFree(mem, false);
+            return NULL;
+        }
+
+        TagHeader* hdr = ((TagHeader*)mem) - 1;
+        AssertFatal(hdr->guard == TagGuard, "Memory::managedRealloc - block was not allocated by us!");
+
+        // Stays with the tag it was first charged to.
+        U32 tag = hdr->tag;
+        dsize_t oldSize = hdr->size;
+
+        // On failure the old block is still there and still charged.
+        TagHeader* newHdr = (TagHeader*)backendRealloc(hdr, size + sizeof(TagHeader));
+        if (!newHdr)
+            return NULL;
+
+        MemoryTag::noteFree(tag, oldSize);
+        newHdr->size = size;
+        MemoryTag::noteAlloc(tag, size);
+        return newHdr + 1;
+    }
+
+#else
+
+    static inline void* managedAlloc(dsize_t size, bool array, const char* fileName, const U32 line)
+    {
+        return backendAlloc(size, array, fileName, line);
+    }
+
+    static inline void managedFree(void* mem, bool array)
+    {
+        backendFree(mem, array);
+    }
+
+    static inline void* managedRealloc(void* mem, dsize_t size)
+    {
+        return backendRealloc(mem, size);
+    }
+
+#endif
+
+} // namespace Memory
+
+//---------------------------------------------------------------------------
+
+#if !defined(TORQUE_DISABLE_MEMORY_MANAGER) || defined(USE_SIZECLASS_ALLOCATOR) || defined(TORQUE_MEMORY_TAGGING)
+
+// Overloaded memory operators, so that everything goes through us.
+
+#if !defined(TORQUE_DISABLE_MEMORY_MANAGER)
 void* FN_CDECL operator new(dsize_t size, const char* fileName, const U32 line)
 {
-    return Memory::alloc(size, false, fileName, line);
+    return Memory::managedAlloc(size, false, fileName, line);
 }
 
 void* FN_CDECL operator new[](dsize_t size, const char* fileName, const U32 line)
 {
-    return Memory::alloc(size, true, fileName, line);
+    return Memory::managedAlloc(size, true, fileName, line);
 }
+#endif
 
 void* FN_CDECL operator new(dsize_t size)
 {
-    return Memory::alloc(size, false, NULL, 0);
+    return Memory::managedAlloc(size, false, NULL, 0);
 }
 
 void* FN_CDECL operator new[](dsize_t size)
 {
-    return Memory::alloc(size, true, NULL, 0);
+    return Memory::managedAlloc(size, true, NULL, 0);
 }
 
 void FN_CDECL operator delete(void* mem)
 {
-    Memory::free(mem, false);
+    Memory::managedFree(mem, false);
 }
 
 void FN_CDECL operator delete[](void* mem)
 {
-    Memory::free(mem, true);
+    Memory::managedFree(mem, true);
 }
 
-void* dMalloc_r(dsize_t in_size, const char* fileName, const dsize_t line)
-{
-    return Memory::alloc(in_size, false, fileName, line);
-}
-
-void dFree(void* in_pFree)
-{
-    Memory::free(in_pFree, false);
-}
-
-void* dRealloc(void* in_pResize, dsize_t in_size)
-{
-    return Memory::realloc(in_pResize, in_size);
-}
-
-#else
-
-// Don't manage our own memory
+#endif
 
 void* dMalloc_r(dsize_t in_size, const char* fileName, const dsize_t line)
 {
-    return malloc(in_size);
+    return Memory::managedAlloc(in_size, false, fileName, line);
 }
 
 void dFree(void* in_pFree)
 {
-    free(in_pFree);
+    Memory::managedFree(in_pFree, false);
 }
 
 void* dRealloc(void* in_pResize, dsize_t in_size)
 {
-    return realloc(in_pResize, in_size);
+    return Memory::managedRealloc(in_pResize, in_size);
 }
-
-#endif // #else
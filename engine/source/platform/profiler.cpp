@@ -5,22 +5,20 @@
 
 #include "platform/platform.h"
 #include "platform/profiler.h"
+#include "platform/profilerTrace.h"
 #include "core/stringTable.h"
 //#include <stdlib.h> // gotta use malloc and free directly
 #include "console/console.h"
 #include "core/tVector.h"
 #include "core/fileStream.h"
 #include "platform/platformThread.h"
+#include "platform/platformMutex.h"
 #include "core/frameAllocator.h"
 
 #ifdef TORQUE_ENABLE_PROFILER
 ProfilerRootData* ProfilerRootData::sRootList = NULL;
 Profiler* gProfiler = NULL;
 
-#ifdef TORQUE_MULTITHREAD
-U32 gMainThread = 0;
-#endif
-
 #if defined(TORQUE_SUPPORTS_VC_INLINE_X86_ASM)
 // platform specific get hires times...
 void startHighResolutionTimer(U32 time[2])
@@ -124,81 +122,175 @@ U32 endHighResolutionTimer(U32 time[2])
 
 #endif
 
+thread_local Profiler::ThreadState* Profiler::smThreadState = NULL;
+
 Profiler::Profiler()
 {
     mMaxStackDepth = MaxStackDepth;
-    mCurrentHash = 0;
-
-    mCurrentProfilerData = (ProfilerData*)dMalloc(sizeof(ProfilerData));
-    mCurrentProfilerData->mRoot = NULL;
-    mCurrentProfilerData->mNextForRoot = NULL;
-    mCurrentProfilerData->mNextProfilerData = NULL;
-    mCurrentProfilerData->mNextHash = NULL;
-    mCurrentProfilerData->mParent = NULL;
-    mCurrentProfilerData->mNextSibling = NULL;
-    mCurrentProfilerData->mFirstChild = NULL;
-    mCurrentProfilerData->mLastSeenProfiler = NULL;
-    mCurrentProfilerData->mHash = 0;
-    mCurrentProfilerData->mSubDepth = 0;
-    mCurrentProfilerData->mInvokeCount = 0;
-    mCurrentProfilerData->mTotalTime = 0;
-    mCurrentProfilerData->mSubTime = 0;
-#ifdef TORQUE_ENABLE_PROFILE_PATH
-    mCurrentProfilerData->mPath = "";
-#endif
-    mRootProfilerData = mCurrentProfilerData;
-
-    for (U32 i = 0; i < ProfilerData::HashTableSize; i++)
-        mCurrentProfilerData->mChildHash[i] = 0;
 
-    mProfileList = NULL;
+    mThreadStateList = NULL;
+    mThreadStateMutex = Mutex::createMutex();
+    mMainThreadState = NULL;
 
-    mEnabled = false;
-    mStackDepth = 0;
     mNextEnable = false;
     gProfiler = this;
     mDumpToConsole = false;
     mDumpToFile = false;
     mDumpFileName[0] = '\0';
 
-#ifdef TORQUE_MULTITHREAD
-    gMainThread = Thread::getCurrentThreadId();
-#endif
+    // Constructed statically, so this is the main thread.
+    mMainThreadState = createThreadState();
 }
 
 Profiler::~Profiler()
 {
     reset();
-    dFree(mRootProfilerData);
+    while (mThreadStateList)
+        destroyThreadState(mThreadStateList);
+    Mutex::destroyMutex(mThreadStateMutex);
     gProfiler = NULL;
+    ProfilerTrace::destroy();
+}
+
+//------------------------------------------------------------------------------
+
+Profiler::ThreadState* Profiler::getThreadState()
+{
+    return smThreadState ? smThreadState : createThreadState();
+}
+
+Profiler::ThreadState* Profiler::createThreadState()
+{
+    ThreadState* state = (ThreadState*)dMalloc(sizeof(ThreadState));
+    state->threadId = Thread::getCurrentThreadId();
+    state->stackDepth = 0;
+    state->enabled = false;
+    state->orphaned = false;
+    state->mutex = mMainThreadState ? Mutex::createMutex() : NULL;
+    state->dataList = NULL;
+
+    ProfilerData* rootData = (ProfilerData*)dMalloc(sizeof(ProfilerData));
+    rootData->mRoot = NULL;
+    rootData->mNextProfilerData = NULL;
+    rootData->mNextHash = NULL;
+    rootData->mParent = NULL;
+    rootData->mNextSibling = NULL;
+    rootData->mFirstChild = NULL;
+    rootData->mLastSeenProfiler = NULL;
+    rootData->mHash = 0;
+    rootData->mSubDepth = 0;
+    rootData->mInvokeCount = 0;
+    rootData->mTotalTime = 0;
+    rootData->mSubTime = 0;
+#ifdef TORQUE_ENABLE_PROFILE_PATH
+    rootData->mPath = "";
+#endif
+    for (U32 i = 0; i < ProfilerData::HashTableSize; i++)
+        rootData->mChildHash[i] = 0;
+
+    state->rootData = rootData;
+    state->currentData = rootData;
+
+    Mutex::lockMutex(mThreadStateMutex);
+    state->next = mThreadStateList;
+    mThreadStateList = state;
+    Mutex::unlockMutex(mThreadStateMutex);
+
+    smThreadState = state;
+    return state;
+}
+
+void Profiler::clearThreadState(ThreadState* state)
+{
+    state->enabled = false; // in case we're in a profiler call.
+    while (state->dataList)
+    {
+        ProfilerData* next = state->dataList->mNextProfilerData;
+        dFree(state->dataList);
+        state->dataList = next;
+    }
+
+    ProfilerData* rootData = state->rootData;
+    state->currentData = rootData;
+    rootData->mFirstChild = 0;
+    for (U32 i = 0; i < ProfilerData::HashTableSize; i++)
+        rootData->mChildHash[i] = 0;
+    rootData->mInvokeCount = 0;
+    rootData->mTotalTime = 0;
+    rootData->mSubTime = 0;
+    rootData->mSubDepth = 0;
+    rootData->mLastSeenProfiler = 0;
+}
+
+void Profiler::destroyThreadState(ThreadState* state)
+{
+    // Called with mThreadStateMutex held, or at shutdown.
+    for (ThreadState** walk = &mThreadStateList; *walk; walk = &(*walk)->next)
+        if (*walk == state)
+        {
+            *walk = state->next;
+            break;
+        }
+
+    clearThreadState(state);
+    if (state->mutex)
+        Mutex::destroyMutex(state->mutex);
+    dFree(state->rootData);
+    dFree(state);
+}
+
+void Profiler::releaseThreadState()
+{
+    if (!gProfiler || !smThreadState)
+        return;
+
+    // Keep what the thread measured around for the next dump, which frees it.
+    Mutex::lockMutex(gProfiler->mThreadStateMutex);
+    smThreadState->orphaned = true;
+    Mutex::unlockMutex(gProfiler->mThreadStateMutex);
+    smThreadState = NULL;
+}
+
+void Profiler::lockWorkerStates()
+{
+    Mutex::lockMutex(mThreadStateMutex);
+    for (ThreadState* walk = mThreadStateList; walk; walk = walk->next)
+        if (walk->mutex)
+            Mutex::lockMutex(walk->mutex);
+}
+
+void Profiler::unlockWorkerStates()
+{
+    for (ThreadState* walk = mThreadStateList; walk; walk = walk->next)
+        if (walk->mutex)
+            Mutex::unlockMutex(walk->mutex);
+    Mutex::unlockMutex(mThreadStateMutex);
 }
 
 void Profiler::reset()
 {
-    mEnabled = false; // in case we're in a profiler call.
-    while (mProfileList)
+    // Only ever called from the main thread.
+    lockWorkerStates();
+    for (ThreadState* walk = mThreadStateList; walk; walk = walk->next)
+        clearThreadState(walk);
+    unlockWorkerStates();
+
+    Mutex::lockMutex(mThreadStateMutex);
+    ThreadState* next;
+    for (ThreadState* walk = mThreadStateList; walk; walk = next)
     {
-        ProfilerData* next = mProfileList->mNextProfilerData;
-        dFree(mProfileList);
-        mProfileList = NULL;
+        next = walk->next;
+        if (walk->orphaned)
+            destroyThreadState(walk);
     }
+    Mutex::unlockMutex(mThreadStateMutex);
+
     for (ProfilerRootData* walk = ProfilerRootData::sRootList; walk; walk = walk->mNextRoot)
     {
-        walk->mFirstProfilerData = 0;
         walk->mTotalTime = 0;
         walk->mSubTime = 0;
         walk->mTotalInvokeCount = 0;
     }
-    mCurrentProfilerData = mRootProfilerData;
-    mCurrentProfilerData->mNextForRoot = 0;
-    mCurrentProfilerData->mFirstChild = 0;
-    for (U32 i = 0; i < ProfilerData::HashTableSize; i++)
-        mCurrentProfilerData->mChildHash[i] = 0;
-    mCurrentProfilerData->mInvokeCount = 0;
-    mCurrentProfilerData->mTotalTime = 0;
-    mCurrentProfilerData->mSubTime = 0;
-    mCurrentProfilerData->mSubDepth = 0;
-    mCurrentProfilerData->mLastSeenProfiler = 0;
 }
 
 static Profiler aProfiler; // allocate the global profiler
@@ -214,19 +306,17 @@ ProfilerRootData::ProfilerRootData(const char* name)
     mNextRoot = sRootList;
     sRootList = this;
     mTotalTime = 0;
+    mSubTime = 0;
     mTotalInvokeCount = 0;
-    mFirstProfilerData = NULL;
     mEnabled = true;
 }
 
 void Profiler::validate()
 {
-    for (ProfilerRootData* walk = ProfilerRootData::sRootList; walk; walk = walk->mNextRoot)
+    for (ThreadState* state = mThreadStateList; state; state = state->next)
     {
-        for (ProfilerData* dp = walk->mFirstProfilerData; dp; dp = dp->mNextForRoot)
+        for (ProfilerData* dp = state->dataList; dp; dp = dp->mNextProfilerData)
         {
-            if (dp->mRoot != walk)
-                Platform::debugBreak();
             // check if it's in the parent's list...
             ProfilerData* wk;
             for (wk = dp->mParent->mFirstChild; wk; wk = wk->mNextSibling)
@@ -234,7 +324,7 @@ void Profiler::validate()
                     break;
             if (!wk)
                 Platform::debugBreak();
-            for (wk = dp->mParent->mChildHash[walk->mNameHash & (ProfilerData::HashTableSize - 1)];
+            for (wk = dp->mParent->mChildHash[dp->mRoot->mNameHash & (ProfilerData::HashTableSize - 1)];
                 wk; wk = wk->mNextHash)
                 if (wk == dp)
                     break;
@@ -247,13 +337,20 @@ void Profiler::validate()
 #ifdef TORQUE_ENABLE_PROFILE_PATH
 const char* Profiler::getProfilePath()
 {
-    return (mEnabled && mCurrentProfilerData) ? mCurrentProfilerData->mPath : "na";
+    // Don't create a state here, this is called for every allocation.
+    ThreadState* state = smThreadState;
+    return (state && state->enabled && state->currentData) ? state->currentData->mPath : "na";
 }
 #endif
 
 #ifdef TORQUE_ENABLE_PROFILE_PATH
 const char* Profiler::constructProfilePath(ProfilerData* pd)
 {
+    // The string table isn't thread safe, so worker threads only get the
+    // name of the innermost marker.
+    if (smThreadState != mMainThreadState)
+        return pd->mRoot->mName;
+
     if (pd->mParent)
     {
         const char* connector = " -> ";
@@ -273,37 +370,29 @@ const char* Profiler::constructProfilePath(ProfilerData* pd)
     }
     return "root";
 }
-#endif
-void Profiler::hashPush(ProfilerRootData* root)
-{
-#ifdef TORQUE_MULTITHREAD
-    // Ignore non-main-thread profiler activity.
-    if (Thread::getCurrentThreadId() != gMainThread)
-        return;
 #endif
 
-    mStackDepth++;
-    AssertFatal(mStackDepth <= mMaxStackDepth,
-        "Stack overflow in profiler.  You may have mismatched PROFILE_START and PROFILE_ENDs");
-    if (!mEnabled)
-        return;
+//------------------------------------------------------------------------------
 
+void Profiler::pushData(ThreadState* state, ProfilerRootData* root)
+{
+    ProfilerData* currentData = state->currentData;
     ProfilerData* nextProfiler = NULL;
-    if (!root->mEnabled || mCurrentProfilerData->mRoot == root)
+    if (!root->mEnabled || currentData->mRoot == root)
     {
-        mCurrentProfilerData->mSubDepth++;
+        currentData->mSubDepth++;
         return;
     }
 
-    if (mCurrentProfilerData->mLastSeenProfiler &&
-        mCurrentProfilerData->mLastSeenProfiler->mRoot == root)
-        nextProfiler = mCurrentProfilerData->mLastSeenProfiler;
+    if (currentData->mLastSeenProfiler &&
+        currentData->mLastSeenProfiler->mRoot == root)
+        nextProfiler = currentData->mLastSeenProfiler;
 
     if (!nextProfiler)
     {
         // first see if it's in the hash table...
         U32 index = root->mNameHash & (ProfilerData::HashTableSize - 1);
-        nextProfiler = mCurrentProfilerData->mChildHash[index];
+        nextProfiler = currentData->mChildHash[index];
         while (nextProfiler)
         {
             if (nextProfiler->mRoot == root)
@@ -317,18 +406,16 @@ void Profiler::hashPush(ProfilerRootData* root)
                 nextProfiler->mChildHash[i] = 0;
 
             nextProfiler->mRoot = root;
-            nextProfiler->mNextForRoot = root->mFirstProfilerData;
-            root->mFirstProfilerData = nextProfiler;
 
-            nextProfiler->mNextProfilerData = mProfileList;
-            mProfileList = nextProfiler;
+            nextProfiler->mNextProfilerData = state->dataList;
+            state->dataList = nextProfiler;
 
-            nextProfiler->mNextHash = mCurrentProfilerData->mChildHash[index];
-            mCurrentProfilerData->mChildHash[index] = nextProfiler;
+            nextProfiler->mNextHash = currentData->mChildHash[index];
+            currentData->mChildHash[index] = nextProfiler;
 
-            nextProfiler->mParent = mCurrentProfilerData;
-            nextProfiler->mNextSibling = mCurrentProfilerData->mFirstChild;
-            mCurrentProfilerData->mFirstChild = nextProfiler;
+            nextProfiler->mParent = currentData;
+            nextProfiler->mNextSibling = currentData->mFirstChild;
+            currentData->mFirstChild = nextProfiler;
             nextProfiler->mFirstChild = NULL;
             nextProfiler->mLastSeenProfiler = NULL;
             nextProfiler->mHash = root->mNameHash;
@@ -341,11 +428,56 @@ void Profiler::hashPush(ProfilerRootData* root)
 #endif
         }
     }
-    root->mTotalInvokeCount++;
     nextProfiler->mInvokeCount++;
     startHighResolutionTimer(nextProfiler->mStartTime);
-    mCurrentProfilerData->mLastSeenProfiler = nextProfiler;
-    mCurrentProfilerData = nextProfiler;
+    currentData->mLastSeenProfiler = nextProfiler;
+    state->currentData = nextProfiler;
+}
+
+void Profiler::popData(ThreadState* state)
+{
+    ProfilerData* currentData = state->currentData;
+    if (currentData->mSubDepth)
+    {
+        currentData->mSubDepth--;
+        return;
+    }
+    F64 fElapsed = endHighResolutionTimer(currentData->mStartTime);
+    currentData->mTotalTime += fElapsed;
+    currentData->mParent->mSubTime += fElapsed; // mark it in the parent as well...
+    state->currentData = currentData->mParent;
+}
+
+void Profiler::hashPush(ProfilerRootData* root)
+{
+    // The timeline covers every thread, whatever the totals below do.
+    if (ProfilerTrace::smRecording)
+        ProfilerTrace::beginEvent(root);
+
+    ThreadState* state = getThreadState();
+    state->stackDepth++;
+    AssertFatal(state->stackDepth <= mMaxStackDepth,
+        "Stack overflow in profiler.  You may have mismatched PROFILE_START and PROFILE_ENDs");
+
+    if (state == mMainThreadState)
+    {
+        if (state->enabled)
+            pushData(state, root);
+        return;
+    }
+
+    // Workers follow the main thread, but only pick up a change while their
+    // own stack is empty so pushes and pops stay paired.
+    if (state->stackDepth == 1)
+        state->enabled = mMainThreadState->enabled;
+    if (!state->enabled)
+        return;
+
+    // Only contended while the main thread dumps or resets.
+    Mutex::lockMutex(state->mutex);
+    if (state->enabled)
+        pushData(state, root);
+    Mutex::unlockMutex(state->mutex);
 }
 
 void Profiler::enable(bool enabled)
@@ -370,40 +502,38 @@ void Profiler::dumpToFile(const char* fileName)
 
 void Profiler::hashPop()
 {
-#ifdef TORQUE_MULTITHREAD
-    // Ignore non-main-thread profiler activity.
-    if (Thread::getCurrentThreadId() != gMainThread)
-        return;
-#endif
+    if (ProfilerTrace::smRecording)
+        ProfilerTrace::endEvent();
+
+    ThreadState* state = getThreadState();
+    state->stackDepth--;
+    AssertFatal(state->stackDepth >= 0, "Stack underflow in profiler.  You may have mismatched PROFILE_START and PROFILE_ENDs");
 
-    mStackDepth--;
-    AssertFatal(mStackDepth >= 0, "Stack underflow in profiler.  You may have mismatched PROFILE_START and PROFILE_ENDs");
-    if (mEnabled)
+    if (state != mMainThreadState)
     {
-        if (mCurrentProfilerData->mSubDepth)
+        if (state->enabled)
         {
-            mCurrentProfilerData->mSubDepth--;
-            return;
+            Mutex::lockMutex(state->mutex);
+            if (state->enabled)
+                popData(state);
+            Mutex::unlockMutex(state->mutex);
         }
-        F64 fElapsed = endHighResolutionTimer(mCurrentProfilerData->mStartTime);
-        mCurrentProfilerData->mTotalTime += fElapsed;
-        mCurrentProfilerData->mParent->mSubTime += fElapsed; // mark it in the parent as well...
-        mCurrentProfilerData->mRoot->mTotalTime += fElapsed;
-        if (mCurrentProfilerData->mParent->mRoot)
-            mCurrentProfilerData->mParent->mRoot->mSubTime += fElapsed; // mark it in the parent as well...
-        mCurrentProfilerData = mCurrentProfilerData->mParent;
+        return;
     }
-    if (mStackDepth == 0)
+
+    if (state->enabled)
+        popData(state);
+    if (state->stackDepth == 0)
     {
         // apply the next enable...
         if (mDumpToConsole || mDumpToFile)
         {
             dump();
-            startHighResolutionTimer(mCurrentProfilerData->mStartTime);
+            startHighResolutionTimer(state->rootData->mStartTime);
         }
-        if (!mEnabled && mNextEnable)
-            startHighResolutionTimer(mCurrentProfilerData->mStartTime);
-        mEnabled = mNextEnable;
+        if (!state->enabled && mNextEnable)
+            startHighResolutionTimer(state->rootData->mStartTime);
+        state->enabled = mNextEnable;
     }
 }
 
@@ -493,20 +623,44 @@ static void profilerDataDumpRecurseFile(ProfilerData* data, char* buffer, U32 bu
 
 void Profiler::dump()
 {
-    bool enableSave = mEnabled;
-    mEnabled = false;
-    mStackDepth++;
     // may have some profiled calls... gotta turn em off.
+    ThreadState* mainState = mMainThreadState;
+    bool enableSave = mainState->enabled;
+    mainState->enabled = false;
+    mainState->stackDepth++;
 
-    Vector<ProfilerRootData*> rootVector;
+    // Workers wait while their trees are merged and cleared.
+    lockWorkerStates();
+
+    // Sum up every thread's nodes per marker. Percentages are relative to the
+    // time spent in markers on the main thread, so busy workers can add up to
+    // more than 100%.
     F64 totalTime = 0;
-    for (ProfilerRootData* walk = ProfilerRootData::sRootList; walk; walk = walk->mNextRoot)
+    for (ThreadState* state = mThreadStateList; state; state = state->next)
     {
-        totalTime += walk->mTotalTime - walk->mSubTime;
-        rootVector.push_back(walk);
+        for (ProfilerData* data = state->dataList; data; data = data->mNextProfilerData)
+        {
+            data->mRoot->mTotalTime += data->mTotalTime;
+            data->mRoot->mSubTime += data->mSubTime;
+            data->mRoot->mTotalInvokeCount += data->mInvokeCount;
+
+            if (state == mainState)
+                totalTime += data->mTotalTime - data->mSubTime;
+        }
+
+        // A worker's root covers the time it spent in markers.
+        if (state != mainState)
+            state->rootData->mTotalTime = state->rootData->mSubTime;
     }
+
+    Vector<ProfilerRootData*> rootVector;
+    for (ProfilerRootData* walk = ProfilerRootData::sRootList; walk; walk = walk->mNextRoot)
+        rootVector.push_back(walk);
     dQsort((void*)&rootVector[0], rootVector.size(), sizeof(ProfilerRootData*), rootDataCompare);
 
+    mainState->rootData->mTotalTime = endHighResolutionTimer(mainState->rootData->mStartTime);
+
+    char depthBuffer[MaxStackDepth * 2 + 1];
 
     if (mDumpToConsole == true)
     {
@@ -520,22 +674,23 @@ void Profiler::dump()
                 100 * rootVector[i]->mTotalTime / totalTime,
                 rootVector[i]->mTotalInvokeCount,
                 rootVector[i]->mName);
-            rootVector[i]->mTotalInvokeCount = 0;
-            rootVector[i]->mTotalTime = 0;
-            rootVector[i]->mSubTime = 0;
         }
         Con::printf("");
         Con::printf("Ordered by stack trace total time -");
         Con::printf("    %% Time   %% NSTime Invoke # Name");
 
-        U32 depth = 0;
-        mCurrentProfilerData->mTotalTime = endHighResolutionTimer(mCurrentProfilerData->mStartTime);
-
-        char depthBuffer[MaxStackDepth * 2 + 1];
         depthBuffer[0] = 0;
-        profilerDataDumpRecurse(mCurrentProfilerData, depthBuffer, 0, totalTime);
-        mEnabled = enableSave;
-        mStackDepth--;
+        profilerDataDumpRecurse(mainState->rootData, depthBuffer, 0, totalTime);
+
+        for (ThreadState* state = mThreadStateList; state; state = state->next)
+        {
+            if (state == mainState || !state->rootData->mTotalTime)
+                continue;
+            Con::printf("");
+            Con::printf("Thread %u -", state->threadId);
+            depthBuffer[0] = 0;
+            profilerDataDumpRecurse(state->rootData, depthBuffer, 0, totalTime);
+        }
     }
     else if (mDumpToFile == true && mDumpFileName[0] != '\0')
     {
@@ -559,28 +714,59 @@ void Profiler::dump()
                 rootVector[i]->mTotalInvokeCount,
                 rootVector[i]->mName);
             fws.write(dStrlen(buffer), buffer);
-
-            rootVector[i]->mTotalInvokeCount = 0;
-            rootVector[i]->mTotalTime = 0;
-            rootVector[i]->mSubTime = 0;
         }
         dStrcpy(buffer, "\nOrdered by non-sub total time -\n");
         fws.write(dStrlen(buffer), buffer);
         dStrcpy(buffer, "   %%NSTime     %% Time Invoke # Name");
         fws.write(dStrlen(buffer), buffer);
 
-        U32 depth = 0;
-        mCurrentProfilerData->mTotalTime = endHighResolutionTimer(mCurrentProfilerData->mStartTime);
-
-        char depthBuffer[MaxStackDepth * 2 + 1];
         depthBuffer[0] = 0;
-        profilerDataDumpRecurseFile(mCurrentProfilerData, depthBuffer, 0, totalTime, fws);
-        mEnabled = enableSave;
-        mStackDepth--;
+        profilerDataDumpRecurseFile(mainState->rootData, depthBuffer, 0, totalTime, fws);
+
+        for (ThreadState* state = mThreadStateList; state; state = state->next)
+        {
+            if (state == mainState || !state->rootData->mTotalTime)
+                continue;
+            dSprintf(buffer, 1023, "\nThread %u -\n", state->threadId);
+            fws.write(dStrlen(buffer), buffer);
+            depthBuffer[0] = 0;
+            profilerDataDumpRecurseFile(state->rootData, depthBuffer, 0, totalTime, fws);
+        }
 
         fws.close();
     }
 
+    // Start over. The recursion above already cleared the nodes it printed.
+    for (ThreadState* state = mThreadStateList; state; state = state->next)
+        for (ProfilerData* data = state->dataList; data; data = data->mNextProfilerData)
+        {
+            data->mTotalTime = 0;
+            data->mSubTime = 0;
+            data->mInvokeCount = 0;
+        }
+    for (U32 i = 0; i < rootVector.size(); i++)
+    {
+        rootVector[i]->mTotalInvokeCount = 0;
+        rootVector[i]->mTotalTime = 0;
+        rootVector[i]->mSubTime = 0;
+    }
+
+    unlockWorkerStates();
+
+    // Threads that have exited are in this dump for the last time.
+    Mutex::lockMutex(mThreadStateMutex);
+    ThreadState* next;
+    for (ThreadState* state = mThreadStateList; state; state = next)
+    {
+        next = state->next;
+        if (state->orphaned)
+            destroyThreadState(state);
+    }
+    Mutex::unlockMutex(mThreadStateMutex);
+
+    mainState->enabled = enableSave;
+    mainState->stackDepth--;
+
     mDumpToConsole = false;
     mDumpToFile = false;
     mDumpFileName[0] = '\0';
@@ -10,6 +10,10 @@
 
 #ifdef TORQUE_ENABLE_PROFILER
 
+#ifndef _PROFILERTRACE_H_
+#include "platform/profilerTrace.h"
+#endif
+
 struct ProfilerData;
 struct ProfilerRootData;
 /// The Profiler is used to see how long a specific chunk of code takes to execute.
@@ -27,6 +31,14 @@ struct ProfilerRootData;
 /// profilerMarkerEnable((string markerName, bool enable);  //enables or disables a given profile tag
 /// @endcode
 ///
+/// Markers may be used on any thread. Every thread keeps its own call stack,
+/// so worker threads don't contend with the main loop, and the dump lists the
+/// main thread's tree followed by one per worker. Times are percentages of
+/// the main thread's profiled time.
+///
+/// To see individual frames rather than totals, record a timeline with
+/// profilerTraceFrames(); see ProfilerTrace.
+///
 /// The C++ code side of the profiler uses pairs of PROFILE_START() and PROFILE_END().
 ///
 /// When using these macros, make sure there is a PROFILE_END() for every PROFILE_START
@@ -55,19 +67,47 @@ class Profiler
         MaxStackDepth = 256,
         DumpFileNameLength = 256
     };
-    U32 mCurrentHash;
 
-    ProfilerData* mCurrentProfilerData;
-    ProfilerData* mProfileList;
-    ProfilerData* mRootProfilerData;
+    /// Call stack and call tree of one thread.
+    ///
+    /// Every thread that hits a profiler marker gets its own, so threads never
+    /// touch each other's data while profiling. The trees are merged when the
+    /// profile is dumped, which happens on the main thread.
+    struct ThreadState
+    {
+        U32 threadId;
+        ProfilerData* rootData;
+        ProfilerData* currentData;
+        ProfilerData* dataList;    ///< Every node of the tree, for freeing.
+        S32 stackDepth;
+        bool enabled;              ///< Latched whenever the stack is empty.
+        bool orphaned;             ///< The thread has exited.
+        void* mutex;               ///< Held by workers while they touch their tree; NULL on the main thread.
+        ThreadState* next;
+    };
+
+    static thread_local ThreadState* smThreadState;
+
+    ThreadState* mMainThreadState;
+    ThreadState* mThreadStateList;
+    void* mThreadStateMutex;
 
-    bool mEnabled;
-    S32 mStackDepth;
     bool mNextEnable;
     U32 mMaxStackDepth;
     bool mDumpToConsole;
     bool mDumpToFile;
     char mDumpFileName[DumpFileNameLength];
+
+    ThreadState* getThreadState();
+    ThreadState* createThreadState();
+    void clearThreadState(ThreadState* state);
+    void destroyThreadState(ThreadState* state);
+    void lockWorkerStates();
+    void unlockWorkerStates();
+
+    void pushData(ThreadState* state, ProfilerRootData* root);
+    void popData(ThreadState* state);
+
     void dump();
     void validate();
 public:
@@ -90,6 +130,8 @@ public:
     void hashPop();
     /// Enable a profiler marker
     void enableMarker(const char* marker, bool enabled);
+    /// Called when a thread exits; its data is kept until the next dump.
+    static void releaseThreadState();
 #ifdef TORQUE_ENABLE_PROFILE_PATH
     /// Get current profile path
     const char* getProfilePath();
@@ -104,9 +146,8 @@ struct ProfilerRootData
 {
     const char* mName;
     U32 mNameHash;
-    ProfilerData* mFirstProfilerData;
     ProfilerRootData* mNextRoot;
-    F64 mTotalTime;
+    F64 mTotalTime;            ///< Totals over all threads, summed up on dump.
     F64 mSubTime;
     U32 mTotalInvokeCount;
     bool mEnabled;
@@ -119,7 +160,6 @@ struct ProfilerRootData
 struct ProfilerData
 {
     ProfilerRootData* mRoot; ///< link to root node.
-    ProfilerData* mNextForRoot; ///< links together all ProfilerData's for a particular root
     ProfilerData* mNextProfilerData; ///< links all the profilerDatas
     ProfilerData* mNextHash;
     ProfilerData* mParent;
@@ -165,11 +205,15 @@ public:
    static ProfilerRootData pdata##name##obj (#name); \
    ScopedProfiler scopedProfiler##name##obj(&pdata##name##obj);
 
+/// Marks the end of a main loop iteration in profiler timelines.
+#define PROFILE_FRAME_MARK() ProfilerTrace::markFrame()
+
 #else
 #define PROFILE_START(x)
 #define PROFILE_END()
 #define PROFILE_SCOPE(x)
 #define PROFILE_END_NAMED(x)
+#define PROFILE_FRAME_MARK()
 #endif
 
 #endif
@@ -0,0 +1,286 @@
+//-----------------------------------------------------------------------------
+// Torque Game Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "platform/profiler.h"
+#include "platform/profilerTrace.h"
+#include "platform/platformMutex.h"
+#include "platform/platformThread.h"
+#include "core/fileStream.h"
+#include "console/console.h"
+
+#ifdef TORQUE_ENABLE_PROFILER
+
+#include <chrono>
+
+bool ProfilerTrace::smRecording = false;
+
+thread_local ProfilerTrace::ThreadBuffer* ProfilerTrace::smBuffer = NULL;
+ProfilerTrace::ThreadBuffer* ProfilerTrace::smBufferList = NULL;
+void* ProfilerTrace::smMutex = NULL;
+
+U32 ProfilerTrace::smMainThreadId = 0;
+U32 ProfilerTrace::smFrameNumber = 0;
+U32 ProfilerTrace::smFramesLeft = 0;
+char ProfilerTrace::smFileName[FileNameLength];
+
+//------------------------------------------------------------------------------
+
+U64 ProfilerTrace::getTime()
+{
+    return U64(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+ProfilerTrace::ThreadBuffer* ProfilerTrace::createBuffer()
+{
+    // Buffers outlive their threads so that their events can still be
+    // written out; they are only freed by destroy().
+    ThreadBuffer* buffer = new ThreadBuffer;
+    buffer->threadId = Thread::getCurrentThreadId();
+    buffer->head = 0;
+
+    Mutex::lockMutex(smMutex);
+    buffer->next = smBufferList;
+    smBufferList = buffer;
+    Mutex::unlockMutex(smMutex);
+
+    smBuffer = buffer;
+    return buffer;
+}
+
+void ProfilerTrace::clearBuffers()
+{
+    Mutex::lockMutex(smMutex);
+    for (ThreadBuffer* walk = smBufferList; walk; walk = walk->next)
+        walk->head = 0;
+    Mutex::unlockMutex(smMutex);
+}
+
+void ProfilerTrace::start()
+{
+    // Only called from the main thread, so creating the mutex here is safe.
+    if (!smMutex)
+        smMutex = Mutex::createMutex();
+
+    smMainThreadId = Thread::getCurrentThreadId();
+    smRecording = false;
+    clearBuffers();
+    smRecording = true;
+}
+
+void ProfilerTrace::destroy()
+{
+    smRecording = false;
+    if (!smMutex)
+        return;
+
+    while (smBufferList)
+    {
+        ThreadBuffer* next = smBufferList->next;
+        delete smBufferList;
+        smBufferList = next;
+    }
+    Mutex::destroyMutex(smMutex);
+    smMutex = NULL;
+}
+
+//------------------------------------------------------------------------------
+
+void ProfilerTrace::markFrame()
+{
+    if (!smRecording)
+        return;
+
+    record(Frame, NULL, smFrameNumber++);
+
+    if (smFramesLeft && --smFramesLeft == 0)
+    {
+        smRecording = false;
+        write(smFileName);
+    }
+}
+
+void ProfilerTrace::recordFrames(U32 frames, const char* fileName)
+{
+    AssertFatal(dStrlen(fileName) < FileNameLength, "ProfilerTrace::recordFrames - file name too long");
+    if (!frames)
+        return;
+
+    dStrcpy(smFileName, fileName);
+    smFramesLeft = frames;
+    start();
+}
+
+void ProfilerTrace::setContinuous(bool enable)
+{
+    smFramesLeft = 0;
+    if (enable)
+        start();
+    else
+        smRecording = false;
+}
+
+//------------------------------------------------------------------------------
+
+static void writeLine(FileStream& stream, bool& first, const char* line)
+{
+    if (!first)
+        stream.write(2, ",\n");
+    first = false;
+    stream.write(dStrlen(line), line);
+}
+
+bool ProfilerTrace::write(const char* fileName)
+{
+    if (!smMutex)
+    {
+        Con::warnf("ProfilerTrace::write - nothing has been recorded.");
+        return false;
+    }
+
+    FileStream stream;
+    if (!stream.open(fileName, FileStream::Write))
+    {
+        Con::errorf("ProfilerTrace::write - could not open '%s' for writing.", fileName);
+        return false;
+    }
+
+    // Threads still recording only ever write past the head we read here, so
+    // this is safe to do while tracing continues, unless a thread manages to
+    // wrap its whole ring while we're busy.
+    Mutex::lockMutex(smMutex);
+
+    U64 startTime = U64(-1);
+    U64 endTime = 0;
+    for (ThreadBuffer* walk = smBufferList; walk; walk = walk->next)
+    {
+        U32 head = walk->head.load(std::memory_order_acquire);
+        if (!head)
+            continue;
+        U32 first = head > EventsPerThread ? head - EventsPerThread : 0;
+        U64 firstTime = walk->events[first & (EventsPerThread - 1)].time;
+        U64 lastTime = walk->events[(head - 1) & (EventsPerThread - 1)].time;
+        if (firstTime < startTime)
+            startTime = firstTime;
+        if (lastTime > endTime)
+            endTime = lastTime;
+    }
+
+    char line[512];
+    bool firstLine = true;
+    U32 numEvents = 0;
+    U32 numDropped = 0;
+
+    const char* header = "{\"traceEvents\":[\n";
+    stream.write(dStrlen(header), header);
+
+    for (ThreadBuffer* walk = smBufferList; walk; walk = walk->next)
+    {
+        U32 head = walk->head.load(std::memory_order_acquire);
+        if (!head)
+            continue;
+
+        const U32 tid = walk->threadId;
+
+        if (tid == smMainThreadId)
+            dSprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Main\"}}", tid);
+        else
+            dSprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}", tid, tid);
+        writeLine(stream, firstLine, line);
+
+        U32 first = 0;
+        if (head > EventsPerThread)
+        {
+            first = head - EventsPerThread;
+            numDropped += first;
+        }
+
+        // The ring may start or end in the middle of a marker, so drop ends we
+        // never saw the start of and close whatever is still open at the end.
+        U32 depth = 0;
+        for (U32 i = first; i < head; i++)
+        {
+            const Event& event = walk->events[i & (EventsPerThread - 1)];
+            F64 ts = F64(event.time - startTime) / 1000.0;
+
+            switch (event.type)
+            {
+            case Begin:
+                dSprintf(line, sizeof(line), "{\"name\":\"%s\",\"ph\":\"B\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}",
+                    event.root->mName, tid, ts);
+                depth++;
+                break;
+
+            case End:
+                if (!depth)
+                    continue;
+                dSprintf(line, sizeof(line), "{\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", tid, ts);
+                depth--;
+                break;
+
+            case Frame:
+                dSprintf(line, sizeof(line), "{\"name\":\"Frame %u\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}",
+                    event.frame, tid, ts);
+                break;
+            }
+            writeLine(stream, firstLine, line);
+            numEvents++;
+        }
+
+        for (; depth; depth--)
+        {
+            dSprintf(line, sizeof(line), "{\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}",
+                tid, F64(endTime - startTime) / 1000.0);
+            writeLine(stream, firstLine, line);
+        }
+    }
+
+    Mutex::unlockMutex(smMutex);
+
+    const char* footer = "\n],\"displayTimeUnit\":\"ms\"}\n";
+    stream.write(dStrlen(footer), footer);
+    stream.close();
+
+    Con::printf("Profiler trace: wrote %u events (%.1f ms) to %s.", numEvents,
+        startTime < endTime ? F64(endTime - startTime) / 1000000.0 : 0.0, fileName);
+    if (numDropped)
+        Con::warnf("Profiler trace: %u older events were overwritten; record fewer frames to keep everything.", numDropped);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+ConsoleFunctionGroupBegin(ProfilerTrace, "Profiler timeline tracing.");
+
+ConsoleFunction(profilerTraceFrames, void, 3, 3, "(int frames, string filename)"
+    "Record a timeline of the next few frames and write it to a Chrome trace file.")
+{
+    argc;
+    char fileName[ProfilerTrace::FileNameLength];
+    Con::expandScriptFilename(fileName, sizeof(fileName), argv[2]);
+    ProfilerTrace::recordFrames(getMax(dAtoi(argv[1]), 0), fileName);
+}
+
+ConsoleFunction(profilerTraceEnable, void, 2, 2, "(bool enable)"
+    "Keep recording the most recent profiler events, to be written out with profilerTraceDump().")
+{
+    argc;
+    ProfilerTrace::setContinuous(dAtob(argv[1]));
+}
+
+ConsoleFunction(profilerTraceDump, bool, 2, 2, "(string filename)"
+    "Write the recorded profiler events to a Chrome trace file.")
+{
+    argc;
+    char fileName[ProfilerTrace::FileNameLength];
+    Con::expandScriptFilename(fileName, sizeof(fileName), argv[1]);
+    return ProfilerTrace::write(fileName);
+}
+
+ConsoleFunctionGroupEnd(ProfilerTrace);
+
+#endif
@@ -0,0 +1,128 @@
+//-----------------------------------------------------------------------------
+// Torque Game Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#ifndef _PROFILERTRACE_H_
+#define _PROFILERTRACE_H_
+
+#ifndef _PLATFORM_H_
+#include "platform/platform.h"
+#endif
+
+#ifdef TORQUE_ENABLE_PROFILER
+
+#include <atomic>
+
+struct ProfilerRootData;
+
+/// Timeline recorder behind the PROFILE_START() and PROFILE_END() macros.
+///
+/// The Profiler only keeps totals per marker, which hides one-off spikes. While
+/// tracing, every marker entry and exit is also stored with a timestamp in a
+/// ring buffer owned by the thread that hit it, together with a marker per main
+/// loop frame, and written out as Chrome trace JSON (load it in
+/// chrome://tracing or ui.perfetto.dev). Each thread gets its own track.
+///
+/// @code
+/// profilerTraceFrames(60, "trace.json");  // record the next 60 frames, then write
+/// profilerTraceEnable(true);              // keep recording the most recent events...
+/// profilerTraceDump("trace.json");        // ...and write them out when something happens
+/// @endcode
+///
+/// Recording costs a timestamp and a store per marker and takes no locks, so
+/// continuous mode can be left on for servers. Every thread keeps the last
+/// EventsPerThread events; older ones are overwritten.
+class ProfilerTrace
+{
+public:
+    enum
+    {
+        EventsPerThread = 1 << 16,
+        FileNameLength = 256,
+    };
+
+    /// Checked by the profiler before calling beginEvent() and endEvent().
+    static bool smRecording;
+
+    static void beginEvent(ProfilerRootData* root);
+    static void endEvent();
+
+    /// Called once per main loop iteration, see PROFILE_FRAME_MARK().
+    static void markFrame();
+
+    /// Record the next 'frames' frames, then write them to 'fileName'.
+    static void recordFrames(U32 frames, const char* fileName);
+
+    /// Turn continuous recording into the ring buffers on or off.
+    static void setContinuous(bool enable);
+
+    /// Write whatever is in the ring buffers to a Chrome trace file.
+    static bool write(const char* fileName);
+
+    static void destroy();
+
+private:
+    enum EventType
+    {
+        Begin,
+        End,
+        Frame,
+    };
+
+    struct Event
+    {
+        U64 time;                 ///< Nanoseconds, see getTime().
+        ProfilerRootData* root;   ///< Marker of a Begin event.
+        U32 type;
+        U32 frame;                ///< Frame number of a Frame event.
+    };
+
+    struct ThreadBuffer
+    {
+        U32 threadId;
+        std::atomic<U32> head;    ///< Events ever written; wraps the ring.
+        ThreadBuffer* next;
+        Event events[EventsPerThread];
+    };
+
+    static thread_local ThreadBuffer* smBuffer;
+    static ThreadBuffer* smBufferList;
+    static void* smMutex;
+
+    static U32 smMainThreadId;
+    static U32 smFrameNumber;
+    static U32 smFramesLeft;
+    static char smFileName[FileNameLength];
+
+    static U64 getTime();
+    static ThreadBuffer* createBuffer();
+    static void clearBuffers();
+    static void start();
+
+    static void record(U32 type, ProfilerRootData* root, U32 frame)
+    {
+        ThreadBuffer* buffer = smBuffer ? smBuffer : createBuffer();
+        U32 head = buffer->head.load(std::memory_order_relaxed);
+        Event& event = buffer->events[head & (EventsPerThread - 1)];
+        event.time = getTime();
+        event.root = root;
+        event.type = type;
+        event.frame = frame;
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+};
+
+inline void ProfilerTrace::beginEvent(ProfilerRootData* root)
+{
+    record(Begin, root, 0);
+}
+
+inline void ProfilerTrace::endEvent()
+{
+    record(End, NULL, 0);
+}
+
+#endif // TORQUE_ENABLE_PROFILER
+
+#endif // _PROFILERTRACE_H_
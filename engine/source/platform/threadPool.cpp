@@ -0,0 +1,236 @@
+//-----------------------------------------------------------------------------
+// Torque Game Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "platform/threadPool.h"
+#include "platform/platformThread.h"
+#include "platform/platformMutex.h"
+#include "platform/platformSemaphore.h"
+#include "platform/profiler.h"
+#include "console/console.h"
+
+ThreadPool* ThreadPool::smGlobal = NULL;
+
+//------------------------------------------------------------------------------
+
+ThreadPool::ThreadPool(U32 numThreads)
+{
+    mQueueHead = 0;
+    mCompletedHead = 0;
+    mNumPending = 0;
+    mShuttingDown = false;
+
+    mQueueMutex = Mutex::createMutex();
+    mQueueSemaphore = Semaphore::createSemaphore(0);
+
+    if (numThreads == 0)
+        numThreads = getDefaultNumThreads();
+
+    for (U32 i = 0; i < numThreads; i++)
+        mThreads.push_back(new Thread(workerThunk, this, true));
+}
+
+ThreadPool::~ThreadPool()
+{
+    waitForAllItems();
+
+    // Wake every worker so it can see the shutdown flag, then join them.
+    mShuttingDown = true;
+    for (U32 i = 0; i < mThreads.size(); i++)
+        Semaphore::releaseSemaphore(mQueueSemaphore);
+    for (U32 i = 0; i < mThreads.size(); i++)
+        delete mThreads[i];
+    mThreads.clear();
+
+    Semaphore::destroySemaphore(mQueueSemaphore);
+    Mutex::destroyMutex(mQueueMutex);
+}
+
+U32 ThreadPool::getDefaultNumThreads()
+{
+    U32 numCores = Platform::SystemInfo.processor.numCores;
+    return numCores > 1 ? numCores - 1 : 1;
+}
+
+//------------------------------------------------------------------------------
+
+void ThreadPool::workerThunk(void* pool)
+{
+    ((ThreadPool*)pool)->workerLoop();
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        Semaphore::acquireSemaphore(mQueueSemaphore);
+        if (mShuttingDown)
+            break;
+
+        // The item may already have been taken by a thread that is
+        // waiting in waitForAllItems().
+        WorkItem* item = dequeue();
+        if (item)
+            executeItem(item);
+    }
+}
+
+namespace
+{
+    /// Pops from a Vector used as a queue from head on; returns NULL once it
+    /// runs dry.  Must be called with the pool's lock held.
+    ThreadPool::WorkItem* popFront(Vector<ThreadPool::WorkItem*>& queue, U32& head)
+    {
+        ThreadPool::WorkItem* item = NULL;
+        while (!item && head < queue.size())
+            item = queue[head++];
+
+        if (head == queue.size())
+        {
+            queue.clear();
+            head = 0;
+        }
+        else if (head >= 64 && head * 2 >= queue.size())
+        {
+            // Slide the live part down now and then, rather than every pop.
+            U32 live = queue.size() - head;
+            dMemmove(queue.address(), queue.address() + head, live * sizeof(ThreadPool::WorkItem*));
+            queue.setSize(live);
+            head = 0;
+        }
+
+        return item;
+    }
+}
+
+ThreadPool::WorkItem* ThreadPool::dequeue()
+{
+    Mutex::lockMutex(mQueueMutex);
+    WorkItem* item = popFront(mQueue, mQueueHead);
+    Mutex::unlockMutex(mQueueMutex);
+
+    return item;
+}
+
+ThreadPool::WorkItem* ThreadPool::dequeueCompleted()
+{
+    Mutex::lockMutex(mQueueMutex);
+    WorkItem* item = popFront(mCompleted, mCompletedHead);
+    Mutex::unlockMutex(mQueueMutex);
+
+    return item;
+}
+
+void ThreadPool::executeItem(WorkItem* item)
+{
+    item->execute();
+
+    Mutex::lockMutex(mQueueMutex);
+    mCompleted.push_back(item);
+    Mutex::unlockMutex(mQueueMutex);
+}
+
+bool ThreadPool::runIfQueued(WorkItem* item)
+{
+    bool found = false;
+
+    Mutex::lockMutex(mQueueMutex);
+    for (U32 i = mQueueHead; i < mQueue.size(); i++)
+    {
+        if (mQueue[i] == item)
+        {
+            // Leave a hole, the worker that gets the semaphore skips it.
+            mQueue[i] = NULL;
+            found = true;
+            break;
+        }
+    }
+    Mutex::unlockMutex(mQueueMutex);
+
+    if (found)
+        executeItem(item);
+    return found;
+}
+
+//------------------------------------------------------------------------------
+
+void ThreadPool::queueWorkItem(WorkItem* item)
+{
+    AssertFatal(item, "ThreadPool::queueWorkItem - no work item!");
+
+    Mutex::lockMutex(mQueueMutex);
+    mQueue.push_back(item);
+    mNumPending++;
+    Mutex::unlockMutex(mQueueMutex);
+
+    Semaphore::releaseSemaphore(mQueueSemaphore);
+}
+
+void ThreadPool::processCompletedItems()
+{
+    AssertFatal(Con::isMainThread(), "ThreadPool::processCompletedItems - only the main thread may complete items.");
+
+    PROFILE_START(ThreadPool_processCompletedItems);
+
+    // One at a time, so onCompleted() may queue more work or wait on the pool
+    // and find the rest of the list still there.
+    while (WorkItem* item = dequeueCompleted())
+    {
+        Mutex::lockMutex(mQueueMutex);
+        mNumPending--;
+        Mutex::unlockMutex(mQueueMutex);
+
+        item->onCompleted();
+        delete item;
+    }
+
+    PROFILE_END();
+}
+
+void ThreadPool::waitForAllItems()
+{
+    while (getNumPendingItems())
+    {
+        WorkItem* item = dequeue();
+        if (item)
+            executeItem(item);
+        else
+            Platform::sleep(0);
+
+        processCompletedItems();
+    }
+}
+
+U32 ThreadPool::getNumPendingItems()
+{
+    Mutex::lockMutex(mQueueMutex);
+    U32 numPending = mNumPending;
+    Mutex::unlockMutex(mQueueMutex);
+
+    return numPending;
+}
+
+//------------------------------------------------------------------------------
+
+void ThreadPool::createGlobal()
+{
+    AssertFatal(smGlobal == NULL, "ThreadPool::createGlobal - global pool already exists.");
+    smGlobal = new ThreadPool;
+
+    Con::printf("Thread pool started with %d worker(s).", smGlobal->getNumThreads());
+}
+
+void ThreadPool::destroyGlobal()
+{
+    AssertFatal(smGlobal != NULL, "ThreadPool::destroyGlobal - global pool does not exist.");
+    delete smGlobal;
+    smGlobal = NULL;
+}
+
+ThreadPool& ThreadPool::getGlobal()
+{
+    AssertFatal(smGlobal != NULL, "ThreadPool::getGlobal - global pool does not exist.");
+    return *smGlobal;
+}
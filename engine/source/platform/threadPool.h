@@ -0,0 +1,139 @@
+//-----------------------------------------------------------------------------
+// Torque Game Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#ifndef _PLATFORM_H_
+#include "platform/platform.h"
+#endif
+#ifndef _TVECTOR_H_
+#include "core/tVector.h"
+#endif
+
+class Thread;
+
+/// A pool of worker threads that execute queued work items.
+///
+/// Work items run execute() on one of the worker threads. Once that returns
+/// the item is handed back to the main thread, where onCompleted() is called
+/// from processCompletedItems() (or waitForAllItems(), which pumps it) and
+/// the item is deleted. onCompleted() is the place for anything that touches
+/// engine state which is not thread-safe, like the console, the resource
+/// dictionary or GFX resources.
+///
+/// @code
+/// class DecodeWorkItem : public ThreadPool::WorkItem
+/// {
+///    virtual void execute()     { ... runs on a worker thread ... }
+///    virtual void onCompleted() { ... runs on the main thread ... }
+/// };
+///
+/// ThreadPool::getGlobal().queueWorkItem(new DecodeWorkItem);
+/// @endcode
+///
+/// The global pool is created in initLibraries() and pumped once per
+/// iteration of the main loop.
+class ThreadPool
+{
+public:
+    /// Base class for a unit of work.
+    class WorkItem
+    {
+    public:
+        WorkItem() {}
+        virtual ~WorkItem() {}
+
+        /// Do the work. Called on a worker thread.
+        virtual void execute() = 0;
+
+        /// Called on the main thread after execute() has returned.
+        virtual void onCompleted() {}
+    };
+
+protected:
+    Vector<Thread*>   mThreads;
+
+    void* mQueueMutex;              ///< Guards the queues and mNumPending.
+    void* mQueueSemaphore;          ///< Counts items pushed onto mQueue.
+
+    /// Items waiting for a worker, from mQueueHead on.  Slots before the head
+    /// have been taken; the dead space is reclaimed when it gets large.  A
+    /// NULL slot is an item runIfQueued() took out of the middle.
+    Vector<WorkItem*> mQueue;
+    U32               mQueueHead;
+
+    Vector<WorkItem*> mCompleted;   ///< Executed items waiting for onCompleted(), from mCompletedHead on.
+    U32               mCompletedHead;
+    U32               mNumPending;  ///< Items queued, executing or waiting for onCompleted().
+
+    volatile bool     mShuttingDown;
+
+    static ThreadPool* smGlobal;
+
+    static void workerThunk(void* pool);
+    void workerLoop();
+
+    /// Pop the next item from the queue, or NULL if it is empty.
+    WorkItem* dequeue();
+
+    /// Pop the next executed item, or NULL if there is none.
+    WorkItem* dequeueCompleted();
+
+    /// Execute an item and move it to the completed list.
+    void executeItem(WorkItem* item);
+
+public:
+    /// @param numThreads  Number of worker threads; zero picks one less than
+    ///                    the number of logical processors (at least one).
+    ThreadPool(U32 numThreads = 0);
+    ~ThreadPool();
+
+    /// Queue an item for execution. The pool takes ownership of it.
+    void queueWorkItem(WorkItem* item);
+
+    /// Run onCompleted() for all executed items and delete them.
+    /// Must be called from the main thread.
+    ///
+    /// Items are taken one at a time and stop counting as pending just before
+    /// their onCompleted() runs, so a callback may itself wait on the pool.
+    void processCompletedItems();
+
+    /// Block until every queued item has executed and completed.
+    ///
+    /// The calling thread helps out by executing queued items itself, and
+    /// runs onCompleted() for every item that finishes meanwhile, not just
+    /// its own.  Must be called from the main thread.  To wait for one
+    /// particular piece of work, track it yourself and use runIfQueued().
+    void waitForAllItems();
+
+    /// If item is still waiting in the queue, take it out and execute it on
+    /// the calling thread.  Its onCompleted() still runs from
+    /// processCompletedItems() as usual.
+    ///
+    /// @returns false if a worker already has the item (or it has run), in
+    ///          which case the caller has to wait on it by other means.
+    bool runIfQueued(WorkItem* item);
+
+    /// Number of items that have been queued but not completed yet.
+    U32 getNumPendingItems();
+
+    U32 getNumThreads() const { return mThreads.size(); }
+
+    /// @name Global Pool
+    /// @{
+
+    ///
+    static void createGlobal();
+    static void destroyGlobal();
+    static ThreadPool& getGlobal();
+    static bool hasGlobal() { return smGlobal != NULL; }
+    /// @}
+
+    /// Returns a sensible default number of workers for this machine.
+    static U32 getDefaultNumThreads();
+};
+
+#endif
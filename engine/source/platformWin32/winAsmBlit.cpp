@@ -321,13 +321,15 @@ void bitmapConvertRGB_to_5551_mmx(U8* src, U32 pixels)
 //--------------------------------------------------------------------------
 void PlatformBlitInit()
 {
+    // bitmapExtrudeRGB keeps its default, the SSE2 version where the build
+    // has it; the MMX one only beats the C version.
     bitmapExtrude5551 = bitmapExtrude5551_asm;
-    bitmapExtrudeRGB = bitmapExtrudeRGB_c;
 
     if (Platform::SystemInfo.processor.properties & CPU_PROP_MMX)
     {
 #if defined(TORQUE_SUPPORTS_VC_INLINE_X86_ASM)
-        bitmapExtrudeRGB = bitmapExtrudeRGB_mmx;
+        if (bitmapExtrudeRGB == bitmapExtrudeRGB_c)
+            bitmapExtrudeRGB = bitmapExtrudeRGB_mmx;
         bitmapConvertRGB_to_5551 = bitmapConvertRGB_to_5551_mmx;
 #endif
     }
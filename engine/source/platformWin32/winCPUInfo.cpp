@@ -39,6 +39,10 @@ void Processor::init()
     Platform::SystemInfo.processor.mhz = 0;
     Platform::SystemInfo.processor.properties = CPU_PROP_C;
 
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+    Platform::SystemInfo.processor.numCores = sysInfo.dwNumberOfProcessors;
+
     char     vendor[13] = { 0, };
     U32   properties = 0;
     U32   processor = 0;
@@ -234,6 +238,7 @@ void Processor::init()
         Con::printf("   3DNow detected");
     if (Platform::SystemInfo.processor.properties & CPU_PROP_SSE)
         Con::printf("   SSE detected");
+    Con::printf("   %d logical processor(s)", Platform::SystemInfo.processor.numCores);
     Con::printf(" ");
 
     PlatformBlitInit();
@@ -6,6 +6,8 @@
 #include "platform/platformThread.h"
 #include "platformWin32/platformWin32.h"
 #include "platform/platformSemaphore.h"
+#include "core/frameAllocator.h"
+#include "platform/profiler.h"
 
 //--------------------------------------------------------------------------
 struct WinThreadData
@@ -52,6 +54,11 @@ static DWORD WINAPI ThreadRunHandler(void* arg)
     WinThreadData* threadData = reinterpret_cast<WinThreadData*>(arg);
 
     threadData->mThread->run(threadData->mRunArg);
+    FrameAllocator::releaseThreadArena();
+    Memory::releaseThreadCache();
+#ifdef TORQUE_ENABLE_PROFILER
+    Profiler::releaseThreadState();
+#endif
     Semaphore::releaseSemaphore(threadData->mSemaphore);
 
     return(0);
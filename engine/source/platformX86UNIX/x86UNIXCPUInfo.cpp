@@ -10,6 +10,7 @@
 #include "console/console.h"
 #include "core/stringTable.h"
 #include <math.h>
+#include <unistd.h>
 
 Platform::SystemInfo_struct Platform::SystemInfo;
 
@@ -41,6 +42,7 @@ void Processor::init()
    Platform::SystemInfo.processor.name = StringTable->insert("Unknown x86 Compatible");
    Platform::SystemInfo.processor.mhz  = 0;
    Platform::SystemInfo.processor.properties = CPU_PROP_C;
+   Platform::SystemInfo.processor.numCores = sysconf(_SC_NPROCESSORS_ONLN);
 
    clockticks = properties = processor = 0;
    dStrcpy(vendor, "");
@@ -114,6 +116,7 @@ void Processor::init()
       Con::printf("   3DNow detected");
    if (Platform::SystemInfo.processor.properties & CPU_PROP_SSE)
       Con::printf("   SSE detected");
+   Con::printf("   %d logical processor(s)", Platform::SystemInfo.processor.numCores);
    Con::printf(" ");
 
    PlatformBlitInit();
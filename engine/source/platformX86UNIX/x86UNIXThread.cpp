@@ -8,6 +8,8 @@
 #include "platform/platformThread.h"
 #include "platformX86UNIX/platformX86UNIX.h"
 #include "platform/platformSemaphore.h"
+#include "core/frameAllocator.h"
+#include "platform/profiler.h"
 #include <pthread.h>
 
 //--------------------------------------------------------------------------
@@ -55,6 +57,11 @@ static void *ThreadRunHandler(void * arg)
    x86UNIXThreadData * threadData = reinterpret_cast<x86UNIXThreadData*>(arg);
 
    threadData->mThread->run(threadData->mRunArg);
+   FrameAllocator::releaseThreadArena();
+   Memory::releaseThreadCache();
+#ifdef TORQUE_ENABLE_PROFILER
+   Profiler::releaseThreadState();
+#endif
    Semaphore::releaseSemaphore(threadData->mSemaphore);
    return NULL;
 }
@@ -37,7 +37,7 @@ struct RenderInst
     GFXPrimitive* prim;
 
     U32 primBuffIndex;
-    //U32 primStartIndex;
+    U32 primStartIndex;        // first index, for particle batches sharing a buffer
     //U32 primCount;
     MatInstance* matInst;
 
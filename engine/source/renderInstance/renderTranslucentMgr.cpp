@@ -156,7 +156,8 @@ void RenderTranslucentMgr::render()
             GFX->setVertexBuffer(*ri->vertBuff);
             GFX->disableShaders();
             GFX->setupGenericShaders(GFXDevice::GSModColorTexture);
-            GFX->drawIndexedPrimitive(GFXTriangleList, 0, ri->primBuffIndex * 4, 0, ri->primBuffIndex * 2);
+            // six indices and four verts a quad, batches start part way into the buffers
+            GFX->drawIndexedPrimitive(GFXTriangleList, ri->primStartIndex / 6 * 4, ri->primBuffIndex * 4, ri->primStartIndex, ri->primBuffIndex * 2);
 
             GFX->popWorldMatrix();
 
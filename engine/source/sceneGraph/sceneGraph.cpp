@@ -20,6 +20,7 @@
 
 #include "gfx/gfxDevice.h"
 #include "gfx/debugDraw.h"
+#include "ts/tsShapeInstance.h"
 
 const U32 SceneGraph::csmMaxTraversalDepth = 4;
 U32 SceneGraph::smStateKey = 0;
@@ -119,6 +120,9 @@ void SceneGraph::renderScene(const U32 objectMask)
     }
 
 
+    // anything advanced since the last process list update
+    TSShapeInstance::animateDeferred();
+
     PROFILE_START(SceneGraphRender);
     if (smVisibleDistanceMod > 1.0f)
         smVisibleDistanceMod = 1.0f;
@@ -13,6 +13,7 @@
 #include "gfx/primBuilder.h"
 #include "renderInstance/renderInstMgr.h"
 #include "interior/interiorInstance.h"
+#include "game/fx/particleManager.h"
 
 // MM/JF: Added for mirrorSubObject fix.
 void SceneState::setupClipPlanes(ZoneState& rState)
@@ -139,6 +140,9 @@ void SceneState::renderCurrentImages()
 
     GFX->popWorldMatrix();
 
+    // the particle batches need every emitter in before they can be built
+    gParticleManager.submit();
+
     gRenderInstManager.sort();
     gRenderInstManager.render();
     gRenderInstManager.clear();
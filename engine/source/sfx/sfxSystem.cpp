@@ -27,10 +27,13 @@ void SFXSystem::init()
    // We register the common resource types 
    // here.  Provider specific resource types
    // should be registered in their constructors.
-   ResourceManager->registerExtension( ".wav", SFXWavResource::create );
+   //
+   // Both decoders only touch the stream they are given,
+   // so they can run on the background loader.
+   ResourceManager->registerExtension( ".wav", SFXWavResource::create, true );
 
 #ifndef TORQUE_NO_OGGVORBIS
-   ResourceManager->registerExtension( ".ogg", SFXOggResource::create );
+   ResourceManager->registerExtension( ".ogg", SFXOggResource::create, true );
 #endif
 
    // Create the system.
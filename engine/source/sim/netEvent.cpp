@@ -8,10 +8,13 @@
 #include "console/simBase.h"
 #include "sim/netConnection.h"
 #include "core/bitStream.h"
+#include "platform/memoryTag.h"
 
 #define DebugChecksum 0xF00DBAAD
 
-FreeListChunker<NetEventNote> NetConnection::mEventNoteChunker;
+static MemoryTag sNetEventMemoryTag("NetEventNotes");
+
+FreeListChunker<NetEventNote> NetConnection::mEventNoteChunker(DataChunker::ChunkSize, &sNetEventMemoryTag);
 
 NetEvent::~NetEvent()
 {
@@ -15,6 +15,7 @@
 #include "game/gameProcess.h"
 #include "math/mathUtils.h"
 #include "game/tickCache.h"
+#include "ts/tsShapeInstance.h"
 
 //----------------------------------------------------------------------------
 
@@ -332,6 +333,7 @@ bool ProcessList::advanceClientTime(SimTime timeDelta)
             GameBase* gb = getGameBase(pobj);
             gb->advanceTime(dt);
         }
+        TSShapeInstance::animateDeferred();
     }
     else {
         mSkipAdvanceObjectsMs -= timeDelta;
@@ -386,6 +388,7 @@ bool ProcessList::advanceSPModeTime(SimTime timeDelta)
         GameBase* gb = getGameBase(obj);
         gb->advanceTime(dt);
     }
+    TSShapeInstance::animateDeferred();
 
     mLastTime = targetTime;
     PROFILE_END();
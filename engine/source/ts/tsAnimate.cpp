@@ -4,6 +4,12 @@
 //-----------------------------------------------------------------------------
 
 #include "ts/tsShapeInstance.h"
+#include "console/console.h"
+#include "platform/profiler.h"
+#include "platform/threadPool.h"
+#include "core/resManager.h"
+
+#include <atomic>
 
 //----------------------------------------------------------------------------------
 // some utility functions
@@ -115,11 +121,26 @@ void TSShapeInstance::animateNodes(S32 ss)
     if (scaleCurrentlyAnimated())
         handleDefaultScale(a, b, scaleBeenSet);
 
+    // nodes of this detail, for sampling only the tracks a thread will hand out
+    TSIntegerSet detailNodes, sampleNodes;
+    detailNodes.clearAll();
+    for (i = a; i < b; i++)
+        detailNodes.set(i);
+
     // handle non-blend sequences
     for (i = 0; i < firstBlend; i++)
     {
         TSThread* th = mThreadList[i];
 
+        // sample the tracks no earlier thread has set in one pass, then hand them out
+        sampleNodes = detailNodes;
+        sampleNodes.takeAway(rotBeenSet);
+        mShape->sampleRotations(*th->sequence, th->keyNum1, th->keyNum2, th->keyPos, smSampledRotations, &sampleNodes);
+        sampleNodes = detailNodes;
+        sampleNodes.takeAway(tranBeenSet);
+        sampleNodes.takeAway(maskPosNodes); // handleMaskedPositionNode reads those keys itself
+        mShape->sampleTranslations(*th->sequence, th->keyNum1, th->keyNum2, th->keyPos, smSampledTranslations, &sampleNodes);
+
         j = 0;
         start = th->sequence->rotationMatters.start();
         end = b;
@@ -130,10 +151,7 @@ void TSShapeInstance::animateNodes(S32 ss)
                 continue;
             if (!rotBeenSet.test(nodeIndex))
             {
-                QuatF q1, q2;
-                mShape->getRotation(*th->sequence, th->keyNum1, j, &q1);
-                mShape->getRotation(*th->sequence, th->keyNum2, j, &q2);
-                TSTransform::interpolate(q1, q2, th->keyPos, &smNodeCurrentRotations[nodeIndex]);
+                smNodeCurrentRotations[nodeIndex] = smSampledRotations[j];
                 rotBeenSet.set(nodeIndex);
                 smRotationThreads[nodeIndex] = th;
             }
@@ -152,9 +170,7 @@ void TSShapeInstance::animateNodes(S32 ss)
                     handleMaskedPositionNode(th, nodeIndex, j);
                 else
                 {
-                    const Point3F& p1 = mShape->getTranslation(*th->sequence, th->keyNum1, j);
-                    const Point3F& p2 = mShape->getTranslation(*th->sequence, th->keyNum2, j);
-                    TSTransform::interpolate(p1, p2, th->keyPos, &smNodeCurrentTranslations[nodeIndex]);
+                    smNodeCurrentTranslations[nodeIndex] = smSampledTranslations[j];
                     smTranslationThreads[nodeIndex] = th;
                 }
                 tranBeenSet.set(nodeIndex);
@@ -204,6 +220,9 @@ void TSShapeInstance::animateNodes(S32 ss)
             mNodeTransforms[i].mul(mNodeTransforms[parentIdx], localMat);
         }
     }
+
+    // skinned vertex buffers made from the old transforms are stale now
+    mTransformStamp++;
 }
 
 void TSShapeInstance::handleDefaultScale(S32 a, S32 b, TSIntegerSet& scaleBeenSet)
@@ -465,8 +484,8 @@ void TSShapeInstance::handleAnimatedScale(TSThread* thread, S32 a, S32 b, TSInte
 
 void TSShapeInstance::handleMaskedPositionNode(TSThread* th, S32 nodeIndex, S32 offset)
 {
-    const Point3F& p1 = mShape->getTranslation(*th->sequence, th->keyNum1, offset);
-    const Point3F& p2 = mShape->getTranslation(*th->sequence, th->keyNum2, offset);
+    Point3F p1 = mShape->getTranslation(*th->sequence, th->keyNum1, offset);
+    Point3F p2 = mShape->getTranslation(*th->sequence, th->keyNum2, offset);
     Point3F p;
     TSTransform::interpolate(p1, p2, th->keyPos, &p);
 
@@ -518,8 +537,8 @@ void TSShapeInstance::handleBlendSequence(TSThread* thread, S32 a, S32 b)
 
         if (thread->sequence->translationMatters.test(nodeIndex))
         {
-            const Point3F& p1 = mShape->getTranslation(*thread->sequence, thread->keyNum1, jtrans);
-            const Point3F& p2 = mShape->getTranslation(*thread->sequence, thread->keyNum2, jtrans);
+            Point3F p1 = mShape->getTranslation(*thread->sequence, thread->keyNum1, jtrans);
+            Point3F p2 = mShape->getTranslation(*thread->sequence, thread->keyNum2, jtrans);
             Point3F p;
             TSTransform::interpolate(p1, p2, thread->keyPos, &p);
             mat.setColumn(3, p);
@@ -871,6 +890,117 @@ void TSShapeInstance::animate(S32 dl)
     mDirtyFlags[ss] = 0;
 }
 
+//-------------------------------------------------------------------------------------
+// Batched animation
+//-------------------------------------------------------------------------------------
+
+bool TSShapeInstance::smThreadedAnimate = true;
+Vector<TSShapeInstance*> TSShapeInstance::smDeferredAnimates;
+
+void TSShapeInstance::deferAnimate()
+{
+    AssertFatal(Con::isMainThread(), "TSShapeInstance::deferAnimate: main thread only");
+
+    // node callbacks go into game code, which isn't safe off the main thread
+    if (mCallback)
+    {
+        animate();
+        return;
+    }
+
+    if (!mAnimateDeferred)
+    {
+        mAnimateDeferred = true;
+        smDeferredAnimates.push_back(this);
+    }
+}
+
+namespace
+{
+    /// One animateDeferred() call, shared by the main thread and the work items.
+    /// Each claims the next instance until there are none left, so an item that
+    /// only gets to run after the batch is done just drops its reference.
+    struct AnimateBatch
+    {
+        Vector<TSShapeInstance*> instances;
+        std::atomic<S32> next;
+        std::atomic<S32> done;
+        std::atomic<S32> refs;
+
+        void run()
+        {
+            S32 i;
+            while ((i = next++) < instances.size())
+            {
+                instances[i]->animate();
+                done++;
+            }
+        }
+
+        void release()
+        {
+            if (--refs == 0)
+                delete this;
+        }
+    };
+
+    class AnimateWorkItem : public ThreadPool::WorkItem
+    {
+        AnimateBatch* mBatch;
+
+    public:
+        AnimateWorkItem(AnimateBatch* batch) { mBatch = batch; }
+        ~AnimateWorkItem() { mBatch->release(); }
+
+        void execute() { mBatch->run(); }
+    };
+}
+
+void TSShapeInstance::animateDeferred()
+{
+    AssertFatal(Con::isMainThread(), "TSShapeInstance::animateDeferred: main thread only");
+
+    if (!smDeferredAnimates.size())
+        return;
+
+    PROFILE_SCOPE(TSShapeInstance_animateDeferred);
+
+    // not worth waking the pool for a handful
+    enum { MinThreadedInstances = 16 };
+
+    S32 count = smDeferredAnimates.size();
+    for (S32 i = 0; i < count; i++)
+        smDeferredAnimates[i]->mAnimateDeferred = false;
+
+    if (!smThreadedAnimate || !ThreadPool::hasGlobal() || count < MinThreadedInstances)
+    {
+        for (S32 i = 0; i < count; i++)
+            smDeferredAnimates[i]->animate();
+        smDeferredAnimates.clear();
+        return;
+    }
+
+    ThreadPool& pool = ThreadPool::getGlobal();
+    U32 numItems = getMin(pool.getNumThreads(), U32(count / (MinThreadedInstances / 2)));
+
+    AnimateBatch* batch = new AnimateBatch;
+    batch->instances = smDeferredAnimates;
+    batch->next = 0;
+    batch->done = 0;
+    batch->refs = numItems + 1;
+    smDeferredAnimates.clear();
+
+    for (U32 i = 0; i < numItems; i++)
+        pool.queueWorkItem(new AnimateWorkItem(batch));
+
+    // work alongside the pool, then wait for whatever it's still finishing
+    batch->run();
+    while (batch->done < count)
+        Platform::sleep(0);
+
+    batch->release();
+}
+
 void TSShapeInstance::animateNodeSubtrees(bool forceFull)
 {
     // animate all the nodes for all the detail levels...
@@ -1104,3 +1234,89 @@ U32 TSShapeInstance::getNodeAnimationState(S32 nodeIndex)
         ret |= MaskNodeCallback;
     return ret;
 }
+
+//-------------------------------------------------------------------------------------
+// Animation benchmark
+//
+// Animates the same set of instances serially and through animateDeferred(), and
+// checks that both end up with the same node transforms.
+
+ConsoleFunction(benchmarkAnimation, void, 1, 4, "([string shape, int count, int frames]) "
+    "Time animating count instances of shape one at a time and as a deferred batch.")
+{
+    const char* shapeName = argc > 1 ? argv[1] : "marble/data/shapes/items/gem.dts";
+    S32 count = argc > 2 ? getMax(dAtoi(argv[2]), 1) : 256;
+    S32 frames = argc > 3 ? getMax(dAtoi(argv[3]), 1) : 100;
+
+    Resource<TSShape> shape = ResourceManager->load(shapeName);
+    if (bool(shape) == false)
+    {
+        Con::errorf("benchmarkAnimation: couldn't load '%s'.", shapeName);
+        return;
+    }
+
+    // two identical sets, each thread started at a different point
+    Vector<TSShapeInstance*> serial, batched;
+    for (S32 i = 0; i < count; i++)
+    {
+        TSShapeInstance* a = new TSShapeInstance(shape, false);
+        TSShapeInstance* b = new TSShapeInstance(shape, false);
+        if (shape->sequences.size())
+        {
+            F32 pos = F32(i) / count;
+            a->setSequence(a->addThread(), i % shape->sequences.size(), pos);
+            b->setSequence(b->addThread(), i % shape->sequences.size(), pos);
+        }
+        serial.push_back(a);
+        batched.push_back(b);
+    }
+
+    const F32 dt = 1.0f / 60.0f;
+    U32 startTime = Platform::getRealMilliseconds();
+    for (S32 f = 0; f < frames; f++)
+    {
+        for (S32 i = 0; i < count; i++)
+        {
+            serial[i]->advanceTime(dt);
+            serial[i]->animate();
+        }
+    }
+    U32 serialTime = Platform::getRealMilliseconds() - startTime;
+
+    startTime = Platform::getRealMilliseconds();
+    for (S32 f = 0; f < frames; f++)
+    {
+        for (S32 i = 0; i < count; i++)
+        {
+            batched[i]->advanceTime(dt);
+            batched[i]->deferAnimate();
+        }
+        TSShapeInstance::animateDeferred();
+    }
+    U32 batchedTime = Platform::getRealMilliseconds() - startTime;
+
+    S32 mismatches = 0;
+    for (S32 i = 0; i < count; i++)
+    {
+        const Vector<MatrixF>& a = serial[i]->mNodeTransforms;
+        const Vector<MatrixF>& b = batched[i]->mNodeTransforms;
+        if (a.size() != b.size() || (a.size() && dMemcmp(a.address(), b.address(), a.size() * sizeof(MatrixF))))
+            mismatches++;
+    }
+
+    Con::printf("Animation benchmark: %d x '%s', %d nodes, %d frames, %d pool thread(s)",
+        count, shapeName, shape->nodes.size(), frames,
+        ThreadPool::hasGlobal() ? ThreadPool::getGlobal().getNumThreads() : 0);
+    Con::printf("   serial    %6d ms", serialTime);
+    Con::printf("   batched   %6d ms%s", batchedTime, TSShapeInstance::smThreadedAnimate ? "" : " ($pref::TS::threadedAnimate is off)");
+    if (mismatches)
+        Con::errorf("   FAILED: %d instances differed from the serial result", mismatches);
+    else
+        Con::printf("   every instance matched the serial result");
+
+    for (S32 i = 0; i < count; i++)
+    {
+        delete serial[i];
+        delete batched[i];
+    }
+}
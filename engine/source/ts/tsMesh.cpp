@@ -24,6 +24,13 @@
 #include "game/game.h"
 #include "lightingSystem/sgLightingModel.h"
 
+#if defined(TORQUE_CPU_X86) || defined(TORQUE_CPU_X64)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TSMESH_SKIN_SSE
+#include <xmmintrin.h>
+#endif
+#endif
+
 // Not worth the effort, much less the effort to comment, but if the draw types
 // are consecutive use addition rather than a table to go from index to command value...
 /*
@@ -41,21 +48,21 @@ GFXPrimitiveType drawTypes[] = { GFXTriangleList, GFXTriangleStrip, GFXTriangleF
 
 // structures used to share data between detail levels...
 // used (and valid) during load only
-Vector<Point3F*> TSMesh::smVertsList;
-Vector<Point3F*> TSMesh::smNormsList;
-Vector<U8*>      TSMesh::smEncodedNormsList;
-Vector<Point2F*> TSMesh::smTVertsList;
-Vector<bool>     TSMesh::smDataCopied;
+thread_local Vector<Point3F*> TSMesh::smVertsList;
+thread_local Vector<Point3F*> TSMesh::smNormsList;
+thread_local Vector<U8*>      TSMesh::smEncodedNormsList;
+thread_local Vector<Point2F*> TSMesh::smTVertsList;
+thread_local Vector<bool>     TSMesh::smDataCopied;
 
 Vector<Point3F>  TSMesh::smSaveVerts;
 Vector<Point3F>  TSMesh::smSaveNorms;
 Vector<Point2F>  TSMesh::smSaveTVerts;
 
-Vector<MatrixF*> TSSkinMesh::smInitTransformList;
-Vector<S32*>     TSSkinMesh::smVertexIndexList;
-Vector<S32*>     TSSkinMesh::smBoneIndexList;
-Vector<F32*>     TSSkinMesh::smWeightList;
-Vector<S32*>     TSSkinMesh::smNodeIndexList;
+thread_local Vector<MatrixF*> TSSkinMesh::smInitTransformList;
+thread_local Vector<S32*>     TSSkinMesh::smVertexIndexList;
+thread_local Vector<S32*>     TSSkinMesh::smBoneIndexList;
+thread_local Vector<F32*>     TSSkinMesh::smWeightList;
+thread_local Vector<S32*>     TSSkinMesh::smNodeIndexList;
 
 Vector<Point3F> gNormalStore;
 
@@ -295,6 +302,9 @@ void TSMesh::renderVB(S32 frame, S32 matFrame, TSMaterialList* materials)
 
 void TSMesh::render()
 {
+    if (mPB.isNull() && meshType != SkinMeshType)
+        createVBIB();
+
     GFX->setVertexBuffer(getVertexBuffer());
     GFX->setPrimitiveBuffer(mPB);
 
@@ -310,6 +320,10 @@ void TSMesh::render(S32 frame, S32 matFrame, TSMaterialList* materials)
     if (meshVisibility < 0.0001f)
         return;
 
+    // Meshes read off the main thread leave their buffers for the first draw.
+    if (mPB.isNull() && meshType != SkinMeshType)
+        createVBIB();
+
     RenderInst* coreRI = gRenderInstManager.allocInst();
     coreRI->type = RenderInstManager::RIT_Mesh;
     if (smSceneState)
@@ -2326,13 +2340,107 @@ Vector<MatrixF> gBoneTransforms;
 Vector<Point3F> gSkinVerts;
 Vector<Point3F> gSkinNorms;
 
-void TSSkinMesh::updateSkin()
+#if defined(TSMESH_SKIN_SSE)
+Vector<F32> gBoneColumns;
+#endif
+
+/// Renormalizes a blended skin normal.  Shared verts between meshes may leave
+/// a normal with nothing in it, so those are left alone.
+inline void normalizeSkinNormal(Point3F& n)
+{
+    F32 len2 = mDot(n, n);
+    if (len2 > 0.01f)
+        n *= 1.0f / mSqrt(len2);
+}
+
+/// Sums the weighted (vertex, bone) tuples into outVerts and outNorms.  The
+/// tuples for a vertex are consecutive, so each vertex is summed in registers
+/// and stored once.  Verts no tuple refers to are left alone.
+static void blendSkin(const MatrixF* bones, S32 numBones, const S32* vertexIndex, const S32* boneIndex,
+    const F32* weight, S32 numTuples, const Point3F* inVerts, const Point3F* inNorms,
+    Point3F* outVerts, Point3F* outNorms)
 {
-    if (smGlowPass || smRefractPass)
+#if defined(TSMESH_SKIN_SSE)
+    // Store each bone as its columns so that a transform is three multiply-adds
+    // of the broadcast x, y and z rather than a row by row dot product.
+    gBoneColumns.setSize(numBones * 16);
+    F32* columns = gBoneColumns.address();
+    for (S32 b = 0; b < numBones; b++)
+    {
+        const F32* m = bones[b];
+        F32* c = columns + b * 16;
+        for (S32 j = 0; j < 4; j++)
+        {
+            c[j * 4 + 0] = m[j];
+            c[j * 4 + 1] = m[4 + j];
+            c[j * 4 + 2] = m[8 + j];
+            c[j * 4 + 3] = 0.0f;
+        }
+    }
+
+    S32 i = 0;
+    while (i < numTuples)
     {
-        return;
+        S32 vIndex = vertexIndex[i];
+        const Point3F& p = inVerts[vIndex];
+        const Point3F& q = inNorms[vIndex];
+        __m128 px = _mm_set1_ps(p.x), py = _mm_set1_ps(p.y), pz = _mm_set1_ps(p.z);
+        __m128 nx = _mm_set1_ps(q.x), ny = _mm_set1_ps(q.y), nz = _mm_set1_ps(q.z);
+        __m128 v = _mm_setzero_ps();
+        __m128 n = _mm_setzero_ps();
+        do
+        {
+            const F32* c = columns + boneIndex[i] * 16;
+            __m128 c0 = _mm_loadu_ps(c);
+            __m128 c1 = _mm_loadu_ps(c + 4);
+            __m128 c2 = _mm_loadu_ps(c + 8);
+            __m128 c3 = _mm_loadu_ps(c + 12);
+            __m128 w = _mm_set1_ps(weight[i]);
+
+            __m128 tv = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, px), _mm_mul_ps(c1, py)),
+                _mm_add_ps(_mm_mul_ps(c2, pz), c3));
+            __m128 tn = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, nx), _mm_mul_ps(c1, ny)), _mm_mul_ps(c2, nz));
+            v = _mm_add_ps(v, _mm_mul_ps(tv, w));
+            n = _mm_add_ps(n, _mm_mul_ps(tn, w));
+        } while (++i < numTuples && vertexIndex[i] == vIndex);
+
+        F32 out[4];
+        _mm_storeu_ps(out, v);
+        outVerts[vIndex].set(out[0], out[1], out[2]);
+        _mm_storeu_ps(out, n);
+        outNorms[vIndex].set(out[0], out[1], out[2]);
+        normalizeSkinNormal(outNorms[vIndex]);
     }
+#else
+    (void)numBones;
 
+    S32 i = 0;
+    while (i < numTuples)
+    {
+        S32 vIndex = vertexIndex[i];
+        const Point3F& p = inVerts[vIndex];
+        const Point3F& q = inNorms[vIndex];
+        Point3F v(0.0f, 0.0f, 0.0f);
+        Point3F n(0.0f, 0.0f, 0.0f);
+        do
+        {
+            const MatrixF& bone = bones[boneIndex[i]];
+            Point3F t;
+            bone.mulP(p, &t);
+            v += t * weight[i];
+            bone.mulV(q, &t);
+            n += t * weight[i];
+        } while (++i < numTuples && vertexIndex[i] == vIndex);
+
+        outVerts[vIndex] = v;
+        outNorms[vIndex] = n;
+        normalizeSkinNormal(outNorms[vIndex]);
+    }
+#endif
+}
+
+void TSSkinMesh::updateSkin()
+{
     PROFILE_START(UpdateSkin);
 
     // set arrays
@@ -2355,79 +2463,45 @@ void TSSkinMesh::updateSkin()
     norms.set(gSkinNorms.address(), gSkinNorms.size());
 #endif
 
-    //if (!initialTangents.size())
-    //{
-    //    dMemcpy(verts.address(), initialVerts.address(), sizeof(Point3F) * verts.size());
-    //    dMemcpy(norms.address(), initialNorms.address(), sizeof(Point3F) * norms.size());
-    //    createTangents();
-    //}
-
     // set up bone transforms
-    S32 i;
-    for (i = 0; i < nodeIndex.size(); i++)
+    for (S32 i = 0; i < nodeIndex.size(); i++)
     {
         S32 node = nodeIndex[i];
         gBoneTransforms[i].mul(TSShapeInstance::ObjectInstance::smTransforms[node], initialTransforms[i]);
     }
 
     // multiply verts and normals by boneTransforms
-    S32 prevIndex = -1;
-    for (i = 0; i < vertexIndex.size(); i++)
-    {
-        Point3F v0, n0, t0;
-        S32 vIndex = vertexIndex[i];
-        MatrixF& deltaTransform = gBoneTransforms[boneIndex[i]];
-        deltaTransform.mulP(initialVerts[vIndex], &v0);
-        deltaTransform.mulV(initialNorms[vIndex], &n0);
-        deltaTransform.mulV(initialTangents[vIndex], &t0);
-        v0 *= weight[i];
-        n0 *= weight[i];
-        t0 *= weight[i];
-        Point3F& v = verts[vIndex];
-        Point3F& n = norms[vIndex];
-        Point3F& t = (Point3F&)tangents[vIndex];
-        // this should be implemented as a series of conditional moves to avoid the branch
-        if (vIndex != prevIndex)
-        {
-            v.x = 0.0f;
-            v.y = 0.0f;
-            v.z = 0.0f;
-            n.x = 0.0f;
-            n.y = 0.0f;
-            n.z = 0.0f;
-            t.x = 0.0f;
-            t.y = 0.0f;
-            t.z = 0.0f;
-        }
-        v += v0;
-        n += n0;
-        t += t0;
-        prevIndex = vIndex;
-    }
-
-    // normalize normals...
-    for (i = 0; i < norms.size(); i++)
-    {
-        // gotta do a check now since shared verts between meshes
-        // may result in an unused vert in the list...
-        Point3F& n = norms[i];
-        F32 len2 = mDot(n, n);
-        if (len2 > 0.01f)
-            norms[i] *= 1.0f / mSqrt(len2);
-
-        // also normalize tangent matrix
-        ((Point3F&)tangents[i]).normalize();
-    }
-
-    createVBIB();
+    blendSkin(gBoneTransforms.address(), gBoneTransforms.size(), vertexIndex.address(), boneIndex.address(),
+        weight.address(), vertexIndex.size(), initialVerts.address(), initialNorms.address(),
+        verts.address(), norms.address());
 
     PROFILE_END();
 }
 
 void TSSkinMesh::render(S32 frame, S32 matFrame, TSMaterialList* materials)
 {
-    // update verts and normals...
-    updateSkin();
+    // Skin into the object instance's vertex buffer, unless it already holds
+    // this pose from an earlier pass over the current scene.
+    TSShapeInstance::MeshObjectInstance* inst = TSShapeInstance::smRenderData.currentObjectInstance;
+    U32 stamp = TSShapeInstance::ObjectInstance::smTransformStamp;
+    U32 scene = GFX->getSceneCount();
+    if (inst->skinnedMesh != this || inst->skinnedStamp != stamp || inst->skinnedScene != scene || inst->mVB.isNull())
+    {
+        updateSkin();
+
+        if (!verts.size())
+            return;
+
+        PROFILE_START(SkinFillVB);
+        fillVertexBuffer(inst->mVB, GFXBufferTypeDynamic);
+        if (mPB.isNull())
+            createPrimitiveBuffer(GFXBufferTypeStatic);
+        PROFILE_END();
+
+        inst->skinnedMesh = this;
+        inst->skinnedStamp = stamp;
+        inst->skinnedScene = scene;
+    }
 
     // render...
     Parent::render(frame, matFrame, materials);
@@ -2757,10 +2831,10 @@ U8 TSMesh::encodeNormal(const Point3F& normal)
 
 TSMesh* TSMesh::assembleMesh(U32 meshType, bool skip)
 {
-    static TSMesh tempStandardMesh;
-    static TSSkinMesh tempSkinMesh;
-    static TSDecalMesh tempDecalMesh;
-    static TSSortedMesh tempSortedMesh;
+    static thread_local TSMesh tempStandardMesh;
+    static thread_local TSSkinMesh tempSkinMesh;
+    static thread_local TSDecalMesh tempDecalMesh;
+    static thread_local TSSortedMesh tempSortedMesh;
 
     bool justSize = skip || !alloc.allocShape32(0); // if this returns NULL, we're just sizing memory block
 
@@ -3182,14 +3256,15 @@ void TSMesh::leaveAsMultipleStrips(S16* primitiveDataIn, S32* primitiveMatIn, S1
 // This adds an extra step to the copying of data from the memory buffer to the shape data buffer.
 // If we have no parentMesh, then we either return a pointer to the data in the memory buffer
 // (in the case that we skip this mesh) or copy the data into the shape data buffer and return
-// that pointer (in the case that we don't skip this mesh).
+// that pointer (in the case that we don't skip this mesh).  When the shape keeps its file buffer
+// (see TSShapeAlloc::setShareInput) the unskipped data is used in place rather than copied.
 // If we do have a parent mesh, then we return a pointer to the data in the shape buffer,
 // copying the data in there ourselves if our parent didn't already do it (i.e., if it was skipped).
 S32* TSMesh::getSharedData32(S32 parentMesh, S32 size, S32** source, bool skip)
 {
     S32* ptr;
     if (parentMesh < 0)
-        ptr = skip ? alloc.getPointer32(size) : alloc.copyToShape32(size);
+        ptr = skip ? alloc.getPointer32(size) : alloc.shareShape32(size);
     else
     {
         ptr = source[parentMesh];
@@ -3210,7 +3285,7 @@ S8* TSMesh::getSharedData8(S32 parentMesh, S32 size, S8** source, bool skip)
 {
     S8* ptr;
     if (parentMesh < 0)
-        ptr = skip ? alloc.getPointer8(size) : alloc.copyToShape8(size);
+        ptr = skip ? alloc.getPointer8(size) : alloc.shareShape8(size);
     else
     {
         ptr = source[parentMesh];
@@ -3244,8 +3319,19 @@ void TSMesh::createVBIB()
 
     PROFILE_START(CreateVBIB);
 
+    GFXBufferType type = mDynamic ? GFXBufferTypeVolatile : GFXBufferTypeStatic;
+    fillVertexBuffer(mVB, type);
+    createPrimitiveBuffer(type);
 
-    MeshVertex* tempVerts = new MeshVertex[verts.size()];
+    PROFILE_END();
+}
+
+Vector<MeshVertex> gFillVerts;
+
+void TSMesh::fillVertexBuffer(GFXVertexBufferHandle<MeshVertex>& vb, GFXBufferType type)
+{
+    gFillVerts.setSize(verts.size());
+    MeshVertex* tempVerts = gFillVerts.address();
 
     // fill in basic info
     for (U32 i = 0; i < verts.size(); i++)
@@ -3258,17 +3344,18 @@ void TSMesh::createVBIB()
     // expensive operation - optimize
     fillTextureSpaceInfo(tempVerts);
 
-    // copy to video mem
-
-    mVB.set(GFX, verts.size(), mDynamic ? GFXBufferTypeVolatile : GFXBufferTypeStatic);
-    MeshVertex* vbVerts = mVB.lock();
+    // copy to video mem, reusing the buffer when it's the right kind
+    if (vb.isNull() || vb->mNumVerts != verts.size() || vb->mBufferType != type || type == GFXBufferTypeVolatile)
+        vb.set(GFX, verts.size(), type);
+    MeshVertex* vbVerts = vb.lock();
 
     dMemcpy(vbVerts, tempVerts, sizeof(MeshVertex) * verts.size());
 
-    mVB.unlock();
-
-    delete[] tempVerts;
+    vb.unlock();
+}
 
+void TSMesh::createPrimitiveBuffer(GFXBufferType type)
+{
     // go through and create PrimitiveInfo array
     Vector <GFXPrimitive> piArray;
     for (S32 i = 0; i < primitives.size(); i++)
@@ -3309,15 +3396,13 @@ void TSMesh::createVBIB()
 
     U16* ibIndices;
     GFXPrimitive* piInput;
-    mPB.set(GFX, indices.size(), piArray.size(), mDynamic ? GFXBufferTypeVolatile : GFXBufferTypeStatic);
+    mPB.set(GFX, indices.size(), piArray.size(), type);
     mPB.lock(&ibIndices, &piInput);
 
     dMemcpy(ibIndices, indices.address(), indices.size() * sizeof(U16));
     dMemcpy(piInput, piArray.address(), piArray.size() * sizeof(GFXPrimitive));
 
     mPB.unlock();
-
-    PROFILE_END();
 }
 
 
@@ -3381,10 +3466,13 @@ void TSMesh::assemble(bool skip)
     S16* ind16 = alloc.getPointer16(szInd);
 
     // count then copy...
+    // sorted meshes keep their strips as they are
+    bool useTriangles = smUseTriangles && getMeshType() != SortedMeshType;
+    bool useOneStrip = smUseOneStrip && getMeshType() != SortedMeshType;
     S32 cpyPrim = szPrim, cpyInd = szInd;
-    if (smUseTriangles)
+    if (useTriangles)
         convertToTris(prim16, prim32, ind16, szPrim, cpyPrim, cpyInd, NULL, NULL);
-    else if (smUseOneStrip)
+    else if (useOneStrip)
         convertToSingleStrip(prim16, prim32, ind16, szPrim, cpyPrim, cpyInd, NULL, NULL);
     else
         leaveAsMultipleStrips(prim16, prim32, ind16, szPrim, cpyPrim, cpyInd, NULL, NULL);
@@ -3392,9 +3480,9 @@ void TSMesh::assemble(bool skip)
     S16* ptr16 = alloc.allocShape16(cpyInd);
     alloc.align32();
     S32 chkPrim = szPrim, chkInd = szInd;
-    if (smUseTriangles)
+    if (useTriangles)
         convertToTris(prim16, prim32, ind16, szPrim, chkPrim, chkInd, ptr32, ptr16);
-    else if (smUseOneStrip)
+    else if (useOneStrip)
         convertToSingleStrip(prim16, prim32, ind16, szPrim, chkPrim, chkInd, ptr32, ptr16);
     else
         leaveAsMultipleStrips(prim16, prim32, ind16, szPrim, chkPrim, chkInd, ptr32, ptr16);
@@ -3403,7 +3491,7 @@ void TSMesh::assemble(bool skip)
     indices.set(ptr16, cpyInd);
 
     S32 sz = alloc.get32();
-    ptr16 = alloc.copyToShape16(sz);
+    ptr16 = alloc.shareShape16(sz);
     alloc.align32();
     mergeIndices.set(ptr16, sz);
 
@@ -3419,7 +3507,7 @@ void TSMesh::assemble(bool skip)
         // only do this if we copied the data...
         computeBounds();
 
-    if (alloc.allocShape32(0) && meshType != SkinMeshType)
+    if (alloc.allocShape32(0) && meshType != SkinMeshType && Con::isMainThread())
     {
         createVBIB();
     }
@@ -132,9 +132,6 @@ public:
                                   ///< verts to form the next detail level
                                   ///< NOT IMPLEMENTED YET
 
-    Vector<Point3F> initialTangents;
-    Vector<Point4F> tangents;
-
     /// billboard data
     Point3F billboardAxis;
 
@@ -235,6 +232,11 @@ public:
     virtual GFXVertexBufferHandle<MeshVertex>& getVertexBuffer() { return mVB; };
 
     void createVBIB();
+    /// Fills vb from verts, tverts and norms, (re)creating it unless it is
+    /// already a buffer of this type and size.
+    void fillVertexBuffer(GFXVertexBufferHandle<MeshVertex>& vb, GFXBufferType type);
+    /// Builds mPB from primitives and indices.
+    void createPrimitiveBuffer(GFXBufferType type);
     void createTextureSpaceMatrix(MeshVertex* v0, MeshVertex* v1, MeshVertex* v2);
     void fillTextureSpaceInfo(MeshVertex* vertArray);
 
@@ -262,14 +264,15 @@ public:
 
     /// @name Assembly Variables
     /// variables used during assembly (for skipping mesh detail levels
-    /// on load and for sharing verts between meshes)
+    /// on load and for sharing verts between meshes); per thread, like
+    /// TSShape::alloc
     /// @{
 
-    static Vector<Point3F*> smVertsList;
-    static Vector<Point3F*> smNormsList;
-    static Vector<U8*>      smEncodedNormsList;
-    static Vector<Point2F*> smTVertsList;
-    static Vector<bool>     smDataCopied;
+    static thread_local Vector<Point3F*> smVertsList;
+    static thread_local Vector<Point3F*> smNormsList;
+    static thread_local Vector<U8*>      smEncodedNormsList;
+    static thread_local Vector<Point2F*> smTVertsList;
+    static thread_local Vector<bool>     smDataCopied;
 
     static Vector<Point3F>  smSaveVerts;
     static Vector<Point3F>  smSaveNorms;
@@ -318,11 +321,14 @@ public:
     /// set verts and normals...
     void updateSkin();
 
+    /// Renders into the object instance's vertex buffer, which is only skinned
+    /// again when the instance's transforms or the scene have changed.
+    void render(S32 frame, S32 matFrame, TSMaterialList*);
+
     // overrides from TSMesh
     GFXVertexBufferHandle<MeshVertex>& getVertexBuffer();
 
     // render methods..
-    void render(S32 frame, S32 matFrame, TSMaterialList*);
     void renderShadow(S32 frame, const MatrixF& mat, S32 dim, U32* bits, TSMaterialList*);
 
     // collision methods...
@@ -338,11 +344,11 @@ public:
 
     /// variables used during assembly (for skipping mesh detail levels
     /// on load and for sharing verts between meshes)
-    static Vector<MatrixF*> smInitTransformList;
-    static Vector<S32*>     smVertexIndexList;
-    static Vector<S32*>     smBoneIndexList;
-    static Vector<F32*>     smWeightList;
-    static Vector<S32*>     smNodeIndexList;
+    static thread_local Vector<MatrixF*> smInitTransformList;
+    static thread_local Vector<S32*>     smVertexIndexList;
+    static thread_local Vector<S32*>     smBoneIndexList;
+    static thread_local Vector<F32*>     smWeightList;
+    static thread_local Vector<S32*>     smNodeIndexList;
 
     TSSkinMesh()
     {
@@ -0,0 +1,668 @@
+//-----------------------------------------------------------------------------
+// Torque Shader Engine
+// Copyright (C) GarageGames.com, Inc.
+//-----------------------------------------------------------------------------
+
+#include "ts/tsShape.h"
+#include "ts/tsTransform.h"
+#include "console/console.h"
+#include "core/resManager.h"
+
+#if defined(TORQUE_CPU_X86) || defined(TORQUE_CPU_X64)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TS_PACKED_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
+//-------------------------------------------------------------------------------------
+// Packing
+//-------------------------------------------------------------------------------------
+
+namespace
+{
+    S32 countSet(const TSIntegerSet& set)
+    {
+        S32 count = 0;
+        for (S32 i = set.start(); i < set.end(); set.next(i))
+            count++;
+        return count;
+    }
+
+    void sampleUnpackedRotations(const TSShape* shape, const TSShape::Sequence& seq, S32 key1, S32 key2, F32 t,
+        Vector<QuatF>& out, const TSIntegerSet* nodes = NULL)
+    {
+        out.setSize(countSet(seq.rotationMatters));
+        S32 j = 0;
+        for (S32 node = seq.rotationMatters.start(); node < seq.rotationMatters.end(); seq.rotationMatters.next(node), j++)
+        {
+            if (nodes && !nodes->test(node))
+                continue;
+
+            QuatF q1, q2;
+            shape->getRotation(seq, key1, j, &q1);
+            shape->getRotation(seq, key2, j, &q2);
+            TSTransform::interpolate(q1, q2, t, &out[j]);
+        }
+    }
+
+    void sampleUnpackedTranslations(const TSShape* shape, const TSShape::Sequence& seq, S32 key1, S32 key2, F32 t,
+        Vector<Point3F>& out, const TSIntegerSet* nodes = NULL)
+    {
+        out.setSize(countSet(seq.translationMatters));
+        S32 j = 0;
+        for (S32 node = seq.translationMatters.start(); node < seq.translationMatters.end(); seq.translationMatters.next(node), j++)
+        {
+            if (nodes && !nodes->test(node))
+                continue;
+
+            Point3F p1 = shape->getTranslation(seq, key1, j);
+            Point3F p2 = shape->getTranslation(seq, key2, j);
+            TSTransform::interpolate(p1, p2, t, &out[j]);
+        }
+    }
+
+    Quat16 packedRotationKey(const TSShape::PackedSequence& ps, S32 key, S32 track)
+    {
+        S32 slot = ps.rotationSlots[track];
+        if (slot < 0)
+            return ps.constRotationKeys[-1 - slot];
+
+        S32 n = ps.numAnimRotations;
+        const S16* rows = (const S16*)(ps.keys.address() + key * ps.keyStride);
+        Quat16 q;
+        q.x = rows[slot];
+        q.y = rows[n + slot];
+        q.z = rows[n * 2 + slot];
+        q.w = rows[n * 3 + slot];
+        return q;
+    }
+
+    Point3F packedTranslationKey(const TSShape::PackedSequence& ps, S32 key, S32 track)
+    {
+        S32 slot = ps.translationSlots[track];
+        if (slot < 0)
+            return ps.constTranslations[-1 - slot];
+
+        S32 n = ps.numAnimTranslations;
+        const F32* rows = (const F32*)(ps.keys.address() + key * ps.keyStride + ps.translationOffset);
+        return Point3F(rows[slot], rows[n + slot], rows[n * 2 + slot]);
+    }
+
+    /// Mark the keys [base, base + count) as used, false if any is out of
+    /// range or already used by another sequence.
+    bool useKeys(Vector<U8>& used, S32 base, S32 count)
+    {
+        if (base < 0 || base + count > used.size())
+            return false;
+        for (S32 i = base; i < base + count; i++)
+            if (used[i]++)
+                return false;
+        return true;
+    }
+
+    bool allUsed(const Vector<U8>& used)
+    {
+        for (S32 i = 0; i < used.size(); i++)
+            if (!used[i])
+                return false;
+        return true;
+    }
+}
+
+void TSShape::packSequences()
+{
+    // importing sequences or changing the pack setting repacks, which needs the keys back
+    unpackSequences();
+
+    // setSize rather than clear so the old tables are freed
+    packedSequences.setSize(0);
+    if (!smPackAnimation)
+        return;
+
+    packedSequences.setSize(sequences.size());
+    for (S32 i = 0; i < sequences.size(); i++)
+        packSequence(sequences[i], packedSequences[i]);
+
+    // the packed keys are exact copies, so once every unpacked key belongs to
+    // exactly one sequence the unpacked vectors can go (older shapes keep their
+    // ground frames in there too, those keep them)
+    Vector<U8> rotUsed, tranUsed;
+    rotUsed.setSize(nodeRotations.size());
+    tranUsed.setSize(nodeTranslations.size());
+    if (rotUsed.size())
+        dMemset(rotUsed.address(), 0, rotUsed.size());
+    if (tranUsed.size())
+        dMemset(tranUsed.address(), 0, tranUsed.size());
+
+    bool exact = true;
+    for (S32 i = 0; i < sequences.size() && exact; i++)
+    {
+        const Sequence& seq = sequences[i];
+        const PackedSequence& ps = packedSequences[i];
+        exact = useKeys(rotUsed, seq.baseRotation, ps.numRotations * seq.numKeyframes) &&
+            useKeys(tranUsed, seq.baseTranslation, ps.numTranslations * seq.numKeyframes);
+    }
+    if (exact && allUsed(rotUsed) && allUsed(tranUsed))
+    {
+        nodeRotations.setSize(0);
+        nodeRotations.compact();
+        nodeTranslations.setSize(0);
+        nodeTranslations.compact();
+        mKeysPacked = true;
+    }
+}
+
+void TSShape::unpackSequences()
+{
+    if (!mKeysPacked)
+        return;
+
+    S32 i, j, k;
+    S32 numRotations = 0, numTranslations = 0;
+    for (i = 0; i < sequences.size(); i++)
+    {
+        numRotations += packedSequences[i].numRotations * sequences[i].numKeyframes;
+        numTranslations += packedSequences[i].numTranslations * sequences[i].numKeyframes;
+    }
+    nodeRotations.setSize(numRotations);
+    nodeTranslations.setSize(numTranslations);
+
+    for (i = 0; i < sequences.size(); i++)
+    {
+        const Sequence& seq = sequences[i];
+        const PackedSequence& ps = packedSequences[i];
+        for (j = 0; j < ps.numRotations; j++)
+            for (k = 0; k < seq.numKeyframes; k++)
+                nodeRotations[seq.baseRotation + j * seq.numKeyframes + k] = packedRotationKey(ps, k, j);
+        for (j = 0; j < ps.numTranslations; j++)
+            for (k = 0; k < seq.numKeyframes; k++)
+                nodeTranslations[seq.baseTranslation + j * seq.numKeyframes + k] = packedTranslationKey(ps, k, j);
+    }
+    mKeysPacked = false;
+}
+
+QuatF& TSShape::getPackedRotation(const Sequence& seq, S32 keyframeNum, S32 rotNum, QuatF* quat) const
+{
+    S32 seqIndex = &seq - sequences.address();
+    AssertFatal(seqIndex >= 0 && seqIndex < packedSequences.size(),
+        "TSShape::getPackedRotation - sequence isn't packed");
+    return packedRotationKey(packedSequences[seqIndex], keyframeNum, rotNum).getQuatF(quat);
+}
+
+Point3F TSShape::getPackedTranslation(const Sequence& seq, S32 keyframeNum, S32 tranNum) const
+{
+    S32 seqIndex = &seq - sequences.address();
+    AssertFatal(seqIndex >= 0 && seqIndex < packedSequences.size(),
+        "TSShape::getPackedTranslation - sequence isn't packed");
+    return packedTranslationKey(packedSequences[seqIndex], keyframeNum, tranNum);
+}
+
+void TSShape::packSequence(const Sequence& seq, PackedSequence& ps)
+{
+    S32 numKeys = seq.numKeyframes;
+    AssertFatal(numKeys > 0, "TSShape::packSequence: sequence without keyframes");
+
+    ps.numRotations = countSet(seq.rotationMatters);
+    ps.numTranslations = countSet(seq.translationMatters);
+
+    // node of each track
+    Vector<S16> rotationTrackNodes, translationTrackNodes;
+    S32 i, j, k;
+    for (i = seq.rotationMatters.start(); i < seq.rotationMatters.end(); seq.rotationMatters.next(i))
+        rotationTrackNodes.push_back(i);
+    for (i = seq.translationMatters.start(); i < seq.translationMatters.end(); seq.translationMatters.next(i))
+        translationTrackNodes.push_back(i);
+
+    // pull out the tracks that hold still, sampling them gives the same answer every time
+    Vector<S32> animRotations, animTranslations;
+    for (j = 0; j < ps.numRotations; j++)
+    {
+        const Quat16* keys = &nodeRotations[seq.baseRotation + j * numKeys];
+        for (k = 1; k < numKeys; k++)
+            if (!(keys[k] == keys[0]))
+                break;
+
+        if (k < numKeys)
+        {
+            animRotations.push_back(j);
+            continue;
+        }
+
+        // interpolating a key with itself still renormalizes, keep that result
+        QuatF q, result;
+        keys[0].getQuatF(&q);
+        ps.constRotationTracks.push_back(j);
+        ps.constRotationKeys.push_back(keys[0]);
+        ps.constRotations.push_back(TSTransform::interpolate(q, q, 0.0f, &result));
+    }
+    for (j = 0; j < ps.numTranslations; j++)
+    {
+        const Point3F* keys = &nodeTranslations[seq.baseTranslation + j * numKeys];
+        for (k = 1; k < numKeys; k++)
+            if (keys[k] != keys[0])
+                break;
+
+        if (k < numKeys)
+        {
+            animTranslations.push_back(j);
+            continue;
+        }
+        ps.constTranslationTracks.push_back(j);
+        ps.constTranslations.push_back(keys[0]);
+    }
+
+    S32 numRot = ps.numAnimRotations = (animRotations.size() + 3) & ~3;
+    S32 numTran = ps.numAnimTranslations = (animTranslations.size() + 3) & ~3;
+
+    ps.rotationTracks.setSize(numRot);
+    ps.rotationNodes.setSize(numRot);
+    for (i = 0; i < numRot; i++)
+    {
+        ps.rotationTracks[i] = i < animRotations.size() ? animRotations[i] : -1;
+        ps.rotationNodes[i] = i < animRotations.size() ? rotationTrackNodes[animRotations[i]] : -1;
+    }
+    ps.translationTracks.setSize(numTran);
+    ps.translationNodes.setSize(numTran);
+    for (i = 0; i < numTran; i++)
+    {
+        ps.translationTracks[i] = i < animTranslations.size() ? animTranslations[i] : -1;
+        ps.translationNodes[i] = i < animTranslations.size() ? translationTrackNodes[animTranslations[i]] : -1;
+    }
+
+    ps.rotationSlots.setSize(ps.numRotations);
+    for (i = 0; i < animRotations.size(); i++)
+        ps.rotationSlots[animRotations[i]] = i;
+    for (i = 0; i < ps.constRotationTracks.size(); i++)
+        ps.rotationSlots[ps.constRotationTracks[i]] = -1 - i;
+    ps.translationSlots.setSize(ps.numTranslations);
+    for (i = 0; i < animTranslations.size(); i++)
+        ps.translationSlots[animTranslations[i]] = i;
+    for (i = 0; i < ps.constTranslationTracks.size(); i++)
+        ps.translationSlots[ps.constTranslationTracks[i]] = -1 - i;
+
+    // one block per keyframe: x, y, z, w rows of rotations, then x, y, z rows of translations
+    ps.translationOffset = numRot * 4 * sizeof(S16);
+    ps.keyStride = ps.translationOffset + numTran * 3 * sizeof(F32);
+    ps.keys.setSize(numKeys * ps.keyStride);
+
+    for (k = 0; k < numKeys; k++)
+    {
+        U8* block = ps.keys.address() + k * ps.keyStride;
+
+        S16* rot = (S16*)block;
+        for (i = 0; i < numRot; i++)
+        {
+            Quat16 q;
+            if (i < animRotations.size())
+                q = nodeRotations[seq.baseRotation + animRotations[i] * numKeys + k];
+            else
+                q.identity();
+            rot[i] = q.x;
+            rot[numRot + i] = q.y;
+            rot[numRot * 2 + i] = q.z;
+            rot[numRot * 3 + i] = q.w;
+        }
+
+        F32* tran = (F32*)(block + ps.translationOffset);
+        for (i = 0; i < numTran; i++)
+        {
+            Point3F p(0.0f, 0.0f, 0.0f);
+            if (i < animTranslations.size())
+                p = nodeTranslations[seq.baseTranslation + animTranslations[i] * numKeys + k];
+            tran[i] = p.x;
+            tran[numTran + i] = p.y;
+            tran[numTran * 2 + i] = p.z;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------
+// Sampling
+//
+// Four tracks at a time, one per lane.  Each lane does exactly the operations
+// TSTransform::interpolate does, in the same order, so the results come out bit
+// for bit the same as sampling the unpacked keys.  When the caller only wants
+// some nodes, groups of four without any of them are skipped.
+//-------------------------------------------------------------------------------------
+
+namespace
+{
+#if defined(TS_PACKED_SSE2)
+    inline __m128 loadS16(const S16* p)
+    {
+        __m128i v = _mm_loadl_epi64((const __m128i*)p);
+        return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+    }
+#endif
+
+    inline bool wantNode(const TSIntegerSet* nodes, S16 node)
+    {
+        return node >= 0 && (!nodes || nodes->test(node));
+    }
+
+    inline bool wantGroup(const TSIntegerSet* nodes, const S16* rowNodes)
+    {
+        return !nodes || wantNode(nodes, rowNodes[0]) || wantNode(nodes, rowNodes[1]) ||
+            wantNode(nodes, rowNodes[2]) || wantNode(nodes, rowNodes[3]);
+    }
+
+    void sampleRotationRows(const TSShape::PackedSequence& ps, const S16* k1, const S16* k2, F32 t,
+        const TSIntegerSet* nodes, QuatF* out)
+    {
+        S32 n = ps.numAnimRotations;
+        const S16* tracks = ps.rotationTracks.address();
+        const S16* rowNodes = ps.rotationNodes.address();
+
+#if defined(TS_PACKED_SSE2)
+        const __m128 maxVal = _mm_set1_ps(F32(Quat16::MAX_VAL));
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 interp = _mm_set1_ps(t);
+        const __m128 split = _mm_set1_ps(0.857f);
+
+        for (S32 i = 0; i < n; i += 4)
+        {
+            if (!wantGroup(nodes, rowNodes + i))
+                continue;
+
+            __m128 x1 = _mm_div_ps(loadS16(k1 + i), maxVal);
+            __m128 y1 = _mm_div_ps(loadS16(k1 + n + i), maxVal);
+            __m128 z1 = _mm_div_ps(loadS16(k1 + n * 2 + i), maxVal);
+            __m128 w1 = _mm_div_ps(loadS16(k1 + n * 3 + i), maxVal);
+            __m128 x2 = _mm_div_ps(loadS16(k2 + i), maxVal);
+            __m128 y2 = _mm_div_ps(loadS16(k2 + n + i), maxVal);
+            __m128 z2 = _mm_div_ps(loadS16(k2 + n * 2 + i), maxVal);
+            __m128 w2 = _mm_div_ps(loadS16(k2 + n * 3 + i), maxVal);
+
+            // flip the first where the quats are further apart than 90 degrees
+            __m128 dot = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x1, x2), _mm_mul_ps(y1, y2)), _mm_mul_ps(z1, z2)), _mm_mul_ps(w1, w2));
+            __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, zero), signBit);
+            x1 = _mm_xor_ps(x1, flip);
+            y1 = _mm_xor_ps(y1, flip);
+            z1 = _mm_xor_ps(z1, flip);
+            w1 = _mm_xor_ps(w1, flip);
+
+            x1 = _mm_add_ps(x1, _mm_mul_ps(interp, _mm_sub_ps(x2, x1)));
+            y1 = _mm_add_ps(y1, _mm_mul_ps(interp, _mm_sub_ps(y2, y1)));
+            z1 = _mm_add_ps(z1, _mm_mul_ps(interp, _mm_sub_ps(z2, z1)));
+            w1 = _mm_add_ps(w1, _mm_mul_ps(interp, _mm_sub_ps(w2, w1)));
+
+            // same polynomial 1/sqrt as TSTransform::interpolate
+            __m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x1, x1), _mm_mul_ps(y1, y1)), _mm_mul_ps(z1, z1)), _mm_mul_ps(w1, w1));
+            __m128 lo = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.699368f), dist2), _mm_set1_ps(-1.819985f)), dist2), _mm_set1_ps(2.126369f));
+            __m128 hi = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.454012f), dist2), _mm_set1_ps(-1.403517f)), dist2), _mm_set1_ps(1.949542f));
+            __m128 useLo = _mm_cmplt_ps(dist2, split);
+            __m128 oneOverL = _mm_or_ps(_mm_and_ps(useLo, lo), _mm_andnot_ps(useLo, hi));
+
+            x1 = _mm_mul_ps(x1, oneOverL);
+            y1 = _mm_mul_ps(y1, oneOverL);
+            z1 = _mm_mul_ps(z1, oneOverL);
+            w1 = _mm_mul_ps(w1, oneOverL);
+
+            // rows to quats
+            _MM_TRANSPOSE4_PS(x1, y1, z1, w1);
+            if (tracks[i] >= 0)
+                _mm_storeu_ps(&out[tracks[i]].x, x1);
+            if (tracks[i + 1] >= 0)
+                _mm_storeu_ps(&out[tracks[i + 1]].x, y1);
+            if (tracks[i + 2] >= 0)
+                _mm_storeu_ps(&out[tracks[i + 2]].x, z1);
+            if (tracks[i + 3] >= 0)
+                _mm_storeu_ps(&out[tracks[i + 3]].x, w1);
+        }
+#else
+        for (S32 i = 0; i < n; i++)
+        {
+            if (!wantNode(nodes, rowNodes[i]))
+                continue;
+
+            Quat16 a, b;
+            a.x = k1[i]; a.y = k1[n + i]; a.z = k1[n * 2 + i]; a.w = k1[n * 3 + i];
+            b.x = k2[i]; b.y = k2[n + i]; b.z = k2[n * 2 + i]; b.w = k2[n * 3 + i];
+
+            QuatF q1, q2;
+            TSTransform::interpolate(a.getQuatF(&q1), b.getQuatF(&q2), t, &out[tracks[i]]);
+        }
+#endif
+    }
+
+    void sampleTranslationRows(const TSShape::PackedSequence& ps, const F32* k1, const F32* k2, F32 t,
+        const TSIntegerSet* nodes, Point3F* out)
+    {
+        S32 n = ps.numAnimTranslations;
+        const S16* tracks = ps.translationTracks.address();
+        const S16* rowNodes = ps.translationNodes.address();
+
+#if defined(TS_PACKED_SSE2)
+        const __m128 interp = _mm_set1_ps(t);
+        F32 rows[3][4];
+
+        for (S32 i = 0; i < n; i += 4)
+        {
+            if (!wantGroup(nodes, rowNodes + i))
+                continue;
+
+            for (S32 c = 0; c < 3; c++)
+            {
+                __m128 p1 = _mm_loadu_ps(k1 + c * n + i);
+                __m128 p2 = _mm_loadu_ps(k2 + c * n + i);
+                _mm_storeu_ps(rows[c], _mm_add_ps(p1, _mm_mul_ps(interp, _mm_sub_ps(p2, p1))));
+            }
+
+            for (S32 lane = 0; lane < 4; lane++)
+                if (tracks[i + lane] >= 0)
+                    out[tracks[i + lane]].set(rows[0][lane], rows[1][lane], rows[2][lane]);
+        }
+#else
+        for (S32 i = 0; i < n; i++)
+        {
+            if (!wantNode(nodes, rowNodes[i]))
+                continue;
+
+            Point3F p1(k1[i], k1[n + i], k1[n * 2 + i]);
+            Point3F p2(k2[i], k2[n + i], k2[n * 2 + i]);
+            TSTransform::interpolate(p1, p2, t, &out[tracks[i]]);
+        }
+#endif
+    }
+}
+
+void TSShape::sampleRotations(const Sequence& seq, S32 key1, S32 key2, F32 t, Vector<QuatF>& out, const TSIntegerSet* nodes) const
+{
+    S32 seqIndex = &seq - sequences.address();
+    AssertFatal(seqIndex >= 0 && seqIndex < sequences.size(),
+        "TSShape::sampleRotations - sequence doesn't belong to this shape");
+    if (seqIndex >= packedSequences.size())
+    {
+        // not packed, or imported without an init()
+        sampleUnpackedRotations(this, seq, key1, key2, t, out, nodes);
+        return;
+    }
+
+    const PackedSequence& ps = packedSequences[seqIndex];
+    out.setSize(ps.numRotations);
+
+    const S16* k1 = (const S16*)(ps.keys.address() + key1 * ps.keyStride);
+    const S16* k2 = (const S16*)(ps.keys.address() + key2 * ps.keyStride);
+    sampleRotationRows(ps, k1, k2, t, nodes, out.address());
+
+    // constant tracks are a plain copy, cheaper than looking up their nodes
+    for (S32 i = 0; i < ps.constRotationTracks.size(); i++)
+        out[ps.constRotationTracks[i]] = ps.constRotations[i];
+}
+
+void TSShape::sampleTranslations(const Sequence& seq, S32 key1, S32 key2, F32 t, Vector<Point3F>& out, const TSIntegerSet* nodes) const
+{
+    S32 seqIndex = &seq - sequences.address();
+    AssertFatal(seqIndex >= 0 && seqIndex < sequences.size(),
+        "TSShape::sampleTranslations - sequence doesn't belong to this shape");
+    if (seqIndex >= packedSequences.size())
+    {
+        sampleUnpackedTranslations(this, seq, key1, key2, t, out, nodes);
+        return;
+    }
+
+    const PackedSequence& ps = packedSequences[seqIndex];
+    out.setSize(ps.numTranslations);
+
+    const F32* k1 = (const F32*)(ps.keys.address() + key1 * ps.keyStride + ps.translationOffset);
+    const F32* k2 = (const F32*)(ps.keys.address() + key2 * ps.keyStride + ps.translationOffset);
+    sampleTranslationRows(ps, k1, k2, t, nodes, out.address());
+
+    for (S32 i = 0; i < ps.constTranslationTracks.size(); i++)
+        out[ps.constTranslationTracks[i]] = ps.constTranslations[i];
+}
+
+//-------------------------------------------------------------------------------------
+// Packed animation report
+//
+// Loads every shape under a path and reports what packing saves, checks the
+// packed keys against the unpacked ones, and times sampling whole sequences
+// and every other node of them.
+
+ConsoleFunction(benchmarkAnimationKeys, void, 1, 3, "([string path, int passes]) "
+    "Report packed animation key memory, accuracy and sampling speed for the shapes under path "
+    "(marble/data by default).")
+{
+    const char* path = argc > 1 ? argv[1] : "marble/data";
+    S32 passes = argc > 2 ? getMax(dAtoi(argv[2]), 1) : 20;
+    U32 pathLen = dStrlen(path);
+
+    Vector<StringTableEntry> shapeFiles;
+    ResourceManager->startResourceTraverse();
+    while (ResourceObject* obj = ResourceManager->getNextResource())
+    {
+        if (!obj->path || dStrnicmp(obj->path, path, pathLen) || (obj->path[pathLen] && obj->path[pathLen] != '/'))
+            continue;
+        const char* ext = dStrrchr(obj->name, '.');
+        if (!ext || dStricmp(ext, ".dts"))
+            continue;
+
+        char fileName[1024];
+        dSprintf(fileName, sizeof(fileName), "%s/%s", obj->path, obj->name);
+        shapeFiles.push_back(StringTable->insert(fileName));
+    }
+
+    S32 numShapes = 0, numDropped = 0, numSequences = 0;
+    S32 numRotTracks = 0, numConstRot = 0, numTranTracks = 0, numConstTran = 0;
+    U32 unpackedBytes = 0, packedBytes = 0;
+    U32 unpackedTime = 0, packedTime = 0, halfTime = 0;
+    U32 samples = 0;
+    S32 rotMismatches = 0, tranMismatches = 0;
+
+    Vector<QuatF> rotA, rotB;
+    Vector<Point3F> tranA, tranB;
+
+    for (S32 f = 0; f < shapeFiles.size(); f++)
+    {
+        Resource<TSShape> shape = ResourceManager->load(shapeFiles[f]);
+        if (bool(shape) == false || shape->packedSequences.size() != shape->sequences.size())
+            continue;
+        numShapes++;
+
+        // bring the unpacked keys back to compare against, packSequences drops them again
+        bool dropped = shape->mKeysPacked;
+        numDropped += dropped ? 1 : 0;
+        shape->unpackSequences();
+
+        for (S32 s = 0; s < shape->sequences.size(); s++)
+        {
+            const TSShape::Sequence& seq = shape->sequences[s];
+            const TSShape::PackedSequence& ps = shape->packedSequences[s];
+            S32 numKeys = seq.numKeyframes;
+
+            numSequences++;
+            numRotTracks += ps.numRotations;
+            numConstRot += ps.constRotationTracks.size();
+            numTranTracks += ps.numTranslations;
+            numConstTran += ps.constTranslationTracks.size();
+
+            unpackedBytes += numKeys * (ps.numRotations * sizeof(Quat16) + ps.numTranslations * sizeof(Point3F));
+            packedBytes += ps.keys.size() +
+                (ps.rotationTracks.size() + ps.rotationNodes.size() + ps.rotationSlots.size()) * sizeof(S16) +
+                (ps.translationTracks.size() + ps.translationNodes.size() + ps.translationSlots.size()) * sizeof(S16) +
+                ps.constRotationTracks.size() * (sizeof(S16) + sizeof(Quat16) + sizeof(QuatF)) +
+                ps.constTranslationTracks.size() * (sizeof(S16) + sizeof(Point3F));
+
+            // check every keyframe pair against the unpacked keys
+            for (S32 k = 0; k < numKeys; k++)
+            {
+                S32 k2 = (k + 1) % numKeys;
+                sampleUnpackedRotations(shape, seq, k, k2, 0.5f, rotA);
+                shape->sampleRotations(seq, k, k2, 0.5f, rotB);
+                if (rotA.size() && dMemcmp(rotA.address(), rotB.address(), rotA.size() * sizeof(QuatF)))
+                    rotMismatches++;
+
+                sampleUnpackedTranslations(shape, seq, k, k2, 0.5f, tranA);
+                shape->sampleTranslations(seq, k, k2, 0.5f, tranB);
+                if (tranA.size() && dMemcmp(tranA.address(), tranB.address(), tranA.size() * sizeof(Point3F)))
+                    tranMismatches++;
+            }
+
+            U32 startTime = Platform::getRealMilliseconds();
+            for (S32 p = 0; p < passes; p++)
+            {
+                for (S32 k = 0; k < numKeys; k++)
+                {
+                    sampleUnpackedRotations(shape, seq, k, (k + 1) % numKeys, 0.5f, rotA);
+                    sampleUnpackedTranslations(shape, seq, k, (k + 1) % numKeys, 0.5f, tranA);
+                }
+            }
+            unpackedTime += Platform::getRealMilliseconds() - startTime;
+
+            startTime = Platform::getRealMilliseconds();
+            for (S32 p = 0; p < passes; p++)
+            {
+                for (S32 k = 0; k < numKeys; k++)
+                {
+                    shape->sampleRotations(seq, k, (k + 1) % numKeys, 0.5f, rotB);
+                    shape->sampleTranslations(seq, k, (k + 1) % numKeys, 0.5f, tranB);
+                }
+            }
+            packedTime += Platform::getRealMilliseconds() - startTime;
+
+            // as if a higher priority thread owned the other half of the nodes
+            TSIntegerSet halfNodes;
+            halfNodes.clearAll();
+            for (S32 n = 0; n < shape->nodes.size(); n += 2)
+                halfNodes.set(n);
+            startTime = Platform::getRealMilliseconds();
+            for (S32 p = 0; p < passes; p++)
+            {
+                for (S32 k = 0; k < numKeys; k++)
+                {
+                    shape->sampleRotations(seq, k, (k + 1) % numKeys, 0.5f, rotB, &halfNodes);
+                    shape->sampleTranslations(seq, k, (k + 1) % numKeys, 0.5f, tranB, &halfNodes);
+                }
+            }
+            halfTime += Platform::getRealMilliseconds() - startTime;
+
+            samples += passes * numKeys * (ps.numRotations + ps.numTranslations);
+        }
+
+        if (dropped)
+            shape->packSequences();
+    }
+
+    if (!numSequences)
+    {
+        Con::errorf("benchmarkAnimationKeys: no packed sequences in shapes under '%s'%s.",
+            path, TSShape::smPackAnimation ? "" : " ($pref::TS::packAnimation is off)");
+        return;
+    }
+
+    Con::printf("Animation keys: %d shapes, %d sequences", numShapes, numSequences);
+    Con::printf("   rotation tracks     %6d, %d constant", numRotTracks, numConstRot);
+    Con::printf("   translation tracks  %6d, %d constant", numTranTracks, numConstTran);
+    Con::printf("   unpacked keys  %8d bytes", unpackedBytes);
+    Con::printf("   packed tables  %8d bytes (%.1f%%), unpacked keys freed in %d of %d shapes",
+        packedBytes, unpackedBytes ? 100.0f * packedBytes / unpackedBytes : 0.0f, numDropped, numShapes);
+    Con::printf("   sampling %d tracks: unpacked %d ms, packed %d ms, packed every other node %d ms",
+        samples, unpackedTime, packedTime, halfTime);
+    if (rotMismatches || tranMismatches)
+        Con::errorf("   FAILED: %d rotation and %d translation samples differed from the unpacked keys",
+            rotMismatches, tranMismatches);
+    else
+        Con::printf("   every sample matched the unpacked keys");
+}
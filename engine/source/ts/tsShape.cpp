@@ -9,11 +9,16 @@
 #include "console/console.h"
 #include "ts/tsShapeInstance.h"
 #include "collision/convex.h"
+#include "platform/memoryTag.h"
+#include "core/resManager.h"
+#include "core/memstream.h"
+
+static MemoryTag sTSShapeMemoryTag("TSShapes");
 
 /// most recent version -- this is the version we write
 S32 TSShape::smVersion = 24;
 /// the version currently being read...valid only during a read
-S32 TSShape::smReadVersion = -1;
+thread_local S32 TSShape::smReadVersion = -1;
 const U32 TSShape::smMostRecentExporterVersion = DTS_EXPORTER_CURRENT_VERSION;
 
 F32 TSShape::smAlphaOutLastDetail = -1.0f;
@@ -28,14 +33,21 @@ S32 TSShape::smNumSkipLoadDetails = 0;
 
 bool TSShape::smInitOnRead = true;
 
+bool TSShape::smShareReadBuffer = false;
+bool TSShape::smPackAnimation = true;
+
 
 TSShape::TSShape()
 {
     materialList = NULL;
     mReadVersion = -1; // -1 means constructed from scratch (e.g., in exporter or no read yet)
     mMemoryBlock = NULL;
+    mReadBuffer = NULL;
+    mMemoryBlockSize = 0;
+    mReadBufferSize = 0;
 
     mSequencesConstructed = false;
+    mKeysPacked = false;
 
     mVertexBuffer = (U32)-1;
     mCallbackKey = (U32)-1;
@@ -99,6 +111,8 @@ TSShape::~TSShape()
 
     delete[] mMemoryBlock;
     mMemoryBlock = NULL;
+    delete[] mReadBuffer;
+    mReadBuffer = NULL;
 
     /*
        if (mVertexBuffer != -1)
@@ -370,6 +384,9 @@ void TSShape::init()
         mMergeBufferSize += maxSize;
     }
 
+    // redone on every init since importing sequences moves the keys around
+    packSequences();
+
     initMaterialList();
 }
 
@@ -536,7 +553,7 @@ void TSShape::computeBounds(S32 dl, Box3F& bounds) const
     }
 }
 
-TSShapeAlloc TSShape::alloc;
+thread_local TSShapeAlloc TSShape::alloc;
 
 #define alloc TSShape::alloc
 
@@ -658,13 +675,14 @@ void TSShape::assembleShape()
 
     alloc.checkGuard();
 
-    // copy various vectors...
-    S32* ptr32 = alloc.copyToShape32(numNodes * 5);
+    // copy various vectors...or point into the read buffer when the shape keeps it
+    S32* ptr32 = alloc.shareShape32(numNodes * 5);
     nodes.set(ptr32, numNodes);
 
     alloc.checkGuard();
 
-    ptr32 = alloc.copyToShape32(numObjects * 6, true);
+    // older shapes append skin objects to this array, so it must be copied
+    ptr32 = numSkins ? alloc.copyToShape32(numObjects * 6, true) : alloc.shareShape32(numObjects * 6, true);
     if (!ptr32)
         ptr32 = alloc.allocShape32(numSkins * 6); // pre v23 shapes store skins and meshes separately...no longer
     else
@@ -673,30 +691,30 @@ void TSShape::assembleShape()
 
     alloc.checkGuard();
 
-    ptr32 = alloc.copyToShape32(numDecals * 5, true);
+    ptr32 = alloc.shareShape32(numDecals * 5, true);
     decals.set(ptr32, numDecals);
 
     alloc.checkGuard();
 
-    ptr32 = alloc.copyToShape32(numIflMaterials * 5);
+    ptr32 = alloc.shareShape32(numIflMaterials * 5);
     iflMaterials.set(ptr32, numIflMaterials);
 
     alloc.checkGuard();
 
-    ptr32 = alloc.copyToShape32(numSubShapes, true);
+    ptr32 = alloc.shareShape32(numSubShapes, true);
     subShapeFirstNode.set(ptr32, numSubShapes);
-    ptr32 = alloc.copyToShape32(numSubShapes, true);
+    ptr32 = alloc.shareShape32(numSubShapes, true);
     subShapeFirstObject.set(ptr32, numSubShapes);
-    ptr32 = alloc.copyToShape32(numSubShapes, true);
+    ptr32 = alloc.shareShape32(numSubShapes, true);
     subShapeFirstDecal.set(ptr32, numSubShapes);
 
     alloc.checkGuard();
 
-    ptr32 = alloc.copyToShape32(numSubShapes);
+    ptr32 = alloc.shareShape32(numSubShapes);
     subShapeNumNodes.set(ptr32, numSubShapes);
-    ptr32 = alloc.copyToShape32(numSubShapes);
+    ptr32 = alloc.shareShape32(numSubShapes);
     subShapeNumObjects.set(ptr32, numSubShapes);
-    ptr32 = alloc.copyToShape32(numSubShapes);
+    ptr32 = alloc.shareShape32(numSubShapes);
     subShapeNumDecals.set(ptr32, numSubShapes);
 
     alloc.checkGuard();
@@ -714,17 +732,11 @@ void TSShape::assembleShape()
     }
 
     // get default translation and rotation
-    S16* ptr16 = alloc.allocShape16(0);
-    for (i = 0; i < numNodes; i++)
-        alloc.copyToShape16(4);
+    S16* ptr16 = alloc.shareShape16(numNodes * 4);
     defaultRotations.set(ptr16, numNodes);
     alloc.align32();
-    ptr32 = alloc.allocShape32(0);
-    for (i = 0; i < numNodes; i++)
-    {
-        alloc.copyToShape32(3);
-        alloc.copyToShape32(sizeof(Point3F) - 12); // handle alignment issues w/ point3f
-    }
+    AssertFatal(sizeof(Point3F) == 12, "TSShape::assembleShape: default translations are read as packed Point3Fs");
+    ptr32 = alloc.shareShape32(numNodes * 3);
     defaultTranslations.set(ptr32, numNodes);
 
     // get any node sequence data stored in shape
@@ -796,14 +808,14 @@ void TSShape::assembleShape()
     }
 
     // object states
-    ptr32 = alloc.copyToShape32(numObjectStates * 3);
+    ptr32 = numSkins ? alloc.copyToShape32(numObjectStates * 3) : alloc.shareShape32(numObjectStates * 3);
     objectStates.set(ptr32, numObjectStates);
     alloc.allocShape32(numSkins * 3); // provide buffer after objectStates for older shapes
 
     alloc.checkGuard();
 
     // decal states
-    ptr32 = alloc.copyToShape32(numDecalStates);
+    ptr32 = alloc.shareShape32(numDecalStates);
     decalStates.set(ptr32, numDecalStates);
 
     alloc.checkGuard();
@@ -816,7 +828,7 @@ void TSShape::assembleShape()
     alloc.checkGuard();
 
     // details
-    ptr32 = alloc.copyToShape32(numDetails * 7, true);
+    ptr32 = alloc.shareShape32(numDetails * 7, true);
     details.set(ptr32, numDetails);
 
     alloc.checkGuard();
@@ -948,7 +960,7 @@ void TSShape::assembleShape()
     }
     if (!namesInStringTable)
     {
-        name = (char*)alloc.copyToShape8(nameBufferSize);
+        name = (char*)alloc.shareShape8(nameBufferSize);
         if (name) // make sure we did copy (might just be getting size of buffer)
             for (i = 0; i < numNames; i++)
             {
@@ -1177,6 +1189,9 @@ void TSShape::write(Stream* s)
     // write version
     s->write(smVersion | (mExporterVersion << 16));
 
+    // the keys go out unpacked
+    unpackSequences();
+
     alloc.setWrite();
     disassembleShape();
 
@@ -1251,6 +1266,7 @@ bool TSShape::read(Stream* s)
     S16* memBuffer16;
     S8* memBuffer8;
     S32 count32, count16, count8;
+    S32 readBufferSize = 0;
     if (mReadVersion < 19)
     {
         Con::printf("... Shape with old version.");
@@ -1275,6 +1291,7 @@ bool TSShape::read(Stream* s)
         S32* tmp = new S32[sizeMemBuffer];
         s->read(sizeof(S32) * sizeMemBuffer, (U8*)tmp);
         memBuffer32 = tmp;
+        readBufferSize = sizeof(S32) * sizeMemBuffer;
         memBuffer16 = (S16*)(tmp + startU16);
         memBuffer8 = (S8*)(tmp + startU8);
 
@@ -1301,7 +1318,11 @@ bool TSShape::read(Stream* s)
     // since we read in the buffers, we need to endian-flip their entire contents...
     fixEndian(memBuffer32, memBuffer16, memBuffer8, count32, count16, count8);
 
+    // newer shapes come in one block, which the meshes can use as it is
+    bool shareBuffer = smShareReadBuffer && mReadVersion >= 19 && smNumSkipLoadDetails == 0;
+
     alloc.setRead(memBuffer32, memBuffer16, memBuffer8, true);
+    alloc.setShareInput(shareBuffer);
     assembleShape(); // determine size of buffer needed
     S32 buffSize = alloc.getSize();
     alloc.doAlloc();
@@ -1309,6 +1330,7 @@ bool TSShape::read(Stream* s)
     alloc.setRead(memBuffer32, memBuffer16, memBuffer8, false);
     assembleShape(); // copy to buffer
     AssertFatal(alloc.getSize() == buffSize, "TSShape::read: shape data buffer size mis-calculated");
+    mMemoryBlockSize = buffSize;
 
     if (smReadVersion < 19)
     {
@@ -1316,6 +1338,11 @@ bool TSShape::read(Stream* s)
         delete[] memBuffer16;
         delete[] memBuffer8;
     }
+    else if (shareBuffer)
+    {
+        mReadBuffer = memBuffer32; // shape and mesh data point into it
+        mReadBufferSize = readBufferSize;
+    }
     else
         delete[] memBuffer32; // this covers all the buffers
 
@@ -1450,6 +1477,8 @@ void TSShape::readIflMaterials(const char* shapePath)
 
 ResourceInstance* constructTSShape(Stream& stream)
 {
+    MemoryTagScope tagScope(sTSShapeMemoryTag);
+
     TSShape* ret = new TSShape;
     if (!ret->read(&stream))
     {
@@ -1710,3 +1739,95 @@ void TSShape::computeAccelerator(S32 dl)
 }
 #endif
 
+
+//-------------------------------------------------------------------------------------
+// Shape load report
+//
+// Reads every shape under a path from memory, once copying into mMemoryBlock
+// and once keeping the file's data block, and reports the load time and the
+// bytes each way keeps resident.
+
+ConsoleFunction(benchmarkShapeLoad, void, 1, 3, "([string path, int passes]) "
+    "Report load time and resident memory of the shapes under path (marble/data by default), "
+    "with and without $pref::TS::shareReadBuffer.")
+{
+    const char* path = argc > 1 ? argv[1] : "marble/data";
+    S32 passes = argc > 2 ? getMax(dAtoi(argv[2]), 1) : 10;
+    U32 pathLen = dStrlen(path);
+
+    // read the files up front so the timings cover only TSShape::read
+    Vector<U8*> fileData;
+    Vector<U32> fileSizes;
+    ResourceManager->startResourceTraverse();
+    while (ResourceObject* obj = ResourceManager->getNextResource())
+    {
+        if (!obj->path || dStrnicmp(obj->path, path, pathLen) || (obj->path[pathLen] && obj->path[pathLen] != '/'))
+            continue;
+        const char* ext = dStrrchr(obj->name, '.');
+        if (!ext || dStricmp(ext, ".dts"))
+            continue;
+
+        Stream* stream = ResourceManager->openStream(obj);
+        if (!stream)
+            continue;
+        U32 size = stream->getStreamSize();
+        U8* data = new U8[size];
+        if (stream->read(size, data))
+        {
+            fileData.push_back(data);
+            fileSizes.push_back(size);
+        }
+        else
+            delete[] data;
+        ResourceManager->closeStream(stream);
+    }
+
+    if (!fileData.size())
+    {
+        Con::errorf("benchmarkShapeLoad: no shapes under '%s'.", path);
+        return;
+    }
+
+    bool oldShare = TSShape::smShareReadBuffer;
+    U32 loadTime[2] = { 0, 0 };
+    U32 blockBytes[2] = { 0, 0 };
+    U32 readBufferBytes[2] = { 0, 0 };
+    S32 numShapes = 0;
+
+    for (S32 share = 0; share < 2; share++)
+    {
+        TSShape::smShareReadBuffer = share != 0;
+        numShapes = 0;
+        for (S32 f = 0; f < fileData.size(); f++)
+        {
+            for (S32 p = 0; p < passes; p++)
+            {
+                MemStream stream(fileSizes[f], fileData[f], true, false);
+                TSShape* shape = new TSShape;
+                U32 startTime = Platform::getRealMilliseconds();
+                bool loaded = shape->read(&stream);
+                loadTime[share] += Platform::getRealMilliseconds() - startTime;
+
+                if (loaded && p == 0)
+                {
+                    numShapes++;
+                    blockBytes[share] += shape->mMemoryBlockSize;
+                    readBufferBytes[share] += shape->mReadBufferSize;
+                }
+                delete shape;
+            }
+        }
+    }
+    TSShape::smShareReadBuffer = oldShare;
+
+    for (S32 f = 0; f < fileData.size(); f++)
+        delete[] fileData[f];
+
+    Con::printf("Shape load: %d shapes, %d passes", numShapes, passes);
+    for (S32 share = 0; share < 2; share++)
+    {
+        U32 resident = blockBytes[share] + readBufferBytes[share];
+        Con::printf("   %-12s %6d ms, resident %9d bytes (shape block %d, file block %d)",
+            share ? "shared" : "copied", loadTime[share], resident, blockBytes[share], readBufferBytes[share]);
+    }
+}
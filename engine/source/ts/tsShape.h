@@ -345,6 +345,14 @@ public:
     /// vectors are resizeable
     S8* mMemoryBlock;
 
+    /// The file's data block, kept when the shape points straight into it
+    /// (see smShareReadBuffer).
+    S32* mReadBuffer;
+
+    /// Bytes held in mMemoryBlock and mReadBuffer, for load reports.
+    S32 mMemoryBlockSize;
+    S32 mReadBufferSize;
+
     TSMaterialList* materialList;
 
     /// @name Bounding
@@ -366,6 +374,7 @@ public:
     U32 data;                  ///< User-defined data storage.
 
     bool mSequencesConstructed;
+    bool mKeysPacked;          ///< nodeRotations/nodeTranslations freed, the keys live in packedSequences
     S32 mVertexBuffer;
     U32 mCallbackKey;
     bool mExportMerge;
@@ -395,7 +404,7 @@ public:
     /// @{
 
     QuatF& getRotation(const Sequence& seq, S32 keyframeNum, S32 rotNum, QuatF*) const;
-    const Point3F& getTranslation(const Sequence& seq, S32 keyframeNum, S32 tranNum) const;
+    Point3F getTranslation(const Sequence& seq, S32 keyframeNum, S32 tranNum) const;
     F32 getUniformScale(const Sequence& seq, S32 keyframeNum, S32 scaleNum) const;
     const Point3F& getAlignedScale(const Sequence& seq, S32 keyframeNum, S32 scaleNum) const;
     TSScale& getArbitraryScale(const Sequence& seq, S32 keyframeNum, S32 scaleNum, TSScale*) const;
@@ -403,6 +412,54 @@ public:
     const DecalState& getDecalState(const Sequence& seq, S32 keyframeNum, S32 decalNum) const;
     /// @}
 
+    /// @name Packed Animation
+    /// Rotation and translation keys laid out again at init() so that a thread
+    /// can sample the tracks of its sequence in one pass.  Each keyframe is one
+    /// contiguous block of SoA rows (x's, then y's...) and tracks that never
+    /// change are pulled out and kept once.  The keys are stored as they are, so
+    /// once every sequence is packed the unpacked vectors are freed; getRotation
+    /// and getTranslation read the packed keys, and unpackSequences() rebuilds the
+    /// vectors exactly for write(), export and import.
+    /// @{
+
+    struct PackedSequence
+    {
+        S32 numRotations;                ///< tracks in the sequence
+        S32 numTranslations;
+        S32 numAnimRotations;            ///< tracks stored per keyframe, padded to 4
+        S32 numAnimTranslations;
+        S32 keyStride;                   ///< bytes per keyframe block
+        S32 translationOffset;           ///< translation rows within a block
+
+        Vector<S16> rotationTracks;      ///< track of each stored rotation, -1 for padding
+        Vector<S16> translationTracks;
+        Vector<S16> rotationNodes;       ///< node of each stored rotation, -1 for padding
+        Vector<S16> translationNodes;
+        Vector<S16> rotationSlots;       ///< per track: stored row, or -1 - index of its constant
+        Vector<S16> translationSlots;
+        Vector<S16> constRotationTracks;
+        Vector<Quat16> constRotationKeys;
+        Vector<QuatF> constRotations;    ///< already interpolated, so exact for any t
+        Vector<S16> constTranslationTracks;
+        Vector<Point3F> constTranslations;
+        Vector<U8> keys;                 ///< numKeyframes blocks of keyStride bytes
+    };
+    Vector<PackedSequence> packedSequences;
+
+    void packSequences();
+    void packSequence(const Sequence&, PackedSequence&);
+    void unpackSequences();
+
+    /// Sample the tracks of seq between two keyframes, out is indexed by track.
+    /// When nodes is given only the tracks of those nodes are sure to be
+    /// sampled, the entries for other tracks hold whatever was handy.
+    void sampleRotations(const Sequence& seq, S32 key1, S32 key2, F32 t, Vector<QuatF>& out, const TSIntegerSet* nodes = NULL) const;
+    void sampleTranslations(const Sequence& seq, S32 key1, S32 key2, F32 t, Vector<Point3F>& out, const TSIntegerSet* nodes = NULL) const;
+
+    QuatF& getPackedRotation(const Sequence& seq, S32 keyframeNum, S32 rotNum, QuatF*) const;
+    Point3F getPackedTranslation(const Sequence& seq, S32 keyframeNum, S32 tranNum) const;
+    /// @}
+
     /// build LOS collision detail
     void computeAccelerator(S32 dl);
     bool buildConvexHull(S32 dl) const;
@@ -454,13 +511,24 @@ public:
     /// by default we initialize shape when we read...
     static bool smInitOnRead;
 
+    /// Keep the file's data block after reading and have the shape and mesh
+    /// arrays point into it, instead of copying them into mMemoryBlock.  This
+    /// saves the copy but not memory: the block also holds the file form of the
+    /// primitives, indices and animation keys, which are converted or copied on
+    /// load anyway.  Off by default, and not done when skipping details.
+    static bool smShareReadBuffer;
+
+    /// Build packedSequences at init, sampling reads the unpacked keys without them.
+    static bool smPackAnimation;
+
     /// @name Version Info
     /// @{
 
     /// Most recent version...the one we write
     static S32 smVersion;
-    /// Version currently being read, only valid during read
-    static S32 smReadVersion;
+    /// Version currently being read, only valid during read.  Per thread, so
+    /// shapes can be read on several threads at once.
+    static thread_local S32 smReadVersion;
     static const U32 smMostRecentExporterVersion;
     ///@}
 
@@ -483,7 +551,7 @@ public:
     /// @name Persist Helper Functions
     /// @{
 
-    static TSShapeAlloc alloc;
+    static thread_local TSShapeAlloc alloc;
     void fixEndian(S32*, S16*, S8*, S32, S32, S32);
     /// @}
 
@@ -612,11 +680,15 @@ extern ResourceInstance* constructTSShape(Stream& stream);
 
 inline QuatF& TSShape::getRotation(const Sequence& seq, S32 keyframeNum, S32 rotNum, QuatF* quat) const
 {
+    if (mKeysPacked)
+        return getPackedRotation(seq, keyframeNum, rotNum, quat);
     return nodeRotations[seq.baseRotation + rotNum * seq.numKeyframes + keyframeNum].getQuatF(quat);
 }
 
-inline const Point3F& TSShape::getTranslation(const Sequence& seq, S32 keyframeNum, S32 tranNum) const
+inline Point3F TSShape::getTranslation(const Sequence& seq, S32 keyframeNum, S32 tranNum) const
 {
+    if (mKeysPacked)
+        return getPackedTranslation(seq, keyframeNum, tranNum);
     return nodeTranslations[seq.baseTranslation + tranNum * seq.numKeyframes + keyframeNum];
 }
 
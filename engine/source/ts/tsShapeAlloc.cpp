@@ -26,6 +26,7 @@ void TSShapeAlloc::setRead(S32* memBuffer32, S16* memBuffer16, S8* memBuffer8, b
     {
         mDest = NULL;
         mSize = 0;
+        mShareInput = false;
     }
 
     setSkipMode(false);
@@ -114,6 +115,16 @@ type * TSShapeAlloc::copyToShape##suffix(S32 num, bool returnSomething) \
    return ret;                                                \
 }                                                             \
                                                               \
+type * TSShapeAlloc::shareShape##suffix(S32 num, bool returnSomething) \
+{                                                             \
+   readOnly();                                                \
+   if (!mShareInput || !mMult)                                \
+      return copyToShape##suffix(num, returnSomething);       \
+   type * ret = (returnSomething || mDest) ? mMemBuffer##suffix : NULL; \
+   mMemBuffer##suffix += num;                                 \
+   return ret;                                                \
+}                                                             \
+                                                              \
 bool TSShapeAlloc::checkGuard##suffix()                       \
 {                                                             \
    readOnly();                                                \
@@ -71,6 +71,7 @@ class TSShapeAlloc
     S8* mDest;
     S32 mSize;
     S32 mMult; ///< mult incoming sizes by this (when 0, then mDest doesn't grow --> skip mode)
+    bool mShareInput; ///< shareShape returns input pointers rather than copying
 
 public:
 
@@ -86,6 +87,9 @@ public:
     S8* getBuffer() { return mDest; }
     S32 getSize() { return mSize; }
     void setSkipMode(bool skip) { mMult = skip ? 0 : 1; }
+    /// Let shareShape point into the input buffers.  The caller must then keep
+    /// the input alive for as long as the shape.  Cleared by setRead(..., true).
+    void setShareInput(bool share) { mShareInput = share; }
 
     /// @name Reading Operations:
     ///
@@ -97,6 +101,9 @@ public:
     ///
     /// getPointer(): gets pointer to next entries of type in input buffer (no effect on input buffer)
     ///
+    /// shareShape(): same as copyToShape, except when sharing input it returns a pointer into the
+    ///               input buffer and takes no room in the output buffer
+    ///
     /// @note all operations advance current "position" of input and output buffers
     ///       writing operations:
     ///
@@ -115,6 +122,7 @@ public:
    void get##suffix(type*,S32);       \
    type * copyToShape##suffix(S32,bool returnSomething=false); \
    type * getPointer##suffix(S32);    \
+   type * shareShape##suffix(S32,bool returnSomething=false); \
    type * allocShape##suffix(S32);    \
    bool checkGuard##suffix();         \
    type getPrevGuard##suffix();       \
@@ -18,6 +18,7 @@
 
 TSShapeInstance::RenderData   TSShapeInstance::smRenderData;
 MatrixF* TSShapeInstance::ObjectInstance::smTransforms = NULL;
+U32 TSShapeInstance::ObjectInstance::smTransformStamp = 0;
 S32                           TSShapeInstance::smMaxSnapshotScale = 2;
 bool                          TSShapeInstance::smNoRenderTranslucent = false;
 bool                          TSShapeInstance::smNoRenderNonTranslucent = false;
@@ -28,15 +29,17 @@ S32                           TSShapeInstance::smNumSkipRenderDetails = 0;
 bool                          TSShapeInstance::smSkipFirstFog = false;
 bool                          TSShapeInstance::smSkipFog = false;
 
-Vector<QuatF>                 TSShapeInstance::smNodeCurrentRotations(__FILE__, __LINE__);
-Vector<Point3F>               TSShapeInstance::smNodeCurrentTranslations(__FILE__, __LINE__);
-Vector<F32>                   TSShapeInstance::smNodeCurrentUniformScales(__FILE__, __LINE__);
-Vector<Point3F>               TSShapeInstance::smNodeCurrentAlignedScales(__FILE__, __LINE__);
-Vector<TSScale>               TSShapeInstance::smNodeCurrentArbitraryScales(__FILE__, __LINE__);
+thread_local Vector<QuatF>    TSShapeInstance::smNodeCurrentRotations(__FILE__, __LINE__);
+thread_local Vector<Point3F>  TSShapeInstance::smNodeCurrentTranslations(__FILE__, __LINE__);
+thread_local Vector<F32>      TSShapeInstance::smNodeCurrentUniformScales(__FILE__, __LINE__);
+thread_local Vector<Point3F>  TSShapeInstance::smNodeCurrentAlignedScales(__FILE__, __LINE__);
+thread_local Vector<TSScale>  TSShapeInstance::smNodeCurrentArbitraryScales(__FILE__, __LINE__);
+thread_local Vector<QuatF>    TSShapeInstance::smSampledRotations(__FILE__, __LINE__);
+thread_local Vector<Point3F>  TSShapeInstance::smSampledTranslations(__FILE__, __LINE__);
 
-Vector<TSThread*>             TSShapeInstance::smRotationThreads(__FILE__, __LINE__);
-Vector<TSThread*>             TSShapeInstance::smTranslationThreads(__FILE__, __LINE__);
-Vector<TSThread*>             TSShapeInstance::smScaleThreads(__FILE__, __LINE__);
+thread_local Vector<TSThread*> TSShapeInstance::smRotationThreads(__FILE__, __LINE__);
+thread_local Vector<TSThread*> TSShapeInstance::smTranslationThreads(__FILE__, __LINE__);
+thread_local Vector<TSThread*> TSShapeInstance::smScaleThreads(__FILE__, __LINE__);
 
 namespace {
 
@@ -109,6 +112,20 @@ TSShapeInstance::TSShapeInstance(TSShape* _shape, bool loadMaterials)
 TSShapeInstance::~TSShapeInstance()
 {
     S32 i;
+
+    // don't leave a dangling pointer for animateDeferred()
+    if (mAnimateDeferred)
+    {
+        for (i = 0; i < smDeferredAnimates.size(); i++)
+        {
+            if (smDeferredAnimates[i] == this)
+            {
+                smDeferredAnimates.erase_fast(i);
+                break;
+            }
+        }
+    }
+
     for (i = 0; i < mMeshObjects.size(); i++)
         destructInPlace(&mMeshObjects[i]);
 
@@ -136,6 +153,9 @@ void TSShapeInstance::init()
     Con::addVariable("$pref::TS::fogTexture", TypeBool, &smRenderData.fogTexture);
     Con::addVariable("$pref::TS::detailAdjust", TypeF32, &smDetailAdjust);
     Con::addVariable("$pref::TS::skipLoadDLs", TypeS32, &TSShape::smNumSkipLoadDetails);
+    Con::addVariable("$pref::TS::shareReadBuffer", TypeBool, &TSShape::smShareReadBuffer);
+    Con::addVariable("$pref::TS::packAnimation", TypeBool, &TSShape::smPackAnimation);
+    Con::addVariable("$pref::TS::threadedAnimate", TypeBool, &smThreadedAnimate);
     Con::addVariable("$pref::TS::skipRenderDLs", TypeS32, &smNumSkipRenderDetails);
     Con::addVariable("$pref::TS::skipFirstFog", TypeBool, &smSkipFirstFog);
     Con::addVariable("$pref::TS::screenError", TypeF32, &smScreenError);
@@ -202,6 +222,8 @@ void TSShapeInstance::buildInstanceData(TSShape* _shape, bool loadMaterials)
     // set up node data
     S32 numNodes = mShape->nodes.size();
     mNodeTransforms.setSize(numNodes);
+    mTransformStamp = 1;
+    mAnimateDeferred = false;
 
     // add objects to trees
     S32 numObjects = mShape->objects.size();
@@ -224,6 +246,10 @@ void TSShapeInstance::buildInstanceData(TSShape* _shape, bool loadMaterials)
             objInst->meshList = NULL;
 
         objInst->object = obj;
+
+        objInst->skinnedMesh = NULL;
+        objInst->skinnedStamp = 0;
+        objInst->skinnedScene = 0;
     }
 
     // set up decal objects
@@ -847,6 +873,7 @@ bool TSShapeInstance::renderDecalsX(S32 ss, S32 od)
 void TSShapeInstance::setStatics(S32 dl, F32 intraDL, const Point3F* objectScale)
 {
     ObjectInstance::smTransforms = mNodeTransforms.address();
+    ObjectInstance::smTransformStamp = mTransformStamp;
     smRenderData.objectScale = objectScale;
     smRenderData.detailLevel = dl;
     smRenderData.intraDetailLevel = intraDL;
@@ -91,6 +91,9 @@ public:
         /// look for the transforms...gets set be shape instance 'setStatics' method
         static MatrixF* smTransforms;
 
+        /// mTransformStamp of the shape instance that set smTransforms
+        static U32 smTransformStamp;
+
         S32 nodeIndex;
         /// Gets the transform of this object
         MatrixF* getTransform();
@@ -134,6 +137,12 @@ public:
         // when rendering.
         GFXVertexBufferHandle<MeshVertex> mVB;
 
+        /// What mVB was last skinned from, so further passes over the same pose
+        /// in the same scene can reuse it (see TSSkinMesh::render).
+        const TSMesh* skinnedMesh;
+        U32 skinnedStamp;
+        U32 skinnedScene;
+
         S32 getSizeVB(S32 size);
         bool hasMergeIndices();
         /// @name Vertex Buffer functions
@@ -209,6 +218,12 @@ public:
     /// storage space for node transforms
     Vector<MatrixF> mNodeTransforms;
 
+    /// bumped whenever mNodeTransforms are recomputed
+    U32 mTransformStamp;
+
+    /// queued for animateDeferred()
+    bool mAnimateDeferred;
+
     /// @name Reference Transform Vectors
     /// unused until first transition
     /// @{
@@ -220,20 +235,25 @@ public:
     /// @}
 
     /// @name Workspace for Node Transforms
+    /// Per thread, so instances can be animated in parallel (see animateDeferred).
     /// @{
-    static Vector<QuatF>   smNodeCurrentRotations;
-    static Vector<Point3F> smNodeCurrentTranslations;
-    static Vector<F32>     smNodeCurrentUniformScales;
-    static Vector<Point3F> smNodeCurrentAlignedScales;
-    static Vector<TSScale> smNodeCurrentArbitraryScales;
+    static thread_local Vector<QuatF>   smNodeCurrentRotations;
+    static thread_local Vector<Point3F> smNodeCurrentTranslations;
+    static thread_local Vector<F32>     smNodeCurrentUniformScales;
+    static thread_local Vector<Point3F> smNodeCurrentAlignedScales;
+    static thread_local Vector<TSScale> smNodeCurrentArbitraryScales;
+
+    /// every track of the thread being animated, see TSShape::sampleRotations
+    static thread_local Vector<QuatF>   smSampledRotations;
+    static thread_local Vector<Point3F> smSampledTranslations;
     /// @}
 
     /// @name Threads
     /// keep track of who controls what on currently animating shape
     /// @{
-    static Vector<TSThread*> smRotationThreads;
-    static Vector<TSThread*> smTranslationThreads;
-    static Vector<TSThread*> smScaleThreads;
+    static thread_local Vector<TSThread*> smRotationThreads;
+    static thread_local Vector<TSThread*> smTranslationThreads;
+    static thread_local Vector<TSThread*> smScaleThreads;
     /// @}
 
  //-------------------------------------------------------------------------------------
@@ -571,6 +591,18 @@ public:
 
     void animate();
     void animate(S32 dl);
+
+    /// @name Batched Animation
+    /// Instances can be queued with deferAnimate() and then animated all at
+    /// once, spread over the thread pool, by animateDeferred().  Animating a
+    /// queued instance directly in the meantime is fine, whichever animate
+    /// comes first clears the dirty flags and the other has nothing to do.
+    /// @{
+    void deferAnimate();           ///< animate() at the next animateDeferred(), main thread only
+    static void animateDeferred(); ///< animate everything queued, main thread only
+    static bool smThreadedAnimate; ///< use the thread pool for animateDeferred()
+    static Vector<TSShapeInstance*> smDeferredAnimates;
+    /// @}
     void animateNodes(S32 ss);
     void animateVisibility(S32 ss);
     void animateFrame(S32 ss);
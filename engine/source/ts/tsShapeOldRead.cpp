@@ -11,31 +11,32 @@
 
 #define OldPageSize 25000 // old page size must be mutliple of 4 so that we can always "over-read" up to next dword
 
+// per thread, like TSShape::alloc
 struct OldAlloc
 {
-    static S32 sz32;
-    static S32 cnt32;
+    static thread_local S32 sz32;
+    static thread_local S32 cnt32;
 
-    static S32 sz16;
-    static S32 cnt16;
+    static thread_local S32 sz16;
+    static thread_local S32 cnt16;
 
-    static S32 sz8;
-    static S32 cnt8;
+    static thread_local S32 sz8;
+    static thread_local S32 cnt8;
 
-    static S32 guard32;
-    static S16 guard16;
-    static S8 guard8;
+    static thread_local S32 guard32;
+    static thread_local S16 guard16;
+    static thread_local S8 guard8;
 };
 
-S32 OldAlloc::sz32;
-S32 OldAlloc::cnt32;
-S32 OldAlloc::sz16;
-S32 OldAlloc::cnt16;
-S32 OldAlloc::sz8;
-S32 OldAlloc::cnt8;
-S32 OldAlloc::guard32;
-S16 OldAlloc::guard16;
-S8 OldAlloc::guard8;
+thread_local S32 OldAlloc::sz32;
+thread_local S32 OldAlloc::cnt32;
+thread_local S32 OldAlloc::sz16;
+thread_local S32 OldAlloc::cnt16;
+thread_local S32 OldAlloc::sz8;
+thread_local S32 OldAlloc::cnt8;
+thread_local S32 OldAlloc::guard32;
+thread_local S16 OldAlloc::guard16;
+thread_local S8 OldAlloc::guard8;
 
 S32 getDWordCount32()
 {
@@ -942,6 +943,8 @@ void TSShape::fixupOldSkins(S32 numMeshes, S32 numSkins, S32 numDetails, S32* de
 //-------------------------------------------------
 void TSShape::exportSequences(Stream* s)
 {
+    unpackSequences();
+
     // write version
     s->write(smVersion);
 
@@ -1047,6 +1050,9 @@ void TSShape::exportSequences(Stream* s)
 //-------------------------------------------------
 bool TSShape::importSequences(Stream* s)
 {
+    // new keys go on the end of the unpacked ones, init() packs them all again
+    unpackSequences();
+
     // write version
     s->read(&smReadVersion);
     if (smReadVersion > smVersion)
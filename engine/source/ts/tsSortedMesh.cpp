@@ -218,34 +218,27 @@ S32 TSSortedMesh::getNumPolys()
 
 void TSSortedMesh::assemble(bool skip)
 {
-    bool save1 = TSMesh::smUseTriangles;
-    bool save2 = TSMesh::smUseOneStrip;
-    TSMesh::smUseTriangles = false;
-    TSMesh::smUseOneStrip = false;
-
+    // TSMesh::assemble leaves the strips of sorted meshes alone
     TSMesh::assemble(skip);
 
-    TSMesh::smUseTriangles = save1;
-    TSMesh::smUseOneStrip = save2;
-
     S32 numClusters = alloc.get32();
-    S32* ptr32 = alloc.copyToShape32(numClusters * 8);
+    S32* ptr32 = alloc.shareShape32(numClusters * 8);
     clusters.set(ptr32, numClusters);
 
     S32 sz = alloc.get32();
-    ptr32 = alloc.copyToShape32(sz);
+    ptr32 = alloc.shareShape32(sz);
     startCluster.set(ptr32, sz);
 
     sz = alloc.get32();
-    ptr32 = alloc.copyToShape32(sz);
+    ptr32 = alloc.shareShape32(sz);
     firstVerts.set(ptr32, sz);
 
     sz = alloc.get32();
-    ptr32 = alloc.copyToShape32(sz);
+    ptr32 = alloc.shareShape32(sz);
     numVerts.set(ptr32, sz);
 
     sz = alloc.get32();
-    ptr32 = alloc.copyToShape32(sz);
+    ptr32 = alloc.shareShape32(sz);
     firstTVerts.set(ptr32, sz);
 
     alwaysWriteDepth = alloc.get32() != 0;
@@ -7,6 +7,10 @@
 #include "map2dif/bspNode.h"
 #include "map2dif/csgBrush.h"
 #include "math/mRandom.h"
+#include "platform/threadPool.h"
+
+BSPBuildStats gBSPBuildStats;
+ThreadPool*   EditBSPNode::smRatingPool = NULL;
 
 namespace {
 
@@ -16,6 +20,85 @@ void flushedOutput(const char* string)
    dFflushStdout();
 }
 
+// Brushes handed to a rating work item at once
+const U32 csgAssessBatchSize = 16;
+
+// Assesses brushes [start, end) against the candidate planes, which are sorted
+//  by index.  Results go to pAssessments[plane * numBrushes + brush].  Both the
+//  planes and each brush's cache are sorted, so they're walked side by side and
+//  only missing pairs are assessed.  Returns the number of cached results used.
+//  Every brush is only touched by one caller, so batches may run in parallel.
+U32 assessBrushes(CSGBrush**         pBrushes,
+                  U32                start,
+                  U32                end,
+                  U32                numBrushes,
+                  const Vector<U32>& planes,
+                  U8*                pAssessments)
+{
+   U32 numCached = 0;
+   Vector<U32> merged;
+
+   for (U32 i = start; i < end; i++) {
+      CSGBrush*    pBrush = pBrushes[i];
+      Vector<U32>& cache  = pBrush->mAssessments;
+
+      merged.clear();
+      U32  c         = 0;
+      bool anyMissed = false;
+      for (U32 j = 0; j < planes.size(); j++) {
+         U32 key = planes[j] >> 1;
+         while (c < cache.size() && (cache[c] >> 8) < key)
+            merged.push_back(cache[c++]);
+
+         U32 assessment;
+         if (c < cache.size() && (cache[c] >> 8) == key) {
+            assessment = cache[c++] & 0xFF;
+            numCached++;
+         } else {
+            assessment = assessPlane(planes[j], *pBrush);
+            anyMissed  = true;
+         }
+         merged.push_back((key << 8) | assessment);
+         pAssessments[j * numBrushes + i] = U8(assessment);
+      }
+
+      if (anyMissed) {
+         while (c < cache.size())
+            merged.push_back(cache[c++]);
+         cache = merged;
+      }
+   }
+
+   return(numCached);
+}
+
+class AssessBrushesWorkItem : public ThreadPool::WorkItem
+{
+  public:
+   CSGBrush**         pBrushes;
+   U32                start;
+   U32                end;
+   U32                numBrushes;
+   const Vector<U32>* pPlanes;
+   U8*                pAssessments;
+   U32                numCached;
+
+   AssessBrushesWorkItem(CSGBrush** _pBrushes, U32 _start, U32 _end, U32 _numBrushes,
+                         const Vector<U32>* _pPlanes, U8* _pAssessments)
+      : pBrushes(_pBrushes), start(_start), end(_end), numBrushes(_numBrushes),
+        pPlanes(_pPlanes), pAssessments(_pAssessments), numCached(0) { }
+
+   void execute()
+   {
+      numCached = assessBrushes(pBrushes, start, end, numBrushes, *pPlanes, pAssessments);
+   }
+
+   void onCompleted()
+   {
+      gBSPBuildStats.cachedAssessments += numCached;
+   }
+};
+
 }
 
 //------------------------------------------------------------------------------
@@ -448,7 +531,7 @@ bool EditBSPNode::planeInParents(U32 testPlane)
 }
 
 
-S32 EditBSPNode::calcPlaneRating(U32 testPlane)
+S32 EditBSPNode::calcPlaneRating(U32 testPlane, const U8* pAssessments, U32 numBrushes)
 {
    // Things that we don't like:
    //    - Splitting of many planes
@@ -479,14 +562,13 @@ S32 EditBSPNode::calcPlaneRating(U32 testPlane)
       isAxial = true;
 
    // Count splits, sides, etc.
-   for (U32 i = 0; i < brushList.size(); i++) {
-      assessPlane(testPlane,
-                  *brushList[i],
-                  &numCoplanar,
-                  &numTinyWindings,
-                  &numSplits,
-                  &numFront,
-                  &numBack);
+   for (U32 i = 0; i < numBrushes; i++) {
+      U32 assessment = pAssessments[i];
+      numCoplanar     += (assessment & AssessCoplanar)    ? 1 : 0;
+      numTinyWindings += (assessment & AssessTinyWinding) ? 1 : 0;
+      numSplits       += (assessment & AssessSplit)       ? 1 : 0;
+      numFront        += (assessment & AssessFront)       ? 1 : 0;
+      numBack         += (assessment & AssessBack)        ? 1 : 0;
    }
 
    // Ok.  Now, I'm blatantly copying this from the qbsp3 source.  Their hueristic:
@@ -772,11 +854,27 @@ void EditBSPNode::splitPortalEntries()
 }
 
 
+//------------------------------------------------------------------------------
+// selectBestPlane shuffles the brushes with this generator.  It goes back to
+//  its first seed for every interior, so an interior compiled in a batch comes
+//  out the same as when it is compiled on its own.
+static MRandomLCG& getShuffleRand()
+{
+   static MRandomLCG sRand;
+   return sRand;
+}
+
+void EditBSPNode::resetPlaneShuffle()
+{
+   static S32 sFirstSeed = getShuffleRand().getSeed();
+   getShuffleRand().setSeed(sFirstSeed);
+}
+
 //------------------------------------------------------------------------------
 U32 EditBSPNode::selectBestPlane()
 {
    // Shuffle the brush indices...
-   static MRandomLCG sRand;
+   MRandomLCG& sRand = getShuffleRand();
    static Vector<U32> shuffledIndices;
    shuffledIndices.setSize(brushList.size());
    for (U32 i = 0; i < shuffledIndices.size(); i++)
@@ -816,10 +914,38 @@ U32 EditBSPNode::selectBestPlane()
    if (uniquePlanes.size() == 0)
       return U32(-1);
 
+   // Rate against every brush, or against a random sample of them if asked to
+   extern U32 gBSPBrushSample;
+   Vector<CSGBrush*> ratedBrushes;
+   if (gBSPBrushSample != 0 && brushList.size() > gBSPBrushSample) {
+      ratedBrushes.setSize(gBSPBrushSample);
+      for (U32 i = 0; i < gBSPBrushSample; i++)
+         ratedBrushes[i] = brushList[shuffledIndices[i]];
+   } else {
+      ratedBrushes = brushList;
+   }
+   U32 numBrushes = ratedBrushes.size();
+
+   Vector<U8> assessments;
+   assessments.setSize(uniquePlanes.size() * numBrushes);
+   if (smRatingPool != NULL && numBrushes >= csgAssessBatchSize * 2) {
+      for (U32 i = 0; i < numBrushes; i += csgAssessBatchSize)
+         smRatingPool->queueWorkItem(new AssessBrushesWorkItem(ratedBrushes.address(), i,
+                                                               getMin(i + csgAssessBatchSize, numBrushes),
+                                                               numBrushes, &uniquePlanes,
+                                                               assessments.address()));
+      smRatingPool->waitForAllItems();
+   } else {
+      gBSPBuildStats.cachedAssessments += assessBrushes(ratedBrushes.address(), 0, numBrushes, numBrushes,
+                                                        uniquePlanes, assessments.address());
+   }
+   gBSPBuildStats.planesRated += uniquePlanes.size();
+   gBSPBuildStats.assessments += uniquePlanes.size() * numBrushes;
+
    S32 maxRating = -(1 << 30);
    S32 maxIndex  = -1;
    for (U32 i = 0; i < uniquePlanes.size(); i++) {
-      S32 currRating = calcPlaneRating(uniquePlanes[i]);
+      S32 currRating = calcPlaneRating(uniquePlanes[i], &assessments[i * numBrushes], numBrushes);
       if (currRating > maxRating) {
          maxRating = currRating;
          maxIndex  = i;
@@ -16,6 +16,18 @@
 
 class CSGBrush;
 class CSGPlane;
+class ThreadPool;
+
+//------------------------------------------------------------------------------
+// Build times and plane selection counters, reset for every BSP built
+struct BSPBuildStats {
+   U32 csgTime;            // ms spent clipping the brushes
+   U32 bspTime;            // ms spent building the tree
+   U32 planesRated;
+   U32 assessments;
+   U32 cachedAssessments;
+};
+extern BSPBuildStats gBSPBuildStats;
 
 //------------------------------------------------------------------------------
 class EditBSPNode {
@@ -60,7 +72,7 @@ class EditBSPNode {
    void         createPortalWindings(const PortalEntry& rBaseWindings, PortalEntry* pFinalEntry);
 
   private:
-   S32  calcPlaneRating(U32 testPlane);
+   S32  calcPlaneRating(U32 testPlane, const U8* pAssessments, U32 numBrushes);
    bool planeInParents(U32 testPlane);
    U32  selectBestPlane();
    void eraseReferencingLinks();
@@ -98,6 +110,9 @@ class EditBSPNode {
    // For building BSP.  List of Brushes
    Vector<CSGBrush*>    brushList;
 
+   // Brushes are assessed against candidate planes on this pool if set
+   static ThreadPool* smRatingPool;
+
   public:
    EditBSPNode() : planeEQIndex(-1), planeType(Detail),
                pParent(NULL), pFront(NULL), pBack(NULL) { isSolid = false; solidBrush = NULL; }
@@ -106,6 +121,7 @@ class EditBSPNode {
    //-------------------------------------- BSP/Portal/Zone creation/manipulation
   public:
    void createBSP(PlaneType _planeType);
+   static void resetPlaneShuffle();
    void createVisLinks();
    void zoneFlood();
    void floodZone(S32 markZoneId);
@@ -8,6 +8,7 @@
 #include "math/mMath.h"
 #include "core/bitMatrix.h"
 #include "interior/interior.h"
+#include "platform/threadPool.h"
 
 #ifdef DUMP_LIGHTMAPS
 #include "core/fileStream.h"
@@ -30,6 +31,7 @@ namespace {
 }
 
 extern bool gBuildAsLowDetail;
+extern U32 gNumThreads;
 
 
 void sgIlluminateSurface(EditGeometry::Surface &surface)
@@ -58,10 +60,10 @@ void sgIlluminateSurface(EditGeometry::Surface &surface)
 // Class Lighting
 //------------------------------------------------------------------------------
 
+thread_local Lighting::Workspace * Lighting::smThreadWorkspace = NULL;
+
 Lighting::Lighting() :
    mNumAmbiguousPlanes(0),
-   mNodeRepository(0),
-   mWindingStore(0),
    mSurfaceEmitterInfos(0),
    mEmitterSurfaceIndices(0)
 {
@@ -81,7 +83,7 @@ Lighting::~Lighting()
 
    //
    mEmitterInfoChunker.clear();
-   mNodeChunker.clear();
+   mWorkspace.mNodeChunker.clear();
    mSurfaceChunker.clear();
 
    //
@@ -458,246 +460,300 @@ void Lighting::processEmitterBSPs()
 
 void Lighting::flushLexelPoints()
 {
-   mLexelPoints.setSize(0);
-   mLexelPoints.reserve(LexelPointStoreSize);
+   Vector<Point3D> & lexelPoints = getWorkspace().mLexelPoints;
+   lexelPoints.setSize(0);
+   lexelPoints.reserve(LexelPointStoreSize);
 }
 
 const Point3D & Lighting::getLexelPoint(U32 index)
 {
-   AssertFatal(index < mLexelPoints.size(), "Lighting::getLexelPoint: index out of range");
-   return(mLexelPoints[index]);
+   Vector<Point3D> & lexelPoints = getWorkspace().mLexelPoints;
+   AssertFatal(index < lexelPoints.size(), "Lighting::getLexelPoint: index out of range");
+   return(lexelPoints[index]);
 }
 
 U32 Lighting::insertLexelPoint(const Point3D & pnt)
 {
-   if(!mLexelPoints.size())
-      mLexelPoints.reserve(LexelPointStoreSize);
+   Vector<Point3D> & lexelPoints = getWorkspace().mLexelPoints;
+   if(!lexelPoints.size())
+      lexelPoints.reserve(LexelPointStoreSize);
 
-   if(mLexelPoints.size() == (mLexelPoints.capacity() - 1))
-      mLexelPoints.reserve(mLexelPoints.size() + LexelPointStoreSize);
+   if(lexelPoints.size() == (lexelPoints.capacity() - 1))
+      lexelPoints.reserve(lexelPoints.size() + LexelPointStoreSize);
 
-   mLexelPoints.push_back(pnt);
-   return(mLexelPoints.size() - 1);
+   lexelPoints.push_back(pnt);
+   return(lexelPoints.size() - 1);
 }
 
 //------------------------------------------------------------------------------
 
+namespace {
+
+   // lights one surface on a worker thread - surfaces only write to their
+   // own lightmaps, so the result is the same as lighting them in order
+   class LightSurfaceWorkItem : public ThreadPool::WorkItem
+   {
+      public:
+         Lighting *  mLighting;
+         U32         mSurface;
+         U32 *       mNumLit;
+
+         LightSurfaceWorkItem(Lighting * lighting, U32 surface, U32 * numLit) :
+            mLighting(lighting), mSurface(surface), mNumLit(numLit) {}
+
+         void execute()
+         {
+            Lighting::Workspace workspace;
+            Lighting::smThreadWorkspace = &workspace;
+            mLighting->lightSurface(mSurface);
+            Lighting::smThreadWorkspace = NULL;
+         }
+
+         void onCompleted()
+         {
+            U32 numLit = (*mNumLit)++;
+            F32 percentDone = F32(numLit) / F32(mLighting->mSurfaces.size()) * 100.0;
+            dPrintf( "Lighting surface %d of %d : %2f percent done.\n", numLit, mLighting->mSurfaces.size(), percentDone );
+         }
+   };
+}
+
 void Lighting::lightSurfaces()
 {
+   // 0 - one thread per processor
+   U32 numThreads = gNumThreads ? gNumThreads : (ThreadPool::getDefaultNumThreads() + 1);
+
+   if(numThreads > 1)
+   {
+      // the main thread helps out while waiting
+      ThreadPool pool(numThreads - 1);
+
+      U32 numLit = 0;
+      for(U32 i = 0; i < mSurfaces.size(); i++)
+         pool.queueWorkItem(new LightSurfaceWorkItem(this, i, &numLit));
+      pool.waitForAllItems();
+      return;
+   }
+
    for(U32 i = 0; i < mSurfaces.size(); i++)
    {
       F32 percentDone = F32(i) / F32(mSurfaces.size()) * 100.0;
       dPrintf( "Lighting surface %d of %d : %2f percent done.\n", i, mSurfaces.size(), percentDone );
 
+      lightSurface(i);
+   }
+}
 
-      Surface * surface = mSurfaces[i];
+void Lighting::lightSurface(U32 index)
+{
+   Surface * surface = mSurfaces[index];
 
-      // must have emitters on this surface
-      if(!surface->mNumEmitters)
-         continue;
+   // must have emitters on this surface
+   if(!surface->mNumEmitters)
+      return;
 
-      const PlaneEQ & plane = gWorkingGeometry->getPlaneEQ(surface->mPlaneIndex);
-      const EditGeometry::Surface * editSurface = &gWorkingGeometry->mSurfaces[surface->mSurfaceIndex];
+   const PlaneEQ & plane = gWorkingGeometry->getPlaneEQ(surface->mPlaneIndex);
+   const EditGeometry::Surface * editSurface = &gWorkingGeometry->mSurfaces[surface->mSurfaceIndex];
 
-      // must have a lightmap
-      if(!editSurface->pLMap)
-         continue;
+   // must have a lightmap
+   if(!editSurface->pLMap)
+      return;
 
-      const F32* const & lGenX = editSurface->lmapTexGenX;
-      const F32* const & lGenY = editSurface->lmapTexGenY;
+   const F32* const & lGenX = editSurface->lmapTexGenX;
+   const F32* const & lGenY = editSurface->lmapTexGenY;
 
-      //
-      AssertFatal((lGenX[0] * lGenX[1] == 0.f) &&
-                  (lGenX[0] * lGenX[2] == 0.f) &&
-                  (lGenX[1] * lGenX[2] == 0.f), "Bad texgen!");
-      AssertFatal((lGenY[0] * lGenY[1] == 0.f) &&
-                  (lGenY[0] * lGenY[2] == 0.f) &&
-                  (lGenY[1] * lGenY[2] == 0.f), "Bad texgen!");
+   //
+   AssertFatal((lGenX[0] * lGenX[1] == 0.f) &&
+               (lGenX[0] * lGenX[2] == 0.f) &&
+               (lGenX[1] * lGenX[2] == 0.f), "Bad texgen!");
+   AssertFatal((lGenY[0] * lGenY[1] == 0.f) &&
+               (lGenY[0] * lGenY[2] == 0.f) &&
+               (lGenY[1] * lGenY[2] == 0.f), "Bad texgen!");
 
 
-      // get the axis index for the texgens (could be swapped)
-      S32 si;
-      S32 ti;
-      S32 axis = -1;
+   // get the axis index for the texgens (could be swapped)
+   S32 si;
+   S32 ti;
+   S32 axis = -1;
 
-      //
-      if(lGenX[0] == 0.f && lGenY[0] == 0.f)          // YZ
-      {
-         axis = 0;
-         if(lGenX[1] == 0.f) { // swapped?
-            si = 2;
-            ti = 1;
-         } else {
-            si = 1;
-            ti = 2;
-         }
+   //
+   if(lGenX[0] == 0.f && lGenY[0] == 0.f)          // YZ
+   {
+      axis = 0;
+      if(lGenX[1] == 0.f) { // swapped?
+         si = 2;
+         ti = 1;
+      } else {
+         si = 1;
+         ti = 2;
       }
-      else if(lGenX[1] == 0.f && lGenY[1] == 0.f)     // XZ
-      {
-         axis = 1;
-         if(lGenX[0] == 0.f) { // swapped?
-            si = 2;
-            ti = 0;
-         } else {
-            si = 0;
-            ti = 2;
-         }
+   }
+   else if(lGenX[1] == 0.f && lGenY[1] == 0.f)     // XZ
+   {
+      axis = 1;
+      if(lGenX[0] == 0.f) { // swapped?
+         si = 2;
+         ti = 0;
+      } else {
+         si = 0;
+         ti = 2;
       }
-      else if(lGenX[2] == 0.f && lGenY[2] == 0.f)     // XY
-      {
-         axis = 2;
-         if(lGenX[0] == 0.f) { // swapped?
-            si = 1;
-            ti = 0;
-         } else {
-            si = 0;
-            ti = 1;
-         }
+   }
+   else if(lGenX[2] == 0.f && lGenY[2] == 0.f)     // XY
+   {
+      axis = 2;
+      if(lGenX[0] == 0.f) { // swapped?
+         si = 1;
+         ti = 0;
+      } else {
+         si = 0;
+         ti = 1;
       }
-      AssertFatal(!(axis == -1), "Lighting::lightSurfaces: bad TexGen!");
+   }
+   AssertFatal(!(axis == -1), "Lighting::lightSurfaces: bad TexGen!");
 
-      // get the start point for this lightmap (project min to surface)
-      Point3D start;
-      F64 * pStart = ((F64*)start);
-      const F64 * pNormal = ((const F64*)plane.normal);
+   // get the start point for this lightmap (project min to surface)
+   Point3D start;
+   F64 * pStart = ((F64*)start);
+   const F64 * pNormal = ((const F64*)plane.normal);
 
-      // TexGens come in scaled by (1/lightmapscale)
-      pStart[si] = -lGenX[3] * surface->sgLightingScale;
-      pStart[ti] = -lGenY[3] * surface->sgLightingScale;
+   // TexGens come in scaled by (1/lightmapscale)
+   pStart[si] = -lGenX[3] * surface->sgLightingScale;
+   pStart[ti] = -lGenY[3] * surface->sgLightingScale;
 
-      pStart[axis] = ((pNormal[si] * pStart[si]) +
-                      (pNormal[ti] * pStart[ti]) + plane.dist) / -pNormal[axis];
+   pStart[axis] = ((pNormal[si] * pStart[si]) +
+                   (pNormal[ti] * pStart[ti]) + plane.dist) / -pNormal[axis];
 
-      // get the s/t vecs oriented on the surface
-      Point3D sVec;
-      Point3D tVec;
+   // get the s/t vecs oriented on the surface
+   Point3D sVec;
+   Point3D tVec;
 
-      F64 * pSVec = ((F64*)sVec);
-      F64 * pTVec = ((F64*)tVec);
+   F64 * pSVec = ((F64*)sVec);
+   F64 * pTVec = ((F64*)tVec);
 
-      Point3D planeNormal;
-      F64 angle;
+   Point3D planeNormal;
+   F64 angle;
 
-      // s
-      pSVec[si] = 1.f;
-      pSVec[ti] = 0.f;
+   // s
+   pSVec[si] = 1.f;
+   pSVec[ti] = 0.f;
 
-      planeNormal = plane.normal;
+   planeNormal = plane.normal;
 
-      ((F64*)planeNormal)[ti] = 0.f;
-      planeNormal.normalize();
+   ((F64*)planeNormal)[ti] = 0.f;
+   planeNormal.normalize();
 
-      angle = mAcos(mClampF(((F64*)planeNormal)[axis], -1.f, 1.f));
-      pSVec[axis] = (((F64*)planeNormal)[si] < 0.f) ? mTan(angle) : -mTan(angle);
+   angle = mAcos(mClampF(((F64*)planeNormal)[axis], -1.f, 1.f));
+   pSVec[axis] = (((F64*)planeNormal)[si] < 0.f) ? mTan(angle) : -mTan(angle);
 
-      // t
-      pTVec[ti] = 1.f;
-      pTVec[si] = 0.f;
+   // t
+   pTVec[ti] = 1.f;
+   pTVec[si] = 0.f;
 
-      planeNormal = plane.normal;
+   planeNormal = plane.normal;
 
-      ((F64*)planeNormal)[si] = 0.f;
-      planeNormal.normalize();
+   ((F64*)planeNormal)[si] = 0.f;
+   planeNormal.normalize();
 
-      angle = mAcos(mClampF(((F64*)planeNormal)[axis], -1.f, 1.f));
-      pTVec[axis] = (((F64*)planeNormal)[ti] < 0.f) ? mTan(angle) : -mTan(angle);
+   angle = mAcos(mClampF(((F64*)planeNormal)[axis], -1.f, 1.f));
+   pTVec[axis] = (((F64*)planeNormal)[ti] < 0.f) ? mTan(angle) : -mTan(angle);
 
-      // scale them
-      sVec *= surface->sgLightingScale;
-      tVec *= surface->sgLightingScale;
+   // scale them
+   sVec *= surface->sgLightingScale;
+   tVec *= surface->sgLightingScale;
 
-      // create all the animated light bitmaps
-      for(U32 j = 0; j < surface->mNumEmitters; j++)
-      {
-         EmitterInfo * emitterInfo = surface->mEmitters[j];
-         Emitter * emitter = mEmitters[emitterInfo->mEmitter];
-         if(!emitter->mAnimated)
-            continue;
+   // create all the animated light bitmaps
+   for(U32 j = 0; j < surface->mNumEmitters; j++)
+   {
+      EmitterInfo * emitterInfo = surface->mEmitters[j];
+      Emitter * emitter = mEmitters[emitterInfo->mEmitter];
+      if(!emitter->mAnimated)
+         continue;
 
-         emitterInfo->mLightMap = new GBitmap(editSurface->lMapDimX, editSurface->lMapDimY, false, GFXFormatA8);
-      }
+      emitterInfo->mLightMap = new GBitmap(editSurface->lMapDimX, editSurface->lMapDimY, false, GFXFormatA8);
+   }
 
-      Point3D & curPos = start;
-      Point3D sRun = sVec * editSurface->lMapDimX;
+   Point3D & curPos = start;
+   Point3D sRun = sVec * editSurface->lMapDimX;
 
-      // get the lexel area
-      Point3D cross;
-      mCross(sVec, tVec, &cross);
-      F64 maxLexelArea = cross.len();
+   // get the lexel area
+   Point3D cross;
+   mCross(sVec, tVec, &cross);
+   F64 maxLexelArea = cross.len();
 
 //      BitMatrix outsideLexels(editSurface->lMapDimX, editSurface->lMapDimY);
 //      outsideLexels.clearAllBits();
 
-      // get the world coordinate for each lexel
-      for(U32 y = 0; y < editSurface->lMapDimY; y++)
+   // get the world coordinate for each lexel
+   for(U32 y = 0; y < editSurface->lMapDimY; y++)
+   {
+      for(U32 x = 0; x < editSurface->lMapDimX; x++)
       {
-         for(U32 x = 0; x < editSurface->lMapDimX; x++)
-         {
-            SVNode * lNode = createNode(SVNode::LexelPlane);
-            lNode->mPlaneIndex = surface->mPlaneIndex;
-            lNode->mWinding->mNumIndices = 4;
+         SVNode * lNode = createNode(SVNode::LexelPlane);
+         lNode->mPlaneIndex = surface->mPlaneIndex;
+         lNode->mWinding->mNumIndices = 4;
 
-            // set the poly indices
-            lNode->mWinding->mIndices[0] = insertLexelPoint(curPos);
-            lNode->mWinding->mIndices[1] = insertLexelPoint(curPos + sVec);
-            lNode->mWinding->mIndices[2] = insertLexelPoint(curPos + sVec + tVec);
-            lNode->mWinding->mIndices[3] = insertLexelPoint(curPos + tVec);
+         // set the poly indices
+         lNode->mWinding->mIndices[0] = insertLexelPoint(curPos);
+         lNode->mWinding->mIndices[1] = insertLexelPoint(curPos + sVec);
+         lNode->mWinding->mIndices[2] = insertLexelPoint(curPos + sVec + tVec);
+         lNode->mWinding->mIndices[3] = insertLexelPoint(curPos + tVec);
 
-            ColorF colSum(0,0,0);
-            Point3F normalSum( 0.0, 0.0, 0.0 );
+         ColorF colSum(0,0,0);
+         Point3F normalSum( 0.0, 0.0, 0.0 );
 
-            // walk the emitters for each that is not shadowed, light it
-            for(U32 j = 0; j < surface->mNumEmitters; j++)
-            {
-               EmitterInfo * emitterInfo = surface->mEmitters[j];
-               Emitter * emitter = mEmitters[emitterInfo->mEmitter];
+         // walk the emitters for each that is not shadowed, light it
+         for(U32 j = 0; j < surface->mNumEmitters; j++)
+         {
+            EmitterInfo * emitterInfo = surface->mEmitters[j];
+            Emitter * emitter = mEmitters[emitterInfo->mEmitter];
 
-               // get the light value
-               RadEmitter *radEmitter = dynamic_cast<RadEmitter*>(emitter);
-               F64 intensity;
-               if( radEmitter )
-               {
-                  intensity = radEmitter->calcIntensity( lNode->getCenter(), plane.normal );
-               }
-               else
-               {
-                  intensity = emitter->calcIntensity(lNode);
-               }
+            // get the light value
+            RadEmitter *radEmitter = dynamic_cast<RadEmitter*>(emitter);
+            F64 intensity;
+            if( radEmitter )
+            {
+               intensity = radEmitter->calcIntensity( lNode->getCenter(), plane.normal );
+            }
+            else
+            {
+               intensity = emitter->calcIntensity(lNode);
+            }
 
-               F64 shadowScale = 1.f;
+            F64 shadowScale = 1.f;
 
-               // calc the normal sum - THIS NEEDS REVISION
-               if( emitter->mBumpSpec )
-               {
-                  Point3D dir = emitter->mPos - lNode->getCenter();
-                  F32 dist = dir.len();
+            // calc the normal sum - THIS NEEDS REVISION
+            if( emitter->mBumpSpec )
+            {
+               Point3D dir = emitter->mPos - lNode->getCenter();
+               F32 dist = dir.len();
 
-                  F64 scale = 400.0 * 400.0 * 400.0 / (dist * dist * dist);
+               F64 scale = 400.0 * 400.0 * 400.0 / (dist * dist * dist);
 
-                  Point3D doubleNorm = Point3D( emitter->mPos - lNode->getCenter() );
-                  Point3F norm( doubleNorm.x, doubleNorm.y, doubleNorm.z );
-                  norm.normalize();
-                  normalSum += norm * scale;
-               }
+               Point3D doubleNorm = Point3D( emitter->mPos - lNode->getCenter() );
+               Point3F norm( doubleNorm.x, doubleNorm.y, doubleNorm.z );
+               norm.normalize();
+               normalSum += norm * scale;
+            }
 
 
-               if(emitterInfo->mShadowed.size())
+            if(emitterInfo->mShadowed.size())
+            {
+               // insert a copy of the lexel node, unless last emitter
+               SVNode * nodeStore = 0;
+               if(j == (surface->mNumEmitters-1))
                {
-                  // insert a copy of the lexel node, unless last emitter
-                  SVNode * nodeStore = 0;
-                  if(j == (surface->mNumEmitters-1))
-                  {
-                     // use the lexel node
-                     nodeStore = lNode;
-                     lNode = 0;
-                  }
-                  else
-                  {
-                     // copy
-                     nodeStore = createNode(SVNode::LexelPlane);
-                     *nodeStore->mWinding = *lNode->mWinding;
-                     nodeStore->mPlaneIndex = lNode->mPlaneIndex;
-                  }
+                  // use the lexel node
+                  nodeStore = lNode;
+                  lNode = 0;
+               }
+               else
+               {
+                  // copy
+                  nodeStore = createNode(SVNode::LexelPlane);
+                  *nodeStore->mWinding = *lNode->mWinding;
+                  nodeStore->mPlaneIndex = lNode->mPlaneIndex;
+               }
 
 //                  // clip the node to own shadow volume
 //                  SVNode * tmp = 0;
@@ -711,94 +767,94 @@ void Lighting::lightSurfaces()
 //                     continue;
 //                  }
 
-                  F64 lexelArea = nodeStore->getWindingSurfaceArea();
+               F64 lexelArea = nodeStore->getWindingSurfaceArea();
 
-                  // clip the lexel node(s) to the shadow volumes
-                  for(U32 k = 0; nodeStore && (k < emitterInfo->mShadowed.size()); k++)
-                  {
-                     SVNode * nodeList = 0;
-                     SVNode * traverse = nodeStore;
+               // clip the lexel node(s) to the shadow volumes
+               for(U32 k = 0; nodeStore && (k < emitterInfo->mShadowed.size()); k++)
+               {
+                  SVNode * nodeList = 0;
+                  SVNode * traverse = nodeStore;
 
-                     while(traverse)
-                     {
-                        SVNode * next = traverse->mFront;
-                        SVNode * currentStore = 0;
+                  while(traverse)
+                  {
+                     SVNode * next = traverse->mFront;
+                     SVNode * currentStore = 0;
 
-                        traverse->clipToVolume(&currentStore, getShadowVolume(emitterInfo->mShadowed[k]));
+                     traverse->clipToVolume(&currentStore, getShadowVolume(emitterInfo->mShadowed[k]));
 
-                        if(currentStore)
-                           currentStore->move(&nodeList);
+                     if(currentStore)
+                        currentStore->move(&nodeList);
 
-                        traverse = next;
-                     }
-                     nodeStore = nodeList;
+                     traverse = next;
                   }
+                  nodeStore = nodeList;
+               }
 
-                  // sum the lexel area of the remaining poly fragments
-                  F64 area = nodeStore ? nodeStore->getWindingSurfaceArea() : 0.f;
-
-                  // clamp it
-                  if(area > lexelArea)
-                     area = lexelArea;
+               // sum the lexel area of the remaining poly fragments
+               F64 area = nodeStore ? nodeStore->getWindingSurfaceArea() : 0.f;
 
-                  // set the scale
-                  shadowScale = area / lexelArea;
-                  recycleNode(nodeStore);
-               }
+               // clamp it
+               if(area > lexelArea)
+                  area = lexelArea;
 
-               // fill in animated light here...
-               if(emitterInfo->mLightMap)
-               {
-                  *(emitterInfo->mLightMap->getAddress(x,y)) = U8(intensity * shadowScale * 255.f);
-               }
-               else if(shadowScale != 0.f)
-               {
-                  ColorF col = emitter->mColor;
-                  col *= intensity;
-                  col *= shadowScale;
-                  colSum += col;
-                  colSum.clamp();
-               }
+               // set the scale
+               shadowScale = area / lexelArea;
+               recycleNode(nodeStore);
             }
 
-            //
-            recycleNode(lNode);
+            // fill in animated light here...
+            if(emitterInfo->mLightMap)
+            {
+               *(emitterInfo->mLightMap->getAddress(x,y)) = U8(intensity * shadowScale * 255.f);
+            }
+            else if(shadowScale != 0.f)
+            {
+               ColorF col = emitter->mColor;
+               col *= intensity;
+               col *= shadowScale;
+               colSum += col;
+               colSum.clamp();
+            }
+         }
 
-            // set the col
-            U8 * pDest = editSurface->pLMap->getAddress(x,y);
+         //
+         recycleNode(lNode);
 
-            // add in the ambient...
-            if(!(editSurface->flags & Interior::SurfaceOutsideVisible))
-               colSum += mAmbientColor;
+         // set the col
+         U8 * pDest = editSurface->pLMap->getAddress(x,y);
 
-            colSum.clamp();
+         // add in the ambient...
+         if(!(editSurface->flags & Interior::SurfaceOutsideVisible))
+            colSum += mAmbientColor;
 
-            pDest[0] = U8(colSum.red   * 255.f);
-            pDest[1] = U8(colSum.green * 255.f);
-            pDest[2] = U8(colSum.blue  * 255.f);
+         colSum.clamp();
 
+         pDest[0] = U8(colSum.red   * 255.f);
+         pDest[1] = U8(colSum.green * 255.f);
+         pDest[2] = U8(colSum.blue  * 255.f);
 
-            // set the norm
-            normalSum.normalizeSafe();
-            editSurface->texSpace.mulV( normalSum );
 
-            U8 * normMap = editSurface->pLightDirMap->getAddress(x,y);
-            normMap[0] = 127 + normalSum.x * 128;
-            normMap[1] = 127 + normalSum.y * 128;
-            normMap[2] = 127 + normalSum.z * 128;
+         // set the norm
+         normalSum.normalizeSafe();
+         editSurface->texSpace.mulV( normalSum );
 
+         U8 * normMap = editSurface->pLightDirMap->getAddress(x,y);
+         normMap[0] = 127 + normalSum.x * 128;
+         normMap[1] = 127 + normalSum.y * 128;
+         normMap[2] = 127 + normalSum.z * 128;
 
 
-            //
-            flushLexelPoints();
-            curPos += sVec;
-         }
 
          //
-         curPos -= sRun;
-         curPos += tVec;
+         flushLexelPoints();
+         curPos += sVec;
       }
 
+      //
+      curPos -= sRun;
+      curPos += tVec;
+   }
+
 //      // filter the outside lexels
 //      static F32 filterTable[3][3] =
 //         {{1, 2, 1},
@@ -851,37 +907,36 @@ void Lighting::lightSurfaces()
 //         }
 
 #ifdef DUMP_LIGHTMAPS
-      //
-      static U32 majCnt = 0;
-      U32 minCnt = 0;
-      for(U32 j = 0; j < surface->mNumEmitters; j++)
-      {
-         EmitterInfo * emitterInfo = surface->mEmitters[j];
+   //
+   static U32 majCnt = 0;
+   U32 minCnt = 0;
+   for(U32 j = 0; j < surface->mNumEmitters; j++)
+   {
+      EmitterInfo * emitterInfo = surface->mEmitters[j];
 
-         if(emitterInfo->mLightMap)
-         {
-            // convert the intensity bitmap to RGB
-            GBitmap bitmap(emitterInfo->mLightMap->getWidth(), emitterInfo->mLightMap->getHeight());
-            for(U32 y = 0; y < emitterInfo->mLightMap->getHeight(); y++)
-               for(U32 x = 0; x < emitterInfo->mLightMap->getWidth(); x++)
-               {
-                  U8 * pDest = bitmap.getAddress(x, y);
-                  U8 src = *emitterInfo->mLightMap->getAddress(x, y);
+      if(emitterInfo->mLightMap)
+      {
+         // convert the intensity bitmap to RGB
+         GBitmap bitmap(emitterInfo->mLightMap->getWidth(), emitterInfo->mLightMap->getHeight());
+         for(U32 y = 0; y < emitterInfo->mLightMap->getHeight(); y++)
+            for(U32 x = 0; x < emitterInfo->mLightMap->getWidth(); x++)
+            {
+               U8 * pDest = bitmap.getAddress(x, y);
+               U8 src = *emitterInfo->mLightMap->getAddress(x, y);
 
-                  *pDest++ = src;
-                  *pDest++ = src;
-                  *pDest++ = src;
-               }
+               *pDest++ = src;
+               *pDest++ = src;
+               *pDest++ = src;
+            }
 
-            //
-            FileStream output;
-            output.open(avar("lightmap_%d_%d.png", majCnt, minCnt++), FileStream::Write);
-            bitmap.writePNG(output);
-         }
+         //
+         FileStream output;
+         output.open(avar("lightmap_%d_%d.png", majCnt, minCnt++), FileStream::Write);
+         bitmap.writePNG(output);
       }
-      majCnt++;
-#endif
    }
+   majCnt++;
+#endif
 }
 
 //------------------------------------------------------------------------------
@@ -890,10 +945,11 @@ void Lighting::lightSurfaces()
 
 Lighting::MiniWinding * Lighting::createWinding()
 {
-   if(mWindingStore)
+   Workspace & workspace = getWorkspace();
+   if(workspace.mWindingStore)
    {
-      MiniWinding * winding = mWindingStore;
-      mWindingStore = mWindingStore->mNext;
+      MiniWinding * winding = workspace.mWindingStore;
+      workspace.mWindingStore = workspace.mWindingStore->mNext;
 
       //
       winding->mNumIndices = 0;
@@ -901,7 +957,7 @@ Lighting::MiniWinding * Lighting::createWinding()
    }
 
    // create it
-   MiniWinding * winding = mWindingChunker.alloc();
+   MiniWinding * winding = workspace.mWindingChunker.alloc();
    winding->mNumIndices = 0;
    return(winding);
 }
@@ -912,8 +968,9 @@ void Lighting::recycleWinding(MiniWinding * winding)
       return;
 
    // add to head
-   winding->mNext = mWindingStore;
-   mWindingStore = winding;
+   Workspace & workspace = getWorkspace();
+   winding->mNext = workspace.mWindingStore;
+   workspace.mWindingStore = winding;
 }
 
 void Lighting::recycleNode(SVNode * node)
@@ -933,8 +990,9 @@ void Lighting::recycleNode(SVNode * node)
    node->mWinding = 0;
 
    // add
-   node->mBack = mNodeRepository;
-   mNodeRepository = node;
+   Workspace & workspace = getWorkspace();
+   node->mBack = workspace.mNodeRepository;
+   workspace.mNodeRepository = node;
 }
 
 //-------------------------------------------------------------------
@@ -942,10 +1000,11 @@ void Lighting::recycleNode(SVNode * node)
 Lighting::SVNode * Lighting::createNode(SVNode::Type type)
 {
    // try to get a recycled node first...
-   if(mNodeRepository)
+   Workspace & workspace = getWorkspace();
+   if(workspace.mNodeRepository)
    {
-      SVNode * node = mNodeRepository;
-      mNodeRepository = mNodeRepository->mBack;
+      SVNode * node = workspace.mNodeRepository;
+      workspace.mNodeRepository = workspace.mNodeRepository->mBack;
 
       //
       node->mType = type;
@@ -959,7 +1018,7 @@ Lighting::SVNode * Lighting::createNode(SVNode::Type type)
    }
 
    // create the node
-   SVNode * node = mNodeChunker.alloc();
+   SVNode * node = workspace.mNodeChunker.alloc();
    node->mFront = node->mBack = 0;
    node->mTarget = 0;
    node->mEmitterInfo = 0;
@@ -1490,7 +1549,7 @@ bool Lighting::SVNode::clipWindingToPlaneFront(U32 planeEQIndex)
    // valid point indices?
    for(U32 i = 0; i < mWinding->mNumIndices; i++)
    {
-      U32 size = mType == LexelPlane ? gWorkingLighting->mLexelPoints.size() :
+      U32 size = mType == LexelPlane ? gWorkingLighting->getWorkspace().mLexelPoints.size() :
          gWorkingGeometry->mPoints.size();
       AssertFatal(mWinding->mIndices[i] < size, "Lighting::SVNode::clipWindingToPlaneFront: invalid point index");
    }
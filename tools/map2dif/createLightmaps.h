@@ -111,16 +111,30 @@ class Lighting
       MiniWinding * createWinding();
       void recycleWinding(MiniWinding *);
 
-      Chunker<MiniWinding>    mWindingChunker;
-      MiniWinding *           mWindingStore;
-
-      //
-      Chunker<SVNode> mNodeChunker;
-      SVNode * mNodeRepository;
-
       SVNode * createNode(SVNode::Type type);
       void recycleNode(SVNode * node);
 
+      // node, winding and lexel point stores - surfaces may be lit on
+      // several threads at once, each of which works out of its own
+      // workspace (the shadow volumes are only read while lighting)
+      class Workspace
+      {
+         public:
+            Chunker<MiniWinding>    mWindingChunker;
+            MiniWinding *           mWindingStore;
+
+            Chunker<SVNode>         mNodeChunker;
+            SVNode *                mNodeRepository;
+
+            Vector<Point3D>         mLexelPoints;
+
+            Workspace() : mWindingStore(0), mNodeRepository(0) {}
+      };
+      Workspace                        mWorkspace;
+      static thread_local Workspace *  smThreadWorkspace;
+
+      Workspace & getWorkspace() { return(smThreadWorkspace ? *smThreadWorkspace : mWorkspace); }
+
       class Surface
       {
          public:
@@ -252,6 +266,7 @@ class Lighting
       void createShadowVolumes();
       void processEmitterBSPs();
       void lightSurfaces();
+      void lightSurface(U32 index);
       void processAnimatedLights();
 
       //
@@ -270,7 +285,6 @@ class Lighting
       //F64 getLumelScale(Surface &surf);
 
       //
-      Vector<Point3D> mLexelPoints;
       U32 mNumAmbiguousPlanes;
 
       const Point3D & getLexelPoint(U32 index);
@@ -6,7 +6,7 @@
 
 #include "gfx/gBitmap.h"
 #include "map2dif/csgBrush.h"
-#include "map2dif/tokenizer.h"
+#include "core/tokenizer.h"
 
 extern int gQuakeVersion;
 
@@ -472,6 +472,8 @@ bool CSGBrush::selfClip()
    AssertISV(mPlanes.size() < VectorBufferSize,
              "CSGBrush::selfClip: talk to Dave Moore.  Must increase planepoint buffer size");
 
+   mAssessments.clear();
+
    for (U32 i = 0; i < mPlanes.size(); i++) {
       for (U32 j = i+1; j < mPlanes.size(); j++) {
          for (U32 k = j+1; k < mPlanes.size(); k++) {
@@ -92,6 +92,11 @@ class CSGBrush
 
    CSGBrush* pNext;
 
+   // assessPlane() results, sorted by plane, packed as
+   //  ((planeEQIndex >> 1) << 8) | PlaneAssessment flags.  Cleared whenever
+   //  the windings are rebuilt.
+   Vector<U32> mAssessments;
+
   public:
    CSGPlane& constructBrushPlane(const Point3I& rPoint1,
                                  const Point3I& rPoint2,
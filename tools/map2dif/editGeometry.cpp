@@ -5,7 +5,7 @@
 
 #include "map2dif/editGeometry.h"
 #include "map2dif/entityTypes.h"
-#include "map2dif/tokenizer.h"
+#include "core/tokenizer.h"
 #include "map2dif/csgBrush.h"
 #include "map2dif/lmapPacker.h"
 
@@ -15,6 +15,7 @@
 #include "math/mMath.h"
 #include "core/bitVector.h"
 #include "core/fileStream.h"
+#include "platform/threadPool.h"
 
 extern bool gVerbose;
 extern const char* gWadPath;
@@ -50,7 +51,20 @@ namespace {
       dFflushStdout();
    }
 
-   GBitmap* loadBitmap(const char* file)
+   GBitmap* transposeBitmap(GBitmap* pSrc)
+   {
+      GBitmap* pDst = new GBitmap(pSrc->getHeight(), pSrc->getWidth(), false, pSrc->getFormat());
+      for(U32 y = 0; y < pSrc->getHeight(); y++)
+      {
+         for(U32 x = 0; x < pSrc->getWidth(); x++)
+            dMemcpy(pDst->getAddress(y, x), pSrc->getAddress(x, y), pSrc->bytesPerPixel);
+      }
+
+      delete pSrc;
+      return pDst;
+   }
+
+   GBitmap* loadBitmap(const char* file, StringTableEntry* pLoadedFrom)
    {
       FileStream loadStream;
       int len = dStrlen(file);
@@ -68,6 +82,7 @@ namespace {
          {
             AssertISV(false,avar("Bad PNG file: %s.\n", file));
          }
+         *pLoadedFrom = StringTable->insert(buf);
          return bitmap;
       }
 
@@ -81,6 +96,7 @@ namespace {
          {
             AssertISV(false,avar("Bad JPEG file: %s.\n", file));
          }
+         *pLoadedFrom = StringTable->insert(buf);
          return bitmap;
       }
 
@@ -106,7 +122,7 @@ namespace {
             {
                parent[1] = 0;
                dStrcat(buf, name);
-               return loadBitmap(buf);
+               return loadBitmap(buf, pLoadedFrom);
             }
          }
       }
@@ -559,12 +575,15 @@ const char* EditGeometry::insertTexture(const char* pInsert)
    {
       char loadBuffer[1024];
       GBitmap* pNewBitmap;
+      StringTableEntry loadedFrom = NULL;
 
       // Look in the dir + wadname.  The load function will search
       // back up the path.
       dSprintf(loadBuffer,sizeof(loadBuffer),"%s%s%s",
                gWadPath, mWorldEntity->mWadPrefix, pCopy);
-      pNewBitmap = loadBitmap(loadBuffer);
+      pNewBitmap = loadBitmap(loadBuffer, &loadedFrom);
+      if(loadedFrom)
+         mTextureFiles.push_back(loadedFrom);
 
       //
       if(pNewBitmap)
@@ -727,24 +746,47 @@ U32 EditGeometry::insertPoint(const Point3D& rPoint)
 //------------------------------------------------------------------------------
 bool EditGeometry::createBSP()
 {
+   dMemset(&gBSPBuildStats, 0, sizeof(gBSPBuildStats));
+   U32 startTime = Platform::getRealMilliseconds();
+
    createBrushPolys();
+   gBSPBuildStats.csgTime = Platform::getRealMilliseconds() - startTime;
 
-   buildBSP();
+   // Candidate split planes are rated on a pool, the main thread helps out
+   extern U32 gNumThreads;
+   U32 numThreads = gNumThreads ? gNumThreads : (ThreadPool::getDefaultNumThreads() + 1);
+   if(numThreads > 1)
+      EditBSPNode::smRatingPool = new ThreadPool(numThreads - 1);
 
-   if(gVerbose)
-   {
-      U32 totalLeaves    = 0;
-      U32 totalLeafDepth = 0;
-      U32 maxLeafDepth   = 0;
-      mBSPRoot->gatherBSPStats(&totalLeaves, &totalLeafDepth, &maxLeafDepth, 0);
+   startTime = Platform::getRealMilliseconds();
 
-      dPrintf("     * BSP Stats\n"
-              "        Total Nodes:  %d\n"
-              "        (Av./Max) Depth: %g / %d\n", (mNodeArena.mBuffers.size() - 1) * mNodeArena.arenaSize + mNodeArena.currPosition,
-              F32(totalLeafDepth) / F32(totalLeaves),
-              maxLeafDepth);
-      flushedOutput("\n");
-   }
+   buildBSP();
+
+   gBSPBuildStats.bspTime = Platform::getRealMilliseconds() - startTime;
+   delete EditBSPNode::smRatingPool;
+   EditBSPNode::smRatingPool = NULL;
+
+   // Always reported, so the speed and quality of the plane selection
+   //  options can be compared
+   U32 totalLeaves    = 0;
+   U32 totalLeafDepth = 0;
+   U32 maxLeafDepth   = 0;
+   mBSPRoot->gatherBSPStats(&totalLeaves, &totalLeafDepth, &maxLeafDepth, 0);
+
+   dPrintf("     * BSP Stats\n"
+           "        Build Time:   %g s\n"
+           "        Total Nodes:  %d\n"
+           "        (Av./Max) Depth: %g / %d\n"
+           "        Planes Rated: %d\n"
+           "        Brush Assessments: %d (%d cached)\n",
+           F32(gBSPBuildStats.bspTime) / 1000.0f,
+           (mNodeArena.mBuffers.size() - 1) * mNodeArena.arenaSize + mNodeArena.currPosition,
+           F32(totalLeafDepth) / F32(totalLeaves),
+           maxLeafDepth,
+           gBSPBuildStats.planesRated,
+           gBSPBuildStats.assessments,
+           gBSPBuildStats.cachedAssessments);
+   flushedOutput("\n");
 
    return true;
 }
@@ -1877,6 +1919,35 @@ void EditGeometry::sortLitSurfaces()
 }
 
 
+//------------------------------------------------------------------------------
+// The packer placed this surface's light maps transposed.  Swap the light map
+//  axes of the surface to match.
+void EditGeometry::rotateSurfaceLMaps(Surface& rSurface)
+{
+   U32 iTemp = rSurface.lMapDimX;
+   rSurface.lMapDimX = rSurface.lMapDimY;
+   rSurface.lMapDimY = iTemp;
+   rSurface.lmapTexGenSwapped = !rSurface.lmapTexGenSwapped;
+
+   F32 fTemp;
+   for(U32 i = 0; i < 4; i++)
+   {
+      fTemp = rSurface.lmapTexGenX[i];
+      rSurface.lmapTexGenX[i] = rSurface.lmapTexGenY[i];
+      rSurface.lmapTexGenY[i] = fTemp;
+   }
+   fTemp = rSurface.tempScale[0];
+   rSurface.tempScale[0] = rSurface.tempScale[1];
+   rSurface.tempScale[1] = fTemp;
+
+   if(rSurface.pNormalLMap)
+      rSurface.pNormalLMap = transposeBitmap(rSurface.pNormalLMap);
+   if(rSurface.pAlarmLMap)
+      rSurface.pAlarmLMap = transposeBitmap(rSurface.pAlarmLMap);
+   if(rSurface.pLightDirMap)
+      rSurface.pLightDirMap = transposeBitmap(rSurface.pLightDirMap);
+}
+
 //------------------------------------------------------------------------------
 void EditGeometry::packLMaps()
 {
@@ -1946,8 +2017,8 @@ void EditGeometry::packLMaps()
             rSurface.offsetX         = rEntry.x + SG_LIGHTMAP_BORDER_SIZE;
             rSurface.offsetY         = rEntry.y + SG_LIGHTMAP_BORDER_SIZE;
 
-            AssertFatal(U32(rSurface.lMapDimX) == U32(rEntry.width - (SG_LIGHTMAP_BORDER_SIZE * 2)) &&
-                U32(rSurface.lMapDimY) == U32(rEntry.height - (SG_LIGHTMAP_BORDER_SIZE * 2)),
+            AssertFatal(U32(rSurface.lMapDimX) == U32((rEntry.rotated ? rEntry.height : rEntry.width) - (SG_LIGHTMAP_BORDER_SIZE * 2)) &&
+                U32(rSurface.lMapDimY) == U32((rEntry.rotated ? rEntry.width : rEntry.height) - (SG_LIGHTMAP_BORDER_SIZE * 2)),
                         "Internal Error: Something got mixed up here");
          }
          for(U32 i = 0; i < pManager->m_sheets.size(); i++)
@@ -1983,8 +2054,8 @@ void EditGeometry::packLMaps()
             rSurface.offsetX         = rEntry.x + SG_LIGHTMAP_BORDER_SIZE;
             rSurface.offsetY         = rEntry.y + SG_LIGHTMAP_BORDER_SIZE;
 
-            AssertFatal(U32(rSurface.lMapDimX) == U32(rEntry.width - (SG_LIGHTMAP_BORDER_SIZE * 2)) &&
-                U32(rSurface.lMapDimY) == U32(rEntry.height - (SG_LIGHTMAP_BORDER_SIZE * 2)),
+            AssertFatal(U32(rSurface.lMapDimX) == U32((rEntry.rotated ? rEntry.height : rEntry.width) - (SG_LIGHTMAP_BORDER_SIZE * 2)) &&
+                U32(rSurface.lMapDimY) == U32((rEntry.rotated ? rEntry.width : rEntry.height) - (SG_LIGHTMAP_BORDER_SIZE * 2)),
                         "Internal Error: Something got mixed up here");
          }
          for(U32 i = 0; i < pManager->m_sheets.size(); i++)
@@ -1992,6 +2063,15 @@ void EditGeometry::packLMaps()
             mLightDirMaps.push_back(new GBitmap(*pManager->m_sheets[i].pData));
          }
 
+         // Both passes packed the same sizes, so the layouts match.  Now
+         //  that both are placed, turn the rotated surfaces to match.
+         for(U32 j = 0; j < surfaceLists[i].size(); j++)
+         {
+            Surface& rSurface = mSurfaces[(surfaceLists[i])[j]];
+            if(pManager->m_lightMaps[j].rotated)
+               rotateSurfaceLMaps(rSurface);
+         }
+
          delete pManager;
       }
 
@@ -2054,8 +2134,11 @@ void EditGeometry::packLMaps()
             rSurface.offsetX         = rEntry.x;
             rSurface.offsetY         = rEntry.y;
 
-            AssertFatal(U32(rSurface.lMapDimX) == U32(rEntry.width) && U32(rSurface.lMapDimY) == U32(rEntry.height),
+            AssertFatal(U32(rSurface.lMapDimX) == U32(rEntry.rotated ? rEntry.height : rEntry.width) &&
+                        U32(rSurface.lMapDimY) == U32(rEntry.rotated ? rEntry.width : rEntry.height),
                         "Internal Error: Something got mixed up here");
+            if(rEntry.rotated)
+               rotateSurfaceLMaps(rSurface);
          }
          for(U32 i = 0; i < pManager->m_sheets.size(); i++)
             mLightmaps.push_back(new GBitmap(*pManager->m_sheets[i].pData));
@@ -2086,8 +2169,11 @@ void EditGeometry::packLMaps()
             rSurface.offsetX         = rEntry.x;
             rSurface.offsetY         = rEntry.y;
 
-            AssertFatal(U32(rSurface.lMapDimX) == U32(rEntry.width) && U32(rSurface.lMapDimY) == U32(rEntry.height),
+            AssertFatal(U32(rSurface.lMapDimX) == U32(rEntry.rotated ? rEntry.height : rEntry.width) &&
+                        U32(rSurface.lMapDimY) == U32(rEntry.rotated ? rEntry.width : rEntry.height),
                         "Internal Error: Something got mixed up here");
+            if(rEntry.rotated)
+               rotateSurfaceLMaps(rSurface);
          }
          for(U32 i = 0; i < pManager->m_sheets.size(); i++)
          {
@@ -245,6 +245,7 @@ class EditGeometry
 
    Vector<char*>     mTextureNames;
    Vector<GBitmap*>  mTextures;
+   Vector<StringTableEntry> mTextureFiles;   // Files the textures were loaded from
 
    Vector<Portal*>   mPortals;
    Vector<Zone*>     mZones;
@@ -395,9 +396,11 @@ class EditGeometry
    void createSurfaces();
    void markEmptyZones();
    void packLMaps();
+   void rotateSurfaceLMaps(Surface& rSurface);
    void computeLightmaps(const bool alarmMode);
 
    bool exportToRuntime(Interior*, InteriorResource*);
+   static void resetUnnamedLights();
 
    U16  getMaterialIndex(const char* texName) const;
 
@@ -4,7 +4,7 @@
 //-----------------------------------------------------------------------------
 
 #include "map2dif/entityTypes.h"
-#include "map2dif/tokenizer.h"
+#include "core/tokenizer.h"
 #include "map2dif/csgBrush.h"
 #include "interior/interior.h"
 #include "map2dif/morianUtil.h"
@@ -10,9 +10,10 @@
 
 #include "map2dif/editGeometry.h"
 #include "map2dif/entityTypes.h"
-#include "map2dif/tokenizer.h"
+#include "core/tokenizer.h"
 #include "map2dif/csgBrush.h"
 #include "map2dif/editInteriorRes.h"
+#include "map2dif/lmapPacker.h"
 
 #include "interior/interior.h"
 #include "gfx/gBitmap.h"
@@ -25,6 +26,9 @@
 #include "interior/interiorResObjects.h"
 #include "interior/forceField.h"
 
+// Numbers the UNNAMED_ animated lights across the detail levels of an interior
+static U32 sUnnamedLight = 0;
+
 
 //------------------------------------------------------------------------------
 enum PointClassification {
@@ -797,10 +801,13 @@ void EditGeometry::dumpSurfaceToRuntime(Interior* pRuntime,
    rSurface.windingCount = pRuntime->mWindingIndices.last().windingCount;
    pRuntime->mWindingIndices.decrement();
 
-   AssertFatal(editSurface.lMapDimX < 256 && editSurface.lMapDimY < 256,
-               "Error, lightmap too large to fit into 8 bits!");
-   AssertFatal(editSurface.offsetX < 256 && editSurface.offsetY < 256,
-               "Error, lightmap too large to fit into 8 bits! (Plus, that's just plain wierd)");
+   // Light maps and their offsets are U32s in the runtime surface, the sheet
+   //  they were packed on is what bounds them
+   const U32 sheetSize = SheetManager::smSheetSize;
+   AssertFatal(editSurface.lMapDimX < sheetSize && editSurface.lMapDimY < sheetSize,
+               avar("Error, lightmap larger than the %d x %d light map sheet!", sheetSize, sheetSize));
+   AssertFatal(editSurface.offsetX < sheetSize && editSurface.offsetY < sheetSize,
+               avar("Error, lightmap offset outside the %d x %d light map sheet!", sheetSize, sheetSize));
 
    rSurface.lightCount          = editSurface.numLights;
    rSurface.lightStateInfoStart = editSurface.stateDataStart;
@@ -1272,6 +1279,11 @@ void EditGeometry::postProcessLighting(Interior* pRuntime)
 }
 
 
+void EditGeometry::resetUnnamedLights()
+{
+   sUnnamedLight = 0;
+}
+
 void EditGeometry::exportLightsToRuntime(Interior* pRuntime)
 {
    postProcessLighting(pRuntime);
@@ -1285,7 +1297,6 @@ void EditGeometry::exportLightsToRuntime(Interior* pRuntime)
       rILight.nameIndex = pRuntime->mNameBuffer.size();
 
       if (pLight->name == NULL) {
-         static U32 sUnnamedLight = 0;
          pLight->name = new char[128];
          dSprintf(pLight->name, 127, "UNNAMED_%d", sUnnamedLight++);
 
@@ -9,14 +9,171 @@
 /* for FN_CDECL defs */
 #include "platform/types.h"
 
-const U32 SheetManager::csm_sheetSize = 256;
+U32 SheetManager::smSheetSize        = 256;
+U32 SheetManager::smTotalSheets      = 0;
+U32 SheetManager::smTotalPixels      = 0;
+U32 SheetManager::smTotalSheetPixels = 0;
 
+namespace {
+
+struct PackRect {
+   S32 x, y;
+   S32 width, height;
+};
+
+inline bool rectContains(const PackRect& outer, const PackRect& inner)
+{
+   return inner.x >= outer.x && inner.y >= outer.y &&
+          inner.x + inner.width  <= outer.x + outer.width &&
+          inner.y + inner.height <= outer.y + outer.height;
+}
+
+//------------------------------------------------------------------------------
+// MaxRects bin.  Keeps a list of every maximal free rectangle, places each
+//  new rectangle where it leaves the shortest leftover side, and splits the
+//  free rectangles it overlaps.
+//
+class MaxRectsBin
+{
+  public:
+   MaxRectsBin(const U32 sizeX, const U32 sizeY);
+
+   bool insert(const U32 width, const U32 height, PackRect* pPlaced, bool* pRotated);
+
+  private:
+   Vector<PackRect> mFreeRects;
+
+   void placeRect(const PackRect& used);
+   bool splitFreeRect(const PackRect freeRect, const PackRect& used);
+   void pruneFreeList();
+};
+
+MaxRectsBin::MaxRectsBin(const U32 sizeX, const U32 sizeY)
+{
+   mFreeRects.increment();
+   mFreeRects.last().x      = 0;
+   mFreeRects.last().y      = 0;
+   mFreeRects.last().width  = sizeX;
+   mFreeRects.last().height = sizeY;
+}
+
+bool MaxRectsBin::insert(const U32 width, const U32 height, PackRect* pPlaced, bool* pRotated)
+{
+   S32 bestShort = S32_MAX;
+   S32 bestLong  = S32_MAX;
+   S32 bestIndex = -1;
+   bool bestRotated = false;
+
+   for (U32 i = 0; i < mFreeRects.size(); i++) {
+      const PackRect& rFree = mFreeRects[i];
+
+      for (U32 rot = 0; rot < 2; rot++) {
+         if (rot == 1 && width == height)
+            break;
+
+         S32 w = rot ? height : width;
+         S32 h = rot ? width  : height;
+         if (w > rFree.width || h > rFree.height)
+            continue;
+
+         S32 leftoverX = rFree.width  - w;
+         S32 leftoverY = rFree.height - h;
+         S32 shortSide = getMin(leftoverX, leftoverY);
+         S32 longSide  = getMax(leftoverX, leftoverY);
+         if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong)) {
+            bestShort   = shortSide;
+            bestLong    = longSide;
+            bestIndex   = i;
+            bestRotated = rot == 1;
+         }
+      }
+   }
+
+   if (bestIndex == -1)
+      return false;
+
+   pPlaced->x      = mFreeRects[bestIndex].x;
+   pPlaced->y      = mFreeRects[bestIndex].y;
+   pPlaced->width  = bestRotated ? height : width;
+   pPlaced->height = bestRotated ? width  : height;
+   *pRotated       = bestRotated;
+
+   placeRect(*pPlaced);
+   return true;
+}
+
+void MaxRectsBin::placeRect(const PackRect& used)
+{
+   // Split pieces are appended, so walking down only visits the old ones
+   for (S32 i = S32(mFreeRects.size()) - 1; i >= 0; i--) {
+      if (splitFreeRect(mFreeRects[i], used))
+         mFreeRects.erase(i);
+   }
+
+   pruneFreeList();
+}
+
+// Adds the parts of freeRect not covered by used.  Returns false if they
+//  don't overlap.  freeRect is a copy, mFreeRects may grow under it.
+bool MaxRectsBin::splitFreeRect(const PackRect freeRect, const PackRect& used)
+{
+   if (used.x >= freeRect.x + freeRect.width  || used.x + used.width  <= freeRect.x ||
+       used.y >= freeRect.y + freeRect.height || used.y + used.height <= freeRect.y)
+      return false;
+
+   PackRect piece;
+   if (used.x > freeRect.x) {
+      piece        = freeRect;
+      piece.width  = used.x - freeRect.x;
+      mFreeRects.push_back(piece);
+   }
+   if (used.x + used.width < freeRect.x + freeRect.width) {
+      piece        = freeRect;
+      piece.x      = used.x + used.width;
+      piece.width  = freeRect.x + freeRect.width - piece.x;
+      mFreeRects.push_back(piece);
+   }
+   if (used.y > freeRect.y) {
+      piece        = freeRect;
+      piece.height = used.y - freeRect.y;
+      mFreeRects.push_back(piece);
+   }
+   if (used.y + used.height < freeRect.y + freeRect.height) {
+      piece        = freeRect;
+      piece.y      = used.y + used.height;
+      piece.height = freeRect.y + freeRect.height - piece.y;
+      mFreeRects.push_back(piece);
+   }
+
+   return true;
+}
+
+void MaxRectsBin::pruneFreeList()
+{
+   // Drop free rectangles that lie inside another one
+   for (S32 i = 0; i < mFreeRects.size(); i++) {
+      for (S32 j = i + 1; j < mFreeRects.size(); j++) {
+         if (rectContains(mFreeRects[j], mFreeRects[i])) {
+            mFreeRects.erase(i);
+            i--;
+            break;
+         }
+         if (rectContains(mFreeRects[i], mFreeRects[j])) {
+            mFreeRects.erase(j);
+            j--;
+         }
+      }
+   }
+}
+
+} // namespace
+
+
+//------------------------------------------------------------------------------
 SheetManager::SheetManager()
 {
-   m_currSheet = -1;
-   m_currX     = 0;
-   m_currY     = 0;
-   m_lowestY   = 0;
+   numPixels      = 0;
+   numSheetPixels = 0;
 }
 
 SheetManager::~SheetManager()
@@ -26,10 +183,16 @@ SheetManager::~SheetManager()
       m_sheets[i].pData = NULL;
    }
 
-   m_currSheet = -1;
-   m_currX     = 0;
-   m_currY     = 0;
-   m_lowestY   = 0;
+   for (U32 i = 0; i < m_stagedMaps.size(); i++)
+      delete m_stagedMaps[i];
+}
+
+void
+SheetManager::resetStats()
+{
+   smTotalSheets      = 0;
+   smTotalPixels      = 0;
+   smTotalSheetPixels = 0;
 }
 
 void
@@ -39,19 +202,103 @@ SheetManager::begin()
    numSheetPixels = 0;
 }
 
+
+SheetManager* g_pManager = NULL;
+
+// Longest side first, then shortest side, then entry order
+S32 FN_CDECL
+compMapSize(const void* in_p1, const void* in_p2)
+{
+   const S32* p1 = (const S32*)in_p1;
+   const S32* p2 = (const S32*)in_p2;
+
+   const SheetManager::LightMapEntry& rEntry1 = g_pManager->getLightmap(*p1);
+   const SheetManager::LightMapEntry& rEntry2 = g_pManager->getLightmap(*p2);
+
+   S32 long1  = getMax(rEntry1.width, rEntry1.height);
+   S32 long2  = getMax(rEntry2.width, rEntry2.height);
+   S32 short1 = getMin(rEntry1.width, rEntry1.height);
+   S32 short2 = getMin(rEntry2.width, rEntry2.height);
+
+   if (long1 != long2)
+      return long2 - long1;
+   if (short1 != short2)
+      return short2 - short1;
+   return *p1 - *p2;
+}
+
+// Smallest area first, then the squarest, then the narrowest
+S32 FN_CDECL
+compSheetSize(const void* in_p1, const void* in_p2)
+{
+   const Point2I* p1 = (const Point2I*)in_p1;
+   const Point2I* p2 = (const Point2I*)in_p2;
+
+   S32 area1 = p1->x * p1->y;
+   S32 area2 = p2->x * p2->y;
+   if (area1 != area2)
+      return area1 - area2;
+
+   S32 aspect1 = getMax(p1->x, p1->y) / getMin(p1->x, p1->y);
+   S32 aspect2 = getMax(p2->x, p2->y) / getMin(p2->x, p2->y);
+   if (aspect1 != aspect2)
+      return aspect1 - aspect2;
+
+   return p1->x - p2->x;
+}
+
 void
 SheetManager::end()
 {
-   repackBlock();
+   AssertISV(isPow2(smSheetSize) && smSheetSize >= 32, "Light map sheet size must be a power of two");
+
+   Vector<S32> remaining;
+   for (U32 i = 0; i < m_lightMaps.size(); i++)
+      remaining.push_back(i);
 
-//   dPrintf("\n\n"
-//           "  Total Pixels: %d\n"
-//           "  Total SheetP: %d\n"
-//           "  Efficiency:   %g\n\n", numPixels, numSheetPixels, F32(numPixels)/F32(numSheetPixels));
+   g_pManager = this;
+   dQsort(remaining.address(), remaining.size(), sizeof(S32), compMapSize);
+   g_pManager = NULL;
 
-   m_currY      =
-      m_lowestY = csm_sheetSize + 1;
-   m_currSheet  = -1;
+   // Candidate sizes for the last sheet, smallest first
+   Vector<Point2I> sizes;
+   for (U32 x = 32; x <= smSheetSize; x <<= 1) {
+      for (U32 y = 32; y <= smSheetSize; y <<= 1)
+         sizes.push_back(Point2I(x, y));
+   }
+   dQsort(sizes.address(), sizes.size(), sizeof(Point2I), compSheetSize);
+
+   while (remaining.size() != 0) {
+      U32 remainingPixels = 0;
+      for (U32 i = 0; i < remaining.size(); i++)
+         remainingPixels += getLightmap(remaining[i]).width * getLightmap(remaining[i]).height;
+
+      // Does everything left fit on one sheet?
+      bool packed = false;
+      for (U32 i = 0; i < sizes.size() && !packed; i++) {
+         if (U32(sizes[i].x * sizes[i].y) >= remainingPixels &&
+             doesFit(remaining, sizes[i].x, sizes[i].y)) {
+            packSheet(remaining, sizes[i].x, sizes[i].y, false);
+            packed = true;
+         }
+      }
+
+      if (packed == false) {
+         // Fill up a full sized sheet, then keep going
+         U32 numBefore = remaining.size();
+         packSheet(remaining, smSheetSize, smSheetSize, true);
+         AssertISV(remaining.size() < numBefore,
+                   avar("Light map does not fit on a %d x %d sheet", smSheetSize, smSheetSize));
+      }
+   }
+
+   for (U32 i = 0; i < m_stagedMaps.size(); i++)
+      delete m_stagedMaps[i];
+   m_stagedMaps.clear();
+
+   smTotalSheets      += m_sheets.size();
+   smTotalPixels      += numPixels;
+   smTotalSheetPixels += numSheetPixels;
 }
 
 U32 SheetManager::enterLightMap(const GBitmap* lm)
@@ -61,36 +308,18 @@ U32 SheetManager::enterLightMap(const GBitmap* lm)
 
    numPixels += width * height;
 
-   if (m_currSheet < 0) 
-   {
-      // Must initialize the sheets...
-      setupNewSheet();
-   }
-
-   if (m_currX + width >= csm_sheetSize) 
-   {
-      // Carriage return...
-      m_currX    = 0;
-      m_currY    = m_lowestY;
-   }
-
-   if (m_currY + height >= csm_sheetSize) 
-   {
-      // new sheet needed
-      setupNewSheet();
-   }
-
    m_lightMaps.increment();
-   m_lightMaps.last().sheetId = m_currSheet;
-   m_lightMaps.last().x       = m_currX;
-   m_lightMaps.last().y       = m_currY;
+   m_lightMaps.last().sheetId = 0;
+   m_lightMaps.last().x       = 0;
+   m_lightMaps.last().y       = 0;
    m_lightMaps.last().width   = width;
    m_lightMaps.last().height  = height;
+   m_lightMaps.last().rotated = false;
 
-   // And place the lightmap...
+   // Keep a bordered copy until the sheets are packed in end()
    //
-   AssertFatal(lm->bytesPerPixel == m_sheets[m_currSheet].pData->bytesPerPixel, "Um, bad mismatch of bitmap types...");
-
+   GBitmap* pStaged = new GBitmap(width, height, false, lm->getFormat());
+   m_stagedMaps.push_back(pStaged);
 
    U32 y, b;
    U32 pixoffset = lm->bytesPerPixel;
@@ -112,7 +341,7 @@ U32 SheetManager::enterLightMap(const GBitmap* lm)
       else
          srun = (U8 *)lm->getAddress(0, (y - SG_LIGHTMAP_BORDER_SIZE));
 
-      drun = (U8 *)m_sheets[m_currSheet].pData->getAddress(m_currX, (m_currY + y));
+      drun = (U8 *)pStaged->getAddress(0, y);
 
       dMemcpy(&drun[borderpixlen], srun, nonborderpixlen);
 
@@ -123,21 +352,13 @@ U32 SheetManager::enterLightMap(const GBitmap* lm)
       for(b=0; b<SG_LIGHTMAP_BORDER_SIZE; b++)
       {
          U32 i = b * pixoffset;
-         drun[i] = ss[0];
-         drun[i+1] = ss[1];
-         drun[i+2] = ss[2];
+         dMemcpy(&drun[i], ss, pixoffset);
 
          i = (lm->getWidth() + SG_LIGHTMAP_BORDER_SIZE + b) * pixoffset;
-         drun[i] = se[0];
-         drun[i+1] = se[1];
-         drun[i+2] = se[2];
+         dMemcpy(&drun[i], se, pixoffset);
       }
    }
 
-   m_currX += width;
-   if (m_currY + height > m_lowestY)
-      m_lowestY = m_currY + height;
-
    return m_lightMaps.size() - 1;
 }
 
@@ -160,185 +381,19 @@ SheetManager::getLightmapNC(const S32 in_lightMapIndex)
 
 
 void
-SheetManager::setupNewSheet()
-{
-   m_sheets.increment();
-   m_currSheet = m_sheets.size() - 1;
-
-   m_sheets.last().pData = new GBitmap(csm_sheetSize, csm_sheetSize);
-   for (U32 y = 0; y < m_sheets.last().pData->getHeight(); y++) {
-      for (U32 x = 0; x < m_sheets.last().pData->getWidth(); x++) {
-         U8* pDst = m_sheets.last().pData->getAddress(x, y);
-         pDst[0] = 0xFF;
-         pDst[1] = 0x00;
-         pDst[2] = 0xFF;
-      }
-   }
-
-
-   m_currX   = 0;
-   m_currY   = 0;
-   m_lowestY = 0;
-}
-
-void
-SheetManager::repackBlock()
-{
-   if (m_lightMaps.size() == 0)
-      return;
-
-   U32 currLightMapStart = 0;
-   U32 currLightMapEnd   = m_lightMaps.size() - 1;
-
-   S32 first = 0;
-   U32 num  = m_sheets.size();
-
-   // OK, so at this point, we have a block of sheets, and a block of lightmaps on
-   //  that sheet.  What we want to do is loop on the lightmaps until we have none
-   //  left, and pack them into new sheets that are as small as possible.
-   //
-   do {
-      const U32 numSizes = 16;
-      U32 sizes[numSizes][2] = {
-         {32, 32},         // 1024
-         {32, 64},         // 2048
-         {64, 32},         // 2048
-         {64, 64},         // 4096
-         {32, 128},        // 4096
-         {128, 32},        // 4096
-         {64, 128},        // 8192
-         {128, 64},        // 8192
-         {32, 256},        // 8192
-         {256, 32},        // 8192
-         {128, 128},       // 16384
-         {64, 256},        // 16384
-         {256, 64},        // 16384
-         {128, 256},       // 32768
-         {256, 128},       // 32768
-         {256, 256}        // 65536
-      };
-//      const U32 numSizes = 4;
-//      U32 sizes[numSizes][2] = {
-//         {32, 32},         // 1024
-//         {64, 64},         // 4096
-//         {128, 128},       // 16384
-//         {256, 256}        // 65536
-//      };
-
-      bool success = false;
-      for (U32 i = 0; i < numSizes; i++) {
-         if (doesFit(currLightMapStart, currLightMapEnd, sizes[i][0], sizes[i][1]) == true) {
-            // Everything left fits into a 32
-            //
-            numSheetPixels += sizes[i][0] * sizes[i][1];
-            repackSection(currLightMapStart, currLightMapEnd, sizes[i][0], sizes[i][1]);
-            currLightMapStart = currLightMapEnd;
-            success = true;
-            break;
-         }
-      }
-      if (success == false) {
-         // BSearch for the max we can get into a 256, then keep going...
-         //
-         U32 searchStart = currLightMapStart;
-         U32 searchEnd   = currLightMapEnd - 1;
-
-         while (searchStart != searchEnd) {
-            U32 probe = (searchStart + searchEnd) >> 1;
-
-            if (doesFit(currLightMapStart, probe, 256, 256) == true) {
-               if (searchStart != probe)
-                  searchStart = probe;
-               else
-                  searchEnd = searchStart;
-            } else {
-               if (searchEnd != probe)
-                  searchEnd = probe;
-               else
-                  searchEnd = searchStart;
-            }
-         }
-
-         numSheetPixels += 256*256;
-         repackSection(currLightMapStart, searchStart, 256, 256, true);
-         currLightMapStart = searchStart + 1;
-      }
-   } while (currLightMapStart < currLightMapEnd);
-
-   // All the sheets from the same block id are contigous, so all we have to do is
-   //  decrement the sheetIds of the affected lightmaps...
-   //
-   for (U32 i = 0; i < m_lightMaps.size(); i++) {
-      if (m_lightMaps[i].sheetId >= (first + num)) {
-         m_lightMaps[i].sheetId -= num;
-      }
-   }
-
-   for (U32 i = num; i != 0; i--) {
-      SheetEntry& rEntry = m_sheets[first];
-
-      delete rEntry.pData;
-      rEntry.pData = NULL;
-
-      m_sheets.erase(first);
-   }
-}
-
-
-S32 FN_CDECL
-compY(const void* p1, const void* p2)
-{
-   const Point2I* point1 = (const Point2I*)p1;
-   const Point2I* point2 = (const Point2I*)p2;
-
-   if (point1->y != point2->y)
-      return point2->y - point1->y;
-   else
-      return point2->x - point1->x;
-}
-
-
-SheetManager* g_pManager = NULL;
-
-S32 FN_CDECL
-compMapY(const void* in_p1, const void* in_p2)
-{
-   const S32* p1 = (const S32*)in_p1;
-   const S32* p2 = (const S32*)in_p2;
-
-   const SheetManager::LightMapEntry& rEntry1 = g_pManager->getLightmap(*p1);
-   const SheetManager::LightMapEntry& rEntry2 = g_pManager->getLightmap(*p2);
-
-   if (rEntry1.height != rEntry2.height)
-      return rEntry2.height - rEntry1.height;
-   else
-      return rEntry2.width - rEntry1.width;
-}
-
-void
-SheetManager::repackSection(const S32 in_start,
-                            const S32 in_end,
-                            const U32 in_sizeX,
-                            const U32 in_sizeY,
-                            const bool overflow)
+SheetManager::packSheet(Vector<S32>& io_remaining,
+                        const U32    in_sizeX,
+                        const U32    in_sizeY,
+                        const bool   overflow)
 {
-   Vector<S32> sheetIndices;
-   for (S32 i = in_start; i <= in_end; i++)
-      sheetIndices.push_back(i);
-
-   g_pManager = this;
-   dQsort(sheetIndices.address(), sheetIndices.size(), sizeof(S32), compMapY);
-   g_pManager = NULL;
-
-   // Ok, we now have the list of entries that we'll be entering, in the correct
-   //  order.  Go for it!  Create the "right-sized" sheet, and pack.
-   //
    m_sheets.increment();
-
    m_sheets.last().pData = new GBitmap(in_sizeX, in_sizeY);
-   for (U32 y = 0; y < m_sheets.last().pData->getHeight(); y++) {
-      for (U32 x = 0; x < m_sheets.last().pData->getWidth(); x++) {
-         U8* pDst = m_sheets.last().pData->getAddress(x, y);
+   GBitmap* pSheet = m_sheets.last().pData;
+   numSheetPixels += in_sizeX * in_sizeY;
+
+   for (U32 y = 0; y < pSheet->getHeight(); y++) {
+      for (U32 x = 0; x < pSheet->getWidth(); x++) {
+         U8* pDst = pSheet->getAddress(x, y);
 
          if (overflow == false) {
             pDst[0] = 0xFF;
@@ -352,120 +407,64 @@ SheetManager::repackSection(const S32 in_start,
       }
    }
 
-   U32 currX   = 0;
-   U32 currY   = 0;
-   U32 lowestY = 0;
+   // Place in order; whatever doesn't fit is left for the next sheet
+   MaxRectsBin bin(in_sizeX, in_sizeY);
+   Vector<S32> leftOver;
 
-   while (sheetIndices.size() != 0) {
-      LightMapEntry& rEntry = getLightmapNC(sheetIndices[0]);
+   for (U32 i = 0; i < io_remaining.size(); i++) {
+      LightMapEntry& rEntry = getLightmapNC(io_remaining[i]);
 
-      S32 lastOfHeight = 0;
-      for (U32 j = 1; j < sheetIndices.size(); j++) {
-         LightMapEntry& rEntryTest = getLightmapNC(sheetIndices[j]);
-         if (rEntryTest.height != rEntry.height)
-            break;
-
-         lastOfHeight = j;
+      PackRect placed;
+      bool rotated;
+      if (bin.insert(rEntry.width, rEntry.height, &placed, &rotated) == false) {
+         AssertFatal(overflow == true, "Error, too many lmaps for this size");
+         leftOver.push_back(io_remaining[i]);
+         continue;
       }
 
-      S32 insert = -1;
-      for (S32 k = 0; k <= lastOfHeight; k++) {
-         LightMapEntry& rEntryTest = getLightmapNC(sheetIndices[k]);
-         if (currX + rEntryTest.width < in_sizeX) {
-            insert = k;
-            break;
+      const GBitmap* pSrc = m_stagedMaps[io_remaining[i]];
+      AssertFatal(pSrc->bytesPerPixel == pSheet->bytesPerPixel, "Um, bad mismatch of bitmap types...");
+      U32 bpp = pSheet->bytesPerPixel;
+
+      if (rotated == false) {
+         for (U32 y = 0; y < rEntry.height; y++)
+            dMemcpy(pSheet->getAddress(placed.x, placed.y + y), pSrc->getAddress(0, y), rEntry.width * bpp);
+      } else {
+         // Transposed, source rows become sheet columns
+         for (U32 y = 0; y < rEntry.height; y++) {
+            for (U32 x = 0; x < rEntry.width; x++)
+               dMemcpy(pSheet->getAddress(placed.x + y, placed.y + x), pSrc->getAddress(x, y), bpp);
          }
       }
 
-      if (insert == -1) {
-         // CR
-         currY  = lowestY;
-         currX  = 0;
-         insert = 0;
-      }
-      LightMapEntry* pInsert = &getLightmapNC(sheetIndices[insert]);
-      AssertFatal(currY + pInsert->height < in_sizeY, "Error, too many lmaps for this size");
-
-      for (S32 y = 0; y < pInsert->height; y++) {
-         const U8* pSrc = m_sheets[pInsert->sheetId].pData->getAddress(pInsert->x, (pInsert->y + y));
-         U8* pDst       = m_sheets.last().pData->getAddress(currX, (currY + y));
-
-         dMemcpy(pDst, pSrc, pInsert->width * m_sheets[pInsert->sheetId].pData->bytesPerPixel);
-      }
-
-      pInsert->sheetId = m_sheets.size() - 1;
-      pInsert->x       = currX;
-      pInsert->y       = currY;
-      AssertFatal(pInsert->x + pInsert->width <= m_sheets.last().pData->getWidth(), "very bad");
-      AssertFatal(pInsert->y + pInsert->height <= m_sheets.last().pData->getHeight(), "also bad");
-
-      currX += pInsert->width;
-      if (currY + pInsert->height > lowestY)
-         lowestY = currY + pInsert->height;
-
-      sheetIndices.erase(insert);
+      rEntry.sheetId = m_sheets.size() - 1;
+      rEntry.x       = placed.x;
+      rEntry.y       = placed.y;
+      rEntry.width   = placed.width;
+      rEntry.height  = placed.height;
+      rEntry.rotated = rotated;
+      AssertFatal(rEntry.x + rEntry.width <= pSheet->getWidth(), "very bad");
+      AssertFatal(rEntry.y + rEntry.height <= pSheet->getHeight(), "also bad");
    }
+
+   io_remaining = leftOver;
 }
 
 
-bool SheetManager::doesFit(const S32 startMap,
-                           const S32 endMap,
-                           const U32 sizeX,
-                           const U32 sizeY) const
+bool SheetManager::doesFit(const Vector<S32>& in_maps,
+                           const U32          sizeX,
+                           const U32          sizeY) const
 {
-   Vector<Point2I> mapSizes;
-   mapSizes.setSize(endMap - startMap + 1);
+   MaxRectsBin bin(sizeX, sizeY);
 
-   for (S32 i = startMap; i <= endMap; i++) {
-      mapSizes[i - startMap].x = m_lightMaps[i].width;
-      mapSizes[i - startMap].y = m_lightMaps[i].height;
+   for (U32 i = 0; i < in_maps.size(); i++) {
+      const LightMapEntry& rEntry = getLightmap(in_maps[i]);
 
-      if (m_lightMaps[i].width > sizeX ||
-          m_lightMaps[i].height > sizeY)
+      PackRect placed;
+      bool rotated;
+      if (bin.insert(rEntry.width, rEntry.height, &placed, &rotated) == false)
          return false;
    }
 
-   dQsort(mapSizes.address(), mapSizes.size(), sizeof(Point2I), compY);
-
-   U32 currX   = 0;
-   U32 currY   = 0;
-   U32 lowestY = 0;
-
-   while (mapSizes.size() != 0) {
-      S32 lastOfHeight = 0;
-      for (U32 j = 1; j < mapSizes.size(); j++) {
-         if (mapSizes[j].y != mapSizes[0].y)
-            break;
-
-         lastOfHeight = j;
-      }
-
-      S32 insert = -1;
-      for (S32 k = 0; k <= lastOfHeight; k++) {
-         if (currX + mapSizes[k].x < sizeX) {
-            insert = k;
-            break;
-         }
-      }
-
-      if (insert == -1) {
-         // CR
-         currX  = 0;
-         currY  = lowestY;
-         insert = 0;
-      }
-
-      if (currY + mapSizes[insert].y >= sizeY) {
-         // Failure.
-         return false;
-      }
-
-      currX += mapSizes[insert].x;
-      if (currY + mapSizes[insert].y > lowestY)
-         lowestY = currY + mapSizes[insert].y;
-
-      mapSizes.erase(insert);
-   }
-
    return true;
 }
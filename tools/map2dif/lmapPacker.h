@@ -22,6 +22,12 @@
 //
 #define SG_LIGHTMAP_BORDER_SIZE 2
 
+//
+// Packs light maps into as few sheets as possible.  Light maps are collected
+// between begin() and end(), then placed with a MaxRects packer (best short
+// side fit), which may rotate a light map by 90 degrees.  The last sheet is
+// shrunk to the smallest power of two size that still holds what's left.
+//
 class SheetManager
 {
   public:
@@ -29,7 +35,8 @@ class SheetManager
       U32   sheetId;
 
       U16   x, y;
-      U16   width, height;
+      U16   width, height;   // As placed on the sheet, border included
+      bool  rotated;         // Transposed on the sheet
    };
 
    struct SheetEntry {
@@ -37,23 +44,24 @@ class SheetManager
    };
 
   public:
-   static const U32     csm_sheetSize;
+   // Largest sheet size, a power of two
+   static U32     smSheetSize;
+
+   // Totals over every manager since resetStats()
+   static U32     smTotalSheets;
+   static U32     smTotalPixels;
+   static U32     smTotalSheetPixels;
+   static void    resetStats();
 
   public:
    Vector<LightMapEntry>   m_lightMaps;
    Vector<SheetEntry>      m_sheets;
 
-   S32                   m_currSheet;
-
-   U32                  m_currX;
-   U32                  m_currY;
-   U32                  m_lowestY;
-
-   void setupNewSheet();
+  private:
+   Vector<GBitmap*>        m_stagedMaps;   // Bordered copies, until end()
 
-   void repackSection(const S32, const S32, const U32 in_sizeX, const U32 in_sizeY, const bool = false);
-   void repackBlock();
-   bool doesFit(const S32, const S32, const U32 sizeX, const U32 sizeY) const;
+   void packSheet(Vector<S32>& io_remaining, const U32 in_sizeX, const U32 in_sizeY, const bool overflow);
+   bool doesFit(const Vector<S32>& in_maps, const U32 sizeX, const U32 sizeY) const;
    LightMapEntry& getLightmapNC(const S32 in_lightMapIndex);
 
   public:
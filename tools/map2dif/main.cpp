@@ -15,7 +15,7 @@
 //#include "dgl/gTexManager.h"
 #include "console/consoleTypes.h"
 #include "math/mathTypes.h"
-#include "map2dif/tokenizer.h"
+#include "core/tokenizer.h"
 #include "map2dif/editGeometry.h"
 #include "interior/interior.h"
 #include "map2dif/editInteriorRes.h"
@@ -25,15 +25,12 @@
 #include "core/frameAllocator.h"
 #include "gui/core/guiCanvas.h"
 #include "map2dif/lmapPacker.h"
+#include "core/crc.h"
 
 #include <stdlib.h>
 
 MorianGame GameObject;
 
-
-// FOR SILLY LINK DEPENDANCY
-bool gEditingMission = false;
-
 #if defined(TORQUE_DEBUG)
 const char* const gProgramVersion = "0.900r-beta";
 #else
@@ -49,6 +46,8 @@ bool gTextureSearch = true;
 int gQuakeVersion = 2;
 
 U32 gMaxPlanesConsidered  = 32;
+U32 gNumThreads           = 0;
+U32 gBSPBrushSample       = 0;
 
 EditInteriorResource* gWorkingResource = NULL;
 
@@ -91,6 +90,7 @@ S32 getGraphNodes( char * mapFileName )
 {
    // setup the tokenizer
    Tokenizer* pTokenizer = new Tokenizer();
+   pTokenizer->setStrictQuotes(true);
    if (pTokenizer->openFile(mapFileName) == false) {
       dPrintf("getGraphNodes(): Error opening map file: %s", mapFileName);
       delete pTokenizer;
@@ -249,117 +249,22 @@ char* mergePath(const char* path1, const char* path2)
 }
 
 
-S32 MorianGame::main(int argc, const char** argv)
+//------------------------------------------------------------------------------
+// Time spent in each stage of a compile, in milliseconds
+struct CompileTimes {
+   U32 parse;
+   U32 csg;
+   U32 bsp;
+   U32 zones;
+   U32 surfaces;
+   U32 lighting;
+   U32 exporting;
+};
+
+// Gets the map files that make up the interior.  For detail based interiors
+//  (name_N.map) these are all detail levels that exist, unless -d was given.
+static void getInteriorMapFiles(const char* mapFile, Vector<char*>& mapFileNames)
 {
-   // Set the memory manager page size to 64 megs...
-   setMinimumAllocUnit(64 << 20);
-
-   if(!initLibraries())
-      return 0;
-
-   // Set up the command line args for the console scripts...
-   Con::setIntVariable("Game::argc", argc);
-   for (S32 i = 0; i < argc; i++)
-      Con::setVariable(avar("Game::argv%d", i), argv[i]);
-
-   // Parse command line args...
-   bool isForNavigation = false, extrusionTest = false;
-   const char* wadPath = 0;
-   const char* difPath = 0;
-   S32 i = 1;
-   for (; i < argc; i++) {
-      if (argv[i][0] != '-')
-         break;
-      switch(dToupper(argv[i][1])) {
-         case 'D':
-            gSpecifiedDetailOnly = true;
-            break;
-         case 'L':
-            gSpecifiedDetailOnly = true;
-            gBuildAsLowDetail = true;
-            break;
-         case 'H':
-            gMaxPlanesConsidered = U32(1 << 30);
-            break;
-         case 'N':
-            gVerbose = true;
-            break;
-         case 'G':
-            isForNavigation = true;
-            extrusionTest = true;
-            break;
-         case 'E':
-            extrusionTest = true;
-            break;
-         case 'S':
-            gTextureSearch = false;
-            break;
-
-         case 'Q':
-            gQuakeVersion = atoi (argv[++i]);
-            break;
-
-         case 'T':
-            wadPath = cleanPath(argv[++i]);
-            break;
-         case 'O':
-            difPath = cleanPath(argv[++i]);
-            break;
-      }
-   }
-   U32 args = argc - i;
-   if (args != 1) {
-      dPrintf("\nmap2dif - Torque .MAP file converter\n"
-              "  Copyright (C) GarageGames.com, Inc.\n"
-              "  Program version: %s\n"
-              "  Programmers: John Folliard & Dave Moore\n"
-              "  Built: %s at %s\n\n"
-              "Usage: map2dif [-v] [-p] [-s] [-l] [-h] [-g] [-e] [-n] [-q ver] [-o outputDirectory] [-t textureDirectory] <file>.map\n"
-              "        -p : Include a preview bitmap in the interior file\n"
-              "        -d : Process only the detail specified on the command line\n"
-              "        -l : Process as a low detail shape (implies -s)\n"
-              "        -h : Process for final build (exhaustive BSP search)\n"
-              "        -g : Generate navigation graph info\n"
-              "        -e : Do extrusion test\n"
-              "        -s : Don't search for textures in parent dir.\n"
-              "        -n : Noisy error/statistic reporting\n"
-              "        -q ver: Quake map file version (2, 3)\n"
-              "        -o dir: Directory in which to place the .dif file\n"
-              "        -t dir: Location of textures\n", gProgramVersion, __DATE__, __TIME__);
-      shutdownLibraries();
-      return -1;
-   }
-
-   // Check map file extension
-   const char* mapFile = argv[i];
-   const char* pDot = dStrrchr(mapFile, '.');
-   AssertISV(pDot && ((dStricmp(pDot, ".map") == 0)),
-         "Error, the map file must have a .MAP extension.");
-
-   // Get path and file name arguments
-   const char* mapPath = getPath(mapFile);
-   const char* baseName = getBaseName(mapFile);
-
-   if (!wadPath)
-      wadPath = mapPath;
-   if (!difPath)
-      difPath = mapPath;
-
-   // Old relative path merge, should think about what to do with it.
-   // wadPath = mergePath(mapPath,wadPath);
-   // difPath = mergePath(mapPath,difPath);
-
-   // Dif file name
-   char* pOutputName = new char[dStrlen(difPath) + dStrlen(baseName) + 5];
-   dStrcpy(pOutputName,difPath);
-   dStrcat(pOutputName,baseName);
-   dStrcat(pOutputName,".dif");
-
-   // Wad path
-   gWadPath = wadPath;
-
-   //
-   Vector<char*> mapFileNames;
    if (gSpecifiedDetailOnly == false) {
       const char* pDot = dStrrchr(mapFile, '.');
 
@@ -394,25 +299,47 @@ S32 MorianGame::main(int argc, const char** argv)
       mapFileNames.push_back(new char[dStrlen(mapFile) + 1]);
       dStrcpy(mapFileNames.last(), mapFile);
    }
+}
 
-   gWorkingResource = new EditInteriorResource;
+static char* getOutputName(const char* mapFile, const char* difPath)
+{
+   char* baseName = getBaseName(mapFile);
 
-   if( isForNavigation ){
-      S32   retCode = getGraphNodes( mapFileNames[0] );
-      delete [] pOutputName;
-      for (U32 i = 0; i < mapFileNames.size(); i++)
-         delete [] mapFileNames[i];
-      return retCode;
-   }
+   char* pOutputName = new char[dStrlen(difPath) + dStrlen(baseName) + 5];
+   dStrcpy(pOutputName,difPath);
+   dStrcat(pOutputName,baseName);
+   dStrcat(pOutputName,".dif");
+
+   delete [] baseName;
+   return pOutputName;
+}
+
+// Compiles the map files into one interior resource, pOutputName.  The files
+//  the textures were loaded from are added to textureFiles.
+static bool compileInterior(const Vector<char*>&      mapFileNames,
+                            const char*               pOutputName,
+                            bool                      extrusionTest,
+                            CompileTimes*             pTimes,
+                            Vector<StringTableEntry>& textureFiles)
+{
+   dMemset(pTimes, 0, sizeof(CompileTimes));
+
+   // Start from the same state whether this is the first interior or not
+   EditBSPNode::resetPlaneShuffle();
+   EditGeometry::resetUnnamedLights();
+
+   gWorkingResource = new EditInteriorResource;
 
    for (U32 i = 0; i < mapFileNames.size(); i++) {
       // setup the tokenizer
       Tokenizer* pTokenizer = new Tokenizer();
+      pTokenizer->setStrictQuotes(true);
       if (pTokenizer->openFile(mapFileNames[i]) == false) {
          dPrintf("Error opening map file: %s", mapFileNames[i]);
          delete pTokenizer;
-         shutdownLibraries();
-         return -1;
+         delete gWorkingResource;
+         gWorkingResource = NULL;
+         return(false);
       }
 
       // Create a geometry object
@@ -423,17 +350,28 @@ S32 MorianGame::main(int argc, const char** argv)
       dPrintf("Successfully opened map file: %s\n"
               "  Parsing mapfile...", mapFileNames[i]);
       dFflushStdout();
+      U32 stageStart = Platform::getRealMilliseconds();
       if (gWorkingGeometry->parseMapFile(pTokenizer) == false) {
          dPrintf("Error parsing map file: %s\n", mapFileNames[i]);
          delete pTokenizer;
          delete gWorkingGeometry;
+         gWorkingGeometry = NULL;
          delete gWorkingResource;
-         shutdownLibraries();
-         return -1;
+         gWorkingResource = NULL;
+         return(false);
       }
       delete pTokenizer;
+      pTimes->parse += Platform::getRealMilliseconds() - stageStart;
       dPrintf("done.\n");
 
+      for (U32 j = 0; j < gWorkingGeometry->mTextureFiles.size(); j++) {
+         bool found = false;
+         for (U32 k = 0; k < textureFiles.size() && !found; k++)
+            found = textureFiles[k] == gWorkingGeometry->mTextureFiles[j];
+         if (!found)
+            textureFiles.push_back(gWorkingGeometry->mTextureFiles[j]);
+      }
+
       gWorkingGeometry->setGraphGeneration(false,extrusionTest);
 
       dPrintf("  Creating BSP...");
@@ -442,17 +380,25 @@ S32 MorianGame::main(int argc, const char** argv)
          dPrintf("Error creating BSP!\n", mapFileNames[i]);
          // delete pTokenizer;  (already)
          delete gWorkingGeometry;
+         gWorkingGeometry = NULL;
          delete gWorkingResource;
-         shutdownLibraries();
-         return -1;
+         gWorkingResource = NULL;
+         return(false);
       }
+      pTimes->csg += gBSPBuildStats.csgTime;
+      pTimes->bsp += gBSPBuildStats.bspTime;
 
       dPrintf("done.\n  Marking active zones...");
+      stageStart = Platform::getRealMilliseconds();
       gWorkingGeometry->markEmptyZones();
+      pTimes->zones += Platform::getRealMilliseconds() - stageStart;
       dPrintf("done\n  Creating surfaces..."); dFflushStdout();
+      stageStart = Platform::getRealMilliseconds();
       gWorkingGeometry->createSurfaces();
+      pTimes->surfaces += Platform::getRealMilliseconds() - stageStart;
       dPrintf("done.\n  Lightmaps: Normal...");
       dFflushStdout();
+      stageStart = Platform::getRealMilliseconds();
       gWorkingGeometry->computeLightmaps(false);
       dPrintf("Alarm...");
       dFflushStdout();
@@ -460,10 +406,17 @@ S32 MorianGame::main(int argc, const char** argv)
       dPrintf("done.\n  Resorting and Packing LightMaps..."); dFflushStdout();
       gWorkingGeometry->preprocessLighting();
       gWorkingGeometry->sortLitSurfaces();
+      SheetManager::resetStats();
       gWorkingGeometry->packLMaps();
+      U32 numSheets      = SheetManager::smTotalSheets;
+      F32 sheetEfficiency = SheetManager::smTotalSheetPixels ?
+         F32(SheetManager::smTotalPixels) / F32(SheetManager::smTotalSheetPixels) * 100.0f : 0.0f;
+      pTimes->lighting += Platform::getRealMilliseconds() - stageStart;
       dPrintf("done.\n");
       dFflushStdout();
 
+      stageStart = Platform::getRealMilliseconds();
+
       // Process any special entitys...
       for (U32 i = 0; i < gWorkingGeometry->mEntities.size(); i++)
       {
@@ -484,12 +437,14 @@ S32 MorianGame::main(int argc, const char** argv)
               "     + detail:           %d\n"
               "     + portal:           %d\n"
               "   - Number of zones:    %d\n"
-              "   - Number of surfaces: %d\n", gWorkingGeometry->getTotalNumBrushes(),
+              "   - Number of surfaces: %d\n"
+              "   - Light map sheets:   %d (%.1f%% used)\n", gWorkingGeometry->getTotalNumBrushes(),
               gWorkingGeometry->getNumStructuralBrushes(),
               gWorkingGeometry->getNumDetailBrushes(),
               gWorkingGeometry->getNumPortalBrushes(),
               gWorkingGeometry->getNumZones(),
-              gWorkingGeometry->getNumSurfaces());
+              gWorkingGeometry->getNumSurfaces(),
+              numSheets, sheetEfficiency);
 
       if (gWorkingGeometry->getNumAmbiguousBrushes() != 0 ||
           gWorkingGeometry->getNumOrphanPolys() != 0) {
@@ -519,6 +474,7 @@ S32 MorianGame::main(int argc, const char** argv)
       dPrintf("done.\n\n");
       dFflushStdout();
       gWorkingResource->addDetailLevel(pRuntime);
+      pTimes->exporting += Platform::getRealMilliseconds() - stageStart;
 
       delete gWorkingGeometry;
       gWorkingGeometry = NULL;
@@ -528,6 +484,7 @@ S32 MorianGame::main(int argc, const char** argv)
       dPrintf(" Writing Resource: "); dFflushStdout();
 
       dPrintf("persist..(%s) ", pOutputName); dFflushStdout();
+      U32 stageStart = Platform::getRealMilliseconds();
       gWorkingResource->sortDetailLevels();
 
       gWorkingResource->getDetailLevel(0)->processHullPolyLists();
@@ -539,19 +496,455 @@ S32 MorianGame::main(int argc, const char** argv)
       fws.open(pOutputName, FileStream::Write);
       gWorkingResource->write(fws);
       fws.close();
+      pTimes->exporting += Platform::getRealMilliseconds() - stageStart;
 
       dPrintf("Done.\n\n");
       dFflushStdout();
+   }
+
+   delete gWorkingResource;
+   gWorkingResource = NULL;
+   return(true);
+}
+
+//------------------------------------------------------------------------------
+// Batch mode
+//
+// Every line of the manifest names a .map file, optionally followed by the
+//  directory to place its .dif in.  Blank lines and lines starting with '#'
+//  are ignored.  Each interior is hashed from its map files, the texture files
+//  it used last time and the options that affect the output.  Interiors whose
+//  hash hasn't changed since their last compile are skipped.  The hashes are
+//  kept in <manifest>.cache.
+//
+struct BatchCacheEntry {
+   StringTableEntry mapFile;
+   U32              hash;
+   StringTableEntry textureFiles;   // Tab separated
+};
 
-      delete gWorkingResource;
+static U32 hashFile(const char* fileName, U32 crc)
+{
+   // A missing file still changes the hash
+   crc = calculateCRC(fileName, dStrlen(fileName), crc);
+
+   FileStream stream;
+   if (stream.open(fileName, FileStream::Read))
+      crc = calculateCRCStream(&stream, crc);
+   return(crc);
+}
+
+static U32 hashInterior(const Vector<char*>& mapFileNames,
+                        const char*          textureFiles,
+                        const char*          pOutputName,
+                        bool                 extrusionTest)
+{
+   // Options that change the output
+   U32 options[] = { gMaxPlanesConsidered, gBSPBrushSample, U32(gQuakeVersion), SheetManager::smSheetSize,
+                     gSpecifiedDetailOnly, gBuildAsLowDetail, gTextureSearch, extrusionTest };
+   U32 crc = calculateCRC(options, sizeof(options));
+   crc = calculateCRC(gProgramVersion, dStrlen(gProgramVersion), crc);
+   crc = calculateCRC(gWadPath, dStrlen(gWadPath), crc);
+   crc = calculateCRC(pOutputName, dStrlen(pOutputName), crc);
+
+   for (U32 i = 0; i < mapFileNames.size(); i++)
+      crc = hashFile(mapFileNames[i], crc);
+
+   char fileName[1024];
+   const char* pStart = textureFiles;
+   while (*pStart) {
+      const char* pEnd = dStrchr(pStart, '\t');
+      U32 len = pEnd ? U32(pEnd - pStart) : dStrlen(pStart);
+      len = getMin(len, U32(sizeof(fileName) - 1));
+      dStrncpy(fileName, pStart, len);
+      fileName[len] = '\0';
+      crc = hashFile(fileName, crc);
+
+      pStart += pEnd ? (pEnd - pStart) + 1 : dStrlen(pStart);
+   }
+
+   return(crc);
+}
+
+// Reads a whole text file, NULL if it can't be opened
+static char* readTextFile(const char* fileName)
+{
+   FileStream stream;
+   if (!stream.open(fileName, FileStream::Read))
+      return(NULL);
+
+   U32 size = stream.getStreamSize();
+   char* pText = new char[size + 1];
+   stream.read(size, pText);
+   pText[size] = '\0';
+   return(pText);
+}
+
+// Splits the text into lines in place, stripping comments and blank lines
+static void getTextLines(char* pText, Vector<char*>& lines)
+{
+   char* pLine = pText;
+   while (pLine && *pLine) {
+      char* pNext = dStrchr(pLine, '\n');
+      if (pNext)
+         *pNext++ = '\0';
+
+      U32 len = dStrlen(pLine);
+      if (len && pLine[len - 1] == '\r')
+         pLine[len - 1] = '\0';
+      while (*pLine == ' ' || *pLine == '\t')
+         pLine++;
+      if (*pLine && *pLine != '#')
+         lines.push_back(pLine);
+
+      pLine = pNext;
+   }
+}
+
+static void writeBatchCache(const char* fileName, const Vector<BatchCacheEntry>& cache)
+{
+   FileStream stream;
+   if (!stream.open(fileName, FileStream::Write)) {
+      dPrintf("Warning: unable to write batch cache: %s\n", fileName);
+      return;
    }
 
+   char buffer[64];
+   for (U32 i = 0; i < cache.size(); i++) {
+      dSprintf(buffer, sizeof(buffer), "\t%08x", cache[i].hash);
+      stream.write(dStrlen(cache[i].mapFile), cache[i].mapFile);
+      stream.write(dStrlen(buffer), buffer);
+      if (cache[i].textureFiles[0]) {
+         stream.write(U8('\t'));
+         stream.write(dStrlen(cache[i].textureFiles), cache[i].textureFiles);
+      }
+      stream.write(U8('\n'));
+   }
+}
+
+static S32 compileBatch(const char* manifest,
+                        const char* wadPath,
+                        const char* difPath,
+                        bool        extrusionTest)
+{
+   char* pManifest = readTextFile(manifest);
+   if (pManifest == NULL) {
+      dPrintf("Error opening batch manifest: %s\n", manifest);
+      return -1;
+   }
+   Vector<char*> entries;
+   getTextLines(pManifest, entries);
+
+   // Load the hashes of the last batch: map file, hash, texture files...
+   char cacheName[1024];
+   dSprintf(cacheName, sizeof(cacheName), "%s.cache", manifest);
+   Vector<BatchCacheEntry> cache;
+   char* pCacheText = readTextFile(cacheName);
+   if (pCacheText) {
+      Vector<char*> lines;
+      getTextLines(pCacheText, lines);
+      for (U32 i = 0; i < lines.size(); i++) {
+         char* pHash = dStrchr(lines[i], '\t');
+         if (pHash == NULL)
+            continue;
+         *pHash++ = '\0';
+         char* pTextures = dStrchr(pHash, '\t');
+         if (pTextures)
+            *pTextures++ = '\0';
+
+         cache.increment();
+         cache.last().mapFile      = StringTable->insert(lines[i]);
+         cache.last().hash         = U32(strtoul(pHash, NULL, 16));
+         cache.last().textureFiles = StringTable->insert(pTextures ? pTextures : "");
+      }
+      delete [] pCacheText;
+   }
+
+   Vector<CompileTimes> times;
+   Vector<S32>          results;   // 1 compiled, 0 up to date, -1 failed
+   times.setSize(entries.size());
+   results.setSize(entries.size());
+   dMemset(times.address(), 0, times.size() * sizeof(CompileTimes));
+
+   U32 batchStart = Platform::getRealMilliseconds();
+   for (U32 i = 0; i < entries.size(); i++) {
+      // map file, then optionally the output directory
+      char* mapFile = entries[i];
+      char* pOutDir = mapFile;
+      while (*pOutDir && *pOutDir != ' ' && *pOutDir != '\t')
+         pOutDir++;
+      if (*pOutDir) {
+         *pOutDir++ = '\0';
+         while (*pOutDir == ' ' || *pOutDir == '\t')
+            pOutDir++;
+      }
+
+      const char* pDot = dStrrchr(mapFile, '.');
+      if (!pDot || dStricmp(pDot, ".map") != 0) {
+         dPrintf("Error, the map file must have a .MAP extension: %s\n", mapFile);
+         results[i] = -1;
+         continue;
+      }
+
+      char* mapPath = getPath(mapFile);
+      char* outPath = *pOutDir ? cleanPath(pOutDir) : NULL;
+      gWadPath = wadPath ? wadPath : mapPath;
+      char* pOutputName = getOutputName(mapFile, outPath ? outPath : (difPath ? difPath : mapPath));
+
+      Vector<char*> mapFileNames;
+      getInteriorMapFiles(mapFile, mapFileNames);
+
+      StringTableEntry mapEntry = StringTable->insert(mapFile);
+      S32 cacheIndex = -1;
+      for (U32 j = 0; j < cache.size() && cacheIndex == -1; j++) {
+         if (cache[j].mapFile == mapEntry)
+            cacheIndex = j;
+      }
+
+      if (cacheIndex != -1 && Platform::isFile(pOutputName) &&
+          hashInterior(mapFileNames, cache[cacheIndex].textureFiles, pOutputName, extrusionTest) == cache[cacheIndex].hash) {
+         dPrintf("%s is up to date.\n", mapFile);
+         results[i] = 0;
+      } else {
+         dPrintf("\nCompiling %s (%d of %d)\n", mapFile, i + 1, entries.size());
+         dFflushStdout();
+
+         Vector<StringTableEntry> textureFiles;
+         if (mapFileNames.size() != 0 &&
+             compileInterior(mapFileNames, pOutputName, extrusionTest, &times[i], textureFiles)) {
+            results[i] = 1;
+
+            U32 len = 1;
+            for (U32 j = 0; j < textureFiles.size(); j++)
+               len += dStrlen(textureFiles[j]) + 1;
+            char* pTextures = new char[len];
+            pTextures[0] = '\0';
+            for (U32 j = 0; j < textureFiles.size(); j++) {
+               if (j != 0)
+                  dStrcat(pTextures, "\t");
+               dStrcat(pTextures, textureFiles[j]);
+            }
+
+            if (cacheIndex == -1) {
+               cache.increment();
+               cacheIndex = cache.size() - 1;
+               cache[cacheIndex].mapFile = mapEntry;
+            }
+            cache[cacheIndex].textureFiles = StringTable->insert(pTextures);
+            cache[cacheIndex].hash         = hashInterior(mapFileNames, pTextures, pOutputName, extrusionTest);
+            delete [] pTextures;
+         } else {
+            dPrintf("Error compiling %s\n", mapFile);
+            results[i] = -1;
+            if (cacheIndex != -1)
+               cache.erase(cacheIndex);
+         }
+
+         // Save after every interior so an interrupted batch can resume
+         writeBatchCache(cacheName, cache);
+      }
+
+      for (U32 j = 0; j < mapFileNames.size(); j++)
+         delete [] mapFileNames[j];
+      delete [] pOutputName;
+      delete [] outPath;
+      delete [] mapPath;
+   }
+   U32 batchTime = Platform::getRealMilliseconds() - batchStart;
+
+   // Timing report
+   U32 numCompiled = 0, numUpToDate = 0, numFailed = 0;
+   dPrintf("\n  BATCH REPORT (seconds)\n"
+           "   %-40s %7s %7s %7s %7s %7s %7s %7s %7s\n",
+           "Interior", "Parse", "CSG", "BSP", "Zones", "Surface", "Light", "Export", "Total");
+   for (U32 i = 0; i < entries.size(); i++) {
+      if (results[i] != 1) {
+         dPrintf("   %-40s %s\n", entries[i], results[i] == 0 ? "up to date" : "FAILED");
+         if (results[i] == 0)
+            numUpToDate++;
+         else
+            numFailed++;
+         continue;
+      }
+
+      numCompiled++;
+      const CompileTimes& t = times[i];
+      U32 total = t.parse + t.csg + t.bsp + t.zones + t.surfaces + t.lighting + t.exporting;
+      dPrintf("   %-40s %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f\n", entries[i],
+              F32(t.parse) / 1000.0f, F32(t.csg) / 1000.0f, F32(t.bsp) / 1000.0f,
+              F32(t.zones) / 1000.0f, F32(t.surfaces) / 1000.0f, F32(t.lighting) / 1000.0f,
+              F32(t.exporting) / 1000.0f, F32(total) / 1000.0f);
+   }
+   dPrintf("\n   Compiled: %d  Up to date: %d  Failed: %d  Time: %.2f s\n\n",
+           numCompiled, numUpToDate, numFailed, F32(batchTime) / 1000.0f);
+   dFflushStdout();
+
+   delete [] pManifest;
+   return numFailed ? -1 : 0;
+}
+
+
+S32 MorianGame::main(int argc, const char** argv)
+{
+   // Set the memory manager page size to 64 megs...
+   setMinimumAllocUnit(64 << 20);
+
+   if(!initLibraries())
+      return 0;
+
+   // Set up the command line args for the console scripts...
+   Con::setIntVariable("Game::argc", argc);
+   for (S32 i = 0; i < argc; i++)
+      Con::setVariable(avar("Game::argv%d", i), argv[i]);
+
+   // Parse command line args...
+   bool isForNavigation = false, extrusionTest = false;
+   const char* wadPath = 0;
+   const char* difPath = 0;
+   const char* batchManifest = 0;
+   S32 i = 1;
+   for (; i < argc; i++) {
+      if (argv[i][0] != '-')
+         break;
+      if (dStricmp(argv[i], "-threads") == 0 && (i + 1) < argc) {
+         gNumThreads = atoi(argv[++i]);
+         continue;
+      }
+      if (dStricmp(argv[i], "-lmsheet") == 0 && (i + 1) < argc) {
+         SheetManager::smSheetSize = atoi(argv[++i]);
+         if (!isPow2(SheetManager::smSheetSize) || SheetManager::smSheetSize < 256) {
+            dPrintf("Light map sheet size must be a power of two of at least 256\n");
+            shutdownLibraries();
+            return -1;
+         }
+         continue;
+      }
+      if (dStricmp(argv[i], "-batch") == 0 && (i + 1) < argc) {
+         batchManifest = argv[++i];
+         continue;
+      }
+      if (dStricmp(argv[i], "-bspsample") == 0 && (i + 1) < argc) {
+         gBSPBrushSample = atoi(argv[++i]);
+         continue;
+      }
+      switch(dToupper(argv[i][1])) {
+         case 'D':
+            gSpecifiedDetailOnly = true;
+            break;
+         case 'L':
+            gSpecifiedDetailOnly = true;
+            gBuildAsLowDetail = true;
+            break;
+         case 'H':
+            gMaxPlanesConsidered = U32(1 << 30);
+            break;
+         case 'N':
+            gVerbose = true;
+            break;
+         case 'G':
+            isForNavigation = true;
+            extrusionTest = true;
+            break;
+         case 'E':
+            extrusionTest = true;
+            break;
+         case 'S':
+            gTextureSearch = false;
+            break;
+
+         case 'Q':
+            gQuakeVersion = atoi (argv[++i]);
+            break;
+
+         case 'T':
+            wadPath = cleanPath(argv[++i]);
+            break;
+         case 'O':
+            difPath = cleanPath(argv[++i]);
+            break;
+      }
+   }
+   U32 args = argc - i;
+   if (args != (batchManifest ? 0 : 1)) {
+      dPrintf("\nmap2dif - Torque .MAP file converter\n"
+              "  Copyright (C) GarageGames.com, Inc.\n"
+              "  Program version: %s\n"
+              "  Programmers: John Folliard & Dave Moore\n"
+              "  Built: %s at %s\n\n"
+              "Usage: map2dif [-v] [-p] [-s] [-l] [-h] [-g] [-e] [-n] [-q ver] [-o outputDirectory] [-t textureDirectory] [-threads n] [-bspsample n] [-lmsheet n] <file>.map\n"
+              "       map2dif [options] -batch manifest\n"
+              "        -p : Include a preview bitmap in the interior file\n"
+              "        -d : Process only the detail specified on the command line\n"
+              "        -l : Process as a low detail shape (implies -s)\n"
+              "        -h : Process for final build (exhaustive BSP search)\n"
+              "        -g : Generate navigation graph info\n"
+              "        -e : Do extrusion test\n"
+              "        -s : Don't search for textures in parent dir.\n"
+              "        -n : Noisy error/statistic reporting\n"
+              "        -q ver: Quake map file version (2, 3)\n"
+              "        -o dir: Directory in which to place the .dif file\n"
+              "        -t dir: Location of textures\n"
+              "        -threads n: Threads used to build the BSP and light surfaces (default: one per processor, 1: don't use threads)\n"
+              "        -bspsample n: Rate BSP split planes against at most n brushes per node (faster, lower quality)\n"
+              "        -lmsheet n: Largest light map sheet size (default: 256)\n"
+              "        -batch file: Compile every .map listed in the file, skipping unchanged ones\n", gProgramVersion, __DATE__, __TIME__);
+      shutdownLibraries();
+      return -1;
+   }
+
+   if (batchManifest) {
+      S32 retCode = compileBatch(batchManifest, wadPath, difPath, extrusionTest);
+      shutdownLibraries();
+      return retCode;
+   }
+
+   // Check map file extension
+   const char* mapFile = argv[i];
+   const char* pDot = dStrrchr(mapFile, '.');
+   AssertISV(pDot && ((dStricmp(pDot, ".map") == 0)),
+         "Error, the map file must have a .MAP extension.");
+
+   // Get path and file name arguments
+   const char* mapPath = getPath(mapFile);
+
+   if (!wadPath)
+      wadPath = mapPath;
+   if (!difPath)
+      difPath = mapPath;
+
+   // Old relative path merge, should think about what to do with it.
+   // wadPath = mergePath(mapPath,wadPath);
+   // difPath = mergePath(mapPath,difPath);
+
+   // Dif file name
+   char* pOutputName = getOutputName(mapFile, difPath);
+
+   // Wad path
+   gWadPath = wadPath;
+
+   //
+   Vector<char*> mapFileNames;
+   getInteriorMapFiles(mapFile, mapFileNames);
+
+   if( isForNavigation ){
+      gWorkingResource = new EditInteriorResource;
+      S32   retCode = getGraphNodes( mapFileNames[0] );
+      delete [] pOutputName;
+      for (U32 i = 0; i < mapFileNames.size(); i++)
+         delete [] mapFileNames[i];
+      return retCode;
+   }
+
+   CompileTimes times;
+   Vector<StringTableEntry> textureFiles;
+   S32 retCode = compileInterior(mapFileNames, pOutputName, extrusionTest, &times, textureFiles) ? 0 : -1;
+
    delete [] pOutputName;
    for (U32 i = 0; i < mapFileNames.size(); i++)
       delete [] mapFileNames[i];
 
    shutdownLibraries();
-   return 0;
+   return retCode;
 }
 
 void GameReactivate()
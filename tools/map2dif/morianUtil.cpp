@@ -450,6 +450,9 @@ void splitBrush(CSGBrush*& inBrush,
             pFront->mPlanes[i].winding.numIndices = 0;
 
          pFront->selfClip();
+      } else {
+         // Untouched, so the plane assessments still hold
+         pFront->mAssessments = inBrush->mAssessments;
       }
 
       outFront = pFront;
@@ -493,6 +496,8 @@ void splitBrush(CSGBrush*& inBrush,
             pBack->mPlanes[i].winding.numIndices = 0;
 
          pBack->selfClip();
+      } else {
+         pBack->mAssessments = inBrush->mAssessments;
       }
 
       outBack = pBack;
@@ -500,30 +505,23 @@ void splitBrush(CSGBrush*& inBrush,
 }
 
 
-void assessPlane(const U32    testPlane,
-                 const CSGBrush& rTestBrush,
-                 S32*          numCoplanar,
-                 S32*          numTinyWindings,
-                 S32*          numSplits,
-                 S32*          numFront,
-                 S32*          numBack)
+U32 assessPlane(const U32       testPlane,
+                const CSGBrush& rTestBrush)
 {
    for (U32 i = 0; i < rTestBrush.mPlanes.size(); i++) {
       if (gWorkingGeometry->isCoplanar(testPlane, rTestBrush.mPlanes[i].planeEQIndex)) {
          // Easy.  Brush abuts the plane.
-         (*numCoplanar)++;
          if (testPlane == rTestBrush.mPlanes[i].planeEQIndex)
-            (*numBack)++;
+            return(AssessCoplanar | AssessBack);
          else
-            (*numFront)++;
-         return;
+            return(AssessCoplanar | AssessFront);
       }
    }
 
    // Ah well, more work...
    const PlaneEQ& rPlane = gWorkingGeometry->getPlaneEQ(testPlane);
 
-   static UniqueVector uniquePoints(64);
+   static thread_local UniqueVector uniquePoints(64);
    for (U32 i = 0; i < rTestBrush.mPlanes.size(); i++) {
       for (U32 j = 0; j < rTestBrush.mPlanes[i].winding.numIndices; j++)
          uniquePoints.pushBackUnique(rTestBrush.mPlanes[i].winding.indices[j]);
@@ -545,23 +543,25 @@ void assessPlane(const U32    testPlane,
    //AssertFatal(maxFront > gcPlaneDistanceEpsilon || minBack < -gcPlaneDistanceEpsilon,
    //            "This should only happen for coplanar windings...");
 
+   U32 assessment = 0;
    if (maxFront >  gcPlaneDistanceEpsilon)
-      (*numFront)++;
+      assessment |= AssessFront;
 
    if (minBack  < -gcPlaneDistanceEpsilon)
-      (*numBack)++;
+      assessment |= AssessBack;
 
    if (maxFront >  gcPlaneDistanceEpsilon &&
        minBack  < -gcPlaneDistanceEpsilon)
-      (*numSplits)++;
+      assessment |= AssessSplit;
 
 
    if ((maxFront > 0.0 && maxFront < 1.0) ||
        (minBack  < 0.0 && minBack  > -1.0))
-      (*numTinyWindings)++;
+      assessment |= AssessTinyWinding;
 
    // done.
    uniquePoints.clear();
+   return(assessment);
 }
 
 
@@ -924,6 +924,7 @@ CSGBrush* BrushArena::allocateBrush()
    pRet->pNext        = NULL;
    pRet->mIsAmbiguous = false;
    pRet->mPlanes.clear();
+   pRet->mAssessments.clear();
    return pRet;
 }
 
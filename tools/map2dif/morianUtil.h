@@ -45,13 +45,18 @@ void splitBrush(CSGBrush*& inBrush,
                 CSGBrush*& outBack);
 
 struct PlaneEQ;
-void assessPlane(const U32    testPlane,
-                 const CSGBrush& rTestBrush,
-                 S32*          numCoplanar,
-                 S32*          numTinyWindings,
-                 S32*          numSplits,
-                 S32*          numFront,
-                 S32*          numBack);
+enum PlaneAssessment {
+   AssessCoplanar    = 1 << 0,
+   AssessTinyWinding = 1 << 1,
+   AssessSplit       = 1 << 2,
+   AssessFront       = 1 << 3,
+   AssessBack        = 1 << 4
+};
+
+// Returns the PlaneAssessment flags of the brush relative to the plane.  Only
+//  reads the working geometry, so brushes may be assessed on several threads.
+U32 assessPlane(const U32       testPlane,
+                const CSGBrush& rTestBrush);
 
 void reextendName(char* pName, const char* pExt);
 void extendName(char* pName, const char* pExt);